@@ -32,6 +32,8 @@ public:
     void run();
 
     Window& getWindow() { return *m_window; }
+    // 应用的外部存储目录，可通过adb取出其中的文件（如录制的传感器数据）
+    std::string getDataPath() const;
     void    setActiveScene(const std::string& name)
     {
         if (m_scene_map.find(name) == m_scene_map.end()) return;
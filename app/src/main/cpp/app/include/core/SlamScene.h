@@ -4,6 +4,7 @@
 #include <mutex>
 #include <thread>
 
+#include <SensorLog.h>
 #include <SlamKernel.h>
 
 #include "core/Scene.h"
@@ -44,6 +45,10 @@ public:
     void update(float dt) override;
     void drawGui(float dt) override;
 
+private:
+    void startSensorLog();
+    void stopSensorLog();
+
 private:
     std::unique_ptr<SensorIMU>    m_imu_pool;       // 用于获取IMU数据
     std::unique_ptr<ImagePool>    m_image_pool;     // 用于获取图像数据
@@ -61,6 +66,10 @@ private:
     std::atomic_bool m_is_running_slam   = true;   // 带自旋锁的SLAM运行标志
 
     bool m_need_update_image = true;  // 用于标志是否在运行SLAM模块以提供新图像
+
+    int64_t                          m_begin_time_stamp = 0;  // SLAM初始时间戳，回放时用于创建相同的SlamKernel
+    std::unique_ptr<SensorLogWriter> m_sensor_log;            // 录制传感器数据，为空时不录制
+    std::mutex                       m_sensor_log_mutex;      // 录制对象的互斥锁
 };
 
 }  // namespace android_slam
\ No newline at end of file
@@ -40,6 +40,12 @@ App::App(android_app* state) noexcept
     SensorTexture::registerFunctions();
 }
 
+std::string App::getDataPath() const
+{
+    const char* path = g_state->activity->externalDataPath;
+    return path ? path : g_state->activity->internalDataPath;
+}
+
 void App::run()
 {
     // 更新计时器
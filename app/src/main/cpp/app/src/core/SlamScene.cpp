@@ -37,19 +37,24 @@ void SlamScene::init()
     {
         std::cout << "[Android Slam App Info] Starts to create slam kernel." << std::endl;
 
-        // 读取ORB-SLAM3的词袋文件
-        AAsset* asset = AAssetManager_open(AssetManager::get(), "vocabulary/ORBVoc.txt", AASSET_MODE_BUFFER);
-        assert(asset && "[Android Slam App Info] Failed to open ORBVoc.txt.");
+        // 读取ORB-SLAM3的词袋文件，优先使用二进制词袋（不压缩打包，直接映射使用，无需解析），否则解析文本词袋
+        AAsset* asset = AAssetManager_open(AssetManager::get(), "vocabulary/ORBVoc.bin", AASSET_MODE_BUFFER);
+        if (!asset)
+        {
+            asset = AAssetManager_open(AssetManager::get(), "vocabulary/ORBVoc.txt", AASSET_MODE_BUFFER);
+        }
+        assert(asset && "[Android Slam App Info] Failed to open ORBVoc.bin or ORBVoc.txt.");
 
         size_t      size   = AAsset_getLength(asset);
-        auto        buffer = (const char*)AAsset_getBuffer(asset);
-        std::string voc_buffer(buffer, buffer + size);
-        AAsset_close(asset);
+        const void* buffer = AAsset_getBuffer(asset);
 
-        // 创建
+        // 创建，asset在词袋使用期间保持打开
+        m_begin_time_stamp = first_image.time_stamp;
         m_slam_kernel = std::make_unique<SlamKernel>(k_sensor_camera_width,
                                                      k_sensor_camera_height,
-                                                     std::move(voc_buffer),
+                                                     buffer,
+                                                     size,
+                                                     std::shared_ptr<const void>(asset, AAsset_close),
                                                      first_image.time_stamp);
 
         std::cout << "[Android Slam App Info] Creates slam kernel successfully." << std::endl;
@@ -79,6 +84,12 @@ void SlamScene::init()
                     imu_points = std::move(m_imu_points);
                 }
 
+                // 录制传入SLAM的原始数据，可在主机上用dataset_runner回放
+                {
+                    std::unique_lock<std::mutex> lock(m_sensor_log_mutex);
+                    if (m_sensor_log) m_sensor_log->write(images, imu_points);
+                }
+
                 // SLAM解算
                 auto res            = m_slam_kernel->handleData(images, imu_points);
                 m_slam_has_new_data = false;  // This image is processed and this thread needs new image.
@@ -100,6 +111,7 @@ void SlamScene::exit()
     m_slam_thread->join();  // 退出时线程join，之后再清理内存
     m_slam_thread.reset(nullptr);
 
+    stopSensorLog();
     m_slam_kernel.reset(nullptr);
     m_slam_renderer.reset(nullptr);
     m_image_pool.reset(nullptr);
@@ -165,6 +177,18 @@ void SlamScene::drawGui(float dt)
             m_need_update_image = !m_need_update_image;
         }
 
+        if (ImGui::Button(m_sensor_log ? u8"停止录制" : u8"开始录制"))
+        {
+            if (m_sensor_log)
+            {
+                stopSensorLog();
+            }
+            else
+            {
+                startSensorLog();
+            }
+        }
+
         // if (ImGui::Button(u8"重置"))
         //{
         //     m_slam_kernel->reset();
@@ -229,4 +253,30 @@ void SlamScene::drawGui(float dt)
     }
 }
 
+void SlamScene::startSensorLog()
+{
+    std::string file = m_app_ref.getDataPath() + "/sensor_log_" +
+                       std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + ".aslg";
+
+    auto log = std::make_unique<SensorLogWriter>(file, k_sensor_camera_width, k_sensor_camera_height, m_begin_time_stamp);
+    if (!log->isOpen()) return;
+
+    std::cout << "[Android Slam App Info] Starts to record sensor log " << file << "." << std::endl;
+
+    std::unique_lock<std::mutex> lock(m_sensor_log_mutex);
+    m_sensor_log = std::move(log);
+}
+
+void SlamScene::stopSensorLog()
+{
+    std::unique_ptr<SensorLogWriter> log;
+    {
+        std::unique_lock<std::mutex> lock(m_sensor_log_mutex);
+        log = std::move(m_sensor_log);
+    }
+    if (!log) return;
+
+    std::cout << "[Android Slam App Info] Stops recording sensor log, " << log->recordCount() << " frames." << std::endl;
+}
+
 }  // namespace android_slam
\ No newline at end of file
@@ -42,6 +42,16 @@ class FClass
    * @return distance
    */
   static double distance(const TDescriptor &a, const TDescriptor &b);
+
+  /**
+   * Calculates the distances between a descriptor and n others
+   * @param a
+   * @param b n descriptors
+   * @param n
+   * @param dist (out) n distances
+   */
+  static void distances(const TDescriptor &a, const pDescriptor *b, int n,
+    double *dist);
   
   /**
    * Returns a string version of the descriptor
@@ -49,6 +59,30 @@ class FClass
    * @return string version
    */
   static std::string toString(const TDescriptor &a);
+
+  /**
+   * Returns a descriptor over L bytes, without copying them
+   * @param p L bytes
+   * @return descriptor
+   */
+  static TDescriptor view(const unsigned char *p);
+
+  /**
+   * Copies the L bytes of a descriptor, the inverse of view
+   * @param a descriptor
+   * @param p (out) L bytes
+   */
+  static void toBytes(const TDescriptor &a, unsigned char *p);
+
+  /**
+   * Returns the position of the nearest of n descriptors stored one after
+   * the other (as toBytes writes them), the first one on ties
+   * @param a
+   * @param packed n * L bytes
+   * @param n > 0
+   */
+  static int nearestPacked(const TDescriptor &a, const unsigned char *packed,
+    int n);
   
   /**
    * Returns a descriptor from a string
@@ -10,11 +10,14 @@
  */
 
  
+#include <algorithm>
+#include <cstring>
 #include <vector>
 #include <string>
 #include <sstream>
 
 #include "FORB.h"
+#include "HammingDistance.h"
 
 using namespace std;
 
@@ -80,23 +83,51 @@ void FORB::meanValue(const std::vector<FORB::pDescriptor> &descriptors,
 int FORB::distance(const FORB::TDescriptor &a,
   const FORB::TDescriptor &b)
 {
-  // Bit set count operation from
-  // http://graphics.stanford.edu/~seander/bithacks.html#CountBitsSetParallel
+  return HammingDistance::distance(a.ptr<unsigned char>(),
+    b.ptr<unsigned char>());
+}
 
-  const int *pa = a.ptr<int32_t>();
-  const int *pb = b.ptr<int32_t>();
+// --------------------------------------------------------------------------
 
-  int dist=0;
+void FORB::distances(const FORB::TDescriptor &a, const FORB::pDescriptor *b,
+  int n, int *dist)
+{
+  // descriptor rows handed to the kernel at once
+  const int chunk = 64;
+  const unsigned char *rows[chunk];
 
-  for(int i=0; i<8; i++, pa++, pb++)
+  for(int i0 = 0; i0 < n; i0 += chunk)
   {
-      unsigned  int v = *pa ^ *pb;
-      v = v - ((v >> 1) & 0x55555555);
-      v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
-      dist += (((v + (v >> 4)) & 0xF0F0F0F) * 0x1010101) >> 24;
+    const int m = std::min(chunk, n - i0);
+    for(int i = 0; i < m; ++i)
+      rows[i] = b[i0 + i]->ptr<unsigned char>();
+    HammingDistance::distances(a.ptr<unsigned char>(), rows, m, dist + i0);
   }
+}
+
+// --------------------------------------------------------------------------
+
+FORB::TDescriptor FORB::view(const unsigned char *p)
+{
+  return cv::Mat(1, L, CV_8U, const_cast<unsigned char*>(p));
+}
 
-  return dist;
+// --------------------------------------------------------------------------
+
+void FORB::toBytes(const FORB::TDescriptor &a, unsigned char *p)
+{
+  memcpy(p, a.ptr<unsigned char>(), L);
+}
+
+// --------------------------------------------------------------------------
+
+int FORB::nearestPacked(const FORB::TDescriptor &a,
+  const unsigned char *packed, int n)
+{
+  // no index when all the distances are 256, the first one is the nearest
+  const int best =
+    HammingDistance::best2Packed(a.ptr<unsigned char>(), packed, n).bestIdx;
+  return best < 0 ? 0 : best;
 }
 
 // --------------------------------------------------------------------------
@@ -46,6 +46,16 @@ public:
    */
   static int distance(const TDescriptor &a, const TDescriptor &b);
 
+  /**
+   * Calculates the distances between a descriptor and n others at once
+   * @param a
+   * @param b n descriptors
+   * @param n
+   * @param dist (out) n distances
+   */
+  static void distances(const TDescriptor &a, const pDescriptor *b, int n,
+    int *dist);
+
   /**
    * Returns a string version of the descriptor
    * @param a descriptor
@@ -53,6 +63,30 @@ public:
    */
   static std::string toString(const TDescriptor &a);
 
+  /**
+   * Returns a 1xL matrix header over the given bytes, without copying them
+   * @param p L bytes
+   * @return descriptor, valid as long as p is
+   */
+  static TDescriptor view(const unsigned char *p);
+
+  /**
+   * Copies the L bytes of a descriptor
+   * @param a descriptor
+   * @param p (out) L bytes
+   */
+  static void toBytes(const TDescriptor &a, unsigned char *p);
+
+  /**
+   * Returns the position of the nearest of n descriptors stored one after
+   * the other, the first one on ties
+   * @param a
+   * @param packed n * L bytes
+   * @param n > 0
+   */
+  static int nearestPacked(const TDescriptor &a, const unsigned char *packed,
+    int n);
+
   /**
    * Returns a descriptor from a string
    * @param a descriptor
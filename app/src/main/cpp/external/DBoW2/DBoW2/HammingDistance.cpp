@@ -0,0 +1,324 @@
+/**
+ * File: HammingDistance.cpp
+ * Description: one to many Hamming distance kernels of 256 bit descriptors
+ * License: see the LICENSE.txt file
+ *
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "HammingDistance.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define HAMMING_X86
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace DBoW2 {
+
+namespace {
+
+typedef void (*DistancesFn)(const unsigned char *query,
+  const unsigned char *const *candidates, int n, int *dist);
+
+// Candidates handed to the kernels at once by the packed and best2 variants
+const int CHUNK = 64;
+
+// ---------------------------------------------------------------------------
+
+int distanceScalar(const unsigned char *a, const unsigned char *b)
+{
+  // Bit set count operation from
+  // http://graphics.stanford.edu/~seander/bithacks.html#CountBitsSetParallel
+  int dist = 0;
+  for(int i = 0; i < 8; i++)
+  {
+    uint32_t va, vb;
+    memcpy(&va, a + i * 4, 4);
+    memcpy(&vb, b + i * 4, 4);
+
+    uint32_t v = va ^ vb;
+    v = v - ((v >> 1) & 0x55555555);
+    v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+    dist += (((v + (v >> 4)) & 0xF0F0F0F) * 0x1010101) >> 24;
+  }
+  return dist;
+}
+
+void distancesScalar(const unsigned char *query,
+  const unsigned char *const *candidates, int n, int *dist)
+{
+  for(int i = 0; i < n; i++)
+    dist[i] = distanceScalar(query, candidates[i]);
+}
+
+// ---------------------------------------------------------------------------
+
+#if defined(HAMMING_X86)
+
+__attribute__((target("popcnt")))
+void distancesPopcnt(const unsigned char *query,
+  const unsigned char *const *candidates, int n, int *dist)
+{
+  uint64_t q[4];
+  memcpy(q, query, 32);
+
+  for(int i = 0; i < n; i++)
+  {
+    uint64_t c[4];
+    memcpy(c, candidates[i], 32);
+    dist[i] = (int)(_mm_popcnt_u64(q[0] ^ c[0]) + _mm_popcnt_u64(q[1] ^ c[1]) +
+      _mm_popcnt_u64(q[2] ^ c[2]) + _mm_popcnt_u64(q[3] ^ c[3]));
+  }
+}
+
+// Per byte bit counts of the 32 bytes of x, with a nibble lookup
+__attribute__((target("avx2")))
+inline __m256i popcount8(__m256i x, __m256i lut, __m256i low)
+{
+  const __m256i lo = _mm256_and_si256(x, low);
+  const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), low);
+  return _mm256_add_epi8(_mm256_shuffle_epi8(lut, lo), _mm256_shuffle_epi8(lut, hi));
+}
+
+__attribute__((target("avx2")))
+void distancesAvx2(const unsigned char *query,
+  const unsigned char *const *candidates, int n, int *dist)
+{
+  const __m256i lut = _mm256_setr_epi8(
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low = _mm256_set1_epi8(0x0f);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i q = _mm256_loadu_si256((const __m256i*)query);
+
+  int i = 0;
+  for(; i + 4 <= n; i += 4)
+  {
+    // 4 partial sums of every candidate
+    __m256i s0 = _mm256_sad_epu8(popcount8(_mm256_xor_si256(q,
+      _mm256_loadu_si256((const __m256i*)candidates[i])), lut, low), zero);
+    __m256i s1 = _mm256_sad_epu8(popcount8(_mm256_xor_si256(q,
+      _mm256_loadu_si256((const __m256i*)candidates[i+1])), lut, low), zero);
+    __m256i s2 = _mm256_sad_epu8(popcount8(_mm256_xor_si256(q,
+      _mm256_loadu_si256((const __m256i*)candidates[i+2])), lut, low), zero);
+    __m256i s3 = _mm256_sad_epu8(popcount8(_mm256_xor_si256(q,
+      _mm256_loadu_si256((const __m256i*)candidates[i+3])), lut, low), zero);
+
+    // Reduce the 4 x 4 partial sums to the 4 distances
+    const __m256i s01 = _mm256_add_epi64(_mm256_unpacklo_epi64(s0, s1), _mm256_unpackhi_epi64(s0, s1));
+    const __m256i s23 = _mm256_add_epi64(_mm256_unpacklo_epi64(s2, s3), _mm256_unpackhi_epi64(s2, s3));
+    const __m256i s = _mm256_add_epi64(_mm256_permute2x128_si256(s01, s23, 0x20),
+      _mm256_permute2x128_si256(s01, s23, 0x31));
+    const __m256i packed = _mm256_permutevar8x32_epi32(s, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+    _mm_storeu_si128((__m128i*)(dist + i), _mm256_castsi256_si128(packed));
+  }
+
+  for(; i < n; i++)
+  {
+    const __m256i s = _mm256_sad_epu8(popcount8(_mm256_xor_si256(q,
+      _mm256_loadu_si256((const __m256i*)candidates[i])), lut, low), zero);
+    const __m128i h = _mm_add_epi64(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+    dist[i] = _mm_cvtsi128_si32(_mm_add_epi64(h, _mm_unpackhi_epi64(h, h)));
+  }
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+
+#if defined(__ARM_NEON)
+
+void distancesNeon(const unsigned char *query,
+  const unsigned char *const *candidates, int n, int *dist)
+{
+  const uint8x16_t q0 = vld1q_u8(query);
+  const uint8x16_t q1 = vld1q_u8(query + 16);
+
+  for(int i = 0; i < n; i++)
+  {
+    const unsigned char *c = candidates[i];
+    // At most 16 per lane
+    const uint8x16_t cnt = vaddq_u8(vcntq_u8(veorq_u8(q0, vld1q_u8(c))),
+      vcntq_u8(veorq_u8(q1, vld1q_u8(c + 16))));
+#if defined(__aarch64__)
+    dist[i] = vaddlvq_u8(cnt);
+#else
+    const uint64x2_t s = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(cnt)));
+    dist[i] = (int)(vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1));
+#endif
+  }
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+
+DistancesFn implFn(HammingDistance::Impl impl)
+{
+  switch(impl)
+  {
+#if defined(HAMMING_X86)
+    case HammingDistance::IMPL_POPCNT: return distancesPopcnt;
+    case HammingDistance::IMPL_AVX2: return distancesAvx2;
+#endif
+#if defined(__ARM_NEON)
+    case HammingDistance::IMPL_NEON: return distancesNeon;
+#endif
+    default: return distancesScalar;
+  }
+}
+
+DistancesFn bestFn()
+{
+  static const DistancesFn fn = implFn(HammingDistance::bestImpl());
+  return fn;
+}
+
+void updateBest2(const int *dist, int n, int offset, HammingMatch &match)
+{
+  for(int i = 0; i < n; i++)
+  {
+    if(dist[i] < match.bestDist)
+    {
+      match.secondDist = match.bestDist;
+      match.secondIdx = match.bestIdx;
+      match.bestDist = dist[i];
+      match.bestIdx = offset + i;
+    }
+    else if(dist[i] < match.secondDist)
+    {
+      match.secondDist = dist[i];
+      match.secondIdx = offset + i;
+    }
+  }
+}
+
+} // namespace
+
+// --------------------------------------------------------------------------
+
+HammingDistance::Impl HammingDistance::bestImpl()
+{
+#if defined(__ARM_NEON)
+  return IMPL_NEON;
+#else
+  if(supported(IMPL_AVX2)) return IMPL_AVX2;
+  if(supported(IMPL_POPCNT)) return IMPL_POPCNT;
+  return IMPL_SCALAR;
+#endif
+}
+
+// --------------------------------------------------------------------------
+
+bool HammingDistance::supported(Impl impl)
+{
+  switch(impl)
+  {
+    case IMPL_SCALAR: return true;
+#if defined(HAMMING_X86)
+    case IMPL_POPCNT: return __builtin_cpu_supports("popcnt");
+    case IMPL_AVX2: return __builtin_cpu_supports("avx2");
+#endif
+#if defined(__ARM_NEON)
+    case IMPL_NEON: return true;
+#endif
+    default: return false;
+  }
+}
+
+// --------------------------------------------------------------------------
+
+const char* HammingDistance::implName(Impl impl)
+{
+  switch(impl)
+  {
+    case IMPL_POPCNT: return "popcnt";
+    case IMPL_AVX2: return "avx2";
+    case IMPL_NEON: return "neon";
+    default: return "scalar";
+  }
+}
+
+// --------------------------------------------------------------------------
+
+int HammingDistance::distance(const unsigned char *a, const unsigned char *b)
+{
+  int dist;
+  bestFn()(a, &b, 1, &dist);
+  return dist;
+}
+
+// --------------------------------------------------------------------------
+
+void HammingDistance::distances(const unsigned char *query,
+  const unsigned char *const *candidates, int n, int *dist)
+{
+  bestFn()(query, candidates, n, dist);
+}
+
+// --------------------------------------------------------------------------
+
+void HammingDistance::distances(const unsigned char *query,
+  const unsigned char *const *candidates, int n, int *dist, Impl impl)
+{
+  implFn(impl)(query, candidates, n, dist);
+}
+
+// --------------------------------------------------------------------------
+
+void HammingDistance::distancesPacked(const unsigned char *query,
+  const unsigned char *packed, int n, int *dist)
+{
+  const unsigned char *candidates[CHUNK];
+  for(int i0 = 0; i0 < n; i0 += CHUNK)
+  {
+    const int m = n - i0 < CHUNK ? n - i0 : CHUNK;
+    for(int i = 0; i < m; i++)
+      candidates[i] = packed + (size_t)(i0 + i) * L;
+    bestFn()(query, candidates, m, dist + i0);
+  }
+}
+
+// --------------------------------------------------------------------------
+
+HammingMatch HammingDistance::best2(const unsigned char *query,
+  const unsigned char *const *candidates, int n)
+{
+  HammingMatch match = { 256, 256, -1, -1 };
+  int dist[CHUNK];
+  for(int i0 = 0; i0 < n; i0 += CHUNK)
+  {
+    const int m = n - i0 < CHUNK ? n - i0 : CHUNK;
+    bestFn()(query, candidates + i0, m, dist);
+    updateBest2(dist, m, i0, match);
+  }
+  return match;
+}
+
+// --------------------------------------------------------------------------
+
+HammingMatch HammingDistance::best2Packed(const unsigned char *query,
+  const unsigned char *packed, int n)
+{
+  HammingMatch match = { 256, 256, -1, -1 };
+  const unsigned char *candidates[CHUNK];
+  int dist[CHUNK];
+  for(int i0 = 0; i0 < n; i0 += CHUNK)
+  {
+    const int m = n - i0 < CHUNK ? n - i0 : CHUNK;
+    for(int i = 0; i < m; i++)
+      candidates[i] = packed + (size_t)(i0 + i) * L;
+    bestFn()(query, candidates, m, dist);
+    updateBest2(dist, m, i0, match);
+  }
+  return match;
+}
+
+// --------------------------------------------------------------------------
+
+} // namespace DBoW2
@@ -0,0 +1,101 @@
+/**
+ * File: HammingDistance.h
+ * Description: one to many Hamming distance kernels of 256 bit descriptors
+ * License: see the LICENSE.txt file
+ *
+ */
+
+#ifndef __D_T_HAMMING_DISTANCE__
+#define __D_T_HAMMING_DISTANCE__
+
+namespace DBoW2 {
+
+/// Best and second best candidates of a query
+struct HammingMatch
+{
+  /// Distances, 256 when there is no such candidate
+  int bestDist;
+  int secondDist;
+  /// Positions in the candidate list, -1 when there is no such candidate
+  int bestIdx;
+  int secondIdx;
+};
+
+/// Hamming distances between 256 bit (32 byte) descriptors such as ORB.
+/**
+ * The one to many functions compare a query against a list of candidates,
+ * given as pointers or packed one after the other, with the fastest
+ * implementation the cpu supports: AVX2 or POPCNT on x86, NEON vcnt on ARM.
+ */
+class HammingDistance
+{
+public:
+
+  /// Descriptor length (in bytes)
+  static const int L = 32;
+
+  enum Impl
+  {
+    IMPL_SCALAR = 0,
+    IMPL_POPCNT,
+    IMPL_AVX2,
+    IMPL_NEON
+  };
+
+  /**
+   * Fastest implementation supported by the build and the running cpu
+   */
+  static Impl bestImpl();
+
+  /**
+   * @return whether impl can run on this build and cpu
+   */
+  static bool supported(Impl impl);
+
+  static const char* implName(Impl impl);
+
+  /**
+   * Distance between two descriptors
+   */
+  static int distance(const unsigned char *a, const unsigned char *b);
+
+  /**
+   * Distances between query and n descriptors
+   * @param query
+   * @param candidates n descriptor pointers
+   * @param n
+   * @param dist (out) n distances
+   */
+  static void distances(const unsigned char *query,
+    const unsigned char *const *candidates, int n, int *dist);
+
+  /**
+   * Same as distances() with the given implementation, which must be supported
+   */
+  static void distances(const unsigned char *query,
+    const unsigned char *const *candidates, int n, int *dist, Impl impl);
+
+  /**
+   * Distances between query and n descriptors stored one after the other
+   * @param query
+   * @param packed n * L bytes
+   * @param n
+   * @param dist (out) n distances
+   */
+  static void distancesPacked(const unsigned char *query,
+    const unsigned char *packed, int n, int *dist);
+
+  /**
+   * Best and second best of n candidates. Ties keep the first candidate,
+   * as a loop updating on strictly smaller distances does.
+   */
+  static HammingMatch best2(const unsigned char *query,
+    const unsigned char *const *candidates, int n);
+
+  static HammingMatch best2Packed(const unsigned char *query,
+    const unsigned char *packed, int n);
+};
+
+} // namespace DBoW2
+
+#endif
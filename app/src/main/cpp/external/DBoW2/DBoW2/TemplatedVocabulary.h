@@ -18,15 +18,24 @@
 #define __D_T_TEMPLATED_VOCABULARY__
 
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 
 #include <vector>
 #include <numeric>
 #include <fstream>
 #include <string>
 #include <algorithm>
+#include <functional>
+#include <memory>
 #include <opencv2/core/core.hpp>
 #include <limits>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "FeatureVector.h"
 #include "BowVector.h"
 #include "ScoringObject.h"
@@ -44,6 +53,11 @@ template<class TDescriptor, class F>
 class TemplatedVocabulary
 {		
 public:
+
+  /// Runs f(0) ... f(n-1), possibly in parallel, and returns when all of
+  /// them are done
+  typedef std::function<void(int n, const std::function<void(int)> &f)>
+    ParallelFor;
   
   /**
    * Initiates an empty vocabulary
@@ -145,6 +159,33 @@ public:
   virtual void transform(const std::vector<TDescriptor>& features,
     BowVector &v, FeatureVector &fv, int levelsup) const;
 
+  /**
+   * Transform n descriptors stored one after the other into a bow vector
+   * and a feature vector, without a descriptor object per feature
+   * @param features n * F::L bytes
+   * @param n
+   * @param v (out) bow vector
+   * @param fv (out) feature vector of nodes and feature indexes
+   * @param levelsup levels to go up the vocabulary tree to get the node index
+   */
+  virtual void transform(const unsigned char *features, int n,
+    BowVector &v, FeatureVector &fv, int levelsup) const;
+
+  /**
+   * Transform n descriptors stored one after the other into a bow vector
+   * and a feature vector, sending blocks of features down the tree in
+   * parallel. The vectors are the same as the serial transform's.
+   * @param features n * F::L bytes
+   * @param n
+   * @param v (out) bow vector
+   * @param fv (out) feature vector of nodes and feature indexes
+   * @param levelsup levels to go up the vocabulary tree to get the node index
+   * @param parallel_for runs the blocks
+   */
+  virtual void transform(const unsigned char *features, int n,
+    BowVector &v, FeatureVector &fv, int levelsup,
+    const ParallelFor &parallel_for) const;
+
   /**
    * Transforms a single feature into a word (without weight)
    * @param feature
@@ -243,6 +284,40 @@ public:
 
   bool loadFromAndroidTextFile(std::string file_buffer);
 
+  /**
+   * Saves the vocabulary into a binary file (see BinaryHeader), which
+   * loads without any parsing
+   * @param filename
+   * @return false if the file could not be written
+   */
+  bool saveToBinaryFile(const std::string &filename) const;
+
+  /**
+   * Loads the vocabulary from a binary file, mapped in memory as long as
+   * the vocabulary uses it
+   * @param filename
+   */
+  bool loadFromBinaryFile(const std::string &filename);
+
+  /**
+   * Loads the vocabulary from the contents of a binary file. The node
+   * descriptors are views of the buffer, which must not change while the
+   * vocabulary uses it
+   * @param data file contents
+   * @param size
+   * @param owner keeps data alive, released when the vocabulary is loaded
+   *   again, created or destroyed
+   */
+  bool loadFromBinaryBuffer(const void *data, size_t size,
+    std::shared_ptr<const void> owner);
+
+  /**
+   * Returns whether a buffer starts with the header of a binary vocabulary
+   * @param data
+   * @param size
+   */
+  static bool isBinary(const void *data, size_t size);
+
 
   /**
    * Saves the vocabulary into a text file
@@ -332,6 +407,46 @@ protected:
     inline bool isLeaf() const { return children.empty(); }
   };
 
+  /// Children of a node in the flat layout: slots [first, first + count)
+  struct FlatNode
+  {
+    uint32_t first;
+    uint32_t count;
+  };
+
+  /// Header of the binary vocabulary files, in native byte order. It is
+  /// followed by the parent of every node (uint32_t), the weight of every
+  /// node (double), the node of every word (uint32_t), then the flat layout
+  /// of the tree: the FlatNode of every node, the node in every slot
+  /// (uint32_t) and the descriptor in every slot (F::L bytes). Each array
+  /// starts on a multiple of 32 bytes from the beginning of the file.
+  struct BinaryHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t descriptor_bytes;
+    int32_t k;
+    int32_t L;
+    int32_t scoring;
+    int32_t weighting;
+    uint32_t nodes;
+    uint32_t words;
+  };
+
+  /// Offsets of the arrays of a binary file, and its size
+  struct BinaryLayout
+  {
+    size_t parents;
+    size_t weights;
+    size_t words;
+    size_t flat_nodes;
+    size_t flat_children;
+    size_t flat_descriptors;
+    size_t size;
+
+    BinaryLayout(size_t nodes, size_t words);
+  };
+
 protected:
 
   /**
@@ -397,6 +512,19 @@ protected:
    * Create the words of the vocabulary once the tree has been built
    */
   void createWords();
+
+  /**
+   * Lays the tree out flat (see m_flat_nodes) from m_nodes, with the
+   * descriptors copied in m_flat_storage, then makes the node descriptors
+   * views of the flat ones
+   */
+  void buildFlatTree();
+
+  /**
+   * Makes the descriptor of every node but the root a view of its slot in
+   * m_flat_descriptors
+   */
+  void bindFlatDescriptors();
   
   /**
    * Sets the weights of the nodes of tree according to the given features.
@@ -405,6 +533,20 @@ protected:
    * @param features
    */
   void setNodeWeights(const vector<vector<TDescriptor> > &features);
+
+  /**
+   * Transform n features into a bow vector and a feature vector
+   * @param feature function returning the i-th feature
+   * @param n
+   * @param v (out) bow vector
+   * @param fv (out) feature vector of nodes and feature indexes
+   * @param levelsup levels to go up the vocabulary tree to get the node index
+   * @param parallel_for if given, runs the descent of blocks of features
+   */
+  template<class GetFeature>
+  void transformFeatures(GetFeature feature, size_t n,
+    BowVector &v, FeatureVector &fv, int levelsup,
+    const ParallelFor *parallel_for = NULL) const;
   
 protected:
 
@@ -429,6 +571,22 @@ protected:
   /// Words of the vocabulary (tree leaves)
   /// this condition holds: m_words[wid]->word_id == wid
   std::vector<Node*> m_words;
+
+  /// Tree laid out for the descent: the children of a node take
+  /// consecutive slots, with their descriptors packed one after the other,
+  /// and the nodes are given their slots in breadth first order. Going down
+  /// a level compares the feature with a single block of descriptors.
+  /// Flat node of every node id
+  std::vector<FlatNode> m_flat_nodes;
+  /// Node id in every slot
+  std::vector<NodeId> m_flat_children;
+  /// Descriptor in every slot, F::L bytes each, in m_flat_storage or in
+  /// m_storage. The node descriptors are views of these.
+  const unsigned char *m_flat_descriptors;
+  std::vector<unsigned char> m_flat_storage;
+
+  /// Buffer of the binary file the flat descriptors are read from in place
+  std::shared_ptr<const void> m_storage;
   
 };
 
@@ -438,7 +596,7 @@ template<class TDescriptor, class F>
 TemplatedVocabulary<TDescriptor,F>::TemplatedVocabulary
   (int k, int L, WeightingType weighting, ScoringType scoring)
   : m_k(k), m_L(L), m_weighting(weighting), m_scoring(scoring),
-  m_scoring_object(NULL)
+  m_scoring_object(NULL), m_flat_descriptors(NULL)
 {
   createScoringObject();
 }
@@ -447,7 +605,8 @@ TemplatedVocabulary<TDescriptor,F>::TemplatedVocabulary
 
 template<class TDescriptor, class F>
 TemplatedVocabulary<TDescriptor,F>::TemplatedVocabulary
-  (const std::string &filename): m_scoring_object(NULL)
+  (const std::string &filename): m_scoring_object(NULL),
+  m_flat_descriptors(NULL)
 {
   load(filename);
 }
@@ -456,7 +615,8 @@ TemplatedVocabulary<TDescriptor,F>::TemplatedVocabulary
 
 template<class TDescriptor, class F>
 TemplatedVocabulary<TDescriptor,F>::TemplatedVocabulary
-  (const char *filename): m_scoring_object(NULL)
+  (const char *filename): m_scoring_object(NULL),
+  m_flat_descriptors(NULL)
 {
   load(filename);
 }
@@ -520,7 +680,7 @@ void TemplatedVocabulary<TDescriptor,F>::setWeightingType(WeightingType type)
 template<class TDescriptor, class F>
 TemplatedVocabulary<TDescriptor,F>::TemplatedVocabulary(
   const TemplatedVocabulary<TDescriptor, F> &voc)
-  : m_scoring_object(NULL)
+  : m_scoring_object(NULL), m_flat_descriptors(NULL)
 {
   *this = voc;
 }
@@ -551,6 +711,20 @@ TemplatedVocabulary<TDescriptor,F>::operator=
   this->m_words.clear();
   
   this->m_nodes = voc.m_nodes;
+  this->m_flat_nodes = voc.m_flat_nodes;
+  this->m_flat_children = voc.m_flat_children;
+  this->m_storage = voc.m_storage;
+  if(voc.m_storage)
+  {
+    this->m_flat_storage.clear();
+    this->m_flat_descriptors = voc.m_flat_descriptors;
+  }
+  else
+  {
+    this->m_flat_storage = voc.m_flat_storage;
+    this->m_flat_descriptors = this->m_flat_storage.data();
+  }
+  this->bindFlatDescriptors();
   this->createWords();
   
   return *this;
@@ -564,6 +738,7 @@ void TemplatedVocabulary<TDescriptor,F>::create(
 {
   m_nodes.clear();
   m_words.clear();
+  m_storage.reset();
   
   // expected_nodes = Sum_{i=0..L} ( k^i )
 	int expected_nodes = 
@@ -587,6 +762,8 @@ void TemplatedVocabulary<TDescriptor,F>::create(
 
   // and set the weight of each node of the tree
   setNodeWeights(training_features);
+
+  buildFlatTree();
   
 }
 
@@ -1131,6 +1308,43 @@ template<class TDescriptor, class F>
 void TemplatedVocabulary<TDescriptor,F>::transform(
   const std::vector<TDescriptor>& features,
   BowVector &v, FeatureVector &fv, int levelsup) const
+{
+  transformFeatures([&features](size_t i) -> const TDescriptor&
+    { return features[i]; }, features.size(), v, fv, levelsup);
+}
+
+// --------------------------------------------------------------------------
+
+template<class TDescriptor, class F> 
+void TemplatedVocabulary<TDescriptor,F>::transform(
+  const unsigned char *features, int n,
+  BowVector &v, FeatureVector &fv, int levelsup) const
+{
+  transformFeatures([features](size_t i)
+    { return F::view(features + i * F::L); }, n, v, fv, levelsup);
+}
+
+// --------------------------------------------------------------------------
+
+template<class TDescriptor, class F> 
+void TemplatedVocabulary<TDescriptor,F>::transform(
+  const unsigned char *features, int n,
+  BowVector &v, FeatureVector &fv, int levelsup,
+  const ParallelFor &parallel_for) const
+{
+  transformFeatures([features](size_t i)
+    { return F::view(features + i * F::L); }, n, v, fv, levelsup,
+    &parallel_for);
+}
+
+// --------------------------------------------------------------------------
+
+template<class TDescriptor, class F> 
+template<class GetFeature>
+void TemplatedVocabulary<TDescriptor,F>::transformFeatures(
+  GetFeature feature, size_t n,
+  BowVector &v, FeatureVector &fv, int levelsup,
+  const ParallelFor *parallel_for) const
 {
   v.clear();
   fv.clear();
@@ -1139,24 +1353,54 @@ void TemplatedVocabulary<TDescriptor,F>::transform(
   {
     return;
   }
+
+  // in parallel, the words of blocks of features are found first, then
+  // added in the order of the features as in the serial case
+  const size_t block = 64;
+  vector<WordId> words;
+  vector<WordValue> weights;
+  vector<NodeId> nodes;
+  if(parallel_for != NULL && n > block)
+  {
+    words.resize(n);
+    weights.resize(n);
+    nodes.resize(n);
+    (*parallel_for)((n + block - 1) / block, [&](int b)
+    {
+      const size_t end = std::min(n, (b + 1) * block);
+      for(size_t i = b * block; i < end; ++i)
+        transform(feature(i), words[i], weights[i], &nodes[i], levelsup);
+    });
+  }
+
+  auto descend = [&](size_t i, WordId &id, WordValue &w, NodeId &nid)
+  {
+    if(words.empty())
+    {
+      transform(feature(i), id, w, &nid, levelsup);
+    }
+    else
+    {
+      id = words[i];
+      w = weights[i];
+      nid = nodes[i];
+    }
+  };
   
   // normalize 
   LNorm norm;
   bool must = m_scoring_object->mustNormalize(norm);
   
-  typename vector<TDescriptor>::const_iterator fit;
-  
   if(m_weighting == TF || m_weighting == TF_IDF)
   {
-    unsigned int i_feature = 0;
-    for(fit = features.begin(); fit < features.end(); ++fit, ++i_feature)
+    for(unsigned int i_feature = 0; i_feature < n; ++i_feature)
     {
       WordId id;
       NodeId nid;
       WordValue w; 
       // w is the idf value if TF_IDF, 1 if TF
       
-      transform(*fit, id, w, &nid, levelsup);
+      descend(i_feature, id, w, nid);
       
       if(w > 0) // not stopped
       { 
@@ -1176,15 +1420,14 @@ void TemplatedVocabulary<TDescriptor,F>::transform(
   }
   else // IDF || BINARY
   {
-    unsigned int i_feature = 0;
-    for(fit = features.begin(); fit < features.end(); ++fit, ++i_feature)
+    for(unsigned int i_feature = 0; i_feature < n; ++i_feature)
     {
       WordId id;
       NodeId nid;
       WordValue w;
       // w is idf if IDF, or 1 if BINARY
       
-      transform(*fit, id, w, &nid, levelsup);
+      descend(i_feature, id, w, nid);
       
       if(w > 0) // not stopped
       {
@@ -1222,9 +1465,9 @@ template<class TDescriptor, class F>
 void TemplatedVocabulary<TDescriptor,F>::transform(const TDescriptor &feature, 
   WordId &word_id, WordValue &weight, NodeId *nid, int levelsup) const
 { 
-  // propagate the feature down the tree
-  vector<NodeId> nodes;
-  typename vector<NodeId>::const_iterator nit;
+  // propagate the feature down the tree, comparing it with the packed
+  // descriptors of the children of a node at once
+  // (the first child wins ties)
 
   // level at which the node must be stored in nid, if given
   const int nid_level = m_L - levelsup;
@@ -1236,26 +1479,15 @@ void TemplatedVocabulary<TDescriptor,F>::transform(const TDescriptor &feature,
   do
   {
     ++current_level;
-    nodes = m_nodes[final_id].children;
-    final_id = nodes[0];
- 
-    double best_d = F::distance(feature, m_nodes[final_id].descriptor);
-
-    for(nit = nodes.begin() + 1; nit != nodes.end(); ++nit)
-    {
-      NodeId id = *nit;
-      double d = F::distance(feature, m_nodes[id].descriptor);
-      if(d < best_d)
-      {
-        best_d = d;
-        final_id = id;
-      }
-    }
+    const FlatNode &node = m_flat_nodes[final_id];
+    const int best = F::nearestPacked(feature,
+      m_flat_descriptors + (size_t)node.first * F::L, node.count);
+    final_id = m_flat_children[node.first + best];
     
     if(nid != NULL && current_level == nid_level)
       *nid = final_id;
     
-  } while( !m_nodes[final_id].isLeaf() );
+  } while( m_flat_nodes[final_id].count > 0 );
 
   // turn node id into word id
   word_id = m_nodes[final_id].word_id;
@@ -1349,6 +1581,7 @@ bool TemplatedVocabulary<TDescriptor,F>::loadFromTextFile(const std::string &fil
 
     m_words.clear();
     m_nodes.clear();
+    m_storage.reset();
 
     string s;
     getline(f,s);
@@ -1423,6 +1656,7 @@ bool TemplatedVocabulary<TDescriptor,F>::loadFromTextFile(const std::string &fil
         }
     }
 
+    buildFlatTree();
     return true;
 
 }
@@ -1436,6 +1670,7 @@ bool TemplatedVocabulary<TDescriptor, F>::loadFromAndroidTextFile(std::string fi
 
     m_words.clear();
     m_nodes.clear();
+    m_storage.reset();
 
     string s;
     getline(iss, s);
@@ -1510,9 +1745,286 @@ bool TemplatedVocabulary<TDescriptor, F>::loadFromAndroidTextFile(std::string fi
         }
     }
 
+    buildFlatTree();
     return true;
 }
 
+// --------------------------------------------------------------------------
+
+template<class TDescriptor, class F>
+TemplatedVocabulary<TDescriptor,F>::BinaryLayout::BinaryLayout(
+  size_t nodes, size_t words)
+{
+  const size_t a = 32;
+  parents = (sizeof(BinaryHeader) + a - 1) / a * a;
+  weights = (parents + nodes * sizeof(uint32_t) + a - 1) / a * a;
+  this->words = (weights + nodes * sizeof(double) + a - 1) / a * a;
+  flat_nodes = (this->words + words * sizeof(uint32_t) + a - 1) / a * a;
+  flat_children = (flat_nodes + nodes * sizeof(FlatNode) + a - 1) / a * a;
+  flat_descriptors =
+    (flat_children + (nodes - 1) * sizeof(uint32_t) + a - 1) / a * a;
+  size = flat_descriptors + (nodes - 1) * F::L;
+}
+
+// --------------------------------------------------------------------------
+
+template<class TDescriptor, class F>
+bool TemplatedVocabulary<TDescriptor,F>::isBinary(const void *data,
+  size_t size)
+{
+  return size >= sizeof(BinaryHeader) &&
+    memcmp(data, "DBoW2BIN", 8) == 0;
+}
+
+// --------------------------------------------------------------------------
+
+template<class TDescriptor, class F>
+bool TemplatedVocabulary<TDescriptor,F>::saveToBinaryFile(
+  const std::string &filename) const
+{
+  if(m_nodes.empty()) return false;
+
+  BinaryHeader header;
+  memcpy(header.magic, "DBoW2BIN", 8);
+  header.version = 2;
+  header.descriptor_bytes = F::L;
+  header.k = m_k;
+  header.L = m_L;
+  header.scoring = m_scoring;
+  header.weighting = m_weighting;
+  header.nodes = m_nodes.size();
+  header.words = m_words.size();
+
+  const BinaryLayout layout(m_nodes.size(), m_words.size());
+  vector<unsigned char> buffer(layout.size, 0);
+  memcpy(buffer.data(), &header, sizeof(header));
+
+  for(size_t i = 0; i < m_nodes.size(); ++i)
+  {
+    const Node &node = m_nodes[i];
+    const uint32_t parent = node.parent;
+    const double weight = node.weight;
+    memcpy(&buffer[layout.parents + i * sizeof(uint32_t)], &parent,
+      sizeof(parent));
+    memcpy(&buffer[layout.weights + i * sizeof(double)], &weight,
+      sizeof(weight));
+  }
+
+  for(size_t i = 0; i < m_words.size(); ++i)
+  {
+    const uint32_t nid = m_words[i]->id;
+    memcpy(&buffer[layout.words + i * sizeof(uint32_t)], &nid, sizeof(nid));
+  }
+
+  memcpy(&buffer[layout.flat_nodes], m_flat_nodes.data(),
+    m_flat_nodes.size() * sizeof(FlatNode));
+  for(size_t s = 0; s < m_flat_children.size(); ++s)
+  {
+    const uint32_t nid = m_flat_children[s];
+    memcpy(&buffer[layout.flat_children + s * sizeof(uint32_t)], &nid,
+      sizeof(nid));
+  }
+  memcpy(&buffer[layout.flat_descriptors], m_flat_descriptors,
+    m_flat_children.size() * F::L);
+
+  ofstream f(filename.c_str(), ios_base::out | ios_base::binary);
+  f.write((const char*)buffer.data(), buffer.size());
+  return f.good();
+}
+
+// --------------------------------------------------------------------------
+
+template<class TDescriptor, class F>
+bool TemplatedVocabulary<TDescriptor,F>::loadFromBinaryFile(
+  const std::string &filename)
+{
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if(fd < 0) return false;
+
+  struct stat st;
+  if(fstat(fd, &st) != 0 || st.st_size <= 0)
+  {
+    close(fd);
+    return false;
+  }
+
+  const size_t size = st.st_size;
+  void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(data == MAP_FAILED) return false;
+
+  std::shared_ptr<const void> owner(data,
+    [size](const void *p){ munmap(const_cast<void*>(p), size); });
+  return loadFromBinaryBuffer(data, size, std::move(owner));
+}
+
+// --------------------------------------------------------------------------
+
+template<class TDescriptor, class F>
+bool TemplatedVocabulary<TDescriptor,F>::loadFromBinaryBuffer(
+  const void *data, size_t size, std::shared_ptr<const void> owner)
+{
+  m_words.clear();
+  m_nodes.clear();
+  m_flat_nodes.clear();
+  m_flat_children.clear();
+  m_flat_storage.clear();
+  m_flat_descriptors = NULL;
+  m_storage.reset();
+
+  BinaryHeader header;
+  if(isBinary(data, size)) memcpy(&header, data, sizeof(header));
+
+  if(!isBinary(data, size) || header.version != 2 ||
+    header.descriptor_bytes != (uint32_t)F::L || header.nodes == 0 ||
+    header.k < 0 || header.k > 20 || header.L < 1 || header.L > 10 ||
+    header.scoring < 0 || header.scoring > 5 ||
+    header.weighting < 0 || header.weighting > 3 ||
+    BinaryLayout(header.nodes, header.words).size > size)
+  {
+    std::cerr << "Vocabulary loading failure: This is not a correct binary file!" << endl;
+    return false;
+  }
+
+  const unsigned char *bytes = static_cast<const unsigned char*>(data);
+  const BinaryLayout layout(header.nodes, header.words);
+  const uint32_t N = header.nodes;
+
+  m_k = header.k;
+  m_L = header.L;
+  m_scoring = (ScoringType)header.scoring;
+  m_weighting = (WeightingType)header.weighting;
+  createScoringObject();
+
+  // every node but the root takes one slot, and its children take slots
+  // after its own one (breadth first), in the order of the text files
+  m_flat_nodes.resize(N);
+  memcpy(m_flat_nodes.data(), bytes + layout.flat_nodes,
+    N * sizeof(FlatNode));
+  m_flat_children.resize(N - 1);
+  for(uint32_t s = 0; s + 1 < N; ++s)
+  {
+    uint32_t nid;
+    memcpy(&nid, bytes + layout.flat_children + s * sizeof(uint32_t),
+      sizeof(nid));
+    m_flat_children[s] = nid;
+  }
+
+  // parents come before their children, as in the text files, so that the
+  // descent always ends
+  vector<uint32_t> parents(N);
+  memcpy(parents.data(), bytes + layout.parents, N * sizeof(uint32_t));
+
+  bool correct = true;
+  for(uint32_t nid = 1; correct && nid < N; ++nid)
+    correct = parents[nid] < nid;
+  for(uint32_t nid = 0; correct && nid < N; ++nid)
+  {
+    const FlatNode &flat = m_flat_nodes[nid];
+    correct = flat.first <= N - 1 && flat.count <= N - 1 - flat.first;
+    for(uint32_t s = flat.first; correct && s < flat.first + flat.count; ++s)
+      correct = m_flat_children[s] < N && parents[m_flat_children[s]] == nid
+        && m_flat_children[s] != 0;
+  }
+  if(!correct)
+  {
+    std::cerr << "Vocabulary loading failure: This is not a correct binary file!" << endl;
+    m_flat_nodes.clear();
+    m_flat_children.clear();
+    return false;
+  }
+
+  m_nodes.resize(N);
+  for(uint32_t nid = 0; nid < N; ++nid)
+  {
+    Node &node = m_nodes[nid];
+    node.id = nid;
+    node.parent = parents[nid];
+    double weight;
+    memcpy(&weight, bytes + layout.weights + nid * sizeof(double),
+      sizeof(weight));
+    node.weight = weight;
+
+    const FlatNode &flat = m_flat_nodes[nid];
+    node.children.assign(m_flat_children.begin() + flat.first,
+      m_flat_children.begin() + flat.first + flat.count);
+  }
+
+  m_flat_descriptors = bytes + layout.flat_descriptors;
+  bindFlatDescriptors();
+
+  m_words.resize(header.words);
+  for(uint32_t wid = 0; wid < header.words; ++wid)
+  {
+    uint32_t nid;
+    memcpy(&nid, bytes + layout.words + wid * sizeof(uint32_t), sizeof(nid));
+    if(nid == 0 || nid >= N)
+    {
+      std::cerr << "Vocabulary loading failure: This is not a correct binary file!" << endl;
+      m_words.clear();
+      m_nodes.clear();
+      m_flat_nodes.clear();
+      m_flat_children.clear();
+      m_flat_descriptors = NULL;
+      return false;
+    }
+    m_nodes[nid].word_id = wid;
+    m_words[wid] = &m_nodes[nid];
+  }
+
+  m_storage = std::move(owner);
+  return true;
+}
+
+// --------------------------------------------------------------------------
+
+template<class TDescriptor, class F>
+void TemplatedVocabulary<TDescriptor,F>::buildFlatTree()
+{
+  m_flat_nodes.assign(m_nodes.size(), FlatNode());
+  m_flat_children.clear();
+  m_flat_storage.clear();
+  m_flat_descriptors = NULL;
+  m_storage.reset();
+  if(m_nodes.empty()) return;
+
+  m_flat_children.reserve(m_nodes.size() - 1);
+  m_flat_storage.resize((m_nodes.size() - 1) * F::L);
+
+  // breadth first: the slots of a node's children are given when the node
+  // is visited, the visit order being the slot order
+  m_flat_nodes[0].first = 0;
+  m_flat_nodes[0].count = m_nodes[0].children.size();
+  m_flat_children.assign(m_nodes[0].children.begin(),
+    m_nodes[0].children.end());
+
+  for(size_t slot = 0; slot < m_flat_children.size(); ++slot)
+  {
+    const Node &node = m_nodes[m_flat_children[slot]];
+    F::toBytes(node.descriptor, &m_flat_storage[slot * F::L]);
+
+    FlatNode &flat = m_flat_nodes[node.id];
+    flat.first = m_flat_children.size();
+    flat.count = node.children.size();
+    m_flat_children.insert(m_flat_children.end(), node.children.begin(),
+      node.children.end());
+  }
+
+  m_flat_storage.resize(m_flat_children.size() * F::L);
+  m_flat_descriptors = m_flat_storage.data();
+  bindFlatDescriptors();
+}
+
+// --------------------------------------------------------------------------
+
+template<class TDescriptor, class F>
+void TemplatedVocabulary<TDescriptor,F>::bindFlatDescriptors()
+{
+  for(size_t slot = 0; slot < m_flat_children.size(); ++slot)
+    m_nodes[m_flat_children[slot]].descriptor =
+      F::view(m_flat_descriptors + slot * F::L);
+}
+
 
 // --------------------------------------------------------------------------
 
@@ -1666,6 +2178,7 @@ void TemplatedVocabulary<TDescriptor,F>::load(const cv::FileStorage &fs,
 {
   m_words.clear();
   m_nodes.clear();
+  m_storage.reset();
   
   cv::FileNode fvoc = fs[name];
   
@@ -1710,6 +2223,8 @@ void TemplatedVocabulary<TDescriptor,F>::load(const cv::FileStorage &fs,
     m_nodes[nid].word_id = wid;
     m_words[wid] = &m_nodes[nid];
   }
+
+  buildFlatTree();
 }
 
 // --------------------------------------------------------------------------
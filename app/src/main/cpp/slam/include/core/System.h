@@ -182,10 +182,15 @@ public:
 
     void ChangeDataset();
 
+    // Blocks until local mapping and loop closing have processed every inserted keyframe and no
+    // global BA is running. Used for replays with a reproducible thread interleaving.
+    void WaitUntilIdle();
+
     float GetImageScale();
 
     Atlas& getAtlas() const { return *mpAtlas; }
     Tracking& getTracker() const;
+    LocalMapping& getLocalMapper() const;
 
     int getTrackingState() const { return mTrackingState; }
 
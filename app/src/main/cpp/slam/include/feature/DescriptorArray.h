@@ -0,0 +1,104 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef DESCRIPTORARRAY_H
+#define DESCRIPTORARRAY_H
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+namespace ORB_SLAM3
+{
+
+// One ORB descriptor (256 bits), aligned so that the Hamming kernels load it in whole vectors.
+struct alignas(32) PackedDescriptor
+{
+    static const int L = 32;
+
+    const unsigned char* Data() const
+    {
+        return data;
+    }
+
+    unsigned char data[L];
+};
+
+// Descriptors of a frame stored one after the other in 32 byte aligned memory. Rows are read through plain
+// pointers, without the header and reference count of cv::Mat::row(). Mat() gives a cv::Mat over the same
+// memory for the OpenCV code, valid until the array is modified.
+class DescriptorArray
+{
+public:
+    DescriptorArray() {}
+
+    // Copies the rows of a N x 32 CV_8U matrix.
+    explicit DescriptorArray(const cv::Mat& descriptors);
+    void Assign(const cv::Mat& descriptors);
+
+    // Appends the rows of another array, as cv::vconcat does.
+    void Append(const DescriptorArray& other);
+
+    void Clear()
+    {
+        mvData.clear();
+    }
+
+    int Size() const
+    {
+        return static_cast<int>(mvData.size());
+    }
+
+    bool Empty() const
+    {
+        return mvData.empty();
+    }
+
+    const unsigned char* Row(size_t i) const
+    {
+        return mvData[i].data;
+    }
+
+    const PackedDescriptor& operator[](size_t i) const
+    {
+        return mvData[i];
+    }
+
+    // Size() * 32 bytes.
+    const unsigned char* Data() const
+    {
+        return mvData.empty() ? nullptr : mvData[0].data;
+    }
+
+    // Size() x 32 CV_8U header on the array, no copy.
+    cv::Mat Mat() const;
+
+    // Heap memory of the array.
+    size_t Bytes() const
+    {
+        return mvData.capacity() * sizeof(PackedDescriptor);
+    }
+
+private:
+    std::vector<PackedDescriptor> mvData;
+};
+
+} //namespace ORB_SLAM3
+
+#endif // DESCRIPTORARRAY_H
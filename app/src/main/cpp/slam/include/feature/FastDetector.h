@@ -0,0 +1,62 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FASTDETECTOR_H
+#define FASTDETECTOR_H
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+namespace ORB_SLAM3
+{
+
+// FAST-9 (16 pixel circle) corner detection split in two steps, so that a whole pyramid level is scanned
+// once and the cells of ORBextractor are served from the result at any threshold above the scan one.
+// Detect() returns exactly what cv::FAST(image(cell), keypoints, threshold, true) returns: same points,
+// same order, same responses, non maximum suppression limited to the cell.
+class FastDetector
+{
+public:
+    enum Impl
+    {
+        IMPL_SCALAR = 0,
+        IMPL_SSE2,
+        IMPL_AVX2,
+        IMPL_NEON
+    };
+
+    // Fastest implementation supported by the build and the running cpu.
+    static Impl BestImpl();
+    static const char* ImplName(Impl impl);
+
+    // Fills contrast with, for every pixel at least 3 pixels inside roi, the largest t for which the pixel
+    // is a corner of threshold t - 1, or 0 if it is not a corner of the given threshold. The matrix is
+    // (re)allocated with the size of image, pixels outside roi shrinked by 3 are left untouched.
+    // The corner response of cv::FAST is contrast - 1.
+    static void ComputeContrast(const cv::Mat& image, const cv::Rect& roi, int threshold, cv::Mat& contrast,
+                                Impl impl = BestImpl());
+
+    // Appends the corners of threshold (not below the one of ComputeContrast()) found in the cell, with
+    // coordinates relative to the cell corner.
+    static void Detect(const cv::Mat& contrast, const cv::Rect& cell, int threshold, std::vector<cv::KeyPoint>& vKeys);
+};
+
+} //namespace ORB_SLAM3
+
+#endif // FASTDETECTOR_H
@@ -0,0 +1,62 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGEPYRAMID_H
+#define IMAGEPYRAMID_H
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+namespace ORB_SLAM3
+{
+
+// Scale pyramid of ORBextractor together with the blurred levels the descriptors are computed on. The
+// buffers are kept between frames and only reallocated when the image size changes. Every level is
+// resized from the previous one straight into its bordered buffer, gets its border filled in place and
+// is blurred while still in cache.
+class ImagePyramid
+{
+public:
+    // border: pixels around every level, filled with BORDER_REFLECT_101.
+    explicit ImagePyramid(int border);
+
+    // Builds one level per entry of vInvScaleFactor from the CV_8UC1 image.
+    void Build(const cv::Mat& image, const std::vector<float>& vInvScaleFactor);
+
+    // Levels, views inside their bordered buffers.
+    std::vector<cv::Mat> mvLevels;
+
+    // 7x7 gaussian blur (sigma 2) of every level, continuous matrices.
+    std::vector<cv::Mat> mvBlurred;
+
+protected:
+
+    void FillBorder(int level);
+
+    int mnBorder;
+
+    std::vector<cv::Mat> mvBuffers;
+
+    // Source column of every border column, for the size of the last level filled
+    std::vector<int> mvBorderCols;
+};
+
+} //namespace ORB_SLAM3
+
+#endif // IMAGEPYRAMID_H
@@ -18,14 +18,20 @@
 
 #ifndef ORBEXTRACTOR_H
 #define ORBEXTRACTOR_H
+#include <functional>
 #include <vector>
 #include <list>
 
 #include <opencv2/opencv.hpp>
 
+#include "feature/ImagePyramid.h"
+#include "feature/OrbDescriptor.h"
+
 namespace ORB_SLAM3
 {
 
+class WorkerPool;
+
 class ExtractorNode
 {
 public:
@@ -39,12 +45,56 @@ public:
     bool bNoMore;
 };
 
+// Flat version of the ExtractorNode list: nodes linked by index in one vector and key points referred by
+// index, children taking consecutive ranges of vKeyIdx. Kept between frames so that the distribution
+// does not allocate once the vectors have grown.
+class DistributionArena
+{
+public:
+    struct Node
+    {
+        int minX, minY, maxX, maxY;
+        // Key points of the node, vKeyIdx[begin] ... vKeyIdx[end-1]
+        int begin, end;
+        int prev, next;
+        bool bNoMore;
+    };
+
+    void Clear();
+
+    int PushFront(const Node& node);
+
+    // Unlinks node n and returns the node following it
+    int Erase(int n);
+
+    // Same split as ExtractorNode::DivideNode(), the non empty children are pushed at the front in the
+    // same order and the ones with more than one key point appended to vToExpand as (size, node).
+    void Divide(int n, const std::vector<cv::KeyPoint>& vKeys, std::vector<std::pair<int,int> >& vToExpand);
+
+    std::vector<Node> vNodes;
+    std::vector<int> vKeyIdx;
+    int head;
+    int size;
+
+    std::vector<int> vIniCount;
+    std::vector<std::pair<int,int> > vToExpand;
+    std::vector<std::pair<int,int> > vPrevToExpand;
+};
+
 class ORBextractor
 {
 public:
     
     enum {HARRIS_SCORE=0, FAST_SCORE=1 };
 
+    enum Distribution
+    {
+        // std::list quadtree of ORB-SLAM
+        DISTRIBUTION_LIST = 0,
+        // Same tree and same result on a DistributionArena
+        DISTRIBUTION_ARENA
+    };
+
     ORBextractor(int nfeatures, float scaleFactor, int nlevels,
                  int iniThFAST, int minThFAST);
 
@@ -60,6 +110,15 @@ public:
     int inline GetLevels(){
         return nlevels;}
 
+    int inline GetNumFeatures(){
+        return nfeatures;}
+
+    int inline GetIniThFAST(){
+        return iniThFAST;}
+
+    int inline GetMinThFAST(){
+        return minThFAST;}
+
     float inline GetScaleFactor(){
         return scaleFactor;}
 
@@ -79,17 +138,40 @@ public:
         return mvInvLevelSigma2;
     }
 
+    // Spreads the extraction of the pyramid levels and of the FAST cell rows on the pool (nullptr:
+    // serial). The output does not depend on the number of threads.
+    void SetWorkerPool(WorkerPool* pPool){
+        mpWorkerPool = pPool;
+    }
+
+    // ANGLE_BINS (default) rotates the descriptor pattern to the nearest of 30 angles,
+    // ANGLE_CONTINUOUS to the exact key point angle.
+    void SetDescriptorAngleMode(OrbDescriptor::AngleMode mode){
+        mDescriptorAngleMode = mode;
+    }
+
+    const OrbDescriptor& GetDescriptor() const {
+        return mDescriptor;
+    }
+
+    void SetDistribution(Distribution distribution){
+        mDistribution = distribution;
+    }
+
     std::vector<cv::Mat> mvImagePyramid;
 
 protected:
 
+    void ParallelFor(int nTasks, const std::function<void(int)>& f);
+
     void ComputePyramid(cv::Mat image);
     void ComputeKeyPointsOctTree(std::vector<std::vector<cv::KeyPoint> >& allKeypoints);    
     std::vector<cv::KeyPoint> DistributeOctTree(const std::vector<cv::KeyPoint>& vToDistributeKeys, const int &minX,
                                            const int &maxX, const int &minY, const int &maxY, const int &nFeatures, const int &level);
+    std::vector<cv::KeyPoint> DistributeArena(const std::vector<cv::KeyPoint>& vToDistributeKeys, const int &minX,
+                                           const int &maxX, const int &minY, const int &maxY, const int &nFeatures, const int &level);
 
     void ComputeKeyPointsOld(std::vector<std::vector<cv::KeyPoint> >& allKeypoints);
-    std::vector<cv::Point> pattern;
 
     int nfeatures;
     double scaleFactor;
@@ -105,6 +187,21 @@ protected:
     std::vector<float> mvInvScaleFactor;    
     std::vector<float> mvLevelSigma2;
     std::vector<float> mvInvLevelSigma2;
+
+    // Levels and blurred levels, reused between frames
+    ImagePyramid mPyramid;
+
+    OrbDescriptor mDescriptor;
+    OrbDescriptor::AngleMode mDescriptorAngleMode;
+
+    // FAST contrast of every pyramid level, reused between frames
+    std::vector<cv::Mat> mvFastContrast;
+
+    Distribution mDistribution;
+    // Distribution tree of every pyramid level, reused between frames
+    std::vector<DistributionArena> mvDistributionArena;
+
+    WorkerPool* mpWorkerPool;
 };
 
 } //namespace ORB_SLAM
@@ -29,6 +29,7 @@
 
 #include "frame/Frame.h"
 #include "frame/KeyFrame.h"
+#include "frame/LocalMapProjection.h"
 
 namespace ORB_SLAM3
 {
@@ -41,11 +42,16 @@ namespace ORB_SLAM3
 
         // Computes the Hamming distance between two ORB descriptors
         static int DescriptorDistance(const cv::Mat &a, const cv::Mat &b);
+        static int DescriptorDistance(const unsigned char *a, const unsigned char *b);
 
         // Search matches between Frame keypoints and projected MapPoints. Returns number of matches
         // Used to track the local map (Tracking)
         int SearchByProjection(Frame &F, const std::vector<MapPoint*> &vpMapPoints, const float th=3, const bool bFarPoints = false, const float thFarPoints = 50.0f);
 
+        // Same search from the visible points of a LocalMapProjection (frames with a single camera).
+        // The tracking variables of the matched MapPoints are set from the projection.
+        int SearchByProjection(Frame &F, const LocalMapProjection &projection, const float th=3, const bool bFarPoints = false, const float thFarPoints = 50.0f);
+
         // Project MapPoints tracked in last frame into the current frame and search matches.
         // Used to track from previous frame (Tracking)
         int SearchByProjection(Frame &CurrentFrame, const Frame &LastFrame, const float th, const bool bMono);
@@ -0,0 +1,70 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ORBDESCRIPTOR_H
+#define ORBDESCRIPTOR_H
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+namespace ORB_SLAM3
+{
+
+// rBRIEF descriptors of ORBextractor. The 256 point pairs of the pattern are rotated to the key point
+// angle, the pixels gathered and the 256 comparisons done 16 at a time with SIMD.
+class OrbDescriptor
+{
+public:
+    enum AngleMode
+    {
+        // Pattern rotated to the nearest of 30 angles, from a table built once
+        ANGLE_BINS = 0,
+        // Pattern rotated to the exact angle of every key point (original ORB-SLAM behaviour)
+        ANGLE_CONTINUOUS
+    };
+
+    static const int ANGLE_BIN_COUNT = 30;
+
+    // pattern: the 512 points of the 256 pairs
+    explicit OrbDescriptor(const cv::Point* pattern);
+
+    // Fills descriptors with one 32 byte row per key point of image, the blurred pyramid level the key
+    // points were found on.
+    void Compute(const cv::Mat& image, const std::vector<cv::KeyPoint>& vKeys, cv::Mat& descriptors,
+                 AngleMode mode) const;
+
+    const std::vector<cv::Point>& GetPattern() const
+    {
+        return mvPattern;
+    }
+
+protected:
+
+    static const int POINT_COUNT = 512;
+
+    std::vector<cv::Point> mvPattern;
+
+    // Pattern rotated to every bin angle, POINT_COUNT x and y per bin
+    std::vector<signed char> mvBinX;
+    std::vector<signed char> mvBinY;
+};
+
+} //namespace ORB_SLAM3
+
+#endif // ORBDESCRIPTOR_H
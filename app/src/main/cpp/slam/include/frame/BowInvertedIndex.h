@@ -0,0 +1,144 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef BOWINVERTEDINDEX_H
+#define BOWINVERTEDINDEX_H
+
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <DBoW2/BowVector.h>
+
+namespace ORB_SLAM3
+{
+
+// Inverted file of the words of bag of words vectors. Every entry gets an id and goes in a partition (a map
+// for the key frame database); each partition keeps, for each word, the ids of its entries having the word
+// in one array, in the order they were added. Erasing an entry only marks its id dead, its postings are
+// skipped by the searches and removed when the dead postings make up a quarter of them. Ids are dense and
+// only reused once their postings are gone, so the words shared with a query are counted in an array.
+//
+// Searches run concurrently with each other and with the writers: the words are split in stripes with a
+// lock each, which a search only holds while going through the postings of one word. Writers are
+// serialized between themselves. A freed id is not reused before the read sections opened when it was
+// freed are closed, so the ids found by a search keep naming the same entries until its section closes.
+class BowInvertedIndex
+{
+public:
+    // Keeps the ids found by the searches from being reused while it lives.
+    class ReadSection
+    {
+    public:
+        explicit ReadSection(BowInvertedIndex& index);
+        ~ReadSection();
+
+        ReadSection(const ReadSection&) = delete;
+        ReadSection& operator=(const ReadSection&) = delete;
+
+    private:
+        BowInvertedIndex& mIndex;
+        std::multiset<uint64_t>::iterator mit;
+    };
+
+    BowInvertedIndex();
+
+    // Adds the words of bowVec in partition nPartition, returns the id of the entry.
+    unsigned int Add(int nPartition, const DBoW2::BowVector& bowVec);
+
+    void Erase(unsigned int nId);
+
+    // Erases every entry of a partition.
+    void ErasePartition(int nPartition);
+
+    void Clear();
+
+    // Entries sharing words with bowVec in partition nPartition, or in all of them if nPartition is -1, in the
+    // order they are first met going through the words of bowVec. vnWords[i] is the number of words vnIds[i]
+    // shares with bowVec. An entry added or erased during the search may be found with part of its words.
+    void Search(const DBoW2::BowVector& bowVec, int nPartition, std::vector<unsigned int>& vnIds,
+                std::vector<int>& vnWords) const;
+
+    int GetPartition(unsigned int nId) const;
+
+    size_t Postings() const;
+
+    size_t DeadPostings() const;
+
+private:
+    static const int STRIPES = 64;
+
+    typedef std::unordered_map<DBoW2::WordId, std::vector<uint32_t> > WordPostings;
+
+    struct Stripe
+    {
+        mutable std::shared_mutex mMutex;
+        // Postings of the words of the stripe, by partition
+        std::vector<WordPostings> mvPartitions;
+    };
+
+    struct Entry
+    {
+        int nPartition;     // -1 when the id is free
+        bool bAlive;
+        unsigned int nWords;
+    };
+
+    static int StripeOf(DBoW2::WordId wordId)
+    {
+        return wordId % STRIPES;
+    }
+
+    void SearchPartition(const WordPostings& postings, DBoW2::WordId wordId, std::vector<int>& vnVotes,
+                         std::vector<unsigned int>& vnIds) const;
+
+    // Removes the postings of the dead entries. mMutexWrite must be locked.
+    void Compact();
+
+    // Makes ids reusable once the searches which could have found them are over. mMutexWrite must be locked.
+    void ReleaseIds(const std::vector<unsigned int>& vnIds);
+
+    Stripe mStripes[STRIPES];
+
+    // Serializes the writers
+    std::mutex mMutexWrite;
+
+    // Entries and postings counts, written with mMutexWrite locked as well
+    mutable std::mutex mMutexEntries;
+    std::vector<Entry> mvEntries;
+    size_t mnPostings;
+    size_t mnDeadPostings;
+
+    // Ids without postings left, reusable and waiting for the read sections which may have seen them
+    std::vector<unsigned int> mvFreeIds;
+    std::vector<std::pair<uint64_t, std::vector<unsigned int> > > mvPendingIds;
+
+    // Read sections open, by the epoch they were opened at
+    std::mutex mMutexReaders;
+    std::multiset<uint64_t> msReaderEpochs;
+    uint64_t mnEpoch;
+};
+
+} //namespace ORB_SLAM3
+
+#endif // BOWINVERTEDINDEX_H
@@ -0,0 +1,151 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef COVISIBILITYEDGES_H
+#define COVISIBILITYEDGES_H
+
+#include <memory>
+#include <vector>
+
+namespace ORB_SLAM3
+{
+
+class KeyFrame;
+
+// Covisible key frames of a key frame, heaviest first, with their weights (number of shared map points).
+struct CovisibilityList
+{
+    std::vector<KeyFrame*> vpKeyFrames;
+    std::vector<int> vWeights;
+
+    // Number of leading key frames sharing at least w map points.
+    size_t CountByWeight(int w) const;
+
+    // Number of key frames among the best N.
+    size_t CountBest(size_t N) const
+    {
+        return vpKeyFrames.size()<N ? vpKeyFrames.size() : N;
+    }
+};
+
+// Covisibility edges of one key frame. The weights are a flat array sorted by key frame address and the
+// order by weight is kept in a CovisibilityList that readers share without copying: it is only copied when
+// it changes while a reader still holds it. Once every edge is in the order, a changed or erased weight moves
+// a single entry instead of sorting the list again.
+// The number of map points shared with every other key frame is counted apart, as the map points gain and
+// lose observations, so that KeyFrame::UpdateConnections builds the edges from it instead of going through
+// the observations of all its map points. Not thread safe, KeyFrame locks it with mMutexConnections.
+class CovisibilityEdges
+{
+public:
+    struct Edge
+    {
+        KeyFrame* pKF;
+        int nWeight;
+    };
+
+    typedef std::shared_ptr<const CovisibilityList> Snapshot;
+
+    CovisibilityEdges();
+
+    // Weight of the edge to pKF, 0 if there is none.
+    int GetWeight(KeyFrame* pKF) const;
+
+    const std::vector<Edge>& GetEdges() const
+    {
+        return mvEdges;
+    }
+
+    Snapshot GetOrdered() const
+    {
+        return mpOrdered;
+    }
+
+    // Edges computed by KeyFrame::UpdateConnections, sorted by address (taken by swap), and the ones kept in
+    // the order, heaviest first.
+    void Assign(std::vector<Edge>& vEdges, const std::vector<Edge>& vOrdered);
+
+    // Sets the weight of an edge, returns false if it had that weight already.
+    bool SetWeight(KeyFrame* pKF, int nWeight);
+    // Returns false if there was no edge to pKF.
+    bool EraseWeight(KeyFrame* pKF);
+
+    // True when every edge is in the order, after RebuildOrdered(). UpdateConnections only orders the edges
+    // over its threshold.
+    bool IsOrderedComplete() const
+    {
+        return mbOrderedComplete;
+    }
+
+    // Moves (or inserts) pKF to its place in a complete order for its new weight.
+    void UpdateOrdered(KeyFrame* pKF, int nWeight);
+    void EraseOrdered(KeyFrame* pKF);
+
+    // Orders every edge whose key frame is not bad.
+    template<class IsBad>
+    void RebuildOrdered(IsBad isBad)
+    {
+        std::vector<Edge> vOrdered;
+        vOrdered.reserve(mvEdges.size());
+        for(const Edge& edge : mvEdges)
+        {
+            if(!isBad(edge.pKF))
+                vOrdered.push_back(edge);
+        }
+        SortOrdered(vOrdered);
+        SetOrdered(vOrdered);
+        mbOrderedComplete = true;
+    }
+
+    // Clears the edges and the order, the shared map point counts are kept.
+    void Clear();
+
+    // Adds nDelta to the number of map points shared with pKF. The changes of concurrent observations may come
+    // in any order, so a count can be negative for a while, a count back to 0 is dropped.
+    void AddShared(KeyFrame* pKF, int nDelta);
+
+    // Shared map point counts sorted by address, the ones not over 0 included.
+    const std::vector<Edge>& GetShared() const
+    {
+        return mvShared;
+    }
+
+    void ClearShared()
+    {
+        mvShared.clear();
+    }
+
+    // Heaviest first, equal weights by decreasing address (the reversed order of sorted (weight, key frame) pairs).
+    static bool IsBefore(const Edge& a, const Edge& b);
+    static void SortOrdered(std::vector<Edge>& vOrdered);
+
+private:
+    void SetOrdered(const std::vector<Edge>& vOrdered);
+    // Ordered list to modify, replaced first if a reader still holds it (by a copy if bKeep).
+    CovisibilityList& WritableOrdered(bool bKeep=true);
+
+    std::vector<Edge> mvEdges;
+    std::vector<Edge> mvShared;
+    std::shared_ptr<CovisibilityList> mpOrdered;
+    bool mbOrderedComplete;
+};
+
+} //namespace ORB_SLAM3
+
+#endif // COVISIBILITYEDGES_H
@@ -0,0 +1,89 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef FEATUREGRID_H
+#define FEATUREGRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ORB_SLAM3
+{
+
+// Keypoint indices bucketed by the cells of a grid over the image, stored as one array of indices sorted by
+// cell plus the offset of every cell in it. The indices of a cell are in increasing order, as if they were
+// pushed one keypoint after the other. Built once per frame, then shared read only by the searches.
+class FeatureGrid
+{
+public:
+    FeatureGrid() : mnCols(0), mnRows(0) {}
+
+    // vCells[i] is the cell x*nRows+y of keypoint i, or -1 if the keypoint is outside the grid.
+    void Build(int nCols, int nRows, const std::vector<int>& vCells);
+
+    int Cols() const
+    {
+        return mnCols;
+    }
+
+    int Rows() const
+    {
+        return mnRows;
+    }
+
+    // True as well before the first Build(), the cells must not be read then.
+    bool Empty() const
+    {
+        return mvIndices.empty();
+    }
+
+    const uint32_t* CellBegin(int x, int y) const
+    {
+        return mvIndices.data() + mvOffsets[x*mnRows+y];
+    }
+
+    const uint32_t* CellEnd(int x, int y) const
+    {
+        return mvIndices.data() + mvOffsets[x*mnRows+y+1];
+    }
+
+    std::size_t CellSize(int x, int y) const
+    {
+        return mvOffsets[x*mnRows+y+1] - mvOffsets[x*mnRows+y];
+    }
+
+    // Heap memory of the grid.
+    std::size_t Bytes() const
+    {
+        return (mvOffsets.capacity() + mvIndices.capacity()) * sizeof(uint32_t);
+    }
+
+private:
+    int mnCols;
+    int mnRows;
+
+    // mnCols*mnRows+1 offsets in mvIndices
+    std::vector<uint32_t> mvOffsets;
+    std::vector<uint32_t> mvIndices;
+};
+
+} //namespace ORB_SLAM3
+
+#endif // FEATUREGRID_H
@@ -34,6 +34,8 @@
 
 #include <opencv2/opencv.hpp>
 
+#include "feature/DescriptorArray.h"
+#include "frame/FeatureGrid.h"
 #include "feature/ORBVocabulary.h"
 
 #include "utils/ImuTypes.h"
@@ -52,6 +54,7 @@ class KeyFrame;
 class ConstraintPoseImu;
 class GeometricCamera;
 class ORBextractor;
+class WorkerPool;
 
 class Frame
 {
@@ -90,8 +93,8 @@ public:
     // Extract ORB on the image. 0 for left image and 1 for right image.
     void ExtractORB(int flag, const cv::Mat &im, const int x0, const int x1);
 
-    // Compute Bag of Words representation.
-    void ComputeBoW();
+    // Compute Bag of Words representation, on the threads of pPool if given.
+    void ComputeBoW(WorkerPool* pPool = nullptr);
 
     // Set the camera pose. (Imu pose is not modified!)
     void SetPose(const Sophus::SE3<float> &Tcw);
@@ -128,6 +131,9 @@ public:
 
     vector<size_t> GetFeaturesInArea(const float &x, const float  &y, const float  &r, const int minLevel=-1, const int maxLevel=-1, const bool bRight = false) const;
 
+    // Same search writing into vIndices, which is cleared first, so that the caller can reuse its buffer.
+    void GetFeaturesInArea(const float &x, const float  &y, const float  &r, const int minLevel, const int maxLevel, const bool bRight, vector<size_t> &vIndices) const;
+
     // Search a match for each keypoint in the left image to a keypoint in the right image.
     // If there is a match, depth is computed and the right coordinate associated to the left keypoint is stored.
     void ComputeStereoMatches();
@@ -257,7 +263,7 @@ public:
     DBoW2::FeatureVector mFeatVec;
 
     // ORB descriptor, each row associated to a keypoint.
-    cv::Mat mDescriptors, mDescriptorsRight;
+    DescriptorArray mDescriptors, mDescriptorsRight;
 
     // MapPoints associated to keypoints, NULL pointer if no association.
     // Flag to identify outlier associations.
@@ -267,8 +273,7 @@ public:
     // Keypoints are assigned to cells in a grid to reduce matching complexity when projecting MapPoints.
     static float mfGridElementWidthInv;
     static float mfGridElementHeightInv;
-    // std::vector<std::size_t> mGrid[FRAME_GRID_COLS][FRAME_GRID_ROWS];
-    std::array<std::array<std::vector<size_t>, FRAME_GRID_ROWS>, FRAME_GRID_COLS> mGrid;
+    FeatureGrid mGrid;
 
     IMU::Bias mPredBias;
 
@@ -356,8 +361,7 @@ public:
     std::vector<Eigen::Vector3f> mvStereo3Dpoints;
 
     //Grid for the right image
-    // std::vector<std::size_t> mGridRight[FRAME_GRID_COLS][FRAME_GRID_ROWS];
-    std::array<std::array<std::vector<size_t>, FRAME_GRID_ROWS>, FRAME_GRID_COLS> mGridRight;
+    FeatureGrid mGridRight;
 
     Frame(const cv::Mat &imLeft, const cv::Mat &imRight, const double &timeStamp, ORBextractor* extractorLeft, ORBextractor* extractorRight, ORBVocabulary* voc, cv::Mat &K, cv::Mat &distCoef, const float &bf, const float &thDepth, GeometricCamera* pCamera, GeometricCamera* pCamera2, Sophus::SE3f& Tlr,Frame* pPrevF = static_cast<Frame*>(NULL), const IMU::Calib &ImuCalib = IMU::Calib());
 
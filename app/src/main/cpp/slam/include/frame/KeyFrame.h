@@ -27,9 +27,12 @@
 #include "feature/ORBVocabulary.h"
 #include "feature/ORBextractor.h"
 
+#include "frame/CovisibilityEdges.h"
 #include "frame/Frame.h"
 
 #include "utils/ImuTypes.h"
+#include "utils/ObjectPool.h"
+#include "utils/SlotMap.h"
 
 #include "camera_models/GeometricCamera.h"
 
@@ -42,13 +45,15 @@ class Frame;
 class KeyFrameDatabase;
 
 class GeometricCamera;
+class WorkerPool;
 
 class KeyFrame
 {
 public:
-    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    SLAM_POOLED_OPERATOR_NEW(KeyFrame)
     KeyFrame();
     KeyFrame(Frame &F, Map* pMap, KeyFrameDatabase* pKFDB);
+    ~KeyFrame();
 
     // Pose functions
     void SetPose(const Sophus::SE3f &Tcw);
@@ -67,19 +72,33 @@ public:
     Eigen::Vector3f GetVelocity();
     bool isVelocitySet();
 
-    // Bag of Words Representation
-    void ComputeBoW();
+    // Bag of Words Representation, on the threads of pPool if given
+    void ComputeBoW(WorkerPool* pPool = nullptr);
+
+    // Bytes held by the keypoints, descriptors, grids and bag of words.
+    size_t FeatureBytes() const;
+
+    // Frees the features of a bad key frame that no thread reads anymore (see Reclaimer), N is unchanged
+    // but the arrays are empty. Returns the bytes released.
+    size_t ReleaseFeatures();
 
     // Covisibility graph functions
     void AddConnection(KeyFrame* pKF, const int &weight);
     void EraseConnection(KeyFrame* pKF);
 
+    // Counts n more (or fewer if negative) map points shared with pKF, MapPoint calls it as its observations
+    // change. UpdateConnections builds the edges from these counts.
+    void AddSharedMapPoints(KeyFrame* pKF, int n);
+
     void UpdateConnections(bool upParent=true);
     void UpdateBestCovisibles();
     std::set<KeyFrame *> GetConnectedKeyFrames();
     std::vector<KeyFrame* > GetVectorCovisibleKeyFrames();
     std::vector<KeyFrame*> GetBestCovisibilityKeyFrames(const int &N);
     std::vector<KeyFrame*> GetCovisiblesByWeight(const int &w);
+    // Ordered covisible key frames shared with the key frame, no copy is made. Take the first N or
+    // CountByWeight(w) for the best N or the ones over a weight.
+    CovisibilityEdges::Snapshot GetCovisibles();
     int GetWeight(KeyFrame* pKF);
 
     // Spanning tree functions
@@ -112,6 +131,8 @@ public:
 
     // KeyPoint functions
     std::vector<size_t> GetFeaturesInArea(const float &x, const float  &y, const float  &r, const bool bRight = false) const;
+    // Same search writing into vIndices, which is cleared first, so that the caller can reuse its buffer.
+    void GetFeaturesInArea(const float &x, const float  &y, const float  &r, const bool bRight, std::vector<size_t> &vIndices) const;
     bool UnprojectStereo(int i, Eigen::Vector3f &x3D);
 
     // Image
@@ -120,6 +141,8 @@ public:
     // Enable/Disable bad flag changes
     void SetNotErase();
     void SetErase();
+    // Flagged bad while it could not be erased, SetErase() will finish it
+    bool isToBeErased();
 
     // Set/check bad flag
     void SetBadFlag();
@@ -221,6 +244,9 @@ public:
     float mfScaleMerge;
     long unsigned int mnBALocalForMerge;
 
+    // Place in the key frames of its map (written by Map under its lock)
+    SlotHandle mMapSlot;
+
     float mfScale;
 
     // Calibration parameters
@@ -230,12 +256,13 @@ public:
     // Number of KeyPoints
     const int N;
 
-    // KeyPoints, stereo coordinate and descriptors (all associated by an index)
-    const std::vector<cv::KeyPoint> mvKeys;
-    const std::vector<cv::KeyPoint> mvKeysUn;
-    const std::vector<float> mvuRight; // negative value for monocular points
-    const std::vector<float> mvDepth; // negative value for monocular points
-    const cv::Mat mDescriptors;
+    // KeyPoints, stereo coordinate and descriptors (all associated by an index), released once the key frame
+    // is bad
+    std::vector<cv::KeyPoint> mvKeys;
+    std::vector<cv::KeyPoint> mvKeysUn;
+    std::vector<float> mvuRight; // negative value for monocular points
+    std::vector<float> mvDepth; // negative value for monocular points
+    DescriptorArray mDescriptors;
 
     //BoW
     DBoW2::BowVector mBowVec;
@@ -308,11 +335,9 @@ protected:
     ORBVocabulary* mpORBvocabulary;
 
     // Grid over the image to speed up feature matching
-    std::vector< std::vector <std::vector<size_t> > > mGrid;
+    FeatureGrid mGrid;
 
-    std::map<KeyFrame*,int> mConnectedKeyFrameWeights;
-    std::vector<KeyFrame*> mvpOrderedConnectedKeyFrames;
-    std::vector<int> mvOrderedWeights;
+    CovisibilityEdges mCovisibility;
     // For save relation without pointer, this is necessary for save/load function
     std::map<long unsigned int, int> mBackupConnectedKeyFrameIdWeights;
 
@@ -364,11 +389,11 @@ public:
     Sophus::SE3f GetRelativePoseTlr();
 
     //KeyPoints in the right image (for stereo fisheye, coordinates are needed)
-    const std::vector<cv::KeyPoint> mvKeysRight;
+    std::vector<cv::KeyPoint> mvKeysRight;
 
     const int NLeft, NRight;
 
-    std::vector< std::vector <std::vector<size_t> > > mGridRight;
+    FeatureGrid mGridRight;
 
     Sophus::SE3<float> GetRightPose();
     Sophus::SE3<float> GetRightPoseInverse();
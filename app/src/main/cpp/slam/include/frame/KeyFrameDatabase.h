@@ -23,7 +23,9 @@
 #include <list>
 #include <set>
 #include <mutex>
+#include <unordered_map>
 
+#include "frame/BowInvertedIndex.h"
 #include "frame/Frame.h"
 #include "frame/KeyFrame.h"
 
@@ -44,7 +46,7 @@ class KeyFrameDatabase
 public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-    KeyFrameDatabase(){}
+    KeyFrameDatabase() : mpVoc(nullptr) {}
     KeyFrameDatabase(const ORBVocabulary &voc);
 
     void add(KeyFrame* pKF);
@@ -54,6 +56,9 @@ public:
     void clear();
     void clearMap(Map* pMap);
 
+    // Moves a key frame of the database to the partition of pMap, called when it changes map
+    void UpdateMap(KeyFrame* pKF, Map* pMap);
+
     // Loop Detection(DEPRECATED)
     std::vector<KeyFrame *> DetectLoopCandidates(KeyFrame* pKF, float minScore);
 
@@ -71,16 +76,36 @@ public:
 
 protected:
 
+   // Key frames sharing words with bowVec in pMap, or in every map if pMap is null, in the order they are
+   // first met, with the number of words they share. Runs alongside the other searches and the writers.
+   void SearchSharedWords(const DBoW2::BowVector &bowVec, Map* pMap, std::vector<KeyFrame*> &vpKFs,
+                          std::vector<int> &vnWords);
+
+   // Partition of the index holding the key frames of pMap, -1 if there is none yet. mMutex must be locked,
+   // or mMutexWrite.
+   int FindPartition(Map* pMap) const;
+
+   // Partition of pMap, created if needed. mMutexWrite must be locked.
+   int GetPartition(Map* pMap);
+
    // Associated vocabulary
    const ORBVocabulary* mpVoc;
 
-   // Inverted file
-   std::vector<list<KeyFrame*> > mvInvertedFile;
+   // Inverted file, partitioned by map
+   BowInvertedIndex mIndex;
+   // Map of every partition
+   std::vector<Map*> mvpPartitionMaps;
+   // Key frame of every id of the index, null for the erased ones
+   std::vector<KeyFrame*> mvpKeyFrames;
+   // Id of every key frame in the index, only used by the writers
+   std::unordered_map<KeyFrame*, unsigned int> mmKeyFrameIds;
 
    // For save relation without pointer, this is necessary for save/load function
    std::vector<list<long unsigned int> > mvBackupInvertedFileId;
 
-   // Mutex
+   // Serializes the writers (add, erase, clear, clearMap and UpdateMap)
+   std::mutex mMutexWrite;
+   // Guards mvpPartitionMaps and mvpKeyFrames, which the searches read; only held for short lookups
    std::mutex mMutex;
 
 };
@@ -0,0 +1,86 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef LOCALMAPPROJECTION_H
+#define LOCALMAPPROJECTION_H
+
+#include <cstddef>
+#include <vector>
+
+namespace ORB_SLAM3
+{
+
+class Frame;
+class MapPoint;
+
+// Local map points of the tracking laid out as arrays, so that the frustum test of Frame::isInFrustum() runs
+// over all of them at once without locking nor writing the map points. The geometry is copied by Reset()
+// once per local map update, Project() then keeps the points visible in a frame with their projection.
+// Only frames with a single camera (Nleft == -1) are handled.
+class LocalMapProjection
+{
+public:
+    // Snapshot of the position, normal and scale invariance distances of the points.
+    void Reset(const std::vector<MapPoint*>& vpMapPoints);
+
+    // Keeps the points inside the frustum of F, in the order of the snapshot, skipping the ones already
+    // seen by F and the bad ones. Same tests and results as Frame::isInFrustum(), returns the number of
+    // visible points.
+    int Project(const Frame& F, float viewingCosLimit);
+
+    std::size_t Size() const
+    {
+        return mvpPoints.size();
+    }
+
+    // Visible points of the last Project()
+    std::size_t Visible() const
+    {
+        return mvpVisible.size();
+    }
+
+    MapPoint* Point(std::size_t k) const { return mvpVisible[k]; }
+    float ProjX(std::size_t k) const { return mvProjX[k]; }
+    float ProjY(std::size_t k) const { return mvProjY[k]; }
+    float ProjXR(std::size_t k) const { return mvProjXR[k]; }
+    float Depth(std::size_t k) const { return mvDepth[k]; }
+    float ViewCos(std::size_t k) const { return mvViewCos[k]; }
+    int Level(std::size_t k) const { return mvLevel[k]; }
+
+private:
+    void Keep(const Frame& F, std::size_t i, float u, float v, float uR, float depth, float dist, float viewCos);
+
+    // Snapshot
+    std::vector<MapPoint*> mvpPoints;
+    std::vector<float> mvX, mvY, mvZ;
+    std::vector<float> mvNx, mvNy, mvNz;
+    std::vector<float> mvMinDistance, mvMaxDistance;    // GetMin/MaxDistanceInvariance()
+    std::vector<float> mvScaleDistance;                 // distance PredictScale() works with
+
+    // Visible points
+    std::vector<MapPoint*> mvpVisible;
+    std::vector<float> mvProjX, mvProjY, mvProjXR;
+    std::vector<float> mvDepth;
+    std::vector<float> mvViewCos;
+    std::vector<int> mvLevel;
+};
+
+} //namespace ORB_SLAM3
+
+#endif // LOCALMAPPROJECTION_H
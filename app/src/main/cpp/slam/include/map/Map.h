@@ -26,6 +26,8 @@
 
 #include "frame/KeyFrame.h"
 
+#include "utils/SlotMap.h"
+
 namespace ORB_SLAM3
 {
 
@@ -54,6 +56,11 @@ public:
     std::vector<MapPoint*> GetAllMapPoints();
     std::vector<MapPoint*> GetReferenceMapPoints();
 
+    // Shared read only copies of all the key frames and map points. Successive calls return the same one
+    // until the map changes, for the readers that enumerate the map often.
+    SlotMap<KeyFrame>::Snapshot GetKeyFrameSnapshot();
+    SlotMap<MapPoint>::Snapshot GetMapPointSnapshot();
+
     long unsigned int MapPointsInMap();
     long unsigned  KeyFramesInMap();
 
@@ -128,8 +135,9 @@ protected:
 
     long unsigned int mnId;
 
-    std::set<MapPoint*> mspMapPoints;
-    std::set<KeyFrame*> mspKeyFrames;
+    // A key frame or map point is in one map at a time, erase it from the old map before adding it to a new one
+    SlotMap<MapPoint> mMapPoints;
+    SlotMap<KeyFrame> mKeyFrames;
 
     // Save/load, the set structure is broken in libboost 1.58 for ubuntu 16.04, a vector is serializated
     std::vector<MapPoint*> mvpBackupMapPoints;
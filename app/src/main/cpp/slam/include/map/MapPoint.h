@@ -19,6 +19,8 @@
 
 #ifndef MAPPOINT_H
 #define MAPPOINT_H
+#include <algorithm>
+#include <functional>
 #include <mutex>
 
 #include <opencv2/core/core.hpp>
@@ -27,6 +29,10 @@
 #include "frame/KeyFrame.h"
 
 #include "utils/Converter.h"
+#include "utils/ObjectPool.h"
+#include "utils/SeqLock.h"
+#include "utils/SlotMap.h"
+#include "utils/SmallVector.h"
 
 namespace ORB_SLAM3
 {
@@ -35,15 +41,63 @@ class KeyFrame;
 class Map;
 class Frame;
 
+// Key frame observing a map point, with the indexes of the point in its left and right keypoints (-1 if not seen).
+struct Observation
+{
+    KeyFrame* pKF;
+    int nLeft;
+    int nRight;
+};
+
+// Observations of a map point sorted by key frame address, the order the former std::map gave. Most points are
+// seen by a handful of key frames, so the list stays inline and copying it does not allocate.
+class ObservationList : public SmallVector<Observation,8>
+{
+public:
+    const Observation* Find(KeyFrame* pKF) const
+    {
+        const_iterator it = LowerBound(pKF);
+        return (it!=end() && it->pKF==pKF) ? it : NULL;
+    }
+
+    // Entry of pKF, inserted with no indexes if missing.
+    Observation& Get(KeyFrame* pKF)
+    {
+        iterator it = const_cast<iterator>(LowerBound(pKF));
+        if(it==end() || it->pKF!=pKF)
+            it = insert(it, Observation{pKF,-1,-1});
+        return *it;
+    }
+
+    bool Erase(KeyFrame* pKF)
+    {
+        const_iterator it = LowerBound(pKF);
+        if(it==end() || it->pKF!=pKF)
+            return false;
+        erase(const_cast<iterator>(it));
+        return true;
+    }
+
+private:
+    const_iterator LowerBound(KeyFrame* pKF) const
+    {
+        return std::lower_bound(begin(), end(), pKF, [](const Observation& obs, KeyFrame* pKFi)
+        {
+            return std::less<KeyFrame*>()(obs.pKF, pKFi);
+        });
+    }
+};
+
 class MapPoint
 {
 public:
-    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    SLAM_POOLED_OPERATOR_NEW(MapPoint)
     MapPoint();
 
     MapPoint(const Eigen::Vector3f &Pos, KeyFrame* pRefKF, Map* pMap);
     MapPoint(const double invDepth, cv::Point2f uv_init, KeyFrame* pRefKF, KeyFrame* pHostKF, Map* pMap);
     MapPoint(const Eigen::Vector3f &Pos,  Map* pMap, Frame* pFrame, const int &idxF);
+    ~MapPoint();
 
     void SetWorldPos(const Eigen::Vector3f &Pos);
     Eigen::Vector3f GetWorldPos();
@@ -51,9 +105,22 @@ public:
     Eigen::Vector3f GetNormal();
     void SetNormalVector(const Eigen::Vector3f& normal);
 
+    // Position, normal and the scale invariance distances read as a whole
+    void GetProjectionData(Eigen::Vector3f &Pos, Eigen::Vector3f &Normal, float &fMinDistance, float &fMaxDistance);
+
     KeyFrame* GetReferenceKeyFrame();
 
-    std::map<KeyFrame*,std::tuple<int,int>> GetObservations();
+    // Copy of the observations, allocation free for the usual number of them
+    ObservationList GetObservations();
+    // Calls f(const Observation&) on every observation under the feature lock. f must not lock the map point
+    // nor the key frames, use GetObservations() for that.
+    template<class F>
+    void ForEachObservation(F f)
+    {
+        std::unique_lock<std::mutex> lock(mMutexFeatures);
+        for(const Observation& obs : mObservations)
+            f(obs);
+    }
     int Observations();
 
     void AddObservation(KeyFrame* pKF,int idx);
@@ -77,7 +144,7 @@ public:
 
     void ComputeDistinctiveDescriptors();
 
-    cv::Mat GetDescriptor();
+    PackedDescriptor GetDescriptor();
 
     void UpdateNormalAndDepth();
 
@@ -126,6 +193,9 @@ public:
     long unsigned int mnBAGlobalForKF;
     long unsigned int mnBALocalForMerge;
 
+    // Place in the map points of its map (written by Map under its lock)
+    SlotHandle mMapSlot;
+
     // Variable used by merging
     Eigen::Vector3f mPosMerge;
     Eigen::Vector3f mNormalVectorMerge;
@@ -137,26 +207,29 @@ public:
     double mInitV;
     KeyFrame* mpHostKF;
 
-    static std::mutex mGlobalMutex;
-
     unsigned int mnOriginMapId;
 
 protected:    
 
-     // Position in absolute coordinates
-     Eigen::Vector3f mWorldPos;
+     // Position in absolute coordinates, mean viewing direction and scale invariance distances. Read without
+     // locking, so tracking does not wait for the BA writing them. Writers hold mMutexPos.
+     struct Geometry
+     {
+         float Pos[3];
+         float Normal[3];
+         float fMinDistance;
+         float fMaxDistance;
+     };
+     SeqLock<Geometry> mGeometry;
 
      // Keyframes observing the point and associated index in keyframe
-     std::map<KeyFrame*,std::tuple<int,int> > mObservations;
+     ObservationList mObservations;
      // For save relation without pointer, this is necessary for save/load function
      std::map<long unsigned int, int> mBackupObservationsId1;
      std::map<long unsigned int, int> mBackupObservationsId2;
 
-     // Mean viewing direction
-     Eigen::Vector3f mNormalVector;
-
      // Best descriptor to fast matching
-     cv::Mat mDescriptor;
+     PackedDescriptor mDescriptor;
 
      // Reference KeyFrame
      KeyFrame* mpRefKF;
@@ -166,16 +239,12 @@ protected:
      int mnVisible;
      int mnFound;
 
-     // Bad flag (we do not currently erase MapPoint from memory)
+     // Bad flag (bad points stay in memory, the frames and other threads keep pointing to them, see Reclaimer)
      bool mbBad;
      MapPoint* mpReplaced;
      // For save relation without pointer, this is necessary for save/load function
      long long int mBackupReplacedId;
 
-     // Scale invariance distances
-     float mfMinDistance;
-     float mfMaxDistance;
-
      Map* mpMap;
 
      // Mutex
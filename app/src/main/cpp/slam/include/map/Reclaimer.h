@@ -0,0 +1,110 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef RECLAIMER_H
+#define RECLAIMER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ORB_SLAM3
+{
+
+class KeyFrame;
+class MapPoint;
+
+// Deferred release of the features of bad key frames, and counts of the key frames and map points alive.
+//
+// A key frame flagged bad is retired: its keypoints, descriptors, grids and bag of words are released once
+// every participant (tracking, local mapping, loop closing, global BA) has gone through a quiescent point
+// after it was retired. A participant is quiescent between two of its iterations, when it holds no key frame
+// it got before. A thread reaching a key frame through a pointer kept over a quiescent point must check
+// isBad() before reading its features.
+//
+// Only the key frame features are reclaimed. Bad key frames and bad map points themselves are not freed,
+// they are counted in the summary:
+// - The trajectory, the spanning tree and the frames still point to bad key frames, and read their pose,
+//   parent and flags.
+// - Bad map points are held over the quiescent points by the last frame of tracking, the recent points of
+//   local mapping, the loop and merge matches and the replaced points leading to them, which do not check
+//   isBad() before dereferencing them. Their observation list is released by SetBadFlag() itself (readers
+//   copy it under the feature lock), their descriptor is stored inline in the object.
+class Reclaimer
+{
+public:
+    struct Summary
+    {
+        // Key frames created and not deleted, with their features, bad ones included
+        uint64_t nKeyFrames;
+        uint64_t nKeyFrameBytes;
+        // Bad key frames waiting for their features to be released
+        uint64_t nRetiredKeyFrames;
+        uint64_t nRetiredKeyFrameBytes;
+        // Bad key frames whose features were released so far, and the bytes released
+        uint64_t nReclaimedKeyFrames;
+        uint64_t nReclaimedBytes;
+        // Map points created and not deleted, bad ones included
+        uint64_t nMapPoints;
+        uint64_t nMapPointBytes;
+        uint64_t nBadMapPoints;
+        uint64_t nBadMapPointBytes;
+    };
+
+    // A thread reading key frames. Registered for its whole life, the first quiescent point is the creation.
+    class Participant
+    {
+    public:
+        Participant();
+        ~Participant();
+
+        Participant(const Participant&) = delete;
+        Participant& operator=(const Participant&) = delete;
+
+        // The thread holds no key frame it got before this call.
+        void Quiescent();
+
+    private:
+        friend class Reclaimer;
+        std::atomic<uint64_t> mnEpoch;
+    };
+
+    // pKF was just flagged bad.
+    static void Retire(KeyFrame* pKF);
+
+    // Deletes pKF once the participants can no longer hold it, after its features if it was retired.
+    static void Delete(KeyFrame* pKF);
+
+    // Releases and deletes what no participant can hold anymore. Called off the tracking path.
+    static void Collect();
+
+    // Accounting of the key frames and map points, by their constructors, destructors and ComputeBoW().
+    static void AddKeyFrame(int64_t nBytes);
+    static void RemoveKeyFrame(int64_t nBytes);
+    static void ResizeKeyFrame(int64_t nBytes);
+    static void AddMapPoint();
+    static void RemoveMapPoint(bool bBad);
+    static void SetMapPointBad();
+
+    static Summary GetSummary();
+};
+
+} //namespace ORB_SLAM3
+
+#endif // RECLAIMER_H
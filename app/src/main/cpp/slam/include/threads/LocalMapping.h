@@ -25,6 +25,7 @@
 
 #include "frame/KeyFrame.h"
 #include "frame/KeyFrameDatabase.h"
+#include "map/Reclaimer.h"
 
 #include "utils/Settings.h"
 
@@ -109,24 +110,6 @@ public:
     bool mbFarPoints;
     float mThFarPoints;
 
-#ifdef REGISTER_TIMES
-    vector<double> vdKFInsert_ms;
-    vector<double> vdMPCulling_ms;
-    vector<double> vdMPCreation_ms;
-    vector<double> vdLBA_ms;
-    vector<double> vdKFCulling_ms;
-    vector<double> vdLMTotal_ms;
-
-
-    vector<double> vdLBASync_ms;
-    vector<double> vdKFCullingSync_ms;
-    vector<int> vnLBA_edges;
-    vector<int> vnLBA_KFopt;
-    vector<int> vnLBA_KFfixed;
-    vector<int> vnLBA_MPs;
-    int nLBA_exec;
-    int nLBA_abort;
-#endif
 protected:
 
     bool CheckNewKeyFrames();
@@ -167,6 +150,9 @@ protected:
 
     std::mutex mMutexNewKFs;
 
+    // Quiescent between two key frames, when the features of the bad key frames are released
+    Reclaimer::Participant mReclaimerParticipant;
+
     bool mbAbortBA;
 
     bool mbStopped;
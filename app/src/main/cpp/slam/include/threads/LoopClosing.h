@@ -31,6 +31,7 @@
 #include "feature/ORBVocabulary.h"
 
 #include "frame/KeyFrameDatabase.h"
+#include "map/Reclaimer.h"
 
 namespace ORB_SLAM3
 {
@@ -77,39 +78,13 @@ public:
         return mbFinishedGBA;
     }   
 
+    // No keyframe queued or being processed and no global BA running.
+    bool isIdle();
+
     void RequestFinish();
 
     bool isFinished();
 
-#ifdef REGISTER_TIMES
-
-    vector<double> vdDataQuery_ms;
-    vector<double> vdEstSim3_ms;
-    vector<double> vdPRTotal_ms;
-
-    vector<double> vdMergeMaps_ms;
-    vector<double> vdWeldingBA_ms;
-    vector<double> vdMergeOptEss_ms;
-    vector<double> vdMergeTotal_ms;
-    vector<int> vnMergeKFs;
-    vector<int> vnMergeMPs;
-    int nMerges;
-
-    vector<double> vdLoopFusion_ms;
-    vector<double> vdLoopOptEss_ms;
-    vector<double> vdLoopTotal_ms;
-    vector<int> vnLoopKFs;
-    int nLoop;
-
-    vector<double> vdGBA_ms;
-    vector<double> vdUpdateMap_ms;
-    vector<double> vdFGBATotal_ms;
-    vector<int> vnGBAKFs;
-    vector<int> vnGBAMPs;
-    int nFGBA_exec;
-    int nFGBA_abort;
-
-#endif
 
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
@@ -162,6 +137,8 @@ protected:
     LocalMapping *mpLocalMapper;
 
     std::list<KeyFrame*> mlpLoopKeyFrameQueue;
+    // The keyframe popped from the queue has not been fully processed yet.
+    bool mbProcessingKF;
 
     std::mutex mMutexLoopQueue;
 
@@ -216,6 +193,9 @@ protected:
     std::mutex mMutexGBA;
     std::thread* mpThreadGBA;
 
+    // Quiescent between two key frames
+    Reclaimer::Participant mReclaimerParticipant;
+
     // Fix scale in the stereo/RGB-D case
     bool mbFixScale;
 
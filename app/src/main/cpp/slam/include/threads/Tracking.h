@@ -30,8 +30,11 @@
 
 #include "frame/Frame.h"
 #include "frame/KeyFrameDatabase.h"
+#include "frame/LocalMapProjection.h"
+#include "map/Reclaimer.h"
 #include "feature/ORBVocabulary.h"
 #include "feature/ORBextractor.h"
+#include "utils/WorkerPool.h"
 #include "utils/ImuTypes.h"
 #include "utils/Settings.h"
 
@@ -122,6 +125,13 @@ namespace ORB_SLAM3
 
         float GetImageScale();
 
+        // Wall time (ms) spent in each stage while processing the last frame.
+        double GetTimeORBExtract() const { return mTime_ORBExtract; }
+        double GetTimePreIntIMU() const { return mTime_PreIntIMU; }
+        double GetTimePosePred() const { return mTime_PosePred; }
+        double GetTimeLocalMapTrack() const { return mTime_LocalMapTrack; }
+        double GetTimeNewKFDec() const { return mTime_NewKF_Dec; }
+
     public:
 
         // Tracking states
@@ -183,6 +193,16 @@ namespace ORB_SLAM3
 
         vector<MapPoint*> GetLocalMapMPS();
 
+        // Number of threads (caller included) the ORB extractors split a frame over. Must not be called
+        // while a frame is being tracked.
+        void SetExtractorThreads(int nThreads);
+
+        // Rotation of the descriptor pattern of the ORB extractors, see ORBextractor::SetDescriptorAngleMode().
+        void SetDescriptorAngleMode(OrbDescriptor::AngleMode mode);
+
+        // Key point distribution of the ORB extractors, see ORBextractor::Distribution.
+        void SetKeyPointDistribution(ORBextractor::Distribution distribution);
+
         bool mbWriteStats;
 
     protected:
@@ -201,6 +221,26 @@ namespace ORB_SLAM3
 
         void CheckReplacedInLastFrame();
 
+        // Way Track() predicts the pose of the current frame. Chosen once before the IMU preintegration
+        // to start the Bag of Words early, then again under the map lock for the branches themselves
+        enum ePosePrediction
+        {
+            PREDICTION_NONE,            // Initialization, or a new map is started
+            PREDICTION_REFERENCE_KF,
+            PREDICTION_MOTION_MODEL,    // Falls back to the reference keyframe outside of localization mode
+            PREDICTION_IMU,             // Recently lost with IMU
+            PREDICTION_RELOCALIZATION,
+            PREDICTION_VO               // Localization mode on visual odometry: motion model and relocalization
+        };
+
+        ePosePrediction ChoosePosePrediction(Map* pCurrentMap) const;
+        static bool PredictionNeedsBoW(ePosePrediction prediction);
+
+        // Bag of Words of the current frame: started on another thread when the pose prediction is going
+        // to need it, and waited for (or computed) when it does
+        void StartComputeBoW();
+        void ComputeBoW();
+
         bool TrackReferenceKeyFrame();
 
         void UpdateLastFrame();
@@ -262,6 +302,14 @@ namespace ORB_SLAM3
         //ORB
         ORBextractor* mpORBextractorLeft, * mpORBextractorRight;
         ORBextractor* mpIniORBextractor;
+        // Threads shared by the extractors, and by the Bag of Words of the current frame
+        WorkerPool* mpExtractorPool;
+
+        // Thread computing the Bag of Words of the current frame
+        TaskThread* mpBowThread;
+
+        // Quiescent between two frames
+        Reclaimer::Participant mReclaimerParticipant;
 
         //BoW
         ORBVocabulary* mpORBVocabulary;
@@ -275,6 +323,8 @@ namespace ORB_SLAM3
         KeyFrame* mpReferenceKF;
         std::vector<KeyFrame*> mvpLocalKeyFrames;
         std::vector<MapPoint*> mvpLocalMapPoints;
+        // Geometry of mvpLocalMapPoints for the frustum test of frames with a single camera
+        LocalMapProjection mLocalMapProjection;
 
         // System
         System* mpSystem;
@@ -340,6 +390,7 @@ namespace ORB_SLAM3
         ofstream f_track_stats;
 
         ofstream f_track_times;
+        double mTime_ORBExtract;
         double mTime_PreIntIMU;
         double mTime_PosePred;
         double mTime_LocalMapTrack;
@@ -31,6 +31,8 @@
 
 #include <sophus/se3.hpp>
 
+#include "utils/ObjectPool.h"
+
 namespace ORB_SLAM3
 {
 
@@ -122,7 +124,7 @@ public:
 class Preintegrated
 {
 public:
-    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    SLAM_POOLED_OPERATOR_NEW(Preintegrated)
     Preintegrated(const Bias &b_, const Calib &calib);
     Preintegrated(Preintegrated* pImuPre);
     Preintegrated() {}
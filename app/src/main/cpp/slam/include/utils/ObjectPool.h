@@ -0,0 +1,128 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace ORB_SLAM3
+{
+
+// Chunks of one size and alignment carved from large aligned slabs. Every thread keeps a cache of free
+// chunks per pool and only goes to the shared free list, under its lock, to move a batch in or out, so the
+// map objects created and freed by tracking and local mapping do not contend on the heap lock nor scatter
+// over it. Slabs are kept for the process life.
+class FixedPool
+{
+public:
+    static const int MAX_POOLS = 8;
+    // Chunks moved between a thread cache and the shared free list at once
+    static const int BATCH = 32;
+
+    struct Summary
+    {
+        std::string name;
+        size_t nChunkSize;
+        uint64_t nLive;
+        uint64_t nSlabBytes;
+    };
+
+    FixedPool(const char* name, size_t nSize, size_t nAlign);
+
+    FixedPool(const FixedPool&) = delete;
+    FixedPool& operator=(const FixedPool&) = delete;
+
+    void* Allocate();
+    void Free(void* p);
+
+    Summary GetSummary();
+
+    // Pools created so far.
+    static std::vector<Summary> GetSummaries();
+
+    struct Node
+    {
+        Node* pNext;
+    };
+
+private:
+    friend struct PoolThreadCache;
+
+    // Moves up to BATCH chunks of the shared list to the thread cache, carving a slab if it is empty.
+    Node* Refill(int &nCount);
+    // Gives a list of chunks back to the shared list.
+    void Release(Node* pFirst, Node* pLast);
+
+    const std::string mName;
+    const size_t mnChunkSize;
+    const size_t mnAlign;
+    const size_t mnChunksPerSlab;
+    int mnId;
+
+    std::mutex mMutex;
+    Node* mpFree;
+    std::vector<void*> mvpSlabs;
+
+    std::atomic<int64_t> mnLive;
+};
+
+// Pool of the objects of type T, of one chunk per object.
+template<class T>
+class ObjectPool
+{
+public:
+    static FixedPool& Get(const char* name)
+    {
+        // Never destroyed, objects may be freed during the exit
+        static FixedPool* pPool = new FixedPool(name, sizeof(T), alignof(T));
+        return *pPool;
+    }
+};
+
+} //namespace ORB_SLAM3
+
+// Class operator new and delete of T taking its objects from ObjectPool<T>, in place of
+// EIGEN_MAKE_ALIGNED_OPERATOR_NEW: the chunks are aligned for the fixed size Eigen members. Only objects of
+// exactly sizeof(T) fit a chunk, a class derived from T gets the global aligned operator new, and the size
+// given back to operator delete tells the two apart. Arrays of T use the global aligned operator new[].
+#define SLAM_POOLED_OPERATOR_NEW(T) \
+    static void* operator new(std::size_t nSize) \
+    { \
+        if(nSize != sizeof(T)) \
+            return ::operator new(nSize, std::align_val_t(alignof(T))); \
+        return ORB_SLAM3::ObjectPool<T>::Get(#T).Allocate(); \
+    } \
+    static void operator delete(void* p, std::size_t nSize) \
+    { \
+        if(!p) \
+            return; \
+        if(nSize != sizeof(T)) \
+            ::operator delete(p, std::align_val_t(alignof(T))); \
+        else \
+            ORB_SLAM3::ObjectPool<T>::Get(#T).Free(p); \
+    }
+
+#endif // OBJECTPOOL_H
@@ -0,0 +1,101 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ORB_SLAM3
+{
+
+// Value read without locking while another thread may write it. The writer makes the sequence odd, writes
+// the words of the value and makes it even again; a reader copies the words and starts over if the sequence
+// was odd or changed meanwhile, so it never blocks the writer and always gets a value as a whole. The words
+// are atomics, so the concurrent copy is not a data race.
+// Writers must be serialized by the owner (one lock around Store, or around Load + Store to change a part
+// of the value).
+template<class T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock values are copied word by word");
+    static_assert(sizeof(T) % sizeof(uint32_t) == 0, "SeqLock values are a whole number of words");
+
+public:
+    SeqLock(): mnSequence(0)
+    {
+        for(std::atomic<uint32_t>& w : mWords)
+            w.store(0, std::memory_order_relaxed);
+    }
+
+    explicit SeqLock(const T& value): SeqLock()
+    {
+        Store(value);
+    }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    T Load() const
+    {
+        uint32_t words[WORDS];
+        while(true)
+        {
+            const uint32_t nBegin = mnSequence.load(std::memory_order_acquire);
+            if(nBegin & 1)
+                continue;
+            for(int i=0; i<WORDS; i++)
+                words[i] = mWords[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(mnSequence.load(std::memory_order_relaxed)==nBegin)
+                break;
+        }
+
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+    void Store(const T& value)
+    {
+        uint32_t words[WORDS];
+        std::memcpy(words, &value, sizeof(T));
+
+        const uint32_t nSequence = mnSequence.load(std::memory_order_relaxed);
+        mnSequence.store(nSequence+1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for(int i=0; i<WORDS; i++)
+            mWords[i].store(words[i], std::memory_order_relaxed);
+        mnSequence.store(nSequence+2, std::memory_order_release);
+    }
+
+private:
+    static const int WORDS = sizeof(T) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> mnSequence;
+    std::atomic<uint32_t> mWords[WORDS];
+};
+
+} //namespace ORB_SLAM3
+
+#endif // SEQLOCK_H
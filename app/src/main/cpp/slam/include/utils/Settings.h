@@ -21,6 +21,7 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <optional>
 #include <string>
 
 #include "camera_models/GeometricCamera.h"
@@ -95,6 +96,10 @@ namespace ORB_SLAM3 {
                 int32_t nLevels;
                 int32_t initThFAST;
                 int32_t minThFAST;
+                int32_t nThreads = 1;
+                bool continuousAngle = false;
+                // ORBextractor::Distribution
+                int32_t distribution = 1;
             } orbInfo;
 
             struct
@@ -173,6 +178,9 @@ namespace ORB_SLAM3 {
         float initThFAST() {return initThFAST_;}
         float minThFAST() {return minThFAST_;}
         float scaleFactor() {return scaleFactor_;}
+        int extractorThreads() {return extractorThreads_;}
+        bool continuousAngle() {return continuousAngle_;}
+        int keyPointDistribution() {return keyPointDistribution_;}
 
         float keyFrameSize() {return keyFrameSize_;}
         float keyFrameLineWidth() {return keyFrameLineWidth_;}
@@ -281,6 +289,9 @@ namespace ORB_SLAM3 {
         float scaleFactor_;
         int nLevels_;
         int initThFAST_, minThFAST_;
+        int extractorThreads_;
+        bool continuousAngle_;
+        int keyPointDistribution_;
 
         /*
          * Viewer stuff
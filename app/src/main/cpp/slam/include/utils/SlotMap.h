@@ -0,0 +1,205 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ORB_SLAM3
+{
+
+// Place of an element in a SlotMap: its slot and the generation of the slot when the element got it.
+struct SlotHandle
+{
+    uint32_t nIndex = UINT32_MAX;
+    uint32_t nGeneration = 0;
+};
+
+// Set of T* with O(1) insert, erase and membership test, whose elements lie in one dense array so that
+// enumerating them is a contiguous scan. Every element keeps its SlotHandle in T::mMapSlot. The slot stays
+// the same while the element is in the container, erase moves the last element into the freed position and
+// bumps the generation of the slot, so a handle kept after the erase no longer resolves. An element is in
+// at most one SlotMap at a time (move it by erasing it before inserting it in the other one): erase and clear
+// reset the handle of the element, and insert asserts the element comes without one.
+// Not thread safe, the owner locks it.
+template<class T>
+class SlotMap
+{
+public:
+    // Read only copy of the elements, shared by every reader of the same version.
+    typedef std::shared_ptr<const std::vector<T*>> Snapshot;
+
+    SlotMap(): mnVersion(0), mnSnapshotVersion(0) {}
+
+    bool Contains(const T* p) const
+    {
+        // The handle may come from another container, the element check makes it safe
+        return Get(p->mMapSlot)==p;
+    }
+
+    // Element of a handle, NULL if it was erased since.
+    T* Get(const SlotHandle& h) const
+    {
+        if(h.nIndex>=mvSlots.size() || mvSlots[h.nIndex].nGeneration!=h.nGeneration ||
+           mvSlots[h.nIndex].nElement==FREE)
+            return NULL;
+        return mvpElements[mvSlots[h.nIndex].nElement];
+    }
+
+    // Returns false if p was already in.
+    bool Insert(T* p)
+    {
+        if(Contains(p))
+            return false;
+        // A valid handle here means p is still in another container, whose slot would be overwritten
+        assert(p->mMapSlot.nIndex==UINT32_MAX && "element already in another SlotMap");
+
+        uint32_t nIndex;
+        if(!mvnFreeSlots.empty())
+        {
+            nIndex = mvnFreeSlots.back();
+            mvnFreeSlots.pop_back();
+        }
+        else
+        {
+            nIndex = mvSlots.size();
+            mvSlots.push_back(Slot{FREE,0});
+        }
+
+        mvSlots[nIndex].nElement = mvpElements.size();
+        mvpElements.push_back(p);
+        mvnElementSlots.push_back(nIndex);
+        p->mMapSlot.nIndex = nIndex;
+        p->mMapSlot.nGeneration = mvSlots[nIndex].nGeneration;
+        mnVersion++;
+        return true;
+    }
+
+    // Returns false if p was not in.
+    bool Erase(T* p)
+    {
+        if(!Contains(p))
+            return false;
+
+        const uint32_t nIndex = p->mMapSlot.nIndex;
+        const uint32_t nElement = mvSlots[nIndex].nElement;
+        const uint32_t nLast = mvpElements.size()-1;
+        if(nElement!=nLast)
+        {
+            mvpElements[nElement] = mvpElements[nLast];
+            mvnElementSlots[nElement] = mvnElementSlots[nLast];
+            mvSlots[mvnElementSlots[nElement]].nElement = nElement;
+        }
+        mvpElements.pop_back();
+        mvnElementSlots.pop_back();
+
+        mvSlots[nIndex].nElement = FREE;
+        mvSlots[nIndex].nGeneration++;
+        mvnFreeSlots.push_back(nIndex);
+        p->mMapSlot = SlotHandle();
+        mnVersion++;
+        return true;
+    }
+
+    void Clear()
+    {
+        // Slots keep their generation so that handles copied from the cleared elements do not resolve
+        for(T* p : mvpElements)
+            p->mMapSlot = SlotHandle();
+        for(uint32_t nIndex : mvnElementSlots)
+        {
+            mvSlots[nIndex].nElement = FREE;
+            mvSlots[nIndex].nGeneration++;
+            mvnFreeSlots.push_back(nIndex);
+        }
+        mvpElements.clear();
+        mvnElementSlots.clear();
+        mnVersion++;
+    }
+
+    size_t Size() const
+    {
+        return mvpElements.size();
+    }
+
+    bool Empty() const
+    {
+        return mvpElements.empty();
+    }
+
+    // Elements in no particular order, valid until the next change.
+    const std::vector<T*>& Elements() const
+    {
+        return mvpElements;
+    }
+
+    // Incremented by every change.
+    uint64_t Version() const
+    {
+        return mnVersion;
+    }
+
+    // Snapshot of the current version. It is only rebuilt after a change, and in place when no reader
+    // still holds the previous one, so polling an unchanged map neither copies nor allocates.
+    Snapshot GetSnapshot()
+    {
+        if(!mpSnapshot || mnSnapshotVersion!=mnVersion)
+        {
+            // use_count() is a relaxed load. A reader dropping its copy decrements the count with release
+            // semantics, so once a count of one is seen the acquire fence orders the reader's last loads before
+            // the assign below. Copies are only made here, under the owner lock, so the count cannot rise again.
+            if(!mpSnapshot || mpSnapshot.use_count()>1)
+                mpSnapshot = std::make_shared<std::vector<T*>>();
+            else
+                std::atomic_thread_fence(std::memory_order_acquire);
+            mpSnapshot->assign(mvpElements.begin(), mvpElements.end());
+            mnSnapshotVersion = mnVersion;
+        }
+        return mpSnapshot;
+    }
+
+private:
+    static const uint32_t FREE = UINT32_MAX;
+
+    struct Slot
+    {
+        // Position in mvpElements, FREE if the slot is unused
+        uint32_t nElement;
+        uint32_t nGeneration;
+    };
+
+    std::vector<T*> mvpElements;
+    // Slot of each element
+    std::vector<uint32_t> mvnElementSlots;
+    std::vector<Slot> mvSlots;
+    std::vector<uint32_t> mvnFreeSlots;
+
+    uint64_t mnVersion;
+    std::shared_ptr<std::vector<T*>> mpSnapshot;
+    uint64_t mnSnapshotVersion;
+};
+
+} //namespace ORB_SLAM3
+
+#endif // SLOTMAP_H
@@ -0,0 +1,176 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SMALLVECTOR_H
+#define SMALLVECTOR_H
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ORB_SLAM3
+{
+
+// Vector of trivially copyable elements keeping the first N of them inside the object. Below that size it is
+// built, copied and destroyed without touching the heap. The interface follows std::vector, so it can stand
+// for it in range loops and generic code. Elements are moved with memcpy/memmove.
+template<class T, int N>
+class SmallVector
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SmallVector elements are moved with memcpy");
+    static_assert(N > 0, "SmallVector needs inline storage");
+
+public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    SmallVector(): mpData(mInline), mnSize(0), mnCapacity(N) {}
+
+    SmallVector(const SmallVector& other): SmallVector()
+    {
+        *this = other;
+    }
+
+    SmallVector(SmallVector&& other) noexcept: SmallVector()
+    {
+        *this = std::move(other);
+    }
+
+    ~SmallVector()
+    {
+        if(!IsInline())
+            ::operator delete(mpData);
+    }
+
+    SmallVector& operator=(const SmallVector& other)
+    {
+        if(this != &other)
+        {
+            mnSize = 0;
+            reserve(other.mnSize);
+            memcpy(mpData, other.mpData, other.mnSize*sizeof(T));
+            mnSize = other.mnSize;
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept
+    {
+        if(this == &other)
+            return *this;
+
+        if(other.IsInline())
+        {
+            // Inline elements can only be copied, and they fit in this object whatever its storage
+            memcpy(mpData, other.mpData, other.mnSize*sizeof(T));
+            mnSize = other.mnSize;
+        }
+        else
+        {
+            if(!IsInline())
+                ::operator delete(mpData);
+            mpData = other.mpData;
+            mnSize = other.mnSize;
+            mnCapacity = other.mnCapacity;
+            other.mpData = other.mInline;
+            other.mnCapacity = N;
+        }
+        other.mnSize = 0;
+        return *this;
+    }
+
+    iterator begin() { return mpData; }
+    iterator end() { return mpData + mnSize; }
+    const_iterator begin() const { return mpData; }
+    const_iterator end() const { return mpData + mnSize; }
+
+    size_t size() const { return mnSize; }
+    bool empty() const { return mnSize == 0; }
+    size_t capacity() const { return mnCapacity; }
+
+    T& operator[](size_t i) { return mpData[i]; }
+    const T& operator[](size_t i) const { return mpData[i]; }
+
+    T& front() { return mpData[0]; }
+    const T& front() const { return mpData[0]; }
+
+    void clear()
+    {
+        mnSize = 0;
+    }
+
+    void reserve(size_t n)
+    {
+        if(n <= mnCapacity)
+            return;
+
+        T* pData = static_cast<T*>(::operator new(n*sizeof(T)));
+        memcpy(pData, mpData, mnSize*sizeof(T));
+        if(!IsInline())
+            ::operator delete(mpData);
+        mpData = pData;
+        mnCapacity = static_cast<uint32_t>(n);
+    }
+
+    void push_back(const T& value)
+    {
+        insert(end(), value);
+    }
+
+    // Inserts before pos and returns the position of the new element.
+    iterator insert(iterator pos, const T& value)
+    {
+        const size_t i = pos - mpData;
+        // value may live in the storage that is about to be released or shifted
+        const T copy = value;
+        if(mnSize == mnCapacity)
+            reserve(2*mnCapacity);
+        memmove(mpData + i + 1, mpData + i, (mnSize - i)*sizeof(T));
+        mpData[i] = copy;
+        mnSize++;
+        return mpData + i;
+    }
+
+    // Removes the element at pos and returns the position of the next one.
+    iterator erase(iterator pos)
+    {
+        const size_t i = pos - mpData;
+        memmove(mpData + i, mpData + i + 1, (mnSize - i - 1)*sizeof(T));
+        mnSize--;
+        return mpData + i;
+    }
+
+    bool IsInline() const
+    {
+        return mpData == mInline;
+    }
+
+private:
+    T* mpData;
+    uint32_t mnSize;
+    uint32_t mnCapacity;
+    T mInline[N];
+};
+
+} //namespace ORB_SLAM3
+
+#endif // SMALLVECTOR_H
@@ -0,0 +1,110 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ORB_SLAM3
+{
+
+// Always-on timing statistics. Every named timer owns one histogram per thread, so recording a
+// sample is a few relaxed atomic stores on memory only the calling thread writes. Readers merge the
+// histograms of all threads without stopping the writers.
+class Stats
+{
+public:
+    static const int MAX_TIMERS = 64;
+
+    // Log-linear buckets over microseconds: 8 sub buckets per power of two (< 7% error) up to ~9 min.
+    static const int SUB_BUCKET_BITS = 3;
+    static const int NUM_BUCKETS = (27 << SUB_BUCKET_BITS);
+
+    struct Summary
+    {
+        std::string name;
+        uint64_t count;
+        double mean_ms;
+        double p50_ms;
+        double p95_ms;
+        double p99_ms;
+        double max_ms;
+    };
+
+    // Returns the id of the timer, registering it on first use. Ids are stable for the process life.
+    static int Register(const std::string& name);
+
+    static void Record(int id, double ms);
+
+    // Records end - start and, when tracing is enabled, the span itself. Returns the duration in ms.
+    static double Record(int id, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+    static const char* GetName(int id);
+
+    // Merged view of all the threads, only timers with samples are returned.
+    static std::vector<Summary> GetSummaries();
+
+    static void Reset();
+
+    static int BucketOf(uint64_t us);
+    static double BucketValueMs(int bucket);
+};
+
+// Records the lifetime of the scope into the timer id (and into the trace when enabled).
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(int id)
+        : mnId(id), mStart(std::chrono::steady_clock::now())
+    {}
+
+    ~ScopedTimer()
+    {
+        Stats::Record(mnId, mStart, std::chrono::steady_clock::now());
+    }
+
+    double ElapsedMs() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStart).count();
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    int mnId;
+    std::chrono::steady_clock::time_point mStart;
+};
+
+} //namespace ORB_SLAM3
+
+// Id of a named timer, registered once per call site.
+#define SLAM_STAT_ID(name) ([]() { static const int nStatId = ORB_SLAM3::Stats::Register(name); return nStatId; }())
+
+#define SLAM_STAT_CONCAT_INNER(a, b) a##b
+#define SLAM_STAT_CONCAT(a, b) SLAM_STAT_CONCAT_INNER(a, b)
+
+// Times the rest of the enclosing scope.
+#define SLAM_SCOPED_TIMER(name) ORB_SLAM3::ScopedTimer SLAM_STAT_CONCAT(scopedTimer_, __LINE__)(SLAM_STAT_ID(name))
+
+#endif // STATS_H
@@ -0,0 +1,106 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+
+namespace ORB_SLAM3
+{
+
+// Span recorder for cross thread latency analysis. Every thread writes complete (begin + duration)
+// events into its own ring buffer, the newest events of all threads can be dumped as Chrome trace
+// json (chrome://tracing, ui.perfetto.dev). Disabled by default, a disabled span costs one relaxed load.
+class Trace
+{
+public:
+    // Events kept per thread, older ones are overwritten.
+    static const int EVENTS_PER_THREAD = 16384;
+
+    static void SetEnabled(bool bEnabled);
+    static bool IsEnabled()
+    {
+        return mbEnabled.load(std::memory_order_relaxed);
+    }
+
+    // Name of the calling thread in the dump. The string must outlive the trace (literal).
+    static void SetThreadName(const char* name);
+
+    // Records a span of the calling thread. The name must outlive the trace (literal or Stats name).
+    static void Complete(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+    // Writes the events which ended within the last windowSeconds (all the kept ones if <= 0).
+    static bool DumpChromeJson(const std::string& filename, double windowSeconds = 0.0);
+
+    static void Clear();
+
+private:
+    static std::atomic<bool> mbEnabled;
+};
+
+// Records the lifetime of the scope when tracing is enabled.
+class ScopedTrace
+{
+public:
+    explicit ScopedTrace(const char* name)
+        : mName(Trace::IsEnabled() ? name : nullptr)
+    {
+        if(mName)
+            mStart = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedTrace()
+    {
+        if(mName)
+            Trace::Complete(mName, mStart, std::chrono::steady_clock::now());
+    }
+
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+private:
+    const char* mName;
+    std::chrono::steady_clock::time_point mStart;
+};
+
+// Locks the mutex, recording a span named name if the lock was contended.
+template<typename Mutex>
+std::unique_lock<Mutex> TracedLock(Mutex& mutex, const char* name)
+{
+    std::unique_lock<Mutex> lock(mutex, std::try_to_lock);
+    if(!lock.owns_lock())
+    {
+        ScopedTrace trace(name);
+        lock.lock();
+    }
+    return lock;
+}
+
+} //namespace ORB_SLAM3
+
+#define SLAM_TRACE_CONCAT_INNER(a, b) a##b
+#define SLAM_TRACE_CONCAT(a, b) SLAM_TRACE_CONCAT_INNER(a, b)
+
+// Traces the rest of the enclosing scope.
+#define SLAM_TRACE_SCOPE(name) ORB_SLAM3::ScopedTrace SLAM_TRACE_CONCAT(scopedTrace_, __LINE__)(name)
+
+#endif // TRACE_H
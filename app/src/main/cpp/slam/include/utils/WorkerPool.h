@@ -0,0 +1,117 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ORB_SLAM3
+{
+
+// Fixed set of threads running index based loops. The calling thread works on the loop too, so a pool
+// of nThreads starts nThreads - 1 workers and a pool of 1 thread runs everything on the caller.
+class WorkerPool
+{
+public:
+    explicit WorkerPool(int nThreads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int GetNumThreads() const
+    {
+        return static_cast<int>(mvThreads.size()) + 1;
+    }
+
+    // Calls f(0) ... f(nTasks-1) and returns once all of them are done. Indices are handed out in
+    // increasing order, so put the largest tasks first. If another loop is running on the pool (two
+    // extractors of a stereo frame), the caller runs its loop alone instead of waiting.
+    void ParallelFor(int nTasks, const std::function<void(int)>& f);
+
+private:
+    void Run();
+    void RunTasks(const std::function<void(int)>& f);
+
+    std::vector<std::thread> mvThreads;
+
+    std::mutex mMutexLoop;
+
+    std::mutex mMutex;
+    std::condition_variable mCondWork;
+    std::condition_variable mCondDone;
+    const std::function<void(int)>* mpTask;
+    int mnTasks;
+    std::atomic<int> mnNextTask;
+    int mnActive;
+    uint64_t mnGeneration;
+    bool mbStop;
+};
+
+// One long lived thread running the tasks handed to it one at a time, for work a thread starts early and
+// waits for later on (the Bag of Words of the tracked frame), without a thread being created per task.
+// Submit() and Wait() are called by a single owner thread.
+class TaskThread
+{
+public:
+    explicit TaskThread(const char* name);
+    ~TaskThread();
+
+    TaskThread(const TaskThread&) = delete;
+    TaskThread& operator=(const TaskThread&) = delete;
+
+    // Runs f on the thread. A task submitted and not waited for yet is waited for first.
+    void Submit(std::function<void()> f);
+
+    // True from Submit() until Wait() returns.
+    bool Pending() const
+    {
+        return mbPending;
+    }
+
+    // Waits for the submitted task. Returns false at once when there is none.
+    bool Wait();
+
+private:
+    void Run();
+
+    const char* mpName;
+
+    std::mutex mMutex;
+    std::condition_variable mCondWork;
+    std::condition_variable mCondDone;
+    std::function<void()> mTask;
+    bool mbBusy;
+    bool mbStop;
+
+    // Owner thread only
+    bool mbPending;
+
+    std::thread mThread;
+};
+
+} //namespace ORB_SLAM3
+
+#endif // WORKERPOOL_H
@@ -0,0 +1,172 @@
+#include "SensorLog.h"
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace android_slam
+{
+namespace sensor_log_utils
+{
+
+constexpr char k_magic[4] = { 'A', 'S', 'L', 'G' };
+
+// Upper bound of a sane record, guards against reading garbage as a huge allocation.
+constexpr uint32_t k_max_images     = 4;
+constexpr uint32_t k_max_imus       = 1 << 16;
+constexpr uint32_t k_max_image_size = 64 << 20;
+
+template <typename T>
+void writeValue(std::ofstream& fout, const T& value)
+{
+    fout.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readValue(std::ifstream& fin, T& value)
+{
+    fin.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return fin.good();
+}
+
+}  // namespace sensor_log_utils
+
+SensorLogWriter::SensorLogWriter(const std::string& file, int32_t img_width, int32_t img_height, int64_t begin_time_stamp)
+    : m_file(file, std::ios::binary)
+{
+    using namespace sensor_log_utils;
+
+    if (!m_file.is_open())
+    {
+        std::cerr << "[Android Slam Info] Failed to create sensor log " << file << "." << std::endl;
+        return;
+    }
+
+    m_file.write(k_magic, sizeof(k_magic));
+    writeValue(m_file, k_version);
+    writeValue(m_file, img_width);
+    writeValue(m_file, img_height);
+    writeValue(m_file, begin_time_stamp);
+}
+
+void SensorLogWriter::write(const std::vector<Image>& images, const std::vector<ImuPoint>& imus)
+{
+    using sensor_log_utils::writeValue;
+
+    if (!m_file.is_open()) return;
+
+    writeValue(m_file, static_cast<uint32_t>(images.size()));
+    writeValue(m_file, static_cast<uint32_t>(imus.size()));
+    for (const Image& image : images)
+    {
+        writeValue(m_file, image.time_stamp);
+        writeValue(m_file, static_cast<uint32_t>(image.data.size()));
+        m_file.write(reinterpret_cast<const char*>(image.data.data()), static_cast<std::streamsize>(image.data.size()));
+    }
+    for (const ImuPoint& imu : imus)
+    {
+        writeValue(m_file, imu.ax);
+        writeValue(m_file, imu.ay);
+        writeValue(m_file, imu.az);
+        writeValue(m_file, imu.wx);
+        writeValue(m_file, imu.wy);
+        writeValue(m_file, imu.wz);
+        writeValue(m_file, imu.time_stamp);
+    }
+
+    ++m_record_count;
+}
+
+SensorLogReader::SensorLogReader(const std::string& file)
+    : m_file(file, std::ios::binary)
+{
+    using namespace sensor_log_utils;
+
+    char     magic[4] = {};
+    uint32_t version  = 0;
+    m_file.read(magic, sizeof(magic));
+    if (!m_file.good() || memcmp(magic, k_magic, sizeof(magic)) != 0 || !readValue(m_file, version) ||
+        version != SensorLogWriter::k_version || !readValue(m_file, m_width) || !readValue(m_file, m_height) ||
+        !readValue(m_file, m_begin_time_stamp) || m_width <= 0 || m_height <= 0 ||
+        (uint64_t)m_width * (uint64_t)m_height * 3 > k_max_image_size)
+    {
+        std::cerr << "[Android Slam Info] " << file << " is not a version " << SensorLogWriter::k_version
+                  << " sensor log." << std::endl;
+        return;
+    }
+
+    m_valid = true;
+}
+
+bool SensorLogReader::next(std::vector<Image>& images, std::vector<ImuPoint>& imus)
+{
+    using namespace sensor_log_utils;
+
+    if (!m_valid) return false;
+
+    uint32_t image_count = 0;
+    uint32_t imu_count   = 0;
+    if (!readValue(m_file, image_count) || !readValue(m_file, imu_count) || image_count > k_max_images || imu_count > k_max_imus)
+    {
+        return false;
+    }
+
+    images.resize(image_count);
+    for (Image& image : images)
+    {
+        uint32_t size = 0;
+        if (!readValue(m_file, image.time_stamp) || !readValue(m_file, size)) return false;
+
+        // The kernel copies the buffer into a width x height RGB image, anything else is a corrupt record.
+        if (size != (uint64_t)m_width * (uint64_t)m_height * 3)
+        {
+            std::cerr << "[Android Slam Info] Image of " << size << " bytes in a " << m_width << "x" << m_height
+                      << " sensor log." << std::endl;
+            m_valid = false;
+            return false;
+        }
+
+        image.data.resize(size);
+        m_file.read(reinterpret_cast<char*>(image.data.data()), size);
+    }
+
+    imus.resize(imu_count);
+    for (ImuPoint& imu : imus)
+    {
+        readValue(m_file, imu.ax);
+        readValue(m_file, imu.ay);
+        readValue(m_file, imu.az);
+        readValue(m_file, imu.wx);
+        readValue(m_file, imu.wy);
+        readValue(m_file, imu.wz);
+        readValue(m_file, imu.time_stamp);
+    }
+
+    return m_file.good();
+}
+
+bool SensorLogReplayer::step(SlamKernel& kernel, TrackingResult& result)
+{
+    if (!m_reader.next(m_images, m_imus) || m_images.empty()) return false;
+
+    const int64_t time_stamp = m_images[0].time_stamp;
+    if (m_record_index == 0)
+    {
+        m_first_time_stamp = time_stamp;
+        m_first_wall_time  = std::chrono::steady_clock::now();
+    }
+    else if (m_options.pace == Pace::WallClock)
+    {
+        std::this_thread::sleep_until(m_first_wall_time + std::chrono::nanoseconds(time_stamp - m_first_time_stamp));
+    }
+
+    result = kernel.handleData(m_images, m_imus);
+    if (m_options.deterministic)
+    {
+        kernel.waitUntilIdle();
+    }
+
+    ++m_record_index;
+    return true;
+}
+
+}  // namespace android_slam
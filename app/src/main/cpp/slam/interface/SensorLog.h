@@ -0,0 +1,109 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "SlamKernel.h"
+
+namespace android_slam
+{
+
+// Binary log of the exact input of SlamKernel::handleData(), one record per call.
+//
+// Layout (little endian), version 1:
+//   header  char[4] "ASLG", uint32 version, int32 width, int32 height, int64 begin_time_stamp
+//   record  uint32 image_count, uint32 imu_count,
+//           image_count x (int64 time_stamp, uint32 byte_count, uint8 rgb[byte_count]),
+//           imu_count   x (float ax, ay, az, wx, wy, wz, int64 time_stamp)
+// A truncated last record (app killed while recording) is ignored by the reader.
+class SensorLogWriter
+{
+public:
+    static constexpr uint32_t k_version = 1;
+
+public:
+    SensorLogWriter(const std::string& file, int32_t img_width, int32_t img_height, int64_t begin_time_stamp);
+    SensorLogWriter(const SensorLogWriter&)            = delete;
+    SensorLogWriter& operator=(const SensorLogWriter&) = delete;
+
+    bool isOpen() const { return m_file.is_open(); }
+    size_t recordCount() const { return m_record_count; }
+
+    void write(const std::vector<Image>& images, const std::vector<ImuPoint>& imus);
+
+private:
+    std::ofstream m_file;
+    size_t        m_record_count = 0;
+};
+
+class SensorLogReader
+{
+public:
+    explicit SensorLogReader(const std::string& file);
+    SensorLogReader(const SensorLogReader&)            = delete;
+    SensorLogReader& operator=(const SensorLogReader&) = delete;
+
+    bool isValid() const { return m_valid; }
+
+    int32_t width() const { return m_width; }
+    int32_t height() const { return m_height; }
+    int64_t beginTimeStamp() const { return m_begin_time_stamp; }
+
+    // Reads the next record, false at the end of the log.
+    bool next(std::vector<Image>& images, std::vector<ImuPoint>& imus);
+
+private:
+    std::ifstream m_file;
+    bool          m_valid            = false;
+    int32_t       m_width            = 0;
+    int32_t       m_height           = 0;
+    int64_t       m_begin_time_stamp = 0;
+};
+
+// Feeds a sensor log to a SlamKernel created with the log's size and begin time stamp.
+class SensorLogReplayer
+{
+public:
+    enum class Pace
+    {
+        MaxSpeed,   // Next record as soon as the previous one is tracked.
+        WallClock,  // Records are spaced by their image time stamps, as on the device.
+    };
+
+    struct Options
+    {
+        Pace pace = Pace::MaxSpeed;
+
+        // Waits for local mapping and loop closing (including global BA) to go idle after every
+        // record, so every run sees the same interleaving of the slam threads.
+        bool deterministic = false;
+    };
+
+public:
+    SensorLogReplayer(SensorLogReader& reader, Options options) noexcept
+        : m_reader(reader)
+        , m_options(options)
+    {}
+
+    // Feeds the next record, false at the end of the log.
+    bool step(SlamKernel& kernel, TrackingResult& result);
+
+    size_t recordIndex() const { return m_record_index; }
+    // Time stamp of the first image of the last fed record.
+    int64_t lastTimeStamp() const { return m_images.empty() ? 0 : m_images[0].time_stamp; }
+
+private:
+    SensorLogReader& m_reader;
+    const Options    m_options;
+
+    size_t                m_record_index = 0;
+    std::vector<Image>    m_images;
+    std::vector<ImuPoint> m_imus;
+
+    int64_t                               m_first_time_stamp = 0;
+    std::chrono::steady_clock::time_point m_first_wall_time;
+};
+
+}  // namespace android_slam
@@ -8,13 +8,33 @@
 
 #include <core/System.h>
 #include <feature/ORBVocabulary.h>
+#include <map/Reclaimer.h>
+#include <utils/ObjectPool.h>
 #include <utils/Settings.h>
+#include <utils/Stats.h>
+#include <utils/Trace.h>
 
 
 namespace android_slam
 {
 
 SlamKernel::SlamKernel(int32_t img_width, int32_t img_height, std::string vocabulary_data, int64_t begin_time_stamp)
+    : SlamKernel(img_width, img_height, std::make_shared<const std::string>(std::move(vocabulary_data)), begin_time_stamp)
+{}
+
+SlamKernel::SlamKernel(int32_t                                   img_width,
+                       int32_t                                   img_height,
+                       const std::shared_ptr<const std::string>& vocabulary_data,
+                       int64_t                                   begin_time_stamp)
+    : SlamKernel(img_width, img_height, vocabulary_data->data(), vocabulary_data->size(), vocabulary_data, begin_time_stamp)
+{}
+
+SlamKernel::SlamKernel(int32_t                     img_width,
+                       int32_t                     img_height,
+                       const void*                 vocabulary_data,
+                       size_t                      vocabulary_size,
+                       std::shared_ptr<const void> vocabulary_owner,
+                       int64_t                     begin_time_stamp)
     : m_width(img_width)
     , m_height(img_height)
     , m_begin_time_stamp(begin_time_stamp)
@@ -64,6 +84,7 @@ SlamKernel::SlamKernel(int32_t img_width, int32_t img_height, std::string vocabu
     desc.orbInfo.nLevels              = 8;
     desc.orbInfo.initThFAST           = 20;
     desc.orbInfo.minThFAST            = 7;
+    desc.orbInfo.nThreads             = 4;
     desc.viewerInfo.keyframeSize      = 0.05f;
     desc.viewerInfo.keyframeLineWidth = 1.0f;
     desc.viewerInfo.graphLineWidth    = 0.9f;
@@ -79,7 +100,15 @@ SlamKernel::SlamKernel(int32_t img_width, int32_t img_height, std::string vocabu
 
 
     auto vocabulary = new ::ORB_SLAM3::ORBVocabulary();
-    vocabulary->loadFromAndroidTextFile(std::move(vocabulary_data));
+    if (::ORB_SLAM3::ORBVocabulary::isBinary(vocabulary_data, vocabulary_size))
+    {
+        vocabulary->loadFromBinaryBuffer(vocabulary_data, vocabulary_size, std::move(vocabulary_owner));
+    }
+    else
+    {
+        auto text = static_cast<const char*>(vocabulary_data);
+        vocabulary->loadFromAndroidTextFile(std::string(text, text + vocabulary_size));
+    }
 
 
     m_orb_slam = std::make_unique<::ORB_SLAM3::System>(vocabulary,
@@ -98,8 +127,76 @@ void SlamKernel::reset()
     m_orb_slam->Reset();
 }
 
+void SlamKernel::waitUntilIdle()
+{
+    m_orb_slam->WaitUntilIdle();
+}
+
+void SlamKernel::saveTrajectory(const std::string& frame_file, const std::string& key_frame_file)
+{
+    m_orb_slam->Shutdown();
+    m_orb_slam->SaveTrajectoryEuRoC(frame_file);
+    m_orb_slam->SaveKeyFrameTrajectoryEuRoC(key_frame_file);
+}
+
+std::vector<TimerStats> SlamKernel::getStats() const
+{
+    std::vector<TimerStats> res;
+    for (const ORB_SLAM3::Stats::Summary& summary : ORB_SLAM3::Stats::GetSummaries())
+    {
+        res.push_back({ summary.name,
+                        summary.count,
+                        summary.mean_ms,
+                        summary.p50_ms,
+                        summary.p95_ms,
+                        summary.p99_ms,
+                        summary.max_ms });
+    }
+    return res;
+}
+
+MemoryStats SlamKernel::getMemoryStats() const
+{
+    const ORB_SLAM3::Reclaimer::Summary summary = ORB_SLAM3::Reclaimer::GetSummary();
+
+    MemoryStats res;
+    res.key_frames              = summary.nKeyFrames;
+    res.key_frame_bytes         = summary.nKeyFrameBytes;
+    res.retired_key_frames      = summary.nRetiredKeyFrames;
+    res.retired_key_frame_bytes = summary.nRetiredKeyFrameBytes;
+    res.reclaimed_key_frames    = summary.nReclaimedKeyFrames;
+    res.reclaimed_bytes         = summary.nReclaimedBytes;
+    res.map_points              = summary.nMapPoints;
+    res.map_point_bytes         = summary.nMapPointBytes;
+    res.bad_map_points          = summary.nBadMapPoints;
+    res.bad_map_point_bytes     = summary.nBadMapPointBytes;
+    return res;
+}
+
+std::vector<PoolStats> SlamKernel::getPoolStats() const
+{
+    std::vector<PoolStats> res;
+    for (const ORB_SLAM3::FixedPool::Summary& summary : ORB_SLAM3::FixedPool::GetSummaries())
+    {
+        res.push_back({ summary.name, summary.nChunkSize, summary.nLive, summary.nSlabBytes });
+    }
+    return res;
+}
+
+void SlamKernel::setTracing(bool enabled)
+{
+    ORB_SLAM3::Trace::SetEnabled(enabled);
+}
+
+bool SlamKernel::dumpTrace(const std::string& file, double window_seconds) const
+{
+    return ORB_SLAM3::Trace::DumpChromeJson(file, window_seconds);
+}
+
 TrackingResult SlamKernel::handleData(const std::vector<Image>& images, const std::vector<ImuPoint>& imus)
 {
+    const std::chrono::steady_clock::time_point begin_time = std::chrono::steady_clock::now();
+
     // Image assertion.
     const Image& image = images[0];
     assert((image.time_stamp >= m_begin_time_stamp) && "Invalid time stamp.");
@@ -128,6 +225,17 @@ TrackingResult SlamKernel::handleData(const std::vector<Image>& images, const st
     // Set tracking result.
     TrackingResult res;
 
+    // Stage time cost.
+    {
+        const ORB_SLAM3::Tracking& tracker = m_orb_slam->getTracker();
+
+        res.stage_time.extract   = tracker.GetTimeORBExtract();
+        res.stage_time.track     = tracker.GetTimePreIntIMU() + tracker.GetTimePosePred() + tracker.GetTimeNewKFDec();
+        res.stage_time.local_map = tracker.GetTimeLocalMapTrack();
+        res.stage_time.total =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin_time).count();
+    }
+
     // Pose.
     {
         Eigen::Matrix4f mat_pose = pose.matrix();
@@ -154,7 +262,8 @@ TrackingResult SlamKernel::handleData(const std::vector<Image>& images, const st
     if (ORB_SLAM3::Map* active_map = m_orb_slam->getAtlas().GetCurrentMap())
     {
         {
-            std::vector<ORB_SLAM3::KeyFrame*> key_frames = active_map->GetAllKeyFrames();
+            // Shared snapshot, it is only copied again after the map changed.
+            const auto key_frames = active_map->GetKeyFrameSnapshot();
 
             static auto key_frame_cmp = [](const ORB_SLAM3::KeyFrame* kf1, const ORB_SLAM3::KeyFrame* kf2) -> bool
             {
@@ -163,7 +272,7 @@ TrackingResult SlamKernel::handleData(const std::vector<Image>& images, const st
                 return kf1->mnFrameId < kf2->mnFrameId;
             };
             std::set<ORB_SLAM3::KeyFrame*, decltype(key_frame_cmp)> kf_set(key_frame_cmp);
-            for (ORB_SLAM3::KeyFrame* kf : key_frames)
+            for (ORB_SLAM3::KeyFrame* kf : *key_frames)
             {
                 if (!kf || kf->isBad()) continue;
 
@@ -194,8 +303,8 @@ TrackingResult SlamKernel::handleData(const std::vector<Image>& images, const st
                 res.map_points.push_back({ position.x(), position.y(), position.z() });
             }
 
-            std::vector<ORB_SLAM3::MapPoint*> all_mps = active_map->GetAllMapPoints();
-            for (ORB_SLAM3::MapPoint* mp : all_mps)
+            const auto all_mps = active_map->GetMapPointSnapshot();
+            for (ORB_SLAM3::MapPoint* mp : *all_mps)
             {
                 if (!mp || mp->isBad() || local_mp_ust.find(mp) != local_mp_ust.end()) continue;
 
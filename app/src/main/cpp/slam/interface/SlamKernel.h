@@ -1,5 +1,6 @@
 #pragma once
 #include <array>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -57,11 +58,60 @@ struct TrackingResult
         float z;
     };
 
+    // Wall time (ms) of each stage of handleData() for this frame. track covers the imu preintegration,
+    // the pose prediction and the new key frame decision, local_map the local map tracking.
+    struct StageTime
+    {
+        double extract;
+        double track;
+        double local_map;
+        double total;
+    };
+
     std::array<float, 16> last_pose;
     std::vector<Pos>      trajectory;
     std::vector<Pos>      map_points;
 
-    float processing_delta_time;
+    StageTime stage_time;
+    float     processing_delta_time;
+};
+
+// Latency distribution (ms) of one named timer of the slam threads, over the whole process life.
+struct TimerStats
+{
+    std::string name;
+    uint64_t    count;
+    double      mean;
+    double      p50;
+    double      p95;
+    double      p99;
+    double      max;
+};
+
+// Key frames and map points in memory. Bad key frames are retired, then their features are reclaimed once
+// the slam threads no longer read them; bad map points stay in memory.
+struct MemoryStats
+{
+    uint64_t key_frames;
+    uint64_t key_frame_bytes;
+    uint64_t retired_key_frames;
+    uint64_t retired_key_frame_bytes;
+    uint64_t reclaimed_key_frames;
+    uint64_t reclaimed_bytes;
+    uint64_t map_points;
+    uint64_t map_point_bytes;
+    uint64_t bad_map_points;
+    uint64_t bad_map_point_bytes;
+};
+
+// Slab pool of one type of map object (key frames, map points, imu preintegrations): objects alive and
+// bytes of the slabs they were carved from.
+struct PoolStats
+{
+    std::string name;
+    uint64_t    chunk_size;
+    uint64_t    live;
+    uint64_t    slab_bytes;
 };
 
 class SlamKernel
@@ -71,7 +121,16 @@ private:
     static constexpr double  k_nano_sec_to_sec_radio     = 1.0 / (double)(k_nano_second_in_one_second);
 
 public:
+    // vocabulary_data is the contents of ORBVoc.txt, or of a binary vocabulary written by vocabulary_converter.
     SlamKernel(int32_t img_width, int32_t img_height, std::string vocabulary_data, int64_t begin_time_stamp);
+    // A binary vocabulary is used in place, vocabulary_owner keeps the buffer alive (an asset, a mapped file)
+    // as long as the kernel needs it. A text vocabulary is parsed.
+    SlamKernel(int32_t                     img_width,
+               int32_t                     img_height,
+               const void*                 vocabulary_data,
+               size_t                      vocabulary_size,
+               std::shared_ptr<const void> vocabulary_owner,
+               int64_t                     begin_time_stamp);
     SlamKernel(const SlamKernel&)            = delete;
     SlamKernel& operator=(const SlamKernel&) = delete;
     ~SlamKernel(); // 不可以设置为=default，因为m_orb_slam本身不完整，因此需要放置到cpp文件中定义析构函数
@@ -80,6 +139,36 @@ public:
 
     void reset();
 
+    // Blocks until the local mapping and loop closing threads have no pending work.
+    void waitUntilIdle();
+
+    // Timers of tracking, local mapping, loop closing and the optimizers that have samples.
+    // Cheap enough to be polled from the ui thread.
+    std::vector<TimerStats> getStats() const;
+
+    // Counts of the whole process, as cheap as getStats().
+    MemoryStats getMemoryStats() const;
+    std::vector<PoolStats> getPoolStats() const;
+
+    // Span tracing of the slam threads (stages, optimizers and contended map locks), off by default.
+    // dumpTrace() writes Chrome trace json of the spans that ended within the last window_seconds,
+    // or of every span still in the per thread ring buffers when window_seconds <= 0.
+    void setTracing(bool enabled);
+    bool dumpTrace(const std::string& file, double window_seconds = 0.0) const;
+
+    // Stops the slam threads and writes the frame and keyframe trajectories in EuRoC format.
+    // Time stamps are relative to begin_time_stamp. handleData() must not be called afterwards.
+    void saveTrajectory(const std::string& frame_file, const std::string& key_frame_file);
+
+    // The underlying ORB-SLAM3 system, only meant for the host tools (benchmarks, fixture capture).
+    ::ORB_SLAM3::System& getSystem() { return *m_orb_slam; }
+
+private:
+    SlamKernel(int32_t                                   img_width,
+               int32_t                                   img_height,
+               const std::shared_ptr<const std::string>& vocabulary_data,
+               int64_t                                   begin_time_stamp);
+
 private:
     int32_t       m_width;
     int32_t       m_height;
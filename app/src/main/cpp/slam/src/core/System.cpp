@@ -260,11 +260,27 @@ System::System(ORBVocabulary* vocabulary, Settings* settings, const eSensor sens
     }
 }
 
+void System::WaitUntilIdle()
+{
+    // Local mapping hands its keyframe to loop closing before accepting new ones again
+    while(mpLocalMapper->KeyframesInQueue() > 0 || !mpLocalMapper->AcceptKeyFrames() || !mpLoopCloser->isIdle())
+    {
+        if(mpLocalMapper->isFinished())
+            break;
+        usleep(500);
+    }
+}
+
 Tracking& System::getTracker() const
 {
     return *mpTracker;
 }
 
+LocalMapping& System::getLocalMapper() const
+{
+    return *mpLocalMapper;
+}
+
 Sophus::SE3f System::TrackStereo(const cv::Mat &imLeft, const cv::Mat &imRight, const double &timestamp, const vector<IMU::Point>& vImuMeas, string filename)
 {
     if(mSensor!=STEREO && mSensor!=IMU_STEREO)
@@ -544,6 +560,8 @@ void System::Shutdown()
 {
     {
         unique_lock<mutex> lock(mMutexReset);
+        if (mbShutDown)
+            return;
         mbShutDown = true;
     }
 
@@ -673,10 +691,10 @@ void System::SaveTrajectoryEuRoC(const string &filename)
     std::cout << "There are " << std::to_string(vpMaps.size()) << " maps in the atlas" << std::endl;
     for(Map* pMap :vpMaps)
     {
-        std::cout << "  Map " << std::to_string(pMap->GetId()) << " has " << std::to_string(pMap->GetAllKeyFrames().size()) << " KFs" << std::endl;
-        if(pMap->GetAllKeyFrames().size() > numMaxKFs)
+        std::cout << "  Map " << std::to_string(pMap->GetId()) << " has " << std::to_string(pMap->KeyFramesInMap()) << " KFs" << std::endl;
+        if(pMap->KeyFramesInMap() > numMaxKFs)
         {
-            numMaxKFs = pMap->GetAllKeyFrames().size();
+            numMaxKFs = pMap->KeyFramesInMap();
             pBiggerMap = pMap;
         }
     }
@@ -894,9 +912,9 @@ void System::SaveTrajectoryEuRoC(const string &filename, Map* pMap)
     int numMaxKFs = 0;
     for(Map* pMap :vpMaps)
     {
-        if(pMap->GetAllKeyFrames().size() > numMaxKFs)
+        if(pMap->KeyFramesInMap() > numMaxKFs)
         {
-            numMaxKFs = pMap->GetAllKeyFrames().size();
+            numMaxKFs = pMap->KeyFramesInMap();
             pBiggerMap = pMap;
         }
     }
@@ -1009,9 +1027,9 @@ void System::SaveTrajectoryEuRoC(const string &filename, Map* pMap)
     int numMaxKFs = 0;
     for(Map* pMap :vpMaps)
     {
-        if(pMap->GetAllKeyFrames().size() > numMaxKFs)
+        if(pMap->KeyFramesInMap() > numMaxKFs)
         {
-            numMaxKFs = pMap->GetAllKeyFrames().size();
+            numMaxKFs = pMap->KeyFramesInMap();
             pBiggerMap = pMap;
         }
     }
@@ -1061,9 +1079,9 @@ void System::SaveKeyFrameTrajectoryEuRoC(const string &filename)
     int numMaxKFs = 0;
     for(Map* pMap :vpMaps)
     {
-        if(pMap && pMap->GetAllKeyFrames().size() > numMaxKFs)
+        if(pMap && pMap->KeyFramesInMap() > numMaxKFs)
         {
-            numMaxKFs = pMap->GetAllKeyFrames().size();
+            numMaxKFs = pMap->KeyFramesInMap();
             pBiggerMap = pMap;
         }
     }
@@ -1382,22 +1400,6 @@ float System::GetImageScale()
     return mpTracker->GetImageScale();
 }
 
-#ifdef REGISTER_TIMES
-void System::InsertRectTime(double& time)
-{
-    mpTracker->vdRectStereo_ms.push_back(time);
-}
-
-void System::InsertResizeTime(double& time)
-{
-    mpTracker->vdResizeImage_ms.push_back(time);
-}
-
-void System::InsertTrackTime(double& time)
-{
-    mpTracker->vdTrackTotal_ms.push_back(time);
-}
-#endif
 
 
 } //namespace ORB_SLAM
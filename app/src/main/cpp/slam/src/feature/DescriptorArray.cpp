@@ -0,0 +1,63 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "feature/DescriptorArray.h"
+
+#include <cstring>
+
+namespace ORB_SLAM3
+{
+
+DescriptorArray::DescriptorArray(const cv::Mat& descriptors)
+{
+    Assign(descriptors);
+}
+
+void DescriptorArray::Assign(const cv::Mat& descriptors)
+{
+    if(descriptors.empty())
+    {
+        mvData.clear();
+        return;
+    }
+
+    CV_Assert(descriptors.type() == CV_8U && descriptors.cols == PackedDescriptor::L);
+
+    mvData.resize(descriptors.rows);
+    if(descriptors.isContinuous())
+        memcpy(mvData.data(), descriptors.data, mvData.size() * PackedDescriptor::L);
+    else
+        for(int i=0; i<descriptors.rows; i++)
+            memcpy(mvData[i].data, descriptors.ptr<unsigned char>(i), PackedDescriptor::L);
+}
+
+void DescriptorArray::Append(const DescriptorArray& other)
+{
+    mvData.insert(mvData.end(), other.mvData.begin(), other.mvData.end());
+}
+
+cv::Mat DescriptorArray::Mat() const
+{
+    if(mvData.empty())
+        return cv::Mat(0, PackedDescriptor::L, CV_8U);
+    return cv::Mat(Size(), PackedDescriptor::L, CV_8U, const_cast<unsigned char*>(Data()));
+}
+
+} //namespace ORB_SLAM3
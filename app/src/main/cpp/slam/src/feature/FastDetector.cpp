@@ -0,0 +1,475 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "feature/FastDetector.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define FAST_DETECTOR_AVX2
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace ORB_SLAM3
+{
+
+namespace
+{
+
+// Bresenham circle of radius 3, plus the first 9 pixels again so that arcs never wrap.
+const int CIRCLE_SIZE = 16;
+const int ARC_LENGTH = 9;
+const int OFFSETS_SIZE = CIRCLE_SIZE + ARC_LENGTH;
+
+void MakeOffsets(int pixel[OFFSETS_SIZE], int step)
+{
+    static const int offsets[CIRCLE_SIZE][2] =
+    {
+        {0,  3}, { 1,  3}, { 2,  2}, { 3,  1}, { 3, 0}, { 3, -1}, { 2, -2}, { 1, -3},
+        {0, -3}, {-1, -3}, {-2, -2}, {-3, -1}, {-3, 0}, {-3,  1}, {-2,  2}, {-1,  3}
+    };
+
+    for(int k=0; k<CIRCLE_SIZE; k++)
+        pixel[k] = offsets[k][0] + offsets[k][1] * step;
+    for(int k=CIRCLE_SIZE; k<OFFSETS_SIZE; k++)
+        pixel[k] = pixel[k - CIRCLE_SIZE];
+}
+
+// Same arithmetic as the cornerScore<16>() of OpenCV, returns its result + 1 for a corner of threshold.
+int CornerContrast(const uchar* ptr, const int pixel[OFFSETS_SIZE], int threshold)
+{
+    const int v = ptr[0];
+    short d[OFFSETS_SIZE];
+    for(int k=0; k<OFFSETS_SIZE; k++)
+        d[k] = (short)(v - ptr[pixel[k]]);
+
+    int a0 = threshold;
+    for(int k=0; k<CIRCLE_SIZE; k+=2)
+    {
+        int a = std::min((int)d[k+1], (int)d[k+2]);
+        a = std::min(a, (int)d[k+3]);
+        if(a <= a0)
+            continue;
+        a = std::min(a, (int)d[k+4]);
+        a = std::min(a, (int)d[k+5]);
+        a = std::min(a, (int)d[k+6]);
+        a = std::min(a, (int)d[k+7]);
+        a = std::min(a, (int)d[k+8]);
+        a0 = std::max(a0, std::min(a, (int)d[k]));
+        a0 = std::max(a0, std::min(a, (int)d[k+9]));
+    }
+
+    int b0 = -a0;
+    for(int k=0; k<CIRCLE_SIZE; k+=2)
+    {
+        int b = std::max((int)d[k+1], (int)d[k+2]);
+        b = std::max(b, (int)d[k+3]);
+        b = std::max(b, (int)d[k+4]);
+        b = std::max(b, (int)d[k+5]);
+        if(b >= b0)
+            continue;
+        b = std::max(b, (int)d[k+6]);
+        b = std::max(b, (int)d[k+7]);
+        b = std::max(b, (int)d[k+8]);
+        b0 = std::min(b0, std::max(b, (int)d[k]));
+        b0 = std::min(b0, std::max(b, (int)d[k+9]));
+    }
+
+    return -b0;
+}
+
+// Tests of opposite pixels first, then a run of ARC_LENGTH darker or brighter pixels.
+int RowScalar(const uchar* ptr, int x, int xEnd, const int pixel[OFFSETS_SIZE], int threshold,
+              const uchar* thresholdTab, uchar* out)
+{
+    for(; x<xEnd; x++)
+    {
+        const uchar* p = ptr + x;
+        const int v = p[0];
+        const uchar* tab = thresholdTab - v + 255;
+        out[x] = 0;
+
+        int d = tab[p[pixel[0]]] | tab[p[pixel[8]]];
+        if(d == 0)
+            continue;
+        d &= tab[p[pixel[2]]] | tab[p[pixel[10]]];
+        d &= tab[p[pixel[4]]] | tab[p[pixel[12]]];
+        d &= tab[p[pixel[6]]] | tab[p[pixel[14]]];
+        if(d == 0)
+            continue;
+        d &= tab[p[pixel[1]]] | tab[p[pixel[9]]];
+        d &= tab[p[pixel[3]]] | tab[p[pixel[11]]];
+        d &= tab[p[pixel[5]]] | tab[p[pixel[13]]];
+        d &= tab[p[pixel[7]]] | tab[p[pixel[15]]];
+
+        bool bCorner = false;
+        if(d & 1)
+        {
+            const int vt = v - threshold;
+            int count = 0;
+            for(int k=0; k<OFFSETS_SIZE && !bCorner; k++)
+            {
+                if(p[pixel[k]] < vt)
+                    bCorner = ++count >= ARC_LENGTH;
+                else
+                    count = 0;
+            }
+        }
+        if((d & 2) && !bCorner)
+        {
+            const int vt = v + threshold;
+            int count = 0;
+            for(int k=0; k<OFFSETS_SIZE && !bCorner; k++)
+            {
+                if(p[pixel[k]] > vt)
+                    bCorner = ++count >= ARC_LENGTH;
+                else
+                    count = 0;
+            }
+        }
+
+        if(bCorner)
+            out[x] = (uchar)CornerContrast(p, pixel, threshold);
+    }
+    return x;
+}
+
+#if defined(__SSE2__)
+// 16 pixels at a time. Unsigned compares are done as signed ones after flipping the sign bit, the
+// saturated bounds make pixels near 0 / 255 behave as the unsaturated scalar test.
+int RowSSE2(const uchar* ptr, int x, int xEnd, const int pixel[OFFSETS_SIZE], int threshold, uchar* out)
+{
+    const __m128i delta = _mm_set1_epi8((char)0x80);
+    const __m128i t = _mm_set1_epi8((char)threshold);
+    const __m128i minRun = _mm_set1_epi8((char)(ARC_LENGTH - 1));
+    const __m128i zero = _mm_setzero_si128();
+
+    for(; x+16<=xEnd; x+=16)
+    {
+        const uchar* p = ptr + x;
+        const __m128i v = _mm_loadu_si128((const __m128i*)p);
+        const __m128i v0 = _mm_xor_si128(_mm_adds_epu8(v, t), delta);
+        const __m128i v1 = _mm_xor_si128(_mm_subs_epu8(v, t), delta);
+        _mm_storeu_si128((__m128i*)(out + x), zero);
+
+        // An arc of 9 pixels covers two consecutive of the pixels 0, 4, 8, 12
+        const __m128i x0 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + pixel[0])), delta);
+        const __m128i x1 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + pixel[4])), delta);
+        const __m128i x2 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + pixel[8])), delta);
+        const __m128i x3 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + pixel[12])), delta);
+        const __m128i b0 = _mm_cmpgt_epi8(x0, v0), b1 = _mm_cmpgt_epi8(x1, v0);
+        const __m128i b2 = _mm_cmpgt_epi8(x2, v0), b3 = _mm_cmpgt_epi8(x3, v0);
+        const __m128i d0 = _mm_cmpgt_epi8(v1, x0), d1 = _mm_cmpgt_epi8(v1, x1);
+        const __m128i d2 = _mm_cmpgt_epi8(v1, x2), d3 = _mm_cmpgt_epi8(v1, x3);
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_and_si128(b0, b1), _mm_and_si128(b1, b2)),
+                                 _mm_or_si128(_mm_and_si128(b2, b3), _mm_and_si128(b3, b0)));
+        m = _mm_or_si128(m, _mm_or_si128(_mm_or_si128(_mm_and_si128(d0, d1), _mm_and_si128(d1, d2)),
+                                         _mm_or_si128(_mm_and_si128(d2, d3), _mm_and_si128(d3, d0))));
+        if(_mm_movemask_epi8(m) == 0)
+            continue;
+
+        __m128i c0 = zero, c1 = zero, max0 = zero, max1 = zero;
+        for(int k=0; k<OFFSETS_SIZE; k++)
+        {
+            const __m128i xk = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + pixel[k])), delta);
+            const __m128i m0 = _mm_cmpgt_epi8(xk, v0);
+            const __m128i m1 = _mm_cmpgt_epi8(v1, xk);
+            c0 = _mm_and_si128(_mm_sub_epi8(c0, m0), m0);
+            c1 = _mm_and_si128(_mm_sub_epi8(c1, m1), m1);
+            max0 = _mm_max_epu8(max0, c0);
+            max1 = _mm_max_epu8(max1, c1);
+        }
+
+        int mask = _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_max_epu8(max0, max1), minRun));
+        for(int k=0; mask; k++, mask>>=1)
+        {
+            if(mask & 1)
+                out[x+k] = (uchar)CornerContrast(p + k, pixel, threshold);
+        }
+    }
+    return x;
+}
+#endif
+
+#if defined(FAST_DETECTOR_AVX2)
+// RowSSE2() on 32 pixels.
+__attribute__((target("avx2")))
+int RowAVX2(const uchar* ptr, int x, int xEnd, const int pixel[OFFSETS_SIZE], int threshold, uchar* out)
+{
+    const __m256i delta = _mm256_set1_epi8((char)0x80);
+    const __m256i t = _mm256_set1_epi8((char)threshold);
+    const __m256i minRun = _mm256_set1_epi8((char)(ARC_LENGTH - 1));
+    const __m256i zero = _mm256_setzero_si256();
+
+    for(; x+32<=xEnd; x+=32)
+    {
+        const uchar* p = ptr + x;
+        const __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        const __m256i v0 = _mm256_xor_si256(_mm256_adds_epu8(v, t), delta);
+        const __m256i v1 = _mm256_xor_si256(_mm256_subs_epu8(v, t), delta);
+        _mm256_storeu_si256((__m256i*)(out + x), zero);
+
+        const __m256i x0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + pixel[0])), delta);
+        const __m256i x1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + pixel[4])), delta);
+        const __m256i x2 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + pixel[8])), delta);
+        const __m256i x3 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + pixel[12])), delta);
+        const __m256i b0 = _mm256_cmpgt_epi8(x0, v0), b1 = _mm256_cmpgt_epi8(x1, v0);
+        const __m256i b2 = _mm256_cmpgt_epi8(x2, v0), b3 = _mm256_cmpgt_epi8(x3, v0);
+        const __m256i d0 = _mm256_cmpgt_epi8(v1, x0), d1 = _mm256_cmpgt_epi8(v1, x1);
+        const __m256i d2 = _mm256_cmpgt_epi8(v1, x2), d3 = _mm256_cmpgt_epi8(v1, x3);
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(b0, b1), _mm256_and_si256(b1, b2)),
+                                    _mm256_or_si256(_mm256_and_si256(b2, b3), _mm256_and_si256(b3, b0)));
+        m = _mm256_or_si256(m, _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(d0, d1), _mm256_and_si256(d1, d2)),
+                                               _mm256_or_si256(_mm256_and_si256(d2, d3), _mm256_and_si256(d3, d0))));
+        if(_mm256_movemask_epi8(m) == 0)
+            continue;
+
+        __m256i c0 = zero, c1 = zero, max0 = zero, max1 = zero;
+        for(int k=0; k<OFFSETS_SIZE; k++)
+        {
+            const __m256i xk = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + pixel[k])), delta);
+            const __m256i m0 = _mm256_cmpgt_epi8(xk, v0);
+            const __m256i m1 = _mm256_cmpgt_epi8(v1, xk);
+            c0 = _mm256_and_si256(_mm256_sub_epi8(c0, m0), m0);
+            c1 = _mm256_and_si256(_mm256_sub_epi8(c1, m1), m1);
+            max0 = _mm256_max_epu8(max0, c0);
+            max1 = _mm256_max_epu8(max1, c1);
+        }
+
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_max_epu8(max0, max1), minRun));
+        for(int k=0; mask; k++, mask>>=1)
+        {
+            if(mask & 1)
+                out[x+k] = (uchar)CornerContrast(p + k, pixel, threshold);
+        }
+    }
+    return x;
+}
+#endif
+
+#if defined(__ARM_NEON)
+inline bool AnyNEON(uint8x16_t m)
+{
+#if defined(__aarch64__)
+    return vmaxvq_u8(m) != 0;
+#else
+    const uint64x2_t m64 = vreinterpretq_u64_u8(m);
+    return (vgetq_lane_u64(m64, 0) | vgetq_lane_u64(m64, 1)) != 0;
+#endif
+}
+
+// RowSSE2() with native unsigned compares.
+int RowNEON(const uchar* ptr, int x, int xEnd, const int pixel[OFFSETS_SIZE], int threshold, uchar* out)
+{
+    const uint8x16_t t = vdupq_n_u8((uint8_t)threshold);
+    const uint8x16_t minRun = vdupq_n_u8((uint8_t)(ARC_LENGTH - 1));
+    const uint8x16_t zero = vdupq_n_u8(0);
+
+    for(; x+16<=xEnd; x+=16)
+    {
+        const uchar* p = ptr + x;
+        const uint8x16_t v = vld1q_u8(p);
+        const uint8x16_t v0 = vqaddq_u8(v, t);
+        const uint8x16_t v1 = vqsubq_u8(v, t);
+        vst1q_u8(out + x, zero);
+
+        const uint8x16_t x0 = vld1q_u8(p + pixel[0]);
+        const uint8x16_t x1 = vld1q_u8(p + pixel[4]);
+        const uint8x16_t x2 = vld1q_u8(p + pixel[8]);
+        const uint8x16_t x3 = vld1q_u8(p + pixel[12]);
+        const uint8x16_t b0 = vcgtq_u8(x0, v0), b1 = vcgtq_u8(x1, v0);
+        const uint8x16_t b2 = vcgtq_u8(x2, v0), b3 = vcgtq_u8(x3, v0);
+        const uint8x16_t d0 = vcltq_u8(x0, v1), d1 = vcltq_u8(x1, v1);
+        const uint8x16_t d2 = vcltq_u8(x2, v1), d3 = vcltq_u8(x3, v1);
+        uint8x16_t m = vorrq_u8(vorrq_u8(vandq_u8(b0, b1), vandq_u8(b1, b2)),
+                                vorrq_u8(vandq_u8(b2, b3), vandq_u8(b3, b0)));
+        m = vorrq_u8(m, vorrq_u8(vorrq_u8(vandq_u8(d0, d1), vandq_u8(d1, d2)),
+                                 vorrq_u8(vandq_u8(d2, d3), vandq_u8(d3, d0))));
+        if(!AnyNEON(m))
+            continue;
+
+        uint8x16_t c0 = zero, c1 = zero, max0 = zero, max1 = zero;
+        for(int k=0; k<OFFSETS_SIZE; k++)
+        {
+            const uint8x16_t xk = vld1q_u8(p + pixel[k]);
+            const uint8x16_t m0 = vcgtq_u8(xk, v0);
+            const uint8x16_t m1 = vcltq_u8(xk, v1);
+            c0 = vandq_u8(vsubq_u8(c0, m0), m0);
+            c1 = vandq_u8(vsubq_u8(c1, m1), m1);
+            max0 = vmaxq_u8(max0, c0);
+            max1 = vmaxq_u8(max1, c1);
+        }
+
+        const uint8x16_t corners = vcgtq_u8(vmaxq_u8(max0, max1), minRun);
+        if(!AnyNEON(corners))
+            continue;
+
+        uchar vCorners[16];
+        vst1q_u8(vCorners, corners);
+        for(int k=0; k<16; k++)
+        {
+            if(vCorners[k])
+                out[x+k] = (uchar)CornerContrast(p + k, pixel, threshold);
+        }
+    }
+    return x;
+}
+#endif
+
+} // namespace
+
+FastDetector::Impl FastDetector::BestImpl()
+{
+#if defined(__ARM_NEON)
+    return IMPL_NEON;
+#else
+#if defined(FAST_DETECTOR_AVX2)
+    static const bool bAVX2 = __builtin_cpu_supports("avx2");
+    if(bAVX2)
+        return IMPL_AVX2;
+#endif
+#if defined(__SSE2__)
+    return IMPL_SSE2;
+#else
+    return IMPL_SCALAR;
+#endif
+#endif
+}
+
+const char* FastDetector::ImplName(Impl impl)
+{
+    switch(impl)
+    {
+    case IMPL_SSE2: return "sse2";
+    case IMPL_AVX2: return "avx2";
+    case IMPL_NEON: return "neon";
+    default: return "scalar";
+    }
+}
+
+void FastDetector::ComputeContrast(const cv::Mat& image, const cv::Rect& roi, int threshold, cv::Mat& contrast, Impl impl)
+{
+    CV_Assert(image.type() == CV_8UC1);
+    contrast.create(image.size(), CV_8UC1);
+
+    threshold = std::min(std::max(threshold, 0), 255);
+    if(impl == IMPL_AVX2 && BestImpl() != IMPL_AVX2)
+        impl = IMPL_SSE2;
+
+    const cv::Rect r = roi & cv::Rect(0, 0, image.cols, image.rows);
+    const int xBegin = r.x + 3, xEnd = r.x + r.width - 3;
+    const int yBegin = r.y + 3, yEnd = r.y + r.height - 3;
+    if(xEnd <= xBegin || yEnd <= yBegin)
+        return;
+
+    int pixel[OFFSETS_SIZE];
+    MakeOffsets(pixel, (int)image.step);
+
+    uchar thresholdTab[512];
+    for(int i=-255; i<=255; i++)
+        thresholdTab[i+255] = (uchar)(i < -threshold ? 1 : i > threshold ? 2 : 0);
+
+    for(int y=yBegin; y<yEnd; y++)
+    {
+        const uchar* ptr = image.ptr<uchar>(y);
+        uchar* out = contrast.ptr<uchar>(y);
+
+        int x = xBegin;
+        switch(impl)
+        {
+#if defined(FAST_DETECTOR_AVX2)
+        case IMPL_AVX2:
+            x = RowAVX2(ptr, x, xEnd, pixel, threshold, out);
+            break;
+#endif
+#if defined(__SSE2__)
+        case IMPL_SSE2:
+            x = RowSSE2(ptr, x, xEnd, pixel, threshold, out);
+            break;
+#endif
+#if defined(__ARM_NEON)
+        case IMPL_NEON:
+            x = RowNEON(ptr, x, xEnd, pixel, threshold, out);
+            break;
+#endif
+        default:
+            break;
+        }
+        RowScalar(ptr, x, xEnd, pixel, threshold, thresholdTab, out);
+    }
+}
+
+void FastDetector::Detect(const cv::Mat& contrast, const cv::Rect& cell, int threshold, std::vector<cv::KeyPoint>& vKeys)
+{
+    threshold = std::min(std::max(threshold, 0), 255);
+
+    // Detection area of cv::FAST inside the cell, neighbours outside of it do not suppress
+    const int xBegin = cell.x + 3, xEnd = cell.x + cell.width - 3;
+    const int yBegin = cell.y + 3, yEnd = cell.y + cell.height - 3;
+    if(xEnd <= xBegin || yEnd <= yBegin)
+        return;
+
+    auto score = [&](const uchar* row, int x) -> int
+    {
+        if(!row || x < xBegin || x >= xEnd || row[x] <= threshold)
+            return 0;
+        return row[x] - 1;
+    };
+
+    for(int y=yBegin; y<yEnd; y++)
+    {
+        const uchar* prev = y > yBegin ? contrast.ptr<uchar>(y - 1) : nullptr;
+        const uchar* curr = contrast.ptr<uchar>(y);
+        const uchar* next = y + 1 < yEnd ? contrast.ptr<uchar>(y + 1) : nullptr;
+
+        int x = xBegin;
+        while(x < xEnd)
+        {
+            // Most pixels are not corners even at the lowest threshold
+            if(x + 8 <= xEnd)
+            {
+                uint64_t word;
+                memcpy(&word, curr + x, sizeof(word));
+                if(word == 0)
+                {
+                    x += 8;
+                    continue;
+                }
+            }
+
+            const int s = score(curr, x);
+            if(s > 0 && s > score(curr, x - 1) && s > score(curr, x + 1) &&
+               s > score(prev, x - 1) && s > score(prev, x) && s > score(prev, x + 1) &&
+               s > score(next, x - 1) && s > score(next, x) && s > score(next, x + 1))
+            {
+                vKeys.push_back(cv::KeyPoint((float)(x - cell.x), (float)(y - cell.y), 7.f, -1, (float)s));
+            }
+            x++;
+        }
+    }
+}
+
+} //namespace ORB_SLAM3
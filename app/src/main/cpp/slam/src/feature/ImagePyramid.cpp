@@ -0,0 +1,102 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "feature/ImagePyramid.h"
+
+#include <cstring>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+namespace ORB_SLAM3
+{
+
+ImagePyramid::ImagePyramid(int border)
+    : mnBorder(border)
+{
+}
+
+void ImagePyramid::Build(const cv::Mat& image, const std::vector<float>& vInvScaleFactor)
+{
+    CV_Assert(image.type() == CV_8UC1);
+
+    const int nLevels = vInvScaleFactor.size();
+    mvBuffers.resize(nLevels);
+    mvLevels.resize(nLevels);
+    mvBlurred.resize(nLevels);
+
+    for(int level=0; level<nLevels; level++)
+    {
+        const float scale = vInvScaleFactor[level];
+        const cv::Size sz(cvRound((float)image.cols*scale), cvRound((float)image.rows*scale));
+
+        // No allocation unless the size changed
+        mvBuffers[level].create(sz.height + mnBorder*2, sz.width + mnBorder*2, CV_8UC1);
+        mvLevels[level] = mvBuffers[level](cv::Rect(mnBorder, mnBorder, sz.width, sz.height));
+
+        if(level != 0)
+        {
+            cv::resize(mvLevels[level-1], mvLevels[level], sz, 0, 0, cv::INTER_LINEAR);
+            FillBorder(level);
+        }
+        else
+        {
+            // The image may be a view, its surrounding pixels are then used as border
+            cv::copyMakeBorder(image, mvBuffers[0], mnBorder, mnBorder, mnBorder, mnBorder, cv::BORDER_REFLECT_101);
+        }
+
+        // Same as blurring a standalone copy of the level
+        mvBlurred[level].create(sz, CV_8UC1);
+        cv::GaussianBlur(mvLevels[level], mvBlurred[level], cv::Size(7, 7), 2, 2,
+                         cv::BORDER_REFLECT_101 + cv::BORDER_ISOLATED);
+    }
+}
+
+void ImagePyramid::FillBorder(int level)
+{
+    cv::Mat& buffer = mvBuffers[level];
+    const int w = mvLevels[level].cols;
+    const int h = mvLevels[level].rows;
+    const int B = mnBorder;
+
+    mvBorderCols.resize(B*2);
+    for(int x=0; x<B; x++)
+    {
+        mvBorderCols[x] = B + cv::borderInterpolate(x-B, w, cv::BORDER_REFLECT_101);
+        mvBorderCols[B+x] = B + cv::borderInterpolate(w+x, w, cv::BORDER_REFLECT_101);
+    }
+
+    for(int y=B; y<B+h; y++)
+    {
+        uchar* row = buffer.ptr<uchar>(y);
+        for(int x=0; x<B; x++)
+        {
+            row[x] = row[mvBorderCols[x]];
+            row[B+w+x] = row[mvBorderCols[B+x]];
+        }
+    }
+
+    for(int y=0; y<B; y++)
+    {
+        memcpy(buffer.ptr<uchar>(y), buffer.ptr<uchar>(B + cv::borderInterpolate(y-B, h, cv::BORDER_REFLECT_101)), buffer.cols);
+        memcpy(buffer.ptr<uchar>(B+h+y), buffer.ptr<uchar>(B + cv::borderInterpolate(h+y, h, cv::BORDER_REFLECT_101)), buffer.cols);
+    }
+}
+
+} //namespace ORB_SLAM3
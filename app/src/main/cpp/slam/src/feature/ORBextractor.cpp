@@ -53,6 +53,9 @@
 
 
 #include "feature/ORBextractor.h"
+#include "feature/FastDetector.h"
+#include "feature/ImagePyramid.h"
+#include "utils/WorkerPool.h"
 #include <vector>
 #include <iostream>
 
@@ -102,49 +105,6 @@ namespace ORB_SLAM3
     }
 
 
-    const float factorPI = (float)(CV_PI/180.f);
-    static void computeOrbDescriptor(const KeyPoint& kpt,
-                                     const Mat& img, const Point* pattern,
-                                     uchar* desc)
-    {
-        float angle = (float)kpt.angle*factorPI;
-        float a = (float)cos(angle), b = (float)sin(angle);
-
-        const uchar* center = &img.at<uchar>(cvRound(kpt.pt.y), cvRound(kpt.pt.x));
-        const int step = (int)img.step;
-
-#define GET_VALUE(idx) \
-        center[cvRound(pattern[idx].x*b + pattern[idx].y*a)*step + \
-               cvRound(pattern[idx].x*a - pattern[idx].y*b)]
-
-
-        for (int i = 0; i < 32; ++i, pattern += 16)
-        {
-            int t0, t1, val;
-            t0 = GET_VALUE(0); t1 = GET_VALUE(1);
-            val = t0 < t1;
-            t0 = GET_VALUE(2); t1 = GET_VALUE(3);
-            val |= (t0 < t1) << 1;
-            t0 = GET_VALUE(4); t1 = GET_VALUE(5);
-            val |= (t0 < t1) << 2;
-            t0 = GET_VALUE(6); t1 = GET_VALUE(7);
-            val |= (t0 < t1) << 3;
-            t0 = GET_VALUE(8); t1 = GET_VALUE(9);
-            val |= (t0 < t1) << 4;
-            t0 = GET_VALUE(10); t1 = GET_VALUE(11);
-            val |= (t0 < t1) << 5;
-            t0 = GET_VALUE(12); t1 = GET_VALUE(13);
-            val |= (t0 < t1) << 6;
-            t0 = GET_VALUE(14); t1 = GET_VALUE(15);
-            val |= (t0 < t1) << 7;
-
-            desc[i] = (uchar)val;
-        }
-
-#undef GET_VALUE
-    }
-
-
     static int bit_pattern_31_[256*4] =
             {
                     8,-3, 9,5/*mean (0), correlation (0)*/,
@@ -408,7 +368,9 @@ namespace ORB_SLAM3
     ORBextractor::ORBextractor(int _nfeatures, float _scaleFactor, int _nlevels,
                                int _iniThFAST, int _minThFAST):
             nfeatures(_nfeatures), scaleFactor(_scaleFactor), nlevels(_nlevels),
-            iniThFAST(_iniThFAST), minThFAST(_minThFAST)
+            iniThFAST(_iniThFAST), minThFAST(_minThFAST), mPyramid(EDGE_THRESHOLD),
+            mDescriptor((const Point*)bit_pattern_31_), mDescriptorAngleMode(OrbDescriptor::ANGLE_BINS),
+            mDistribution(DISTRIBUTION_ARENA), mpWorkerPool(nullptr)
     {
         mvScaleFactor.resize(nlevels);
         mvLevelSigma2.resize(nlevels);
@@ -429,6 +391,8 @@ namespace ORB_SLAM3
         }
 
         mvImagePyramid.resize(nlevels);
+        mvFastContrast.resize(nlevels);
+        mvDistributionArena.resize(nlevels);
 
         mnFeaturesPerLevel.resize(nlevels);
         float factor = 1.0f / scaleFactor;
@@ -443,10 +407,6 @@ namespace ORB_SLAM3
         }
         mnFeaturesPerLevel[nlevels-1] = std::max(nfeatures - sumFeatures, 0);
 
-        const int npoints = 512;
-        const Point* pattern0 = (const Point*)bit_pattern_31_;
-        std::copy(pattern0, pattern0 + npoints, std::back_inserter(pattern));
-
         //This is for orientation
         // pre-compute the end of a row in a circular patch
         umax.resize(HALF_PATCH_SIZE + 1);
@@ -777,76 +737,340 @@ namespace ORB_SLAM3
         return vResultKeys;
     }
 
+    void DistributionArena::Clear()
+    {
+        vNodes.clear();
+        vKeyIdx.clear();
+        head = -1;
+        size = 0;
+    }
+
+    int DistributionArena::PushFront(const Node& node)
+    {
+        const int n = vNodes.size();
+        vNodes.push_back(node);
+        vNodes[n].prev = -1;
+        vNodes[n].next = head;
+        if(head != -1)
+            vNodes[head].prev = n;
+        head = n;
+        size++;
+        return n;
+    }
+
+    int DistributionArena::Erase(int n)
+    {
+        const int prev = vNodes[n].prev;
+        const int next = vNodes[n].next;
+        if(prev != -1)
+            vNodes[prev].next = next;
+        else
+            head = next;
+        if(next != -1)
+            vNodes[next].prev = prev;
+        size--;
+        return next;
+    }
+
+    void DistributionArena::Divide(int n, const vector<cv::KeyPoint>& vKeys, vector<pair<int,int> >& vToExpand)
+    {
+        const Node parent = vNodes[n];
+        const int halfX = ceil(static_cast<float>(parent.maxX-parent.minX)/2);
+        const int halfY = ceil(static_cast<float>(parent.maxY-parent.minY)/2);
+        const int midX = parent.minX+halfX;
+        const int midY = parent.minY+halfY;
+
+        Node children[4] = {};
+        children[0].minX = parent.minX; children[0].minY = parent.minY; children[0].maxX = midX; children[0].maxY = midY;
+        children[1].minX = midX; children[1].minY = parent.minY; children[1].maxX = parent.maxX; children[1].maxY = midY;
+        children[2].minX = parent.minX; children[2].minY = midY; children[2].maxX = midX; children[2].maxY = parent.maxY;
+        children[3].minX = midX; children[3].minY = midY; children[3].maxX = parent.maxX; children[3].maxY = parent.maxY;
+
+        //Associate points to childs, keeping their order
+        int nCount[4] = {0, 0, 0, 0};
+        for(int i=parent.begin; i<parent.end; i++)
+        {
+            const cv::Point2f& pt = vKeys[vKeyIdx[i]].pt;
+            nCount[(pt.x<midX ? 0 : 1) + (pt.y<midY ? 0 : 2)]++;
+        }
+
+        int pos[4];
+        int offset = vKeyIdx.size();
+        for(int c=0; c<4; c++)
+        {
+            children[c].begin = pos[c] = offset;
+            offset += nCount[c];
+            children[c].end = offset;
+        }
+
+        vKeyIdx.resize(offset);
+        for(int i=parent.begin; i<parent.end; i++)
+        {
+            const cv::Point2f& pt = vKeys[vKeyIdx[i]].pt;
+            vKeyIdx[pos[(pt.x<midX ? 0 : 1) + (pt.y<midY ? 0 : 2)]++] = vKeyIdx[i];
+        }
+
+        // Add childs if they contain points
+        for(int c=0; c<4; c++)
+        {
+            if(nCount[c] == 0)
+                continue;
+
+            children[c].bNoMore = nCount[c]==1;
+            const int child = PushFront(children[c]);
+            if(nCount[c] > 1)
+                vToExpand.push_back(make_pair(nCount[c], child));
+        }
+    }
+
+    vector<cv::KeyPoint> ORBextractor::DistributeArena(const vector<cv::KeyPoint>& vToDistributeKeys, const int &minX,
+                                                       const int &maxX, const int &minY, const int &maxY, const int &N, const int &level)
+    {
+        DistributionArena& arena = mvDistributionArena[level];
+        arena.Clear();
+
+        // Compute how many initial nodes
+        const int nIni = round(static_cast<float>(maxX-minX)/(maxY-minY));
+
+        const float hX = static_cast<float>(maxX-minX)/nIni;
+
+        // Key points of every initial node, in input order
+        arena.vIniCount.assign(nIni+1, 0);
+        for(size_t i=0;i<vToDistributeKeys.size();i++)
+            arena.vIniCount[(size_t)(vToDistributeKeys[i].pt.x/hX)+1]++;
+        for(int i=0; i<nIni; i++)
+            arena.vIniCount[i+1] += arena.vIniCount[i];
+
+        arena.vKeyIdx.resize(vToDistributeKeys.size());
+        for(size_t i=0;i<vToDistributeKeys.size();i++)
+            arena.vKeyIdx[arena.vIniCount[(size_t)(vToDistributeKeys[i].pt.x/hX)]++] = i;
+
+        // vIniCount[i] is now the end of node i, empty nodes are dropped
+        for(int i=nIni-1; i>=0; i--)
+        {
+            const int begin = i>0 ? arena.vIniCount[i-1] : 0;
+            const int end = arena.vIniCount[i];
+            if(begin == end)
+                continue;
+
+            DistributionArena::Node ni = {};
+            ni.minX = hX*static_cast<float>(i);
+            ni.maxX = hX*static_cast<float>(i+1);
+            ni.minY = 0;
+            ni.maxY = maxY-minY;
+            ni.begin = begin;
+            ni.end = end;
+            ni.bNoMore = end-begin==1;
+            arena.PushFront(ni);
+        }
+
+        bool bFinish = false;
+
+        vector<pair<int,int> >& vSizeAndNode = arena.vToExpand;
+        vector<pair<int,int> >& vPrevSizeAndNode = arena.vPrevToExpand;
+
+        // Same order as compareNodes()
+        auto compareArenaNodes = [&arena](const pair<int,int>& e1, const pair<int,int>& e2)
+        {
+            if(e1.first != e2.first)
+                return e1.first < e2.first;
+            return arena.vNodes[e1.second].minX < arena.vNodes[e2.second].minX;
+        };
+
+        while(!bFinish)
+        {
+            int prevSize = arena.size;
+
+            vSizeAndNode.clear();
+
+            int n = arena.head;
+            while(n != -1)
+            {
+                if(arena.vNodes[n].bNoMore)
+                {
+                    // If node only contains one point do not subdivide and continue
+                    n = arena.vNodes[n].next;
+                    continue;
+                }
+
+                // If more than one point, subdivide
+                arena.Divide(n, vToDistributeKeys, vSizeAndNode);
+                n = arena.Erase(n);
+            }
+
+            const int nToExpand = vSizeAndNode.size();
+
+            // Finish if there are more nodes than required features
+            // or all nodes contain just one point
+            if(arena.size>=N || arena.size==prevSize)
+            {
+                bFinish = true;
+            }
+            else if((arena.size+nToExpand*3)>N)
+            {
+                while(!bFinish)
+                {
+                    prevSize = arena.size;
+
+                    vPrevSizeAndNode.swap(vSizeAndNode);
+                    vSizeAndNode.clear();
+
+                    sort(vPrevSizeAndNode.begin(),vPrevSizeAndNode.end(),compareArenaNodes);
+                    for(int j=vPrevSizeAndNode.size()-1;j>=0;j--)
+                    {
+                        arena.Divide(vPrevSizeAndNode[j].second, vToDistributeKeys, vSizeAndNode);
+                        arena.Erase(vPrevSizeAndNode[j].second);
+
+                        if(arena.size>=N)
+                            break;
+                    }
+
+                    if(arena.size>=N || arena.size==prevSize)
+                        bFinish = true;
+                }
+            }
+        }
+
+        // Retain the best point in each node
+        vector<cv::KeyPoint> vResultKeys;
+        vResultKeys.reserve(nfeatures);
+        for(int n=arena.head; n!=-1; n=arena.vNodes[n].next)
+        {
+            const DistributionArena::Node& node = arena.vNodes[n];
+            int best = arena.vKeyIdx[node.begin];
+            float maxResponse = vToDistributeKeys[best].response;
+
+            for(int k=node.begin+1;k<node.end;k++)
+            {
+                const int idx = arena.vKeyIdx[k];
+                if(vToDistributeKeys[idx].response>maxResponse)
+                {
+                    best = idx;
+                    maxResponse = vToDistributeKeys[idx].response;
+                }
+            }
+
+            vResultKeys.push_back(vToDistributeKeys[best]);
+        }
+
+        return vResultKeys;
+    }
+
     void ORBextractor::ComputeKeyPointsOctTree(vector<vector<KeyPoint> >& allKeypoints)
     {
         allKeypoints.resize(nlevels);
 
         const float W = 35;
 
+        struct LevelGrid
+        {
+            int minBorderX, minBorderY, maxBorderX, maxBorderY;
+            float width, height;
+            int nCols, nRows, wCell, hCell;
+        };
+
+        // Cell rows of all the levels, largest level first. vFirstRow[level] is the first row of the level
+        vector<LevelGrid> vGrids(nlevels);
+        vector<pair<int,int> > vCellRows;
+        vector<int> vFirstRow(nlevels+1);
         for (int level = 0; level < nlevels; ++level)
         {
-            const int minBorderX = EDGE_THRESHOLD-3;
-            const int minBorderY = minBorderX;
-            const int maxBorderX = mvImagePyramid[level].cols-EDGE_THRESHOLD+3;
-            const int maxBorderY = mvImagePyramid[level].rows-EDGE_THRESHOLD+3;
+            LevelGrid& grid = vGrids[level];
+            grid.minBorderX = EDGE_THRESHOLD-3;
+            grid.minBorderY = grid.minBorderX;
+            grid.maxBorderX = mvImagePyramid[level].cols-EDGE_THRESHOLD+3;
+            grid.maxBorderY = mvImagePyramid[level].rows-EDGE_THRESHOLD+3;
+
+            grid.width = (grid.maxBorderX-grid.minBorderX);
+            grid.height = (grid.maxBorderY-grid.minBorderY);
+
+            grid.nCols = grid.width/W;
+            grid.nRows = grid.height/W;
+            grid.wCell = ceil(grid.width/grid.nCols);
+            grid.hCell = ceil(grid.height/grid.nRows);
+
+            vFirstRow[level] = vCellRows.size();
+            for(int i=0; i<grid.nRows; i++)
+                vCellRows.push_back(make_pair(level, i));
+
+            // Rows of the contrast map are written by different tasks, allocate it before
+            mvFastContrast[level].create(mvImagePyramid[level].size(), CV_8UC1);
+        }
+        vFirstRow[nlevels] = vCellRows.size();
 
-            vector<cv::KeyPoint> vToDistributeKeys;
-            vToDistributeKeys.reserve(nfeatures*10);
+        // FAST on every cell row: one pass at the lower threshold over the rows of the cells, which are
+        // then served from it at both thresholds
+        vector<vector<KeyPoint> > vRowKeys(vCellRows.size());
+        ParallelFor(vCellRows.size(), [&](int r)
+        {
+            const int level = vCellRows[r].first;
+            const int i = vCellRows[r].second;
+            const LevelGrid& grid = vGrids[level];
 
-            const float width = (maxBorderX-minBorderX);
-            const float height = (maxBorderY-minBorderY);
+            const float iniY =grid.minBorderY+i*grid.hCell;
+            float maxY = iniY+grid.hCell+6;
 
-            const int nCols = width/W;
-            const int nRows = height/W;
-            const int wCell = ceil(width/nCols);
-            const int hCell = ceil(height/nRows);
+            if(iniY>=grid.maxBorderY-3)
+                return;
+            if(maxY>grid.maxBorderY)
+                maxY = grid.maxBorderY;
 
-            for(int i=0; i<nRows; i++)
-            {
-                const float iniY =minBorderY+i*hCell;
-                float maxY = iniY+hCell+6;
+            cv::Mat& contrast = mvFastContrast[level];
+            FastDetector::ComputeContrast(mvImagePyramid[level], cv::Rect(grid.minBorderX, iniY, (int)grid.width, maxY - iniY),
+                                          std::min(iniThFAST, minThFAST), contrast);
 
-                if(iniY>=maxBorderY-3)
+            vector<cv::KeyPoint>& vKeysRow = vRowKeys[r];
+            for(int j=0; j<grid.nCols; j++)
+            {
+                const float iniX =grid.minBorderX+j*grid.wCell;
+                float maxX = iniX+grid.wCell+6;
+                if(iniX>=grid.maxBorderX-6)
                     continue;
-                if(maxY>maxBorderY)
-                    maxY = maxBorderY;
+                if(maxX>grid.maxBorderX)
+                    maxX = grid.maxBorderX;
 
-                for(int j=0; j<nCols; j++)
-                {
-                    const float iniX =minBorderX+j*wCell;
-                    float maxX = iniX+wCell+6;
-                    if(iniX>=maxBorderX-6)
-                        continue;
-                    if(maxX>maxBorderX)
-                        maxX = maxBorderX;
+                vector<cv::KeyPoint> vKeysCell;
+                const cv::Rect cell(iniX, iniY, maxX - iniX, maxY - iniY);
 
-                    vector<cv::KeyPoint> vKeysCell;
+                FastDetector::Detect(contrast, cell, iniThFAST, vKeysCell);
 
-                    FAST(mvImagePyramid[level].rowRange(iniY,maxY).colRange(iniX,maxX), vKeysCell,iniThFAST,true);
-
-                    if(vKeysCell.empty())
-                    {
-                        FAST(mvImagePyramid[level].rowRange(iniY,maxY).colRange(iniX,maxX), vKeysCell,minThFAST,true);
-                    }
+                if(vKeysCell.empty())
+                {
+                    FastDetector::Detect(contrast, cell, minThFAST, vKeysCell);
+                }
 
-                    if(!vKeysCell.empty())
+                if(!vKeysCell.empty())
+                {
+                    for(auto vit=vKeysCell.begin(); vit!=vKeysCell.end();vit++)
                     {
-                        for(auto vit=vKeysCell.begin(); vit!=vKeysCell.end();vit++)
-                        {
-                            (*vit).pt.x+=j*wCell;
-                            (*vit).pt.y+=i*hCell;
-                            vToDistributeKeys.push_back(*vit);
-                        }
+                        (*vit).pt.x+=j*grid.wCell;
+                        (*vit).pt.y+=i*grid.hCell;
+                        vKeysRow.push_back(*vit);
                     }
-
                 }
+
             }
+        });
+
+        // Distribution and orientation of every level, from its rows in order
+        ParallelFor(nlevels, [&](int level)
+        {
+            const LevelGrid& grid = vGrids[level];
+
+            vector<cv::KeyPoint> vToDistributeKeys;
+            vToDistributeKeys.reserve(nfeatures*10);
+            for(int r=vFirstRow[level]; r<vFirstRow[level+1]; r++)
+                vToDistributeKeys.insert(vToDistributeKeys.end(), vRowKeys[r].begin(), vRowKeys[r].end());
 
             vector<KeyPoint> & keypoints = allKeypoints[level];
             keypoints.reserve(nfeatures);
 
-            keypoints = DistributeOctTree(vToDistributeKeys, minBorderX, maxBorderX,
-                                          minBorderY, maxBorderY,mnFeaturesPerLevel[level], level);
+            if(mDistribution == DISTRIBUTION_LIST)
+                keypoints = DistributeOctTree(vToDistributeKeys, grid.minBorderX, grid.maxBorderX,
+                                              grid.minBorderY, grid.maxBorderY,mnFeaturesPerLevel[level], level);
+            else
+                keypoints = DistributeArena(vToDistributeKeys, grid.minBorderX, grid.maxBorderX,
+                                            grid.minBorderY, grid.maxBorderY,mnFeaturesPerLevel[level], level);
 
             const int scaledPatchSize = PATCH_SIZE*mvScaleFactor[level];
 
@@ -854,16 +1078,15 @@ namespace ORB_SLAM3
             const int nkps = keypoints.size();
             for(int i=0; i<nkps ; i++)
             {
-                keypoints[i].pt.x+=minBorderX;
-                keypoints[i].pt.y+=minBorderY;
+                keypoints[i].pt.x+=grid.minBorderX;
+                keypoints[i].pt.y+=grid.minBorderY;
                 keypoints[i].octave=level;
                 keypoints[i].size = scaledPatchSize;
             }
-        }
 
-        // compute orientations
-        for (int level = 0; level < nlevels; ++level)
-            computeOrientation(mvImagePyramid[level], allKeypoints[level], umax);
+            // compute orientations
+            computeOrientation(mvImagePyramid[level], keypoints, umax);
+        });
     }
 
     void ORBextractor::ComputeKeyPointsOld(std::vector<std::vector<KeyPoint> > &allKeypoints)
@@ -1045,15 +1268,6 @@ namespace ORB_SLAM3
             computeOrientation(mvImagePyramid[level], allKeypoints[level], umax);
     }
 
-    static void computeDescriptors(const Mat& image, vector<KeyPoint>& keypoints, Mat& descriptors,
-                                   const vector<Point>& pattern)
-    {
-        descriptors = Mat::zeros((int)keypoints.size(), 32, CV_8UC1);
-
-        for (size_t i = 0; i < keypoints.size(); i++)
-            computeOrbDescriptor(keypoints[i], image, &pattern[0], descriptors.ptr((int)i));
-    }
-
     int ORBextractor::operator()( InputArray _image, InputArray _mask, vector<KeyPoint>& _keypoints,
                                   OutputArray _descriptors, std::vector<int> &vLappingArea)
     {
@@ -1088,6 +1302,18 @@ namespace ORB_SLAM3
         //_keypoints.reserve(nkeypoints);
         _keypoints = vector<cv::KeyPoint>(nkeypoints);
 
+        // Descriptors of every level, gathered below in level order
+        vector<Mat> vLevelDescriptors(nlevels);
+        ParallelFor(nlevels, [&](int level)
+        {
+            vector<KeyPoint>& keypoints = allKeypoints[level];
+            if(keypoints.empty())
+                return;
+
+            // Compute the descriptors on the blurred level
+            mDescriptor.Compute(mPyramid.mvBlurred[level], keypoints, vLevelDescriptors[level], mDescriptorAngleMode);
+        });
+
         int offset = 0;
         //Modified for speeding up stereo fisheye matching
         int monoIndex = 0, stereoIndex = nkeypoints-1;
@@ -1099,14 +1325,7 @@ namespace ORB_SLAM3
             if(nkeypointsLevel==0)
                 continue;
 
-            // preprocess the resized image
-            Mat workingMat = mvImagePyramid[level].clone();
-            GaussianBlur(workingMat, workingMat, Size(7, 7), 2, 2, BORDER_REFLECT_101);
-
-            // Compute the descriptors
-            //Mat desc = descriptors.rowRange(offset, offset + nkeypointsLevel);
-            Mat desc = cv::Mat(nkeypointsLevel, 32, CV_8U);
-            computeDescriptors(workingMat, keypoints, desc, pattern);
+            const Mat& desc = vLevelDescriptors[level];
 
             offset += nkeypointsLevel;
 
@@ -1138,31 +1357,24 @@ namespace ORB_SLAM3
         return monoIndex;
     }
 
-    void ORBextractor::ComputePyramid(cv::Mat image)
+    void ORBextractor::ParallelFor(int nTasks, const std::function<void(int)>& f)
     {
-        for (int level = 0; level < nlevels; ++level)
+        if(mpWorkerPool)
         {
-            float scale = mvInvScaleFactor[level];
-            Size sz(cvRound((float)image.cols*scale), cvRound((float)image.rows*scale));
-            Size wholeSize(sz.width + EDGE_THRESHOLD*2, sz.height + EDGE_THRESHOLD*2);
-            Mat temp(wholeSize, image.type()), masktemp;
-            mvImagePyramid[level] = temp(Rect(EDGE_THRESHOLD, EDGE_THRESHOLD, sz.width, sz.height));
-
-            // Compute the resized image
-            if( level != 0 )
-            {
-                resize(mvImagePyramid[level-1], mvImagePyramid[level], sz, 0, 0, INTER_LINEAR);
-
-                copyMakeBorder(mvImagePyramid[level], temp, EDGE_THRESHOLD, EDGE_THRESHOLD, EDGE_THRESHOLD, EDGE_THRESHOLD,
-                               BORDER_REFLECT_101+BORDER_ISOLATED);
-            }
-            else
-            {
-                copyMakeBorder(image, temp, EDGE_THRESHOLD, EDGE_THRESHOLD, EDGE_THRESHOLD, EDGE_THRESHOLD,
-                               BORDER_REFLECT_101);
-            }
+            mpWorkerPool->ParallelFor(nTasks, f);
+            return;
         }
 
+        for(int i=0; i<nTasks; i++)
+            f(i);
+    }
+
+    void ORBextractor::ComputePyramid(cv::Mat image)
+    {
+        mPyramid.Build(image, mvInvScaleFactor);
+
+        for (int level = 0; level < nlevels; ++level)
+            mvImagePyramid[level] = mPyramid.mvLevels[level];
     }
 
 } //namespace ORB_SLAM
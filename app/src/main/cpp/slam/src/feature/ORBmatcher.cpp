@@ -23,12 +23,65 @@
 #include <opencv2/core/core.hpp>
 
 #include <DBoW2/FeatureVector.h>
+#include <DBoW2/HammingDistance.h>
 
 using namespace std;
 
 namespace ORB_SLAM3
 {
 
+    namespace
+    {
+
+    // Candidates of one query gathered by a matching loop. Their distances to the query are computed at
+    // once by the batched Hamming kernels, then the loop goes through them in the order they were added.
+    class CandidateBatch
+    {
+    public:
+        void Clear()
+        {
+            mvIdx.clear();
+            mvRows.clear();
+        }
+
+        void Add(size_t idx, const DescriptorArray &descriptors, size_t row)
+        {
+            mvIdx.push_back(idx);
+            mvRows.push_back(descriptors.Row(row));
+        }
+
+        void Compute(const unsigned char *query)
+        {
+            mvDist.resize(mvRows.size());
+            DBoW2::HammingDistance::distances(query, mvRows.data(), (int)mvRows.size(), mvDist.data());
+        }
+
+        size_t Size() const { return mvIdx.size(); }
+        size_t Idx(size_t k) const { return mvIdx[k]; }
+        int Dist(size_t k) const { return mvDist[k]; }
+
+    private:
+        vector<size_t> mvIdx;
+        vector<const unsigned char*> mvRows;
+        vector<int> mvDist;
+    };
+
+    // Matchers are short lived, the buffers are kept per thread instead
+    CandidateBatch& GetCandidateBatch()
+    {
+        thread_local CandidateBatch batch;
+        return batch;
+    }
+
+    // Keypoints found by the grid search around one projection
+    vector<size_t>& GetAreaIndices()
+    {
+        thread_local vector<size_t> vIndices;
+        return vIndices;
+    }
+
+    } // namespace
+
     const int ORBmatcher::TH_HIGH = 100;
     const int ORBmatcher::TH_LOW = 50;
     const int ORBmatcher::HISTO_LENGTH = 30;
@@ -65,11 +118,11 @@ namespace ORB_SLAM3
                 if(bFactor)
                     r*=th;
 
-                const vector<size_t> vIndices =
-                        F.GetFeaturesInArea(pMP->mTrackProjX,pMP->mTrackProjY,r*F.mvScaleFactors[nPredictedLevel],nPredictedLevel-1,nPredictedLevel);
+                vector<size_t> &vIndices = GetAreaIndices();
+                F.GetFeaturesInArea(pMP->mTrackProjX,pMP->mTrackProjY,r*F.mvScaleFactors[nPredictedLevel],nPredictedLevel-1,nPredictedLevel,false,vIndices);
 
                 if(!vIndices.empty()){
-                    const cv::Mat MPdescriptor = pMP->GetDescriptor();
+                    const PackedDescriptor MPdescriptor = pMP->GetDescriptor();
 
                     int bestDist=256;
                     int bestLevel= -1;
@@ -78,6 +131,8 @@ namespace ORB_SLAM3
                     int bestIdx =-1 ;
 
                     // Get best and second matches with near keypoints
+                    CandidateBatch &batch = GetCandidateBatch();
+                    batch.Clear();
                     for(vector<size_t>::const_iterator vit=vIndices.begin(), vend=vIndices.end(); vit!=vend; vit++)
                     {
                         const size_t idx = *vit;
@@ -93,9 +148,14 @@ namespace ORB_SLAM3
                                 continue;
                         }
 
-                        const cv::Mat &d = F.mDescriptors.row(idx);
+                        batch.Add(idx, F.mDescriptors, idx);
+                    }
+                    batch.Compute(MPdescriptor.Data());
 
-                        const int dist = DescriptorDistance(MPdescriptor,d);
+                    for(size_t k=0; k<batch.Size(); k++)
+                    {
+                        const size_t idx = batch.Idx(k);
+                        const int dist = batch.Dist(k);
 
                         if(dist<bestDist)
                         {
@@ -143,13 +203,13 @@ namespace ORB_SLAM3
                 if(nPredictedLevel != -1){
                     float r = RadiusByViewingCos(pMP->mTrackViewCosR);
 
-                    const vector<size_t> vIndices =
-                            F.GetFeaturesInArea(pMP->mTrackProjXR,pMP->mTrackProjYR,r*F.mvScaleFactors[nPredictedLevel],nPredictedLevel-1,nPredictedLevel,true);
+                    vector<size_t> &vIndices = GetAreaIndices();
+                    F.GetFeaturesInArea(pMP->mTrackProjXR,pMP->mTrackProjYR,r*F.mvScaleFactors[nPredictedLevel],nPredictedLevel-1,nPredictedLevel,true,vIndices);
 
                     if(vIndices.empty())
                         continue;
 
-                    const cv::Mat MPdescriptor = pMP->GetDescriptor();
+                    const PackedDescriptor MPdescriptor = pMP->GetDescriptor();
 
                     int bestDist=256;
                     int bestLevel= -1;
@@ -158,6 +218,8 @@ namespace ORB_SLAM3
                     int bestIdx =-1 ;
 
                     // Get best and second matches with near keypoints
+                    CandidateBatch &batch = GetCandidateBatch();
+                    batch.Clear();
                     for(vector<size_t>::const_iterator vit=vIndices.begin(), vend=vIndices.end(); vit!=vend; vit++)
                     {
                         const size_t idx = *vit;
@@ -166,10 +228,14 @@ namespace ORB_SLAM3
                             if(F.mvpMapPoints[idx + F.Nleft]->Observations()>0)
                                 continue;
 
+                        batch.Add(idx, F.mDescriptors, idx + F.Nleft);
+                    }
+                    batch.Compute(MPdescriptor.Data());
 
-                        const cv::Mat &d = F.mDescriptors.row(idx + F.Nleft);
-
-                        const int dist = DescriptorDistance(MPdescriptor,d);
+                    for(size_t k=0; k<batch.Size(); k++)
+                    {
+                        const size_t idx = batch.Idx(k);
+                        const int dist = batch.Dist(k);
 
                         if(dist<bestDist)
                         {
@@ -209,6 +275,110 @@ namespace ORB_SLAM3
         return nmatches;
     }
 
+    int ORBmatcher::SearchByProjection(Frame &F, const LocalMapProjection &projection, const float th, const bool bFarPoints, const float thFarPoints)
+    {
+        int nmatches=0;
+
+        const bool bFactor = th!=1.0;
+
+        for(size_t k=0; k<projection.Visible(); k++)
+        {
+            if(bFarPoints && projection.Depth(k)>thFarPoints)
+                continue;
+
+            MapPoint* pMP = projection.Point(k);
+            if(pMP->isBad())
+                continue;
+
+            const int nPredictedLevel = projection.Level(k);
+
+            // The size of the window will depend on the viewing direction
+            float r = RadiusByViewingCos(projection.ViewCos(k));
+
+            if(bFactor)
+                r*=th;
+
+            vector<size_t> &vIndices = GetAreaIndices();
+            F.GetFeaturesInArea(projection.ProjX(k),projection.ProjY(k),r*F.mvScaleFactors[nPredictedLevel],nPredictedLevel-1,nPredictedLevel,false,vIndices);
+
+            if(vIndices.empty())
+                continue;
+
+            const PackedDescriptor MPdescriptor = pMP->GetDescriptor();
+            const float projXR = projection.ProjXR(k);
+
+            int bestDist=256;
+            int bestLevel= -1;
+            int bestDist2=256;
+            int bestLevel2 = -1;
+            int bestIdx =-1 ;
+
+            // Get best and second matches with near keypoints
+            CandidateBatch &batch = GetCandidateBatch();
+            batch.Clear();
+            for(vector<size_t>::const_iterator vit=vIndices.begin(), vend=vIndices.end(); vit!=vend; vit++)
+            {
+                const size_t idx = *vit;
+
+                if(F.mvpMapPoints[idx])
+                    if(F.mvpMapPoints[idx]->Observations()>0)
+                        continue;
+
+                if(F.mvuRight[idx]>0)
+                {
+                    const float er = fabs(projXR-F.mvuRight[idx]);
+                    if(er>r*F.mvScaleFactors[nPredictedLevel])
+                        continue;
+                }
+
+                batch.Add(idx, F.mDescriptors, idx);
+            }
+            batch.Compute(MPdescriptor.Data());
+
+            for(size_t c=0; c<batch.Size(); c++)
+            {
+                const size_t idx = batch.Idx(c);
+                const int dist = batch.Dist(c);
+
+                if(dist<bestDist)
+                {
+                    bestDist2=bestDist;
+                    bestDist=dist;
+                    bestLevel2 = bestLevel;
+                    bestLevel = F.mvKeysUn[idx].octave;
+                    bestIdx=idx;
+                }
+                else if(dist<bestDist2)
+                {
+                    bestLevel2 = F.mvKeysUn[idx].octave;
+                    bestDist2=dist;
+                }
+            }
+
+            // Apply ratio to second match (only if best and second are in the same scale level)
+            if(bestDist<=TH_HIGH)
+            {
+                if(bestLevel==bestLevel2 && bestDist>mfNNratio*bestDist2)
+                    continue;
+
+                if(bestLevel!=bestLevel2 || bestDist<=mfNNratio*bestDist2){
+                    F.mvpMapPoints[bestIdx]=pMP;
+                    nmatches++;
+
+                    // Data used by the tracking
+                    pMP->mbTrackInView = true;
+                    pMP->mTrackProjX = projection.ProjX(k);
+                    pMP->mTrackProjY = projection.ProjY(k);
+                    pMP->mTrackProjXR = projXR;
+                    pMP->mTrackDepth = projection.Depth(k);
+                    pMP->mnTrackScaleLevel = nPredictedLevel;
+                    pMP->mTrackViewCos = projection.ViewCos(k);
+                }
+            }
+        }
+        return nmatches;
+    }
+
     float ORBmatcher::RadiusByViewingCos(const float &viewCos)
     {
         if(viewCos>0.998)
@@ -257,7 +427,7 @@ namespace ORB_SLAM3
                     if(pMP->isBad())
                         continue;
 
-                    const cv::Mat &dKF= pKF->mDescriptors.row(realIdxKF);
+                    const unsigned char* dKF = pKF->mDescriptors.Row(realIdxKF);
 
                     int bestDist1=256;
                     int bestIdxF =-1 ;
@@ -267,18 +437,25 @@ namespace ORB_SLAM3
                     int bestIdxFR =-1 ;
                     int bestDist2R=256;
 
+                    CandidateBatch &batch = GetCandidateBatch();
+                    batch.Clear();
                     for(size_t iF=0; iF<vIndicesF.size(); iF++)
                     {
-                        if(F.Nleft == -1){
-                            const unsigned int realIdxF = vIndicesF[iF];
+                        const unsigned int realIdxF = vIndicesF[iF];
 
-                            if(vpMapPointMatches[realIdxF])
-                                continue;
+                        if(vpMapPointMatches[realIdxF])
+                            continue;
 
-                            const cv::Mat &dF = F.mDescriptors.row(realIdxF);
+                        batch.Add(realIdxF, F.mDescriptors, realIdxF);
+                    }
+                    batch.Compute(dKF);
 
-                            const int dist =  DescriptorDistance(dKF,dF);
+                    for(size_t k=0; k<batch.Size(); k++)
+                    {
+                        const unsigned int realIdxF = batch.Idx(k);
+                        const int dist = batch.Dist(k);
 
+                        if(F.Nleft == -1){
                             if(dist<bestDist1)
                             {
                                 bestDist2=bestDist1;
@@ -291,15 +468,6 @@ namespace ORB_SLAM3
                             }
                         }
                         else{
-                            const unsigned int realIdxF = vIndicesF[iF];
-
-                            if(vpMapPointMatches[realIdxF])
-                                continue;
-
-                            const cv::Mat &dF = F.mDescriptors.row(realIdxF);
-
-                            const int dist =  DescriptorDistance(dKF,dF);
-
                             if(realIdxF < F.Nleft && dist<bestDist1){
                                 bestDist2=bestDist1;
                                 bestDist1=dist;
@@ -485,16 +653,19 @@ namespace ORB_SLAM3
             // Search in a radius
             const float radius = th*pKF->mvScaleFactors[nPredictedLevel];
 
-            const vector<size_t> vIndices = pKF->GetFeaturesInArea(uv(0),uv(1),radius);
+            vector<size_t> &vIndices = GetAreaIndices();
+            pKF->GetFeaturesInArea(uv(0),uv(1),radius,false,vIndices);
 
             if(vIndices.empty())
                 continue;
 
             // Match to the most similar keypoint in the radius
-            const cv::Mat dMP = pMP->GetDescriptor();
+            const PackedDescriptor dMP = pMP->GetDescriptor();
 
             int bestDist = 256;
             int bestIdx = -1;
+            CandidateBatch &batch = GetCandidateBatch();
+            batch.Clear();
             for(vector<size_t>::const_iterator vit=vIndices.begin(), vend=vIndices.end(); vit!=vend; vit++)
             {
                 const size_t idx = *vit;
@@ -506,9 +677,14 @@ namespace ORB_SLAM3
                 if(kpLevel<nPredictedLevel-1 || kpLevel>nPredictedLevel)
                     continue;
 
-                const cv::Mat &dKF = pKF->mDescriptors.row(idx);
+                batch.Add(idx, pKF->mDescriptors, idx);
+            }
+            batch.Compute(dMP.Data());
 
-                const int dist = DescriptorDistance(dMP,dKF);
+            for(size_t k=0; k<batch.Size(); k++)
+            {
+                const size_t idx = batch.Idx(k);
+                const int dist = batch.Dist(k);
 
                 if(dist<bestDist)
                 {
@@ -598,16 +774,19 @@ namespace ORB_SLAM3
             // Search in a radius
             const float radius = th*pKF->mvScaleFactors[nPredictedLevel];
 
-            const vector<size_t> vIndices = pKF->GetFeaturesInArea(u,v,radius);
+            vector<size_t> &vIndices = GetAreaIndices();
+            pKF->GetFeaturesInArea(u,v,radius,false,vIndices);
 
             if(vIndices.empty())
                 continue;
 
             // Match to the most similar keypoint in the radius
-            const cv::Mat dMP = pMP->GetDescriptor();
+            const PackedDescriptor dMP = pMP->GetDescriptor();
 
             int bestDist = 256;
             int bestIdx = -1;
+            CandidateBatch &batch = GetCandidateBatch();
+            batch.Clear();
             for(vector<size_t>::const_iterator vit=vIndices.begin(), vend=vIndices.end(); vit!=vend; vit++)
             {
                 const size_t idx = *vit;
@@ -619,9 +798,14 @@ namespace ORB_SLAM3
                 if(kpLevel<nPredictedLevel-1 || kpLevel>nPredictedLevel)
                     continue;
 
-                const cv::Mat &dKF = pKF->mDescriptors.row(idx);
+                batch.Add(idx, pKF->mDescriptors, idx);
+            }
+            batch.Compute(dMP.Data());
 
-                const int dist = DescriptorDistance(dMP,dKF);
+            for(size_t k=0; k<batch.Size(); k++)
+            {
+                const size_t idx = batch.Idx(k);
+                const int dist = batch.Dist(k);
 
                 if(dist<bestDist)
                 {
@@ -662,24 +846,29 @@ namespace ORB_SLAM3
             if(level1>0)
                 continue;
 
-            vector<size_t> vIndices2 = F2.GetFeaturesInArea(vbPrevMatched[i1].x,vbPrevMatched[i1].y, windowSize,level1,level1);
+            vector<size_t> &vIndices2 = GetAreaIndices();
+            F2.GetFeaturesInArea(vbPrevMatched[i1].x,vbPrevMatched[i1].y, windowSize,level1,level1,false,vIndices2);
 
             if(vIndices2.empty())
                 continue;
 
-            cv::Mat d1 = F1.mDescriptors.row(i1);
+            const unsigned char* d1 = F1.mDescriptors.Row(i1);
 
             int bestDist = INT_MAX;
             int bestDist2 = INT_MAX;
             int bestIdx2 = -1;
 
+            CandidateBatch &batch = GetCandidateBatch();
+            batch.Clear();
             for(vector<size_t>::iterator vit=vIndices2.begin(); vit!=vIndices2.end(); vit++)
-            {
-                size_t i2 = *vit;
+                batch.Add(*vit, F2.mDescriptors, *vit);
+            batch.Compute(d1);
 
-                cv::Mat d2 = F2.mDescriptors.row(i2);
+            for(size_t k=0; k<batch.Size(); k++)
+            {
+                size_t i2 = batch.Idx(k);
 
-                int dist = DescriptorDistance(d1,d2);
+                int dist = batch.Dist(k);
 
                 if(vMatchedDistance[i2]<=dist)
                     continue;
@@ -764,12 +953,12 @@ namespace ORB_SLAM3
         const vector<cv::KeyPoint> &vKeysUn1 = pKF1->mvKeysUn;
         const DBoW2::FeatureVector &vFeatVec1 = pKF1->mFeatVec;
         const vector<MapPoint*> vpMapPoints1 = pKF1->GetMapPointMatches();
-        const cv::Mat &Descriptors1 = pKF1->mDescriptors;
+        const DescriptorArray &Descriptors1 = pKF1->mDescriptors;
 
         const vector<cv::KeyPoint> &vKeysUn2 = pKF2->mvKeysUn;
         const DBoW2::FeatureVector &vFeatVec2 = pKF2->mFeatVec;
         const vector<MapPoint*> vpMapPoints2 = pKF2->GetMapPointMatches();
-        const cv::Mat &Descriptors2 = pKF2->mDescriptors;
+        const DescriptorArray &Descriptors2 = pKF2->mDescriptors;
 
         vpMatches12 = vector<MapPoint*>(vpMapPoints1.size(),static_cast<MapPoint*>(NULL));
         vector<bool> vbMatched2(vpMapPoints2.size(),false);
@@ -804,12 +993,14 @@ namespace ORB_SLAM3
                     if(pMP1->isBad())
                         continue;
 
-                    const cv::Mat &d1 = Descriptors1.row(idx1);
+                    const unsigned char* d1 = Descriptors1.Row(idx1);
 
                     int bestDist1=256;
                     int bestIdx2 =-1 ;
                     int bestDist2=256;
 
+                    CandidateBatch &batch = GetCandidateBatch();
+                    batch.Clear();
                     for(size_t i2=0, iend2=f2it->second.size(); i2<iend2; i2++)
                     {
                         const size_t idx2 = f2it->second[i2];
@@ -826,9 +1017,14 @@ namespace ORB_SLAM3
                         if(pMP2->isBad())
                             continue;
 
-                        const cv::Mat &d2 = Descriptors2.row(idx2);
+                        batch.Add(idx2, Descriptors2, idx2);
+                    }
+                    batch.Compute(d1);
 
-                        int dist = DescriptorDistance(d1,d2);
+                    for(size_t k=0; k<batch.Size(); k++)
+                    {
+                        const size_t idx2 = batch.Idx(k);
+                        int dist = batch.Dist(k);
 
                         if(dist<bestDist1)
                         {
@@ -986,11 +1182,13 @@ namespace ORB_SLAM3
                     const bool bRight1 = (pKF1 -> NLeft == -1 || idx1 < pKF1 -> NLeft) ? false
                                                                                        : true;
 
-                    const cv::Mat &d1 = pKF1->mDescriptors.row(idx1);
+                    const unsigned char* d1 = pKF1->mDescriptors.Row(idx1);
 
                     int bestDist = TH_LOW;
                     int bestIdx2 = -1;
 
+                    CandidateBatch &batch = GetCandidateBatch();
+                    batch.Clear();
                     for(size_t i2=0, iend2=f2it->second.size(); i2<iend2; i2++)
                     {
                         size_t idx2 = f2it->second[i2];
@@ -1007,9 +1205,17 @@ namespace ORB_SLAM3
                             if(!bStereo2)
                                 continue;
 
-                        const cv::Mat &d2 = pKF2->mDescriptors.row(idx2);
+                        batch.Add(idx2, pKF2->mDescriptors, idx2);
+                    }
+                    batch.Compute(d1);
+
+                    for(size_t k=0; k<batch.Size(); k++)
+                    {
+                        size_t idx2 = batch.Idx(k);
+
+                        const bool bStereo2 = (!pKF2->mpCamera2 &&  pKF2->mvuRight[idx2]>=0);
 
-                        const int dist = DescriptorDistance(d1,d2);
+                        const int dist = batch.Dist(k);
 
                         if(dist>TH_LOW || dist>bestDist)
                             continue;
@@ -1240,7 +1446,8 @@ namespace ORB_SLAM3
             // Search in a radius
             const float radius = th*pKF->mvScaleFactors[nPredictedLevel];
 
-            const vector<size_t> vIndices = pKF->GetFeaturesInArea(uv(0),uv(1),radius,bRight);
+            vector<size_t> &vIndices = GetAreaIndices();
+            pKF->GetFeaturesInArea(uv(0),uv(1),radius,bRight,vIndices);
 
             if(vIndices.empty())
             {
@@ -1250,10 +1457,12 @@ namespace ORB_SLAM3
 
             // Match to the most similar keypoint in the radius
 
-            const cv::Mat dMP = pMP->GetDescriptor();
+            const PackedDescriptor dMP = pMP->GetDescriptor();
 
             int bestDist = 256;
             int bestIdx = -1;
+            CandidateBatch &batch = GetCandidateBatch();
+            batch.Clear();
             for(vector<size_t>::const_iterator vit=vIndices.begin(), vend=vIndices.end(); vit!=vend; vit++)
             {
                 size_t idx = *vit;
@@ -1294,9 +1503,14 @@ namespace ORB_SLAM3
 
                 if(bRight) idx += pKF->NLeft;
 
-                const cv::Mat &dKF = pKF->mDescriptors.row(idx);
+                batch.Add(idx, pKF->mDescriptors, idx);
+            }
+            batch.Compute(dMP.Data());
 
-                const int dist = DescriptorDistance(dMP,dKF);
+            for(size_t k=0; k<batch.Size(); k++)
+            {
+                const size_t idx = batch.Idx(k);
+                const int dist = batch.Dist(k);
 
                 if(dist<bestDist)
                 {
@@ -1400,17 +1614,20 @@ namespace ORB_SLAM3
             // Search in a radius
             const float radius = th*pKF->mvScaleFactors[nPredictedLevel];
 
-            const vector<size_t> vIndices = pKF->GetFeaturesInArea(uv(0),uv(1),radius);
+            vector<size_t> &vIndices = GetAreaIndices();
+            pKF->GetFeaturesInArea(uv(0),uv(1),radius,false,vIndices);
 
             if(vIndices.empty())
                 continue;
 
             // Match to the most similar keypoint in the radius
 
-            const cv::Mat dMP = pMP->GetDescriptor();
+            const PackedDescriptor dMP = pMP->GetDescriptor();
 
             int bestDist = INT_MAX;
             int bestIdx = -1;
+            CandidateBatch &batch = GetCandidateBatch();
+            batch.Clear();
             for(vector<size_t>::const_iterator vit=vIndices.begin(); vit!=vIndices.end(); vit++)
             {
                 const size_t idx = *vit;
@@ -1419,9 +1636,14 @@ namespace ORB_SLAM3
                 if(kpLevel<nPredictedLevel-1 || kpLevel>nPredictedLevel)
                     continue;
 
-                const cv::Mat &dKF = pKF->mDescriptors.row(idx);
+                batch.Add(idx, pKF->mDescriptors, idx);
+            }
+            batch.Compute(dMP.Data());
 
-                int dist = DescriptorDistance(dMP,dKF);
+            for(size_t k=0; k<batch.Size(); k++)
+            {
+                const size_t idx = batch.Idx(k);
+                int dist = batch.Dist(k);
 
                 if(dist<bestDist)
                 {
@@ -1533,16 +1755,19 @@ namespace ORB_SLAM3
             // Search in a radius
             const float radius = th*pKF2->mvScaleFactors[nPredictedLevel];
 
-            const vector<size_t> vIndices = pKF2->GetFeaturesInArea(u,v,radius);
+            vector<size_t> &vIndices = GetAreaIndices();
+            pKF2->GetFeaturesInArea(u,v,radius,false,vIndices);
 
             if(vIndices.empty())
                 continue;
 
             // Match to the most similar keypoint in the radius
-            const cv::Mat dMP = pMP->GetDescriptor();
+            const PackedDescriptor dMP = pMP->GetDescriptor();
 
             int bestDist = INT_MAX;
             int bestIdx = -1;
+            CandidateBatch &batch = GetCandidateBatch();
+            batch.Clear();
             for(vector<size_t>::const_iterator vit=vIndices.begin(), vend=vIndices.end(); vit!=vend; vit++)
             {
                 const size_t idx = *vit;
@@ -1552,9 +1777,14 @@ namespace ORB_SLAM3
                 if(kp.octave<nPredictedLevel-1 || kp.octave>nPredictedLevel)
                     continue;
 
-                const cv::Mat &dKF = pKF2->mDescriptors.row(idx);
+                batch.Add(idx, pKF2->mDescriptors, idx);
+            }
+            batch.Compute(dMP.Data());
 
-                const int dist = DescriptorDistance(dMP,dKF);
+            for(size_t k=0; k<batch.Size(); k++)
+            {
+                const size_t idx = batch.Idx(k);
+                const int dist = batch.Dist(k);
 
                 if(dist<bestDist)
                 {
@@ -1613,16 +1843,19 @@ namespace ORB_SLAM3
             // Search in a radius of 2.5*sigma(ScaleLevel)
             const float radius = th*pKF1->mvScaleFactors[nPredictedLevel];
 
-            const vector<size_t> vIndices = pKF1->GetFeaturesInArea(u,v,radius);
+            vector<size_t> &vIndices = GetAreaIndices();
+            pKF1->GetFeaturesInArea(u,v,radius,false,vIndices);
 
             if(vIndices.empty())
                 continue;
 
             // Match to the most similar keypoint in the radius
-            const cv::Mat dMP = pMP->GetDescriptor();
+            const PackedDescriptor dMP = pMP->GetDescriptor();
 
             int bestDist = INT_MAX;
             int bestIdx = -1;
+            CandidateBatch &batch = GetCandidateBatch();
+            batch.Clear();
             for(vector<size_t>::const_iterator vit=vIndices.begin(), vend=vIndices.end(); vit!=vend; vit++)
             {
                 const size_t idx = *vit;
@@ -1632,9 +1865,14 @@ namespace ORB_SLAM3
                 if(kp.octave<nPredictedLevel-1 || kp.octave>nPredictedLevel)
                     continue;
 
-                const cv::Mat &dKF = pKF1->mDescriptors.row(idx);
+                batch.Add(idx, pKF1->mDescriptors, idx);
+            }
+            batch.Compute(dMP.Data());
 
-                const int dist = DescriptorDistance(dMP,dKF);
+            for(size_t k=0; k<batch.Size(); k++)
+            {
+                const size_t idx = batch.Idx(k);
+                const int dist = batch.Dist(k);
 
                 if(dist<bestDist)
                 {
@@ -1720,23 +1958,25 @@ namespace ORB_SLAM3
                     // Search in a window. Size depends on scale
                     float radius = th*CurrentFrame.mvScaleFactors[nLastOctave];
 
-                    vector<size_t> vIndices2;
+                    vector<size_t> &vIndices2 = GetAreaIndices();
 
                     if(bForward)
-                        vIndices2 = CurrentFrame.GetFeaturesInArea(uv(0),uv(1), radius, nLastOctave);
+                        CurrentFrame.GetFeaturesInArea(uv(0),uv(1), radius, nLastOctave, -1, false, vIndices2);
                     else if(bBackward)
-                        vIndices2 = CurrentFrame.GetFeaturesInArea(uv(0),uv(1), radius, 0, nLastOctave);
+                        CurrentFrame.GetFeaturesInArea(uv(0),uv(1), radius, 0, nLastOctave, false, vIndices2);
                     else
-                        vIndices2 = CurrentFrame.GetFeaturesInArea(uv(0),uv(1), radius, nLastOctave-1, nLastOctave+1);
+                        CurrentFrame.GetFeaturesInArea(uv(0),uv(1), radius, nLastOctave-1, nLastOctave+1, false, vIndices2);
 
                     if(vIndices2.empty())
                         continue;
 
-                    const cv::Mat dMP = pMP->GetDescriptor();
+                    const PackedDescriptor dMP = pMP->GetDescriptor();
 
                     int bestDist = 256;
                     int bestIdx2 = -1;
 
+                    CandidateBatch &batch = GetCandidateBatch();
+                    batch.Clear();
                     for(vector<size_t>::const_iterator vit=vIndices2.begin(), vend=vIndices2.end(); vit!=vend; vit++)
                     {
                         const size_t i2 = *vit;
@@ -1753,9 +1993,14 @@ namespace ORB_SLAM3
                                 continue;
                         }
 
-                        const cv::Mat &d = CurrentFrame.mDescriptors.row(i2);
+                        batch.Add(i2, CurrentFrame.mDescriptors, i2);
+                    }
+                    batch.Compute(dMP.Data());
 
-                        const int dist = DescriptorDistance(dMP,d);
+                    for(size_t k=0; k<batch.Size(); k++)
+                    {
+                        const size_t i2 = batch.Idx(k);
+                        const int dist = batch.Dist(k);
 
                         if(dist<bestDist)
                         {
@@ -1798,20 +2043,22 @@ namespace ORB_SLAM3
                         // Search in a window. Size depends on scale
                         float radius = th*CurrentFrame.mvScaleFactors[nLastOctave];
 
-                        vector<size_t> vIndices2;
+                        vector<size_t> &vIndices2 = GetAreaIndices();
 
                         if(bForward)
-                            vIndices2 = CurrentFrame.GetFeaturesInArea(uv(0),uv(1), radius, nLastOctave, -1,true);
+                            CurrentFrame.GetFeaturesInArea(uv(0),uv(1), radius, nLastOctave, -1,true, vIndices2);
                         else if(bBackward)
-                            vIndices2 = CurrentFrame.GetFeaturesInArea(uv(0),uv(1), radius, 0, nLastOctave, true);
+                            CurrentFrame.GetFeaturesInArea(uv(0),uv(1), radius, 0, nLastOctave, true, vIndices2);
                         else
-                            vIndices2 = CurrentFrame.GetFeaturesInArea(uv(0),uv(1), radius, nLastOctave-1, nLastOctave+1, true);
+                            CurrentFrame.GetFeaturesInArea(uv(0),uv(1), radius, nLastOctave-1, nLastOctave+1, true, vIndices2);
 
-                        const cv::Mat dMP = pMP->GetDescriptor();
+                        const PackedDescriptor dMP = pMP->GetDescriptor();
 
                         int bestDist = 256;
                         int bestIdx2 = -1;
 
+                        CandidateBatch &batch = GetCandidateBatch();
+                        batch.Clear();
                         for(vector<size_t>::const_iterator vit=vIndices2.begin(), vend=vIndices2.end(); vit!=vend; vit++)
                         {
                             const size_t i2 = *vit;
@@ -1819,9 +2066,14 @@ namespace ORB_SLAM3
                                 if(CurrentFrame.mvpMapPoints[i2 + CurrentFrame.Nleft]->Observations()>0)
                                     continue;
 
-                            const cv::Mat &d = CurrentFrame.mDescriptors.row(i2 + CurrentFrame.Nleft);
+                            batch.Add(i2, CurrentFrame.mDescriptors, i2 + CurrentFrame.Nleft);
+                        }
+                        batch.Compute(dMP.Data());
 
-                            const int dist = DescriptorDistance(dMP,d);
+                        for(size_t k=0; k<batch.Size(); k++)
+                        {
+                            const size_t i2 = batch.Idx(k);
+                            const int dist = batch.Dist(k);
 
                             if(dist<bestDist)
                             {
@@ -1933,25 +2185,33 @@ namespace ORB_SLAM3
                     // Search in a window
                     const float radius = th*CurrentFrame.mvScaleFactors[nPredictedLevel];
 
-                    const vector<size_t> vIndices2 = CurrentFrame.GetFeaturesInArea(uv(0), uv(1), radius, nPredictedLevel-1, nPredictedLevel+1);
+                    vector<size_t> &vIndices2 = GetAreaIndices();
+                    CurrentFrame.GetFeaturesInArea(uv(0), uv(1), radius, nPredictedLevel-1, nPredictedLevel+1, false, vIndices2);
 
                     if(vIndices2.empty())
                         continue;
 
-                    const cv::Mat dMP = pMP->GetDescriptor();
+                    const PackedDescriptor dMP = pMP->GetDescriptor();
 
                     int bestDist = 256;
                     int bestIdx2 = -1;
 
+                    CandidateBatch &batch = GetCandidateBatch();
+                    batch.Clear();
                     for(vector<size_t>::const_iterator vit=vIndices2.begin(); vit!=vIndices2.end(); vit++)
                     {
                         const size_t i2 = *vit;
                         if(CurrentFrame.mvpMapPoints[i2])
                             continue;
 
-                        const cv::Mat &d = CurrentFrame.mDescriptors.row(i2);
+                        batch.Add(i2, CurrentFrame.mDescriptors, i2);
+                    }
+                    batch.Compute(dMP.Data());
 
-                        const int dist = DescriptorDistance(dMP,d);
+                    for(size_t k=0; k<batch.Size(); k++)
+                    {
+                        const size_t i2 = batch.Idx(k);
+                        const int dist = batch.Dist(k);
 
                         if(dist<bestDist)
                         {
@@ -2050,24 +2310,14 @@ namespace ORB_SLAM3
     }
 
 
-// Bit set count operation from
-// http://graphics.stanford.edu/~seander/bithacks.html#CountBitsSetParallel
     int ORBmatcher::DescriptorDistance(const cv::Mat &a, const cv::Mat &b)
     {
-        const int *pa = a.ptr<int32_t>();
-        const int *pb = b.ptr<int32_t>();
-
-        int dist=0;
-
-        for(int i=0; i<8; i++, pa++, pb++)
-        {
-            unsigned  int v = *pa ^ *pb;
-            v = v - ((v >> 1) & 0x55555555);
-            v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
-            dist += (((v + (v >> 4)) & 0xF0F0F0F) * 0x1010101) >> 24;
-        }
+        return DBoW2::HammingDistance::distance(a.ptr<unsigned char>(), b.ptr<unsigned char>());
+    }
 
-        return dist;
+    int ORBmatcher::DescriptorDistance(const unsigned char *a, const unsigned char *b)
+    {
+        return DBoW2::HammingDistance::distance(a, b);
     }
 
 } //namespace ORB_SLAM
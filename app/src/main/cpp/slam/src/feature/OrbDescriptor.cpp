@@ -0,0 +1,138 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "feature/OrbDescriptor.h"
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace ORB_SLAM3
+{
+
+namespace
+{
+
+const int PAIR_COUNT = 256;
+
+// desc bit i%8 of byte i/8 is a[i] < b[i]
+void CompareBits(const uchar* a, const uchar* b, uchar* desc)
+{
+#if defined(__SSE2__)
+    for(int i=0; i<PAIR_COUNT; i+=16)
+    {
+        const __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        const __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        // a >= b where max(a, b) == a
+        const int ge = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(va, vb), va));
+        const int lt = ~ge & 0xffff;
+        desc[i/8] = (uchar)lt;
+        desc[i/8+1] = (uchar)(lt >> 8);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t vw = vld1q_u8(weights);
+    for(int i=0; i<PAIR_COUNT; i+=16)
+    {
+        const uint8x16_t lt = vandq_u8(vcltq_u8(vld1q_u8(a + i), vld1q_u8(b + i)), vw);
+        desc[i/8] = vaddv_u8(vget_low_u8(lt));
+        desc[i/8+1] = vaddv_u8(vget_high_u8(lt));
+    }
+#else
+    for(int i=0; i<PAIR_COUNT/8; i++)
+    {
+        int val = 0;
+        for(int k=0; k<8; k++)
+            val |= (a[i*8+k] < b[i*8+k]) << k;
+        desc[i] = (uchar)val;
+    }
+#endif
+}
+
+} // namespace
+
+OrbDescriptor::OrbDescriptor(const cv::Point* pattern)
+    : mvPattern(pattern, pattern + POINT_COUNT)
+{
+    mvBinX.resize(ANGLE_BIN_COUNT*POINT_COUNT);
+    mvBinY.resize(ANGLE_BIN_COUNT*POINT_COUNT);
+    for(int bin=0; bin<ANGLE_BIN_COUNT; bin++)
+    {
+        const float angle = (float)(bin*360/ANGLE_BIN_COUNT)*(float)(CV_PI/180.f);
+        const float a = (float)std::cos(angle), b = (float)std::sin(angle);
+        for(int i=0; i<POINT_COUNT; i++)
+        {
+            mvBinX[bin*POINT_COUNT+i] = (signed char)cvRound(mvPattern[i].x*a - mvPattern[i].y*b);
+            mvBinY[bin*POINT_COUNT+i] = (signed char)cvRound(mvPattern[i].x*b + mvPattern[i].y*a);
+        }
+    }
+}
+
+void OrbDescriptor::Compute(const cv::Mat& image, const std::vector<cv::KeyPoint>& vKeys, cv::Mat& descriptors,
+                            AngleMode mode) const
+{
+    descriptors = cv::Mat::zeros((int)vKeys.size(), 32, CV_8UC1);
+
+    const int step = (int)image.step;
+    const float factorPI = (float)(CV_PI/180.f);
+
+    int offsets[POINT_COUNT];
+    uchar va[PAIR_COUNT], vb[PAIR_COUNT];
+    for(size_t k=0; k<vKeys.size(); k++)
+    {
+        const cv::KeyPoint& kpt = vKeys[k];
+
+        if(mode == ANGLE_CONTINUOUS)
+        {
+            const float angle = (float)kpt.angle*factorPI;
+            const float a = (float)std::cos(angle), b = (float)std::sin(angle);
+            for(int i=0; i<POINT_COUNT; i++)
+                offsets[i] = cvRound(mvPattern[i].x*b + mvPattern[i].y*a)*step + cvRound(mvPattern[i].x*a - mvPattern[i].y*b);
+        }
+        else
+        {
+            int bin = cvRound(kpt.angle*ANGLE_BIN_COUNT/360.f);
+            if(bin >= ANGLE_BIN_COUNT)
+                bin -= ANGLE_BIN_COUNT;
+            else if(bin < 0)
+                bin += ANGLE_BIN_COUNT;
+
+            const signed char* binX = &mvBinX[bin*POINT_COUNT];
+            const signed char* binY = &mvBinY[bin*POINT_COUNT];
+            for(int i=0; i<POINT_COUNT; i++)
+                offsets[i] = binY[i]*step + binX[i];
+        }
+
+        const uchar* center = &image.at<uchar>(cvRound(kpt.pt.y), cvRound(kpt.pt.x));
+        for(int i=0; i<PAIR_COUNT; i++)
+        {
+            va[i] = center[offsets[2*i]];
+            vb[i] = center[offsets[2*i+1]];
+        }
+
+        CompareBits(va, vb, descriptors.ptr((int)k));
+    }
+}
+
+} //namespace ORB_SLAM3
@@ -0,0 +1,328 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "frame/BowInvertedIndex.h"
+
+#include <algorithm>
+
+namespace ORB_SLAM3
+{
+
+// No compaction below this number of dead postings
+static const size_t MIN_DEAD_POSTINGS = 4096;
+
+BowInvertedIndex::ReadSection::ReadSection(BowInvertedIndex& index) : mIndex(index)
+{
+    std::unique_lock<std::mutex> lock(mIndex.mMutexReaders);
+    mit = mIndex.msReaderEpochs.insert(mIndex.mnEpoch);
+}
+
+BowInvertedIndex::ReadSection::~ReadSection()
+{
+    std::unique_lock<std::mutex> lock(mIndex.mMutexReaders);
+    mIndex.msReaderEpochs.erase(mit);
+}
+
+BowInvertedIndex::BowInvertedIndex() : mnPostings(0), mnDeadPostings(0), mnEpoch(0)
+{
+}
+
+unsigned int BowInvertedIndex::Add(int nPartition, const DBoW2::BowVector& bowVec)
+{
+    std::unique_lock<std::mutex> lockWrite(mMutexWrite);
+
+    // Ids freed before the oldest read section opened can be reused
+    {
+        std::unique_lock<std::mutex> lock(mMutexReaders);
+        const uint64_t nOldest = msReaderEpochs.empty() ? mnEpoch : *msReaderEpochs.begin();
+        size_t nReleased = 0;
+        while(nReleased < mvPendingIds.size() && mvPendingIds[nReleased].first <= nOldest)
+        {
+            mvFreeIds.insert(mvFreeIds.end(), mvPendingIds[nReleased].second.begin(),
+                             mvPendingIds[nReleased].second.end());
+            nReleased++;
+        }
+        mvPendingIds.erase(mvPendingIds.begin(), mvPendingIds.begin()+nReleased);
+    }
+
+    unsigned int nId;
+    {
+        std::unique_lock<std::mutex> lock(mMutexEntries);
+        if(!mvFreeIds.empty())
+        {
+            nId = mvFreeIds.back();
+            mvFreeIds.pop_back();
+        }
+        else
+        {
+            nId = mvEntries.size();
+            mvEntries.emplace_back();
+        }
+
+        Entry& entry = mvEntries[nId];
+        entry.nPartition = nPartition;
+        entry.bAlive = true;
+        entry.nWords = bowVec.size();
+        mnPostings += entry.nWords;
+    }
+
+    // Words grouped by stripe, so that every stripe is locked once
+    std::vector<std::pair<int, DBoW2::WordId> > vWords;
+    vWords.reserve(bowVec.size());
+    for(DBoW2::BowVector::const_iterator vit=bowVec.begin(), vend=bowVec.end(); vit!=vend; vit++)
+        vWords.push_back(std::make_pair(StripeOf(vit->first), vit->first));
+    std::sort(vWords.begin(), vWords.end());
+
+    for(size_t i=0; i<vWords.size();)
+    {
+        Stripe& stripe = mStripes[vWords[i].first];
+        std::unique_lock<std::shared_mutex> lock(stripe.mMutex);
+        if(nPartition >= static_cast<int>(stripe.mvPartitions.size()))
+            stripe.mvPartitions.resize(nPartition+1);
+
+        WordPostings& postings = stripe.mvPartitions[nPartition];
+        const int nStripe = vWords[i].first;
+        for(; i<vWords.size() && vWords[i].first==nStripe; i++)
+            postings[vWords[i].second].push_back(nId);
+    }
+
+    return nId;
+}
+
+void BowInvertedIndex::Erase(unsigned int nId)
+{
+    std::unique_lock<std::mutex> lockWrite(mMutexWrite);
+
+    size_t nPostings, nDeadPostings;
+    {
+        std::unique_lock<std::mutex> lock(mMutexEntries);
+        Entry& entry = mvEntries[nId];
+        if(entry.nPartition < 0 || !entry.bAlive)
+            return;
+
+        entry.bAlive = false;
+        mnDeadPostings += entry.nWords;
+        nPostings = mnPostings;
+        nDeadPostings = mnDeadPostings;
+    }
+
+    if(nDeadPostings >= MIN_DEAD_POSTINGS && 4*nDeadPostings >= nPostings)
+        Compact();
+}
+
+void BowInvertedIndex::ErasePartition(int nPartition)
+{
+    std::unique_lock<std::mutex> lockWrite(mMutexWrite);
+
+    for(Stripe& stripe : mStripes)
+    {
+        std::unique_lock<std::shared_mutex> lock(stripe.mMutex);
+        if(nPartition < static_cast<int>(stripe.mvPartitions.size()))
+            stripe.mvPartitions[nPartition].clear();
+    }
+
+    std::vector<unsigned int> vnIds;
+    {
+        std::unique_lock<std::mutex> lock(mMutexEntries);
+        for(unsigned int nId=0; nId<mvEntries.size(); nId++)
+        {
+            Entry& entry = mvEntries[nId];
+            if(entry.nPartition != nPartition)
+                continue;
+
+            mnPostings -= entry.nWords;
+            if(!entry.bAlive)
+                mnDeadPostings -= entry.nWords;
+            entry.nPartition = -1;
+            vnIds.push_back(nId);
+        }
+    }
+    ReleaseIds(vnIds);
+}
+
+void BowInvertedIndex::Clear()
+{
+    std::unique_lock<std::mutex> lockWrite(mMutexWrite);
+
+    for(Stripe& stripe : mStripes)
+    {
+        std::unique_lock<std::shared_mutex> lock(stripe.mMutex);
+        stripe.mvPartitions.clear();
+    }
+
+    std::vector<unsigned int> vnIds;
+    {
+        std::unique_lock<std::mutex> lock(mMutexEntries);
+        for(unsigned int nId=0; nId<mvEntries.size(); nId++)
+        {
+            if(mvEntries[nId].nPartition >= 0)
+            {
+                mvEntries[nId].nPartition = -1;
+                vnIds.push_back(nId);
+            }
+        }
+        mnPostings = 0;
+        mnDeadPostings = 0;
+    }
+    ReleaseIds(vnIds);
+}
+
+void BowInvertedIndex::Search(const DBoW2::BowVector& bowVec, int nPartition, std::vector<unsigned int>& vnIds,
+                              std::vector<int>& vnWords) const
+{
+    vnIds.clear();
+    vnWords.clear();
+
+    // Words shared with the query by id, zero between searches. The entries added after this point are left out.
+    thread_local std::vector<int> vnVotes;
+    {
+        std::unique_lock<std::mutex> lock(mMutexEntries);
+        vnVotes.resize(mvEntries.size(), 0);
+    }
+
+    for(DBoW2::BowVector::const_iterator vit=bowVec.begin(), vend=bowVec.end(); vit!=vend; vit++)
+    {
+        const Stripe& stripe = mStripes[StripeOf(vit->first)];
+        std::shared_lock<std::shared_mutex> lock(stripe.mMutex);
+
+        if(nPartition >= 0)
+        {
+            if(nPartition < static_cast<int>(stripe.mvPartitions.size()))
+                SearchPartition(stripe.mvPartitions[nPartition], vit->first, vnVotes, vnIds);
+        }
+        else
+        {
+            for(const WordPostings& postings : stripe.mvPartitions)
+                SearchPartition(postings, vit->first, vnVotes, vnIds);
+        }
+    }
+
+    // Entries erased since they were met are dropped
+    std::unique_lock<std::mutex> lock(mMutexEntries);
+    size_t nKept = 0;
+    vnWords.reserve(vnIds.size());
+    for(size_t i=0; i<vnIds.size(); i++)
+    {
+        const unsigned int nId = vnIds[i];
+        if(mvEntries[nId].bAlive)
+        {
+            vnIds[nKept++] = nId;
+            vnWords.push_back(vnVotes[nId]);
+        }
+        vnVotes[nId] = 0;
+    }
+    vnIds.resize(nKept);
+}
+
+void BowInvertedIndex::SearchPartition(const WordPostings& postings, DBoW2::WordId wordId, std::vector<int>& vnVotes,
+                                       std::vector<unsigned int>& vnIds) const
+{
+    WordPostings::const_iterator pit = postings.find(wordId);
+    if(pit == postings.end())
+        return;
+
+    for(uint32_t nId : pit->second)
+    {
+        if(nId >= vnVotes.size())
+            continue;
+        if(vnVotes[nId]++ == 0)
+            vnIds.push_back(nId);
+    }
+}
+
+int BowInvertedIndex::GetPartition(unsigned int nId) const
+{
+    std::unique_lock<std::mutex> lock(mMutexEntries);
+    return mvEntries[nId].nPartition;
+}
+
+size_t BowInvertedIndex::Postings() const
+{
+    std::unique_lock<std::mutex> lock(mMutexEntries);
+    return mnPostings;
+}
+
+size_t BowInvertedIndex::DeadPostings() const
+{
+    std::unique_lock<std::mutex> lock(mMutexEntries);
+    return mnDeadPostings;
+}
+
+void BowInvertedIndex::Compact()
+{
+    // Only the writers change the entries, so the dead ones stay dead while the stripes are filtered
+    std::vector<char> vbDead;
+    std::vector<unsigned int> vnIds;
+    {
+        std::unique_lock<std::mutex> lock(mMutexEntries);
+        vbDead.resize(mvEntries.size(), 0);
+        for(unsigned int nId=0; nId<mvEntries.size(); nId++)
+        {
+            if(mvEntries[nId].nPartition >= 0 && !mvEntries[nId].bAlive)
+            {
+                vbDead[nId] = 1;
+                vnIds.push_back(nId);
+            }
+        }
+    }
+
+    // One stripe at a time, the searches keep going on the others
+    for(Stripe& stripe : mStripes)
+    {
+        std::unique_lock<std::shared_mutex> lock(stripe.mMutex);
+        for(WordPostings& postings : stripe.mvPartitions)
+        {
+            for(WordPostings::iterator pit=postings.begin(); pit!=postings.end();)
+            {
+                std::vector<uint32_t>& vnPostings = pit->second;
+                vnPostings.erase(std::remove_if(vnPostings.begin(), vnPostings.end(),
+                                                [&vbDead](uint32_t nId) { return vbDead[nId] != 0; }),
+                                 vnPostings.end());
+                if(vnPostings.empty())
+                    pit = postings.erase(pit);
+                else
+                    ++pit;
+            }
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mMutexEntries);
+        for(unsigned int nId : vnIds)
+        {
+            mnPostings -= mvEntries[nId].nWords;
+            mnDeadPostings -= mvEntries[nId].nWords;
+            mvEntries[nId].nPartition = -1;
+        }
+    }
+    ReleaseIds(vnIds);
+}
+
+void BowInvertedIndex::ReleaseIds(const std::vector<unsigned int>& vnIds)
+{
+    if(vnIds.empty())
+        return;
+
+    // The read sections opened from now on cannot meet these ids
+    std::unique_lock<std::mutex> lock(mMutexReaders);
+    mvPendingIds.push_back(std::make_pair(++mnEpoch, vnIds));
+}
+
+} //namespace ORB_SLAM3
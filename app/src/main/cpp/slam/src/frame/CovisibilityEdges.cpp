@@ -0,0 +1,164 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "frame/CovisibilityEdges.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+namespace ORB_SLAM3
+{
+
+namespace
+{
+
+bool AddressLess(const CovisibilityEdges::Edge& edge, KeyFrame* pKF)
+{
+    return std::less<KeyFrame*>()(edge.pKF, pKF);
+}
+
+} // namespace
+
+size_t CovisibilityList::CountByWeight(int w) const
+{
+    // Weights decrease along the list
+    return std::upper_bound(vWeights.begin(), vWeights.end(), w, [](int a, int b) { return a>b; }) - vWeights.begin();
+}
+
+CovisibilityEdges::CovisibilityEdges(): mpOrdered(std::make_shared<CovisibilityList>()), mbOrderedComplete(false)
+{
+}
+
+int CovisibilityEdges::GetWeight(KeyFrame* pKF) const
+{
+    std::vector<Edge>::const_iterator it = std::lower_bound(mvEdges.begin(), mvEdges.end(), pKF, AddressLess);
+    if(it!=mvEdges.end() && it->pKF==pKF)
+        return it->nWeight;
+    return 0;
+}
+
+void CovisibilityEdges::Assign(std::vector<Edge>& vEdges, const std::vector<Edge>& vOrdered)
+{
+    mvEdges.swap(vEdges);
+    SetOrdered(vOrdered);
+    mbOrderedComplete = false;
+}
+
+bool CovisibilityEdges::SetWeight(KeyFrame* pKF, int nWeight)
+{
+    std::vector<Edge>::iterator it = std::lower_bound(mvEdges.begin(), mvEdges.end(), pKF, AddressLess);
+    if(it!=mvEdges.end() && it->pKF==pKF)
+    {
+        if(it->nWeight==nWeight)
+            return false;
+        it->nWeight = nWeight;
+    }
+    else
+        mvEdges.insert(it, Edge{pKF,nWeight});
+    return true;
+}
+
+bool CovisibilityEdges::EraseWeight(KeyFrame* pKF)
+{
+    std::vector<Edge>::iterator it = std::lower_bound(mvEdges.begin(), mvEdges.end(), pKF, AddressLess);
+    if(it==mvEdges.end() || it->pKF!=pKF)
+        return false;
+    mvEdges.erase(it);
+    return true;
+}
+
+void CovisibilityEdges::UpdateOrdered(KeyFrame* pKF, int nWeight)
+{
+    EraseOrdered(pKF);
+
+    CovisibilityList& ordered = WritableOrdered();
+    size_t i = 0;
+    const Edge edge{pKF,nWeight};
+    while(i<ordered.vpKeyFrames.size() && IsBefore(Edge{ordered.vpKeyFrames[i],ordered.vWeights[i]}, edge))
+        i++;
+    ordered.vpKeyFrames.insert(ordered.vpKeyFrames.begin()+i, pKF);
+    ordered.vWeights.insert(ordered.vWeights.begin()+i, nWeight);
+}
+
+void CovisibilityEdges::EraseOrdered(KeyFrame* pKF)
+{
+    const std::vector<KeyFrame*>& vpKFs = mpOrdered->vpKeyFrames;
+    std::vector<KeyFrame*>::const_iterator it = std::find(vpKFs.begin(), vpKFs.end(), pKF);
+    if(it==vpKFs.end())
+        return;
+
+    const size_t i = it-vpKFs.begin();
+    CovisibilityList& ordered = WritableOrdered();
+    ordered.vpKeyFrames.erase(ordered.vpKeyFrames.begin()+i);
+    ordered.vWeights.erase(ordered.vWeights.begin()+i);
+}
+
+void CovisibilityEdges::Clear()
+{
+    mvEdges.clear();
+    CovisibilityList& ordered = WritableOrdered(false);
+    ordered.vpKeyFrames.clear();
+    ordered.vWeights.clear();
+    mbOrderedComplete = false;
+}
+
+void CovisibilityEdges::AddShared(KeyFrame* pKF, int nDelta)
+{
+    std::vector<Edge>::iterator it = std::lower_bound(mvShared.begin(), mvShared.end(), pKF, AddressLess);
+    if(it==mvShared.end() || it->pKF!=pKF)
+        mvShared.insert(it, Edge{pKF,nDelta});
+    else if((it->nWeight+=nDelta)==0)
+        mvShared.erase(it);
+}
+
+bool CovisibilityEdges::IsBefore(const Edge& a, const Edge& b)
+{
+    if(a.nWeight!=b.nWeight)
+        return a.nWeight>b.nWeight;
+    return std::greater<KeyFrame*>()(a.pKF, b.pKF);
+}
+
+void CovisibilityEdges::SortOrdered(std::vector<Edge>& vOrdered)
+{
+    std::sort(vOrdered.begin(), vOrdered.end(), IsBefore);
+}
+
+void CovisibilityEdges::SetOrdered(const std::vector<Edge>& vOrdered)
+{
+    CovisibilityList& ordered = WritableOrdered(false);
+    ordered.vpKeyFrames.resize(vOrdered.size());
+    ordered.vWeights.resize(vOrdered.size());
+    for(size_t i=0; i<vOrdered.size(); i++)
+    {
+        ordered.vpKeyFrames[i] = vOrdered[i].pKF;
+        ordered.vWeights[i] = vOrdered[i].nWeight;
+    }
+}
+
+CovisibilityList& CovisibilityEdges::WritableOrdered(bool bKeep)
+{
+    if(mpOrdered.use_count()>1)
+        mpOrdered = bKeep ? std::make_shared<CovisibilityList>(*mpOrdered) : std::make_shared<CovisibilityList>();
+    else
+        std::atomic_thread_fence(std::memory_order_acquire); // see the last reader's release before writing in place
+    return *mpOrdered;
+}
+
+} //namespace ORB_SLAM3
@@ -0,0 +1,57 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "frame/FeatureGrid.h"
+
+namespace ORB_SLAM3
+{
+
+void FeatureGrid::Build(int nCols, int nRows, const std::vector<int>& vCells)
+{
+    mnCols = nCols;
+    mnRows = nRows;
+
+    const int nCells = nCols*nRows;
+    mvOffsets.assign(nCells+1, 0);
+
+    // Count the keypoints of every cell, then turn the counts into offsets
+    std::size_t nIn = 0;
+    for(int c : vCells)
+    {
+        if(c >= 0)
+        {
+            mvOffsets[c+1]++;
+            nIn++;
+        }
+    }
+    for(int c=0; c<nCells; c++)
+        mvOffsets[c+1] += mvOffsets[c];
+
+    // Fill the cells in keypoint order, using the offsets of the next cell as insertion points
+    mvIndices.resize(nIn);
+    std::vector<uint32_t> vNext(mvOffsets.begin(), mvOffsets.end()-1);
+    for(std::size_t i=0; i<vCells.size(); i++)
+    {
+        if(vCells[i] >= 0)
+            mvIndices[vNext[vCells[i]]++] = static_cast<uint32_t>(i);
+    }
+}
+
+} //namespace ORB_SLAM3
@@ -29,6 +29,7 @@
 #include "feature/ORBmatcher.h"
 
 #include "utils/Converter.h"
+#include "utils/WorkerPool.h"
 
 #include "camera_models/GeometricCamera.h"
 #include "camera_models/Pinhole.h"
@@ -153,8 +154,6 @@ void Frame::copyFrom(const Frame& rhs) noexcept
     this->mK = rhs.mK.clone();
     this->mK_ = Converter::toMatrix3f(rhs.mK);
     this->mDistCoef = rhs.mDistCoef.clone();
-    this->mDescriptors = rhs.mDescriptors.clone();
-    this->mDescriptorsRight = rhs.mDescriptorsRight.clone();
     this->mbHasPose = false;
     this->mbHasVelocity = false;
     this->mpMutexImu = rhs.mpMutexImu;
@@ -477,44 +476,44 @@ Frame::Frame( const cv::Mat &imGray
 
 void Frame::AssignFeaturesToGrid()
 {
-    // Fill matrix with points
-    const int nCells = FRAME_GRID_COLS * FRAME_GRID_ROWS;
-
-    int nReserve = 0.5f * N / (nCells);
-
-    for (unsigned int i = 0; i < FRAME_GRID_COLS; i++)
-        for (unsigned int j = 0; j < FRAME_GRID_ROWS; j++)
-        {
-            mGrid[i][j].reserve(nReserve);
-            if (Nleft != -1)
-            {
-                mGridRight[i][j].reserve(nReserve);
-            }
-        }
-
-
+    // Cell of every keypoint, the right keypoints of a stereo fisheye pair go to their own grid
+    const int nLeft = (Nleft == -1) ? N : Nleft;
+    vector<int> vCells(N, -1);
     for (int i = 0; i < N; i++)
     {
         const cv::KeyPoint& kp = (Nleft == -1) ? mvKeysUn[i] : (i < Nleft) ? mvKeys[i] : mvKeysRight[i - Nleft];
 
         int nGridPosX, nGridPosY;
         if (PosInGrid(kp, nGridPosX, nGridPosY))
-        {
-            if (Nleft == -1 || i < Nleft)
-                mGrid[nGridPosX][nGridPosY].push_back(i);
-            else
-                mGridRight[nGridPosX][nGridPosY].push_back(i - Nleft);
-        }
+            vCells[i] = nGridPosX * FRAME_GRID_ROWS + nGridPosY;
+    }
+
+    if (Nleft == -1)
+    {
+        mGrid.Build(FRAME_GRID_COLS, FRAME_GRID_ROWS, vCells);
+    }
+    else
+    {
+        mGridRight.Build(FRAME_GRID_COLS, FRAME_GRID_ROWS, vector<int>(vCells.begin() + nLeft, vCells.end()));
+        vCells.resize(nLeft);
+        mGrid.Build(FRAME_GRID_COLS, FRAME_GRID_ROWS, vCells);
     }
 }
 
 void Frame::ExtractORB(int flag, const cv::Mat &im, const int x0, const int x1)
 {
     vector<int> vLapping = {x0,x1};
+    cv::Mat descriptors;
     if(flag==0)
-        monoLeft = (*mpORBextractorLeft)(im,cv::Mat(),mvKeys,mDescriptors,vLapping);
+    {
+        monoLeft = (*mpORBextractorLeft)(im,cv::Mat(),mvKeys,descriptors,vLapping);
+        mDescriptors.Assign(descriptors);
+    }
     else
-        monoRight = (*mpORBextractorRight)(im,cv::Mat(),mvKeysRight,mDescriptorsRight,vLapping);
+    {
+        monoRight = (*mpORBextractorRight)(im,cv::Mat(),mvKeysRight,descriptors,vLapping);
+        mDescriptorsRight.Assign(descriptors);
+    }
 }
 
 bool Frame::isSet() const {
@@ -750,7 +749,17 @@ Eigen::Vector3f Frame::inRefCoordinates(Eigen::Vector3f pCw)
 vector<size_t> Frame::GetFeaturesInArea(const float &x, const float  &y, const float  &r, const int minLevel, const int maxLevel, const bool bRight) const
 {
     vector<size_t> vIndices;
-    vIndices.reserve(N);
+    GetFeaturesInArea(x, y, r, minLevel, maxLevel, bRight, vIndices);
+    return vIndices;
+}
+
+void Frame::GetFeaturesInArea(const float &x, const float  &y, const float  &r, const int minLevel, const int maxLevel, const bool bRight, vector<size_t> &vIndices) const
+{
+    vIndices.clear();
+
+    const FeatureGrid &grid = (!bRight) ? mGrid : mGridRight;
+    if(grid.Empty())
+        return;
 
     float factorX = r;
     float factorY = r;
@@ -758,25 +767,25 @@ vector<size_t> Frame::GetFeaturesInArea(const float &x, const float  &y, const f
     const int nMinCellX = max(0,(int)floor((x-mnMinX-factorX)*mfGridElementWidthInv));
     if(nMinCellX>=FRAME_GRID_COLS)
     {
-        return vIndices;
+        return;
     }
 
     const int nMaxCellX = min((int)FRAME_GRID_COLS-1,(int)ceil((x-mnMinX+factorX)*mfGridElementWidthInv));
     if(nMaxCellX<0)
     {
-        return vIndices;
+        return;
     }
 
     const int nMinCellY = max(0,(int)floor((y-mnMinY-factorY)*mfGridElementHeightInv));
     if(nMinCellY>=FRAME_GRID_ROWS)
     {
-        return vIndices;
+        return;
     }
 
     const int nMaxCellY = min((int)FRAME_GRID_ROWS-1,(int)ceil((y-mnMinY+factorY)*mfGridElementHeightInv));
     if(nMaxCellY<0)
     {
-        return vIndices;
+        return;
     }
 
     const bool bCheckLevels = (minLevel>0) || (maxLevel>=0);
@@ -785,15 +794,12 @@ vector<size_t> Frame::GetFeaturesInArea(const float &x, const float  &y, const f
     {
         for(int iy = nMinCellY; iy<=nMaxCellY; iy++)
         {
-            const vector<size_t> vCell = (!bRight) ? mGrid[ix][iy] : mGridRight[ix][iy];
-            if(vCell.empty())
-                continue;
-
-            for(size_t j=0, jend=vCell.size(); j<jend; j++)
+            for(const uint32_t *pIdx = grid.CellBegin(ix,iy), *pEnd = grid.CellEnd(ix,iy); pIdx!=pEnd; pIdx++)
             {
-                const cv::KeyPoint &kpUn = (Nleft == -1) ? mvKeysUn[vCell[j]]
-                                                         : (!bRight) ? mvKeys[vCell[j]]
-                                                                     : mvKeysRight[vCell[j]];
+                const size_t idx = *pIdx;
+                const cv::KeyPoint &kpUn = (Nleft == -1) ? mvKeysUn[idx]
+                                                         : (!bRight) ? mvKeys[idx]
+                                                                     : mvKeysRight[idx];
                 if(bCheckLevels)
                 {
                     if(kpUn.octave<minLevel)
@@ -807,12 +813,10 @@ vector<size_t> Frame::GetFeaturesInArea(const float &x, const float  &y, const f
                 const float disty = kpUn.pt.y-y;
 
                 if(fabs(distx)<factorX && fabs(disty)<factorY)
-                    vIndices.push_back(vCell[j]);
+                    vIndices.push_back(idx);
             }
         }
     }
-
-    return vIndices;
 }
 
 bool Frame::PosInGrid(const cv::KeyPoint &kp, int &posX, int &posY)
@@ -828,12 +832,19 @@ bool Frame::PosInGrid(const cv::KeyPoint &kp, int &posX, int &posY)
 }
 
 
-void Frame::ComputeBoW()
+void Frame::ComputeBoW(WorkerPool* pPool)
 {
     if(mBowVec.empty())
     {
-        vector<cv::Mat> vCurrentDesc = Converter::toDescriptorVector(mDescriptors);
-        mpORBvocabulary->transform(vCurrentDesc,mBowVec,mFeatVec,4);
+        if(pPool)
+        {
+            mpORBvocabulary->transform(mDescriptors.Data(),mDescriptors.Size(),mBowVec,mFeatVec,4,
+                                       [pPool](int n, const std::function<void(int)>& f) { pPool->ParallelFor(n,f); });
+        }
+        else
+        {
+            mpORBvocabulary->transform(mDescriptors.Data(),mDescriptors.Size(),mBowVec,mFeatVec,4);
+        }
     }
 }
 
@@ -960,7 +971,7 @@ void Frame::ComputeStereoMatches()
         int bestDist = ORBmatcher::TH_HIGH;
         size_t bestIdxR = 0;
 
-        const cv::Mat &dL = mDescriptors.row(iL);
+        const unsigned char* dL = mDescriptors.Row(iL);
 
         // Compare descriptor to right keypoints
         for(size_t iC=0; iC<vCandidates.size(); iC++)
@@ -975,7 +986,7 @@ void Frame::ComputeStereoMatches()
 
             if(uR>=minU && uR<=maxU)
             {
-                const cv::Mat &dR = mDescriptorsRight.row(iR);
+                const unsigned char* dR = mDescriptorsRight.Row(iR);
                 const int dist = ORBmatcher::DescriptorDistance(dL,dR);
 
                 if(dist<bestDist)
@@ -1224,7 +1235,7 @@ Frame::Frame(const cv::Mat &imLeft,
     ComputeStereoFishEyeMatches();
 
     //Put all descriptors in the same matrix
-    cv::vconcat(mDescriptors,mDescriptorsRight,mDescriptors);
+    mDescriptors.Append(mDescriptorsRight);
 
     mvpMapPoints = vector<MapPoint*>(N,static_cast<MapPoint*>(nullptr));
     mvbOutlier = vector<bool>(N,false);
@@ -1240,8 +1251,8 @@ void Frame::ComputeStereoFishEyeMatches()
     vector<cv::KeyPoint> stereoLeft(mvKeys.begin() + monoLeft, mvKeys.end());
     vector<cv::KeyPoint> stereoRight(mvKeysRight.begin() + monoRight, mvKeysRight.end());
 
-    cv::Mat stereoDescLeft = mDescriptors.rowRange(monoLeft, mDescriptors.rows);
-    cv::Mat stereoDescRight = mDescriptorsRight.rowRange(monoRight, mDescriptorsRight.rows);
+    cv::Mat stereoDescLeft = mDescriptors.Mat().rowRange(monoLeft, mDescriptors.Size());
+    cv::Mat stereoDescRight = mDescriptorsRight.Mat().rowRange(monoRight, mDescriptorsRight.Size());
 
     mvLeftToRightMatch = vector<int>(Nleft,-1);
     mvRightToLeftMatch = vector<int>(Nright,-1);
@@ -21,8 +21,10 @@
 
 #include "frame/KeyFrameDatabase.h"
 #include "map/MapPoint.h"
+#include "map/Reclaimer.h"
 #include "utils/Converter.h"
 #include "utils/ImuTypes.h"
+#include "utils/WorkerPool.h"
 
 namespace ORB_SLAM3
 {
@@ -77,6 +79,7 @@ KeyFrame::KeyFrame()
     , mnMaxY(0)
     , mPrevKF(nullptr)
     , mNextKF(nullptr)
+    , mpKeyFrameDB(nullptr)
     , mbFirstConnection(true)
     , mpParent(nullptr)
     , mbNotErase(false)
@@ -90,7 +93,7 @@ KeyFrame::KeyFrame()
     , mnNumberOfOpt(0)
     , mbHasVelocity(false)
 {
-
+    Reclaimer::AddKeyFrame(sizeof(KeyFrame) + FeatureBytes());
 }
 
 KeyFrame::KeyFrame(Frame &F, Map *pMap, KeyFrameDatabase *pKFDB)
@@ -123,7 +126,7 @@ KeyFrame::KeyFrame(Frame &F, Map *pMap, KeyFrameDatabase *pKFDB)
     , mvKeysUn(F.mvKeysUn)
     , mvuRight(F.mvuRight)
     , mvDepth(F.mvDepth)
-    , mDescriptors(F.mDescriptors.clone())
+    , mDescriptors(F.mDescriptors)
     , mBowVec(F.mBowVec)
     , mFeatVec(F.mFeatVec)
     , mnScaleLevels(F.mnScaleLevels)
@@ -144,6 +147,7 @@ KeyFrame::KeyFrame(Frame &F, Map *pMap, KeyFrameDatabase *pKFDB)
     , mvpMapPoints(F.mvpMapPoints)
     , mpKeyFrameDB(pKFDB)
     , mpORBvocabulary(F.mpORBvocabulary)
+    , mGrid(F.mGrid)
     , mbFirstConnection(true)
     , mpParent(nullptr)
     , mDistCoef(F.mDistCoef)
@@ -167,25 +171,10 @@ KeyFrame::KeyFrame(Frame &F, Map *pMap, KeyFrameDatabase *pKFDB)
     , mTrl(F.GetRelativePoseTrl())
     , mnNumberOfOpt(0)
     , mbHasVelocity(false)
+    , mGridRight(F.mGridRight)
 {
     mnId=nNextId++;
 
-    mGrid.resize(mnGridCols);
-    if(F.Nleft != -1)  mGridRight.resize(mnGridCols);
-    for(int i=0; i<mnGridCols;i++)
-    {
-        mGrid[i].resize(mnGridRows);
-        if(F.Nleft != -1) mGridRight[i].resize(mnGridRows);
-        for(int j=0; j<mnGridRows; j++){
-            mGrid[i][j] = F.mGrid[i][j];
-            if(F.Nleft != -1){
-                mGridRight[i][j] = F.mGridRight[i][j];
-            }
-        }
-    }
-
-
-
     if(!F.HasVelocity()) {
         mVw.setZero();
         mbHasVelocity = false;
@@ -200,19 +189,72 @@ KeyFrame::KeyFrame(Frame &F, Map *pMap, KeyFrameDatabase *pKFDB)
     SetPose(F.GetPose());
 
     mnOriginMapId = pMap->GetId();
+
+    Reclaimer::AddKeyFrame(sizeof(KeyFrame) + FeatureBytes());
+}
+
+KeyFrame::~KeyFrame()
+{
+    Reclaimer::RemoveKeyFrame(sizeof(KeyFrame) + FeatureBytes());
 }
 
-void KeyFrame::ComputeBoW()
+void KeyFrame::ComputeBoW(WorkerPool* pPool)
 {
     if(mBowVec.empty() || mFeatVec.empty())
     {
-        vector<cv::Mat> vCurrentDesc = Converter::toDescriptorVector(mDescriptors);
+        const size_t nBytes = FeatureBytes();
+
         // Feature vector associate features with nodes in the 4th level (from leaves up)
         // We assume the vocabulary tree has 6 levels, change the 4 otherwise
-        mpORBvocabulary->transform(vCurrentDesc,mBowVec,mFeatVec,4);
+        if(pPool)
+        {
+            mpORBvocabulary->transform(mDescriptors.Data(),mDescriptors.Size(),mBowVec,mFeatVec,4,
+                                       [pPool](int n, const std::function<void(int)>& f) { pPool->ParallelFor(n,f); });
+        }
+        else
+        {
+            mpORBvocabulary->transform(mDescriptors.Data(),mDescriptors.Size(),mBowVec,mFeatVec,4);
+        }
+
+        Reclaimer::ResizeKeyFrame(static_cast<int64_t>(FeatureBytes()) - static_cast<int64_t>(nBytes));
     }
 }
 
+size_t KeyFrame::FeatureBytes() const
+{
+    // A node of the bag of words maps holds the value, the links to its parent and children and its colour
+    const size_t nNodeBytes = 4*sizeof(void*);
+
+    size_t nBytes = (mvKeys.capacity() + mvKeysUn.capacity() + mvKeysRight.capacity()) * sizeof(cv::KeyPoint)
+                  + (mvuRight.capacity() + mvDepth.capacity()) * sizeof(float)
+                  + (mvLeftToRightMatch.capacity() + mvRightToLeftMatch.capacity()) * sizeof(int)
+                  + mDescriptors.Bytes() + mGrid.Bytes() + mGridRight.Bytes()
+                  + mBowVec.size() * (sizeof(DBoW2::BowVector::value_type) + nNodeBytes);
+    for(DBoW2::FeatureVector::const_iterator it=mFeatVec.begin(); it!=mFeatVec.end(); it++)
+        nBytes += sizeof(DBoW2::FeatureVector::value_type) + nNodeBytes + it->second.capacity() * sizeof(unsigned int);
+    return nBytes;
+}
+
+size_t KeyFrame::ReleaseFeatures()
+{
+    const size_t nBytes = FeatureBytes();
+
+    std::vector<cv::KeyPoint>().swap(mvKeys);
+    std::vector<cv::KeyPoint>().swap(mvKeysUn);
+    std::vector<cv::KeyPoint>().swap(mvKeysRight);
+    std::vector<float>().swap(mvuRight);
+    std::vector<float>().swap(mvDepth);
+    std::vector<int>().swap(mvLeftToRightMatch);
+    std::vector<int>().swap(mvRightToLeftMatch);
+    mDescriptors = DescriptorArray();
+    mGrid = FeatureGrid();
+    mGridRight = FeatureGrid();
+    DBoW2::BowVector().swap(mBowVec);
+    DBoW2::FeatureVector().swap(mFeatVec);
+
+    return nBytes - FeatureBytes();
+}
+
 void KeyFrame::SetPose(const Sophus::SE3f &Tcw)
 {
     unique_lock<mutex> lock(mMutexPose);
@@ -295,14 +337,22 @@ bool KeyFrame::isVelocitySet()
 
 void KeyFrame::AddConnection(KeyFrame *pKF, const int &weight)
 {
+    // Bad key frames are left out of the ordered list, as in UpdateBestCovisibles()
+    const bool bBad = pKF->isBad();
     {
         unique_lock<mutex> lock(mMutexConnections);
-        if(!mConnectedKeyFrameWeights.count(pKF))
-            mConnectedKeyFrameWeights[pKF]=weight;
-        else if(mConnectedKeyFrameWeights[pKF]!=weight)
-            mConnectedKeyFrameWeights[pKF]=weight;
-        else
+        if(!mCovisibility.SetWeight(pKF,weight))
+            return;
+
+        // Once every edge is ordered the new weight only moves one entry
+        if(mCovisibility.IsOrderedComplete())
+        {
+            if(bBad)
+                mCovisibility.EraseOrdered(pKF);
+            else
+                mCovisibility.UpdateOrdered(pKF,weight);
             return;
+        }
     }
 
     UpdateBestCovisibles();
@@ -311,81 +361,52 @@ void KeyFrame::AddConnection(KeyFrame *pKF, const int &weight)
 void KeyFrame::UpdateBestCovisibles()
 {
     unique_lock<mutex> lock(mMutexConnections);
-    vector<pair<int,KeyFrame*> > vPairs;
-    vPairs.reserve(mConnectedKeyFrameWeights.size());
-    for(map<KeyFrame*,int>::iterator mit=mConnectedKeyFrameWeights.begin(), mend=mConnectedKeyFrameWeights.end(); mit!=mend; mit++)
-       vPairs.push_back(make_pair(mit->second,mit->first));
-
-    sort(vPairs.begin(),vPairs.end());
-    list<KeyFrame*> lKFs;
-    list<int> lWs;
-    for(size_t i=0, iend=vPairs.size(); i<iend;i++)
-    {
-        if(!vPairs[i].second->isBad())
-        {
-            lKFs.push_front(vPairs[i].second);
-            lWs.push_front(vPairs[i].first);
-        }
-    }
-
-    mvpOrderedConnectedKeyFrames = vector<KeyFrame*>(lKFs.begin(),lKFs.end());
-    mvOrderedWeights = vector<int>(lWs.begin(), lWs.end());
+    mCovisibility.RebuildOrdered([](KeyFrame* pKF) { return pKF->isBad(); });
 }
 
 set<KeyFrame*> KeyFrame::GetConnectedKeyFrames()
 {
     unique_lock<mutex> lock(mMutexConnections);
     set<KeyFrame*> s;
-    for(map<KeyFrame*,int>::iterator mit=mConnectedKeyFrameWeights.begin();mit!=mConnectedKeyFrameWeights.end();mit++)
-        s.insert(mit->first);
+    for(const CovisibilityEdges::Edge& edge : mCovisibility.GetEdges())
+        s.insert(s.end(),edge.pKF);
     return s;
 }
 
 vector<KeyFrame*> KeyFrame::GetVectorCovisibleKeyFrames()
 {
     unique_lock<mutex> lock(mMutexConnections);
-    return mvpOrderedConnectedKeyFrames;
+    return mCovisibility.GetOrdered()->vpKeyFrames;
 }
 
 vector<KeyFrame*> KeyFrame::GetBestCovisibilityKeyFrames(const int &N)
 {
     unique_lock<mutex> lock(mMutexConnections);
-    if((int)mvpOrderedConnectedKeyFrames.size()<N)
-        return mvpOrderedConnectedKeyFrames;
+    const vector<KeyFrame*>& vpOrdered = mCovisibility.GetOrdered()->vpKeyFrames;
+    if((int)vpOrdered.size()<N)
+        return vpOrdered;
     else
-        return vector<KeyFrame*>(mvpOrderedConnectedKeyFrames.begin(),mvpOrderedConnectedKeyFrames.begin()+N);
+        return vector<KeyFrame*>(vpOrdered.begin(),vpOrdered.begin()+N);
 
 }
 
 vector<KeyFrame*> KeyFrame::GetCovisiblesByWeight(const int &w)
 {
     unique_lock<mutex> lock(mMutexConnections);
+    const CovisibilityList& ordered = *mCovisibility.GetOrdered();
+    return vector<KeyFrame*>(ordered.vpKeyFrames.begin(), ordered.vpKeyFrames.begin()+ordered.CountByWeight(w));
+}
 
-    if(mvpOrderedConnectedKeyFrames.empty())
-    {
-        return vector<KeyFrame*>();
-    }
-
-    vector<int>::iterator it = upper_bound(mvOrderedWeights.begin(),mvOrderedWeights.end(),w,KeyFrame::weightComp);
-
-    if(it==mvOrderedWeights.end() && mvOrderedWeights.back() < w)
-    {
-        return vector<KeyFrame*>();
-    }
-    else
-    {
-        int n = it-mvOrderedWeights.begin();
-        return vector<KeyFrame*>(mvpOrderedConnectedKeyFrames.begin(), mvpOrderedConnectedKeyFrames.begin()+n);
-    }
+CovisibilityEdges::Snapshot KeyFrame::GetCovisibles()
+{
+    unique_lock<mutex> lock(mMutexConnections);
+    return mCovisibility.GetOrdered();
 }
 
 int KeyFrame::GetWeight(KeyFrame *pKF)
 {
     unique_lock<mutex> lock(mMutexConnections);
-    if(mConnectedKeyFrameWeights.count(pKF))
-        return mConnectedKeyFrameWeights[pKF];
-    else
-        return 0;
+    return mCovisibility.GetWeight(pKF);
 }
 
 int KeyFrame::GetNumberMPs()
@@ -483,42 +504,29 @@ MapPoint* KeyFrame::GetMapPoint(const size_t &idx)
     return mvpMapPoints[idx];
 }
 
-void KeyFrame::UpdateConnections(bool upParent)
+void KeyFrame::AddSharedMapPoints(KeyFrame* pKF, int n)
 {
-    map<KeyFrame*,int> KFcounter;
-
-    vector<MapPoint*> vpMP;
+    unique_lock<mutex> lock(mMutexConnections);
+    mCovisibility.AddShared(pKF,n);
+}
 
+void KeyFrame::UpdateConnections(bool upParent)
+{
+    // Map points shared with each key frame, kept up to date by the observations of the map points, sorted by
+    // address as the std::map counter visited them
+    vector<CovisibilityEdges::Edge> vEdges;
     {
-        unique_lock<mutex> lockMPs(mMutexFeatures);
-        vpMP = mvpMapPoints;
+        unique_lock<mutex> lockCon(mMutexConnections);
+        vEdges = mCovisibility.GetShared();
     }
 
-    //For all map points in keyframe check in which other keyframes are they seen
-    //Increase counter for those keyframes
-    for(vector<MapPoint*>::iterator vit=vpMP.begin(), vend=vpMP.end(); vit!=vend; vit++)
+    vEdges.erase(remove_if(vEdges.begin(),vEdges.end(),[this](const CovisibilityEdges::Edge& edge)
     {
-        MapPoint* pMP = *vit;
-
-        if(!pMP)
-            continue;
-
-        if(pMP->isBad())
-            continue;
-
-        map<KeyFrame*,tuple<int,int>> observations = pMP->GetObservations();
-
-        for(map<KeyFrame*,tuple<int,int>>::iterator mit=observations.begin(), mend=observations.end(); mit!=mend; mit++)
-        {
-            if(mit->first->mnId==mnId || mit->first->isBad() || mit->first->GetMap() != mpMap)
-                continue;
-            KFcounter[mit->first]++;
-
-        }
-    }
+        return edge.nWeight<=0 || edge.pKF==this || edge.pKF->isBad() || edge.pKF->GetMap() != mpMap;
+    }),vEdges.end());
 
     // This should not happen
-    if(KFcounter.empty())
+    if(vEdges.empty())
         return;
 
     //If the counter is greater than threshold add connection
@@ -527,52 +535,42 @@ void KeyFrame::UpdateConnections(bool upParent)
     KeyFrame* pKFmax=NULL;
     int th = 15;
 
-    vector<pair<int,KeyFrame*> > vPairs;
-    vPairs.reserve(KFcounter.size());
+    vector<CovisibilityEdges::Edge> vOrdered;
+    vOrdered.reserve(vEdges.size());
     if(!upParent)
         cout << "UPDATE_CONN: current KF " << mnId << endl;
-    for(map<KeyFrame*,int>::iterator mit=KFcounter.begin(), mend=KFcounter.end(); mit!=mend; mit++)
+    for(const CovisibilityEdges::Edge& edge : vEdges)
     {
         if(!upParent)
-            cout << "  UPDATE_CONN: KF " << mit->first->mnId << " ; num matches: " << mit->second << endl;
-        if(mit->second>nmax)
+            cout << "  UPDATE_CONN: KF " << edge.pKF->mnId << " ; num matches: " << edge.nWeight << endl;
+        if(edge.nWeight>nmax)
         {
-            nmax=mit->second;
-            pKFmax=mit->first;
+            nmax=edge.nWeight;
+            pKFmax=edge.pKF;
         }
-        if(mit->second>=th)
+        if(edge.nWeight>=th)
         {
-            vPairs.push_back(make_pair(mit->second,mit->first));
-            (mit->first)->AddConnection(this,mit->second);
+            vOrdered.push_back(edge);
+            edge.pKF->AddConnection(this,edge.nWeight);
         }
     }
 
-    if(vPairs.empty())
+    if(vOrdered.empty())
     {
-        vPairs.push_back(make_pair(nmax,pKFmax));
+        vOrdered.push_back(CovisibilityEdges::Edge{pKFmax,nmax});
         pKFmax->AddConnection(this,nmax);
     }
 
-    sort(vPairs.begin(),vPairs.end());
-    list<KeyFrame*> lKFs;
-    list<int> lWs;
-    for(size_t i=0; i<vPairs.size();i++)
-    {
-        lKFs.push_front(vPairs[i].second);
-        lWs.push_front(vPairs[i].first);
-    }
+    CovisibilityEdges::SortOrdered(vOrdered);
 
     {
         unique_lock<mutex> lockCon(mMutexConnections);
 
-        mConnectedKeyFrameWeights = KFcounter;
-        mvpOrderedConnectedKeyFrames = vector<KeyFrame*>(lKFs.begin(),lKFs.end());
-        mvOrderedWeights = vector<int>(lWs.begin(), lWs.end());
-
+        mCovisibility.Assign(vEdges,vOrdered);
 
         if(mbFirstConnection && mnId!=mpMap->GetInitKFid())
         {
-            mpParent = mvpOrderedConnectedKeyFrames.front();
+            mpParent = vOrdered.front().pKF;
             mpParent->AddChild(this);
             mbFirstConnection = false;
         }
@@ -677,8 +675,15 @@ void KeyFrame::SetErase()
     }
 }
 
+bool KeyFrame::isToBeErased()
+{
+    unique_lock<mutex> lock(mMutexConnections);
+    return mbToBeErased;
+}
+
 void KeyFrame::SetBadFlag()
 {
+    bool bRetire = false;
     {
         unique_lock<mutex> lock(mMutexConnections);
         if(mnId==mpMap->GetInitKFid())
@@ -692,9 +697,14 @@ void KeyFrame::SetBadFlag()
         }
     }
 
-    for(map<KeyFrame*,int>::iterator mit = mConnectedKeyFrameWeights.begin(), mend=mConnectedKeyFrameWeights.end(); mit!=mend; mit++)
+    vector<CovisibilityEdges::Edge> vEdges;
+    {
+        unique_lock<mutex> lock(mMutexConnections);
+        vEdges = mCovisibility.GetEdges();
+    }
+    for(const CovisibilityEdges::Edge& edge : vEdges)
     {
-        mit->first->EraseConnection(this);
+        edge.pKF->EraseConnection(this);
     }
 
     for(size_t i=0; i<mvpMapPoints.size(); i++)
@@ -709,8 +719,8 @@ void KeyFrame::SetBadFlag()
         unique_lock<mutex> lock(mMutexConnections);
         unique_lock<mutex> lock1(mMutexFeatures);
 
-        mConnectedKeyFrameWeights.clear();
-        mvpOrderedConnectedKeyFrames.clear();
+        mCovisibility.Clear();
+        mCovisibility.ClearShared();
 
         // Update Spanning Tree
         set<KeyFrame*> sParentCandidates;
@@ -777,12 +787,16 @@ void KeyFrame::SetBadFlag()
             mpParent->EraseChild(this);
             mTcp = mTcw * mpParent->GetPoseInverse();
         }
+        bRetire = !mbBad;
         mbBad = true;
     }
 
 
     mpMap->EraseKeyFrame(this);
     mpKeyFrameDB->erase(this);
+
+    if(bRetire)
+        Reclaimer::Retire(this);
 }
 
 bool KeyFrame::isBad()
@@ -796,10 +810,13 @@ void KeyFrame::EraseConnection(KeyFrame* pKF)
     bool bUpdate = false;
     {
         unique_lock<mutex> lock(mMutexConnections);
-        if(mConnectedKeyFrameWeights.count(pKF))
+        if(mCovisibility.EraseWeight(pKF))
         {
-            mConnectedKeyFrameWeights.erase(pKF);
-            bUpdate=true;
+            // A complete order only loses the entry
+            if(mCovisibility.IsOrderedComplete())
+                mCovisibility.EraseOrdered(pKF);
+            else
+                bUpdate=true;
         }
     }
 
@@ -811,47 +828,55 @@ void KeyFrame::EraseConnection(KeyFrame* pKF)
 vector<size_t> KeyFrame::GetFeaturesInArea(const float &x, const float &y, const float &r, const bool bRight) const
 {
     vector<size_t> vIndices;
-    vIndices.reserve(N);
+    GetFeaturesInArea(x, y, r, bRight, vIndices);
+    return vIndices;
+}
+
+void KeyFrame::GetFeaturesInArea(const float &x, const float &y, const float &r, const bool bRight, vector<size_t> &vIndices) const
+{
+    vIndices.clear();
+
+    const FeatureGrid &grid = (!bRight) ? mGrid : mGridRight;
+    if(grid.Empty())
+        return;
 
     float factorX = r;
     float factorY = r;
 
     const int nMinCellX = max(0,(int)floor((x-mnMinX-factorX)*mfGridElementWidthInv));
     if(nMinCellX>=mnGridCols)
-        return vIndices;
+        return;
 
     const int nMaxCellX = min((int)mnGridCols-1,(int)ceil((x-mnMinX+factorX)*mfGridElementWidthInv));
     if(nMaxCellX<0)
-        return vIndices;
+        return;
 
     const int nMinCellY = max(0,(int)floor((y-mnMinY-factorY)*mfGridElementHeightInv));
     if(nMinCellY>=mnGridRows)
-        return vIndices;
+        return;
 
     const int nMaxCellY = min((int)mnGridRows-1,(int)ceil((y-mnMinY+factorY)*mfGridElementHeightInv));
     if(nMaxCellY<0)
-        return vIndices;
+        return;
 
     for(int ix = nMinCellX; ix<=nMaxCellX; ix++)
     {
         for(int iy = nMinCellY; iy<=nMaxCellY; iy++)
         {
-            const vector<size_t> vCell = (!bRight) ? mGrid[ix][iy] : mGridRight[ix][iy];
-            for(size_t j=0, jend=vCell.size(); j<jend; j++)
+            for(const uint32_t *pIdx = grid.CellBegin(ix,iy), *pEnd = grid.CellEnd(ix,iy); pIdx!=pEnd; pIdx++)
             {
-                const cv::KeyPoint &kpUn = (NLeft == -1) ? mvKeysUn[vCell[j]]
-                                                         : (!bRight) ? mvKeys[vCell[j]]
-                                                                     : mvKeysRight[vCell[j]];
+                const size_t idx = *pIdx;
+                const cv::KeyPoint &kpUn = (NLeft == -1) ? mvKeysUn[idx]
+                                                         : (!bRight) ? mvKeys[idx]
+                                                                     : mvKeysRight[idx];
                 const float distx = kpUn.pt.x-x;
                 const float disty = kpUn.pt.y-y;
 
                 if(fabs(distx)<r && fabs(disty)<r)
-                    vIndices.push_back(vCell[j]);
+                    vIndices.push_back(idx);
             }
         }
     }
-
-    return vIndices;
 }
 
 bool KeyFrame::IsInImage(const float &x, const float &y) const
@@ -947,8 +972,14 @@ Map* KeyFrame::GetMap()
 
 void KeyFrame::UpdateMap(Map* pMap)
 {
-    unique_lock<mutex> lock(mMutexMap);
-    mpMap = pMap;
+    {
+        unique_lock<mutex> lock(mMutexMap);
+        mpMap = pMap;
+    }
+
+    // The database indexes the key frames by map
+    if(mpKeyFrameDB)
+        mpKeyFrameDB->UpdateMap(this, pMap);
 }
 
 void KeyFrame::PreSave(set<KeyFrame*>& spKF,set<MapPoint*>& spMP, set<GeometricCamera*>& spCam)
@@ -966,10 +997,10 @@ void KeyFrame::PreSave(set<KeyFrame*>& spKF,set<MapPoint*>& spMP, set<GeometricC
     }
     // Save the id of each connected KF with it weight
     mBackupConnectedKeyFrameIdWeights.clear();
-    for(std::map<KeyFrame*,int>::const_iterator it = mConnectedKeyFrameWeights.begin(), end = mConnectedKeyFrameWeights.end(); it != end; ++it)
+    for(const CovisibilityEdges::Edge& edge : mCovisibility.GetEdges())
     {
-        if(spKF.find(it->first) != spKF.end())
-            mBackupConnectedKeyFrameIdWeights[it->first->mnId] = it->second;
+        if(spKF.find(edge.pKF) != spKF.end())
+            mBackupConnectedKeyFrameIdWeights[edge.pKF->mnId] = edge.nWeight;
     }
 
     // Save the parent id
@@ -1047,12 +1078,12 @@ void KeyFrame::PostLoad(map<long unsigned int, KeyFrame*>& mpKFid, map<long unsi
     }
 
     // Conected KeyFrames with him weight
-    mConnectedKeyFrameWeights.clear();
+    mCovisibility.Clear();
     for(map<long unsigned int, int>::const_iterator it = mBackupConnectedKeyFrameIdWeights.begin(), end = mBackupConnectedKeyFrameIdWeights.end();
         it != end; ++it)
     {
         KeyFrame* pKFi = mpKFid[it->first];
-        mConnectedKeyFrameWeights[pKFi] = it->second;
+        mCovisibility.SetWeight(pKFi,it->second);
     }
 
     // Restore parent KeyFrame
@@ -18,6 +18,7 @@
 
 
 #include "frame/KeyFrameDatabase.h"
+#include <algorithm>
 #include <mutex>
 
 #include <DBoW2/BowVector.h>
@@ -32,115 +33,196 @@ namespace ORB_SLAM3
 KeyFrameDatabase::KeyFrameDatabase (const ORBVocabulary &voc):
     mpVoc(&voc)
 {
-    mvInvertedFile.resize(voc.size());
 }
 
 
 void KeyFrameDatabase::add(KeyFrame *pKF)
 {
-    unique_lock<mutex> lock(mMutex);
+    unique_lock<mutex> lockWrite(mMutexWrite);
+
+    if(mmKeyFrameIds.count(pKF))
+        return;
+
+    const unsigned int nId = mIndex.Add(GetPartition(pKF->GetMap()), pKF->mBowVec);
+    mmKeyFrameIds[pKF] = nId;
 
-    for(DBoW2::BowVector::const_iterator vit= pKF->mBowVec.begin(), vend=pKF->mBowVec.end(); vit!=vend; vit++)
-        mvInvertedFile[vit->first].push_back(pKF);
+    unique_lock<mutex> lock(mMutex);
+    if(nId >= mvpKeyFrames.size())
+        mvpKeyFrames.resize(nId+1, static_cast<KeyFrame*>(NULL));
+    mvpKeyFrames[nId] = pKF;
 }
 
 void KeyFrameDatabase::erase(KeyFrame* pKF)
 {
-    unique_lock<mutex> lock(mMutex);
+    unique_lock<mutex> lockWrite(mMutexWrite);
 
-    // Erase elements in the Inverse File for the entry
-    for(DBoW2::BowVector::const_iterator vit=pKF->mBowVec.begin(), vend=pKF->mBowVec.end(); vit!=vend; vit++)
-    {
-        // List of keyframes that share the word
-        list<KeyFrame*> &lKFs =   mvInvertedFile[vit->first];
+    // The postings of the key frame are left in the inverted file until it is compacted
+    unordered_map<KeyFrame*, unsigned int>::iterator it = mmKeyFrameIds.find(pKF);
+    if(it == mmKeyFrameIds.end())
+        return;
 
-        for(list<KeyFrame*>::iterator lit=lKFs.begin(), lend= lKFs.end(); lit!=lend; lit++)
-        {
-            if(pKF==*lit)
-            {
-                lKFs.erase(lit);
-                break;
-            }
-        }
+    {
+        unique_lock<mutex> lock(mMutex);
+        mvpKeyFrames[it->second] = static_cast<KeyFrame*>(NULL);
     }
+    mIndex.Erase(it->second);
+    mmKeyFrameIds.erase(it);
 }
 
 void KeyFrameDatabase::clear()
 {
-    mvInvertedFile.clear();
-    mvInvertedFile.resize(mpVoc->size());
+    unique_lock<mutex> lockWrite(mMutexWrite);
+
+    mIndex.Clear();
+    mmKeyFrameIds.clear();
+
+    unique_lock<mutex> lock(mMutex);
+    mvpPartitionMaps.clear();
+    mvpKeyFrames.clear();
 }
 
 void KeyFrameDatabase::clearMap(Map* pMap)
 {
-    unique_lock<mutex> lock(mMutex);
+    unique_lock<mutex> lockWrite(mMutexWrite);
 
-    // Erase elements in the Inverse File for the entry
-    for(std::vector<list<KeyFrame*> >::iterator vit=mvInvertedFile.begin(), vend=mvInvertedFile.end(); vit!=vend; vit++)
-    {
-        // List of keyframes that share the word
-        list<KeyFrame*> &lKFs =  *vit;
+    const int nPartition = FindPartition(pMap);
+    if(nPartition < 0)
+        return;
 
-        for(list<KeyFrame*>::iterator lit=lKFs.begin(), lend= lKFs.end(); lit!=lend;)
+    // Dont delete the KFs because the class Map clean all the KF when it is destroyed
+    {
+        unique_lock<mutex> lock(mMutex);
+        for(unordered_map<KeyFrame*, unsigned int>::iterator it=mmKeyFrameIds.begin(); it!=mmKeyFrameIds.end();)
         {
-            KeyFrame* pKFi = *lit;
-            if(pMap == pKFi->GetMap())
+            if(mIndex.GetPartition(it->second) == nPartition)
             {
-                lit = lKFs.erase(lit);
-                // Dont delete the KF because the class Map clean all the KF when it is destroyed
+                mvpKeyFrames[it->second] = static_cast<KeyFrame*>(NULL);
+                it = mmKeyFrameIds.erase(it);
             }
             else
             {
-                ++lit;
+                ++it;
             }
         }
     }
+    mIndex.ErasePartition(nPartition);
+}
+
+void KeyFrameDatabase::UpdateMap(KeyFrame* pKF, Map* pMap)
+{
+    unique_lock<mutex> lockWrite(mMutexWrite);
+
+    unordered_map<KeyFrame*, unsigned int>::iterator it = mmKeyFrameIds.find(pKF);
+    if(it == mmKeyFrameIds.end() || mvpPartitionMaps[mIndex.GetPartition(it->second)] == pMap)
+        return;
+
+    {
+        unique_lock<mutex> lock(mMutex);
+        mvpKeyFrames[it->second] = static_cast<KeyFrame*>(NULL);
+    }
+    mIndex.Erase(it->second);
+
+    const unsigned int nId = mIndex.Add(GetPartition(pMap), pKF->mBowVec);
+    it->second = nId;
+
+    unique_lock<mutex> lock(mMutex);
+    if(nId >= mvpKeyFrames.size())
+        mvpKeyFrames.resize(nId+1, static_cast<KeyFrame*>(NULL));
+    mvpKeyFrames[nId] = pKF;
+}
+
+int KeyFrameDatabase::FindPartition(Map* pMap) const
+{
+    for(size_t i=0; i<mvpPartitionMaps.size(); i++)
+    {
+        if(mvpPartitionMaps[i] == pMap)
+            return i;
+    }
+    return -1;
+}
+
+int KeyFrameDatabase::GetPartition(Map* pMap)
+{
+    int nPartition = FindPartition(pMap);
+    if(nPartition < 0)
+    {
+        unique_lock<mutex> lock(mMutex);
+        nPartition = mvpPartitionMaps.size();
+        mvpPartitionMaps.push_back(pMap);
+    }
+    return nPartition;
+}
+
+void KeyFrameDatabase::SearchSharedWords(const DBoW2::BowVector &bowVec, Map* pMap, vector<KeyFrame*> &vpKFs,
+                                         vector<int> &vnWords)
+{
+    vpKFs.clear();
+    vnWords.clear();
+
+    // The ids found stay the ones of the same key frames until the section is closed
+    BowInvertedIndex::ReadSection read(mIndex);
+
+    int nPartition = -1;
+    if(pMap)
+    {
+        unique_lock<mutex> lock(mMutex);
+        nPartition = FindPartition(pMap);
+        if(nPartition < 0)
+            return;
+    }
+
+    vector<unsigned int> vnIds;
+    vector<int> vnIdWords;
+    mIndex.Search(bowVec, nPartition, vnIds, vnIdWords);
+
+    // Key frames being added are left out until they are in mvpKeyFrames
+    unique_lock<mutex> lock(mMutex);
+    vpKFs.reserve(vnIds.size());
+    vnWords.reserve(vnIds.size());
+    for(size_t i=0; i<vnIds.size(); i++)
+    {
+        KeyFrame* pKFi = vnIds[i] < mvpKeyFrames.size() ? mvpKeyFrames[vnIds[i]] : static_cast<KeyFrame*>(NULL);
+        if(pKFi)
+        {
+            vpKFs.push_back(pKFi);
+            vnWords.push_back(vnIdWords[i]);
+        }
+    }
 }
 
 vector<KeyFrame*> KeyFrameDatabase::DetectLoopCandidates(KeyFrame* pKF, float minScore)
 {
     set<KeyFrame*> spConnectedKeyFrames = pKF->GetConnectedKeyFrames();
-    list<KeyFrame*> lKFsSharingWords;
+    vector<KeyFrame*> vpKFsSharingWords;
 
     // Search all keyframes that share a word with current keyframes
     // Discard keyframes connected to the query keyframe
     {
-        unique_lock<mutex> lock(mMutex);
+        // For consider a loop candidate it a candidate it must be in the same map
+        vector<KeyFrame*> vpKFs;
+        vector<int> vnWords;
+        SearchSharedWords(pKF->mBowVec, pKF->GetMap(), vpKFs, vnWords);
 
-        for(DBoW2::BowVector::const_iterator vit=pKF->mBowVec.begin(), vend=pKF->mBowVec.end(); vit != vend; vit++)
+        for(size_t i=0; i<vpKFs.size(); i++)
         {
-            list<KeyFrame*> &lKFs =   mvInvertedFile[vit->first];
-
-            for(list<KeyFrame*>::iterator lit=lKFs.begin(), lend= lKFs.end(); lit!=lend; lit++)
+            KeyFrame* pKFi = vpKFs[i];
+            if(!spConnectedKeyFrames.count(pKFi))
             {
-                KeyFrame* pKFi=*lit;
-                if(pKFi->GetMap()==pKF->GetMap()) // For consider a loop candidate it a candidate it must be in the same map
-                {
-                    if(pKFi->mnLoopQuery!=pKF->mnId)
-                    {
-                        pKFi->mnLoopWords=0;
-                        if(!spConnectedKeyFrames.count(pKFi))
-                        {
-                            pKFi->mnLoopQuery=pKF->mnId;
-                            lKFsSharingWords.push_back(pKFi);
-                        }
-                    }
-                    pKFi->mnLoopWords++;
-                }
-
-
+                pKFi->mnLoopQuery=pKF->mnId;
+                pKFi->mnLoopWords=vnWords[i];
+                vpKFsSharingWords.push_back(pKFi);
             }
         }
     }
 
-    if(lKFsSharingWords.empty())
+    if(vpKFsSharingWords.empty())
         return vector<KeyFrame*>();
 
-    list<pair<float,KeyFrame*> > lScoreAndMatch;
+    vector<pair<float,KeyFrame*> > vScoreAndMatch;
 
     // Only compare against those keyframes that share enough words
     int maxCommonWords=0;
-    for(list<KeyFrame*>::iterator lit=lKFsSharingWords.begin(), lend= lKFsSharingWords.end(); lit!=lend; lit++)
+    for(vector<KeyFrame*>::iterator lit=vpKFsSharingWords.begin(), lend= vpKFsSharingWords.end(); lit!=lend; lit++)
     {
         if((*lit)->mnLoopWords>maxCommonWords)
             maxCommonWords=(*lit)->mnLoopWords;
@@ -151,7 +233,7 @@ vector<KeyFrame*> KeyFrameDatabase::DetectLoopCandidates(KeyFrame* pKF, float mi
     int nscores=0;
 
     // Compute similarity score. Retain the matches whose score is higher than minScore
-    for(list<KeyFrame*>::iterator lit=lKFsSharingWords.begin(), lend= lKFsSharingWords.end(); lit!=lend; lit++)
+    for(vector<KeyFrame*>::iterator lit=vpKFsSharingWords.begin(), lend= vpKFsSharingWords.end(); lit!=lend; lit++)
     {
         KeyFrame* pKFi = *lit;
 
@@ -163,28 +245,28 @@ vector<KeyFrame*> KeyFrameDatabase::DetectLoopCandidates(KeyFrame* pKF, float mi
 
             pKFi->mLoopScore = si;
             if(si>=minScore)
-                lScoreAndMatch.push_back(make_pair(si,pKFi));
+                vScoreAndMatch.push_back(make_pair(si,pKFi));
         }
     }
 
-    if(lScoreAndMatch.empty())
+    if(vScoreAndMatch.empty())
         return vector<KeyFrame*>();
 
-    list<pair<float,KeyFrame*> > lAccScoreAndMatch;
+    vector<pair<float,KeyFrame*> > vAccScoreAndMatch;
     float bestAccScore = minScore;
 
     // Lets now accumulate score by covisibility
-    for(list<pair<float,KeyFrame*> >::iterator it=lScoreAndMatch.begin(), itend=lScoreAndMatch.end(); it!=itend; it++)
+    for(vector<pair<float,KeyFrame*> >::iterator it=vScoreAndMatch.begin(), itend=vScoreAndMatch.end(); it!=itend; it++)
     {
         KeyFrame* pKFi = it->second;
-        vector<KeyFrame*> vpNeighs = pKFi->GetBestCovisibilityKeyFrames(10);
+        const CovisibilityEdges::Snapshot pNeighs = pKFi->GetCovisibles();
 
         float bestScore = it->first;
         float accScore = it->first;
         KeyFrame* pBestKF = pKFi;
-        for(vector<KeyFrame*>::iterator vit=vpNeighs.begin(), vend=vpNeighs.end(); vit!=vend; vit++)
+        for(size_t iN=0, iNend=pNeighs->CountBest(10); iN<iNend; iN++)
         {
-            KeyFrame* pKF2 = *vit;
+            KeyFrame* pKF2 = pNeighs->vpKeyFrames[iN];
             if(pKF2->mnLoopQuery==pKF->mnId && pKF2->mnLoopWords>minCommonWords)
             {
                 accScore+=pKF2->mLoopScore;
@@ -196,7 +278,7 @@ vector<KeyFrame*> KeyFrameDatabase::DetectLoopCandidates(KeyFrame* pKF, float mi
             }
         }
 
-        lAccScoreAndMatch.push_back(make_pair(accScore,pBestKF));
+        vAccScoreAndMatch.push_back(make_pair(accScore,pBestKF));
         if(accScore>bestAccScore)
             bestAccScore=accScore;
     }
@@ -206,9 +288,9 @@ vector<KeyFrame*> KeyFrameDatabase::DetectLoopCandidates(KeyFrame* pKF, float mi
 
     set<KeyFrame*> spAlreadyAddedKF;
     vector<KeyFrame*> vpLoopCandidates;
-    vpLoopCandidates.reserve(lAccScoreAndMatch.size());
+    vpLoopCandidates.reserve(vAccScoreAndMatch.size());
 
-    for(list<pair<float,KeyFrame*> >::iterator it=lAccScoreAndMatch.begin(), itend=lAccScoreAndMatch.end(); it!=itend; it++)
+    for(vector<pair<float,KeyFrame*> >::iterator it=vAccScoreAndMatch.begin(), itend=vAccScoreAndMatch.end(); it!=itend; it++)
     {
         if(it->first>minScoreToRetain)
         {
@@ -228,60 +310,49 @@ vector<KeyFrame*> KeyFrameDatabase::DetectLoopCandidates(KeyFrame* pKF, float mi
 void KeyFrameDatabase::DetectCandidates(KeyFrame* pKF, float minScore,vector<KeyFrame*>& vpLoopCand, vector<KeyFrame*>& vpMergeCand)
 {
     set<KeyFrame*> spConnectedKeyFrames = pKF->GetConnectedKeyFrames();
-    list<KeyFrame*> lKFsSharingWordsLoop,lKFsSharingWordsMerge;
+    vector<KeyFrame*> vpKFsSharingWordsLoop,vpKFsSharingWordsMerge;
+    vector<KeyFrame*> vpKFsSharingWords;
 
     // Search all keyframes that share a word with current keyframes
     // Discard keyframes connected to the query keyframe
     {
-        unique_lock<mutex> lock(mMutex);
+        vector<int> vnWords;
+        SearchSharedWords(pKF->mBowVec, NULL, vpKFsSharingWords, vnWords);
 
-        for(DBoW2::BowVector::const_iterator vit=pKF->mBowVec.begin(), vend=pKF->mBowVec.end(); vit != vend; vit++)
+        for(size_t i=0; i<vpKFsSharingWords.size(); i++)
         {
-            list<KeyFrame*> &lKFs = mvInvertedFile[vit->first];
-
-            for(list<KeyFrame*>::iterator lit=lKFs.begin(), lend= lKFs.end(); lit!=lend; lit++)
+            KeyFrame* pKFi = vpKFsSharingWords[i];
+            if(pKFi->GetMap()==pKF->GetMap()) // For consider a loop candidate it a candidate it must be in the same map
             {
-                KeyFrame* pKFi=*lit;
-                if(pKFi->GetMap()==pKF->GetMap()) // For consider a loop candidate it a candidate it must be in the same map
+                if(!spConnectedKeyFrames.count(pKFi))
                 {
-                    if(pKFi->mnLoopQuery!=pKF->mnId)
-                    {
-                        pKFi->mnLoopWords=0;
-                        if(!spConnectedKeyFrames.count(pKFi))
-                        {
-                            pKFi->mnLoopQuery=pKF->mnId;
-                            lKFsSharingWordsLoop.push_back(pKFi);
-                        }
-                    }
-                    pKFi->mnLoopWords++;
+                    pKFi->mnLoopQuery=pKF->mnId;
+                    pKFi->mnLoopWords=vnWords[i];
+                    vpKFsSharingWordsLoop.push_back(pKFi);
                 }
-                else if(!pKFi->GetMap()->IsBad())
+            }
+            else if(!pKFi->GetMap()->IsBad())
+            {
+                if(!spConnectedKeyFrames.count(pKFi))
                 {
-                    if(pKFi->mnMergeQuery!=pKF->mnId)
-                    {
-                        pKFi->mnMergeWords=0;
-                        if(!spConnectedKeyFrames.count(pKFi))
-                        {
-                            pKFi->mnMergeQuery=pKF->mnId;
-                            lKFsSharingWordsMerge.push_back(pKFi);
-                        }
-                    }
-                    pKFi->mnMergeWords++;
+                    pKFi->mnMergeQuery=pKF->mnId;
+                    pKFi->mnMergeWords=vnWords[i];
+                    vpKFsSharingWordsMerge.push_back(pKFi);
                 }
             }
         }
     }
 
-    if(lKFsSharingWordsLoop.empty() && lKFsSharingWordsMerge.empty())
+    if(vpKFsSharingWordsLoop.empty() && vpKFsSharingWordsMerge.empty())
         return;
 
-    if(!lKFsSharingWordsLoop.empty())
+    if(!vpKFsSharingWordsLoop.empty())
     {
-        list<pair<float,KeyFrame*> > lScoreAndMatch;
+        vector<pair<float,KeyFrame*> > vScoreAndMatch;
 
         // Only compare against those keyframes that share enough words
         int maxCommonWords=0;
-        for(list<KeyFrame*>::iterator lit=lKFsSharingWordsLoop.begin(), lend= lKFsSharingWordsLoop.end(); lit!=lend; lit++)
+        for(vector<KeyFrame*>::iterator lit=vpKFsSharingWordsLoop.begin(), lend= vpKFsSharingWordsLoop.end(); lit!=lend; lit++)
         {
             if((*lit)->mnLoopWords>maxCommonWords)
                 maxCommonWords=(*lit)->mnLoopWords;
@@ -292,7 +363,7 @@ void KeyFrameDatabase::DetectCandidates(KeyFrame* pKF, float minScore,vector<Key
         int nscores=0;
 
         // Compute similarity score. Retain the matches whose score is higher than minScore
-        for(list<KeyFrame*>::iterator lit=lKFsSharingWordsLoop.begin(), lend= lKFsSharingWordsLoop.end(); lit!=lend; lit++)
+        for(vector<KeyFrame*>::iterator lit=vpKFsSharingWordsLoop.begin(), lend= vpKFsSharingWordsLoop.end(); lit!=lend; lit++)
         {
             KeyFrame* pKFi = *lit;
 
@@ -304,27 +375,27 @@ void KeyFrameDatabase::DetectCandidates(KeyFrame* pKF, float minScore,vector<Key
 
                 pKFi->mLoopScore = si;
                 if(si>=minScore)
-                    lScoreAndMatch.push_back(make_pair(si,pKFi));
+                    vScoreAndMatch.push_back(make_pair(si,pKFi));
             }
         }
 
-        if(!lScoreAndMatch.empty())
+        if(!vScoreAndMatch.empty())
         {
-            list<pair<float,KeyFrame*> > lAccScoreAndMatch;
+            vector<pair<float,KeyFrame*> > vAccScoreAndMatch;
             float bestAccScore = minScore;
 
             // Lets now accumulate score by covisibility
-            for(list<pair<float,KeyFrame*> >::iterator it=lScoreAndMatch.begin(), itend=lScoreAndMatch.end(); it!=itend; it++)
+            for(vector<pair<float,KeyFrame*> >::iterator it=vScoreAndMatch.begin(), itend=vScoreAndMatch.end(); it!=itend; it++)
             {
                 KeyFrame* pKFi = it->second;
-                vector<KeyFrame*> vpNeighs = pKFi->GetBestCovisibilityKeyFrames(10);
+                const CovisibilityEdges::Snapshot pNeighs = pKFi->GetCovisibles();
 
                 float bestScore = it->first;
                 float accScore = it->first;
                 KeyFrame* pBestKF = pKFi;
-                for(vector<KeyFrame*>::iterator vit=vpNeighs.begin(), vend=vpNeighs.end(); vit!=vend; vit++)
+                for(size_t iN=0, iNend=pNeighs->CountBest(10); iN<iNend; iN++)
                 {
-                    KeyFrame* pKF2 = *vit;
+                    KeyFrame* pKF2 = pNeighs->vpKeyFrames[iN];
                     if(pKF2->mnLoopQuery==pKF->mnId && pKF2->mnLoopWords>minCommonWords)
                     {
                         accScore+=pKF2->mLoopScore;
@@ -336,7 +407,7 @@ void KeyFrameDatabase::DetectCandidates(KeyFrame* pKF, float minScore,vector<Key
                     }
                 }
 
-                lAccScoreAndMatch.push_back(make_pair(accScore,pBestKF));
+                vAccScoreAndMatch.push_back(make_pair(accScore,pBestKF));
                 if(accScore>bestAccScore)
                     bestAccScore=accScore;
             }
@@ -345,9 +416,9 @@ void KeyFrameDatabase::DetectCandidates(KeyFrame* pKF, float minScore,vector<Key
             float minScoreToRetain = 0.75f*bestAccScore;
 
             set<KeyFrame*> spAlreadyAddedKF;
-            vpLoopCand.reserve(lAccScoreAndMatch.size());
+            vpLoopCand.reserve(vAccScoreAndMatch.size());
 
-            for(list<pair<float,KeyFrame*> >::iterator it=lAccScoreAndMatch.begin(), itend=lAccScoreAndMatch.end(); it!=itend; it++)
+            for(vector<pair<float,KeyFrame*> >::iterator it=vAccScoreAndMatch.begin(), itend=vAccScoreAndMatch.end(); it!=itend; it++)
             {
                 if(it->first>minScoreToRetain)
                 {
@@ -363,13 +434,13 @@ void KeyFrameDatabase::DetectCandidates(KeyFrame* pKF, float minScore,vector<Key
 
     }
 
-    if(!lKFsSharingWordsMerge.empty())
+    if(!vpKFsSharingWordsMerge.empty())
     {
-        list<pair<float,KeyFrame*> > lScoreAndMatch;
+        vector<pair<float,KeyFrame*> > vScoreAndMatch;
 
         // Only compare against those keyframes that share enough words
         int maxCommonWords=0;
-        for(list<KeyFrame*>::iterator lit=lKFsSharingWordsMerge.begin(), lend=lKFsSharingWordsMerge.end(); lit!=lend; lit++)
+        for(vector<KeyFrame*>::iterator lit=vpKFsSharingWordsMerge.begin(), lend=vpKFsSharingWordsMerge.end(); lit!=lend; lit++)
         {
             if((*lit)->mnMergeWords>maxCommonWords)
                 maxCommonWords=(*lit)->mnMergeWords;
@@ -380,7 +451,7 @@ void KeyFrameDatabase::DetectCandidates(KeyFrame* pKF, float minScore,vector<Key
         int nscores=0;
 
         // Compute similarity score. Retain the matches whose score is higher than minScore
-        for(list<KeyFrame*>::iterator lit=lKFsSharingWordsMerge.begin(), lend=lKFsSharingWordsMerge.end(); lit!=lend; lit++)
+        for(vector<KeyFrame*>::iterator lit=vpKFsSharingWordsMerge.begin(), lend=vpKFsSharingWordsMerge.end(); lit!=lend; lit++)
         {
             KeyFrame* pKFi = *lit;
 
@@ -392,27 +463,27 @@ void KeyFrameDatabase::DetectCandidates(KeyFrame* pKF, float minScore,vector<Key
 
                 pKFi->mMergeScore = si;
                 if(si>=minScore)
-                    lScoreAndMatch.push_back(make_pair(si,pKFi));
+                    vScoreAndMatch.push_back(make_pair(si,pKFi));
             }
         }
 
-        if(!lScoreAndMatch.empty())
+        if(!vScoreAndMatch.empty())
         {
-            list<pair<float,KeyFrame*> > lAccScoreAndMatch;
+            vector<pair<float,KeyFrame*> > vAccScoreAndMatch;
             float bestAccScore = minScore;
 
             // Lets now accumulate score by covisibility
-            for(list<pair<float,KeyFrame*> >::iterator it=lScoreAndMatch.begin(), itend=lScoreAndMatch.end(); it!=itend; it++)
+            for(vector<pair<float,KeyFrame*> >::iterator it=vScoreAndMatch.begin(), itend=vScoreAndMatch.end(); it!=itend; it++)
             {
                 KeyFrame* pKFi = it->second;
-                vector<KeyFrame*> vpNeighs = pKFi->GetBestCovisibilityKeyFrames(10);
+                const CovisibilityEdges::Snapshot pNeighs = pKFi->GetCovisibles();
 
                 float bestScore = it->first;
                 float accScore = it->first;
                 KeyFrame* pBestKF = pKFi;
-                for(vector<KeyFrame*>::iterator vit=vpNeighs.begin(), vend=vpNeighs.end(); vit!=vend; vit++)
+                for(size_t iN=0, iNend=pNeighs->CountBest(10); iN<iNend; iN++)
                 {
-                    KeyFrame* pKF2 = *vit;
+                    KeyFrame* pKF2 = pNeighs->vpKeyFrames[iN];
                     if(pKF2->mnMergeQuery==pKF->mnId && pKF2->mnMergeWords>minCommonWords)
                     {
                         accScore+=pKF2->mMergeScore;
@@ -424,7 +495,7 @@ void KeyFrameDatabase::DetectCandidates(KeyFrame* pKF, float minScore,vector<Key
                     }
                 }
 
-                lAccScoreAndMatch.push_back(make_pair(accScore,pBestKF));
+                vAccScoreAndMatch.push_back(make_pair(accScore,pBestKF));
                 if(accScore>bestAccScore)
                     bestAccScore=accScore;
             }
@@ -433,9 +504,9 @@ void KeyFrameDatabase::DetectCandidates(KeyFrame* pKF, float minScore,vector<Key
             float minScoreToRetain = 0.75f*bestAccScore;
 
             set<KeyFrame*> spAlreadyAddedKF;
-            vpMergeCand.reserve(lAccScoreAndMatch.size());
+            vpMergeCand.reserve(vAccScoreAndMatch.size());
 
-            for(list<pair<float,KeyFrame*> >::iterator it=lAccScoreAndMatch.begin(), itend=lAccScoreAndMatch.end(); it!=itend; it++)
+            for(vector<pair<float,KeyFrame*> >::iterator it=vAccScoreAndMatch.begin(), itend=vAccScoreAndMatch.end(); it!=itend; it++)
             {
                 if(it->first>minScoreToRetain)
                 {
@@ -451,59 +522,46 @@ void KeyFrameDatabase::DetectCandidates(KeyFrame* pKF, float minScore,vector<Key
 
     }
 
-    for(DBoW2::BowVector::const_iterator vit=pKF->mBowVec.begin(), vend=pKF->mBowVec.end(); vit != vend; vit++)
+    for(vector<KeyFrame*>::iterator vit=vpKFsSharingWords.begin(), vend=vpKFsSharingWords.end(); vit != vend; vit++)
     {
-        list<KeyFrame*> &lKFs = mvInvertedFile[vit->first];
-
-        for(list<KeyFrame*>::iterator lit=lKFs.begin(), lend= lKFs.end(); lit!=lend; lit++)
-        {
-            KeyFrame* pKFi=*lit;
-            pKFi->mnLoopQuery=-1;
-            pKFi->mnMergeQuery=-1;
-        }
+        KeyFrame* pKFi=*vit;
+        pKFi->mnLoopQuery=-1;
+        pKFi->mnMergeQuery=-1;
     }
 
 }
 
 void KeyFrameDatabase::DetectBestCandidates(KeyFrame *pKF, vector<KeyFrame*> &vpLoopCand, vector<KeyFrame*> &vpMergeCand, int nMinWords)
 {
-    list<KeyFrame*> lKFsSharingWords;
+    vector<KeyFrame*> vpKFsSharingWords;
     set<KeyFrame*> spConnectedKF;
 
     // Search all keyframes that share a word with current frame
     {
-        unique_lock<mutex> lock(mMutex);
-
         spConnectedKF = pKF->GetConnectedKeyFrames();
 
-        for(DBoW2::BowVector::const_iterator vit=pKF->mBowVec.begin(), vend=pKF->mBowVec.end(); vit != vend; vit++)
-        {
-            list<KeyFrame*> &lKFs =   mvInvertedFile[vit->first];
+        vector<KeyFrame*> vpKFs;
+        vector<int> vnWords;
+        SearchSharedWords(pKF->mBowVec, NULL, vpKFs, vnWords);
 
-            for(list<KeyFrame*>::iterator lit=lKFs.begin(), lend= lKFs.end(); lit!=lend; lit++)
+        for(size_t i=0; i<vpKFs.size(); i++)
+        {
+            KeyFrame* pKFi = vpKFs[i];
+            if(spConnectedKF.find(pKFi) != spConnectedKF.end())
             {
-                KeyFrame* pKFi=*lit;
-                if(spConnectedKF.find(pKFi) != spConnectedKF.end())
-                {
-                    continue;
-                }
-                if(pKFi->mnPlaceRecognitionQuery!=pKF->mnId)
-                {
-                    pKFi->mnPlaceRecognitionWords=0;
-                    pKFi->mnPlaceRecognitionQuery=pKF->mnId;
-                    lKFsSharingWords.push_back(pKFi);
-                }
-               pKFi->mnPlaceRecognitionWords++;
-
+                continue;
             }
+            pKFi->mnPlaceRecognitionQuery=pKF->mnId;
+            pKFi->mnPlaceRecognitionWords=vnWords[i];
+            vpKFsSharingWords.push_back(pKFi);
         }
     }
-    if(lKFsSharingWords.empty())
+    if(vpKFsSharingWords.empty())
         return;
 
     // Only compare against those keyframes that share enough words
     int maxCommonWords=0;
-    for(list<KeyFrame*>::iterator lit=lKFsSharingWords.begin(), lend= lKFsSharingWords.end(); lit!=lend; lit++)
+    for(vector<KeyFrame*>::iterator lit=vpKFsSharingWords.begin(), lend= vpKFsSharingWords.end(); lit!=lend; lit++)
     {
         if((*lit)->mnPlaceRecognitionWords>maxCommonWords)
             maxCommonWords=(*lit)->mnPlaceRecognitionWords;
@@ -516,12 +574,12 @@ void KeyFrameDatabase::DetectBestCandidates(KeyFrame *pKF, vector<KeyFrame*> &vp
         minCommonWords = nMinWords;
     }
 
-    list<pair<float,KeyFrame*> > lScoreAndMatch;
+    vector<pair<float,KeyFrame*> > vScoreAndMatch;
 
     int nscores=0;
 
     // Compute similarity score.
-    for(list<KeyFrame*>::iterator lit=lKFsSharingWords.begin(), lend= lKFsSharingWords.end(); lit!=lend; lit++)
+    for(vector<KeyFrame*>::iterator lit=vpKFsSharingWords.begin(), lend= vpKFsSharingWords.end(); lit!=lend; lit++)
     {
         KeyFrame* pKFi = *lit;
 
@@ -530,28 +588,28 @@ void KeyFrameDatabase::DetectBestCandidates(KeyFrame *pKF, vector<KeyFrame*> &vp
             nscores++;
             float si = mpVoc->score(pKF->mBowVec,pKFi->mBowVec);
             pKFi->mPlaceRecognitionScore=si;
-            lScoreAndMatch.push_back(make_pair(si,pKFi));
+            vScoreAndMatch.push_back(make_pair(si,pKFi));
         }
     }
 
-    if(lScoreAndMatch.empty())
+    if(vScoreAndMatch.empty())
         return;
 
-    list<pair<float,KeyFrame*> > lAccScoreAndMatch;
+    vector<pair<float,KeyFrame*> > vAccScoreAndMatch;
     float bestAccScore = 0;
 
     // Lets now accumulate score by covisibility
-    for(list<pair<float,KeyFrame*> >::iterator it=lScoreAndMatch.begin(), itend=lScoreAndMatch.end(); it!=itend; it++)
+    for(vector<pair<float,KeyFrame*> >::iterator it=vScoreAndMatch.begin(), itend=vScoreAndMatch.end(); it!=itend; it++)
     {
         KeyFrame* pKFi = it->second;
-        vector<KeyFrame*> vpNeighs = pKFi->GetBestCovisibilityKeyFrames(10);
+        const CovisibilityEdges::Snapshot pNeighs = pKFi->GetCovisibles();
 
         float bestScore = it->first;
         float accScore = bestScore;
         KeyFrame* pBestKF = pKFi;
-        for(vector<KeyFrame*>::iterator vit=vpNeighs.begin(), vend=vpNeighs.end(); vit!=vend; vit++)
+        for(size_t iN=0, iNend=pNeighs->CountBest(10); iN<iNend; iN++)
         {
-            KeyFrame* pKF2 = *vit;
+            KeyFrame* pKF2 = pNeighs->vpKeyFrames[iN];
             if(pKF2->mnPlaceRecognitionQuery!=pKF->mnId)
                 continue;
 
@@ -563,7 +621,7 @@ void KeyFrameDatabase::DetectBestCandidates(KeyFrame *pKF, vector<KeyFrame*> &vp
             }
 
         }
-        lAccScoreAndMatch.push_back(make_pair(accScore,pBestKF));
+        vAccScoreAndMatch.push_back(make_pair(accScore,pBestKF));
         if(accScore>bestAccScore)
             bestAccScore=accScore;
     }
@@ -571,9 +629,9 @@ void KeyFrameDatabase::DetectBestCandidates(KeyFrame *pKF, vector<KeyFrame*> &vp
     // Return all those keyframes with a score higher than 0.75*bestScore
     float minScoreToRetain = 0.75f*bestAccScore;
     set<KeyFrame*> spAlreadyAddedKF;
-    vpLoopCand.reserve(lAccScoreAndMatch.size());
-    vpMergeCand.reserve(lAccScoreAndMatch.size());
-    for(list<pair<float,KeyFrame*> >::iterator it=lAccScoreAndMatch.begin(), itend=lAccScoreAndMatch.end(); it!=itend; it++)
+    vpLoopCand.reserve(vAccScoreAndMatch.size());
+    vpMergeCand.reserve(vAccScoreAndMatch.size());
+    for(vector<pair<float,KeyFrame*> >::iterator it=vAccScoreAndMatch.begin(), itend=vAccScoreAndMatch.end(); it!=itend; it++)
     {
         const float &si = it->first;
         if(si>minScoreToRetain)
@@ -603,43 +661,34 @@ bool compFirst(const pair<float, KeyFrame*> & a, const pair<float, KeyFrame*> &
 
 void KeyFrameDatabase::DetectNBestCandidates(KeyFrame *pKF, vector<KeyFrame*> &vpLoopCand, vector<KeyFrame*> &vpMergeCand, int nNumCandidates)
 {
-    list<KeyFrame*> lKFsSharingWords;
+    vector<KeyFrame*> vpKFsSharingWords;
     set<KeyFrame*> spConnectedKF;
 
     // Search all keyframes that share a word with current frame
     {
-        unique_lock<mutex> lock(mMutex);
-
         spConnectedKF = pKF->GetConnectedKeyFrames();
 
-        for(DBoW2::BowVector::const_iterator vit=pKF->mBowVec.begin(), vend=pKF->mBowVec.end(); vit != vend; vit++)
-        {
-            list<KeyFrame*> &lKFs =   mvInvertedFile[vit->first];
+        vector<KeyFrame*> vpKFs;
+        vector<int> vnWords;
+        SearchSharedWords(pKF->mBowVec, NULL, vpKFs, vnWords);
 
-            for(list<KeyFrame*>::iterator lit=lKFs.begin(), lend= lKFs.end(); lit!=lend; lit++)
+        for(size_t i=0; i<vpKFs.size(); i++)
+        {
+            KeyFrame* pKFi = vpKFs[i];
+            if(!spConnectedKF.count(pKFi))
             {
-                KeyFrame* pKFi=*lit;
-
-                if(pKFi->mnPlaceRecognitionQuery!=pKF->mnId)
-                {
-                    pKFi->mnPlaceRecognitionWords=0;
-                    if(!spConnectedKF.count(pKFi))
-                    {
-
-                        pKFi->mnPlaceRecognitionQuery=pKF->mnId;
-                        lKFsSharingWords.push_back(pKFi);
-                    }
-                }
-                pKFi->mnPlaceRecognitionWords++;
+                pKFi->mnPlaceRecognitionQuery=pKF->mnId;
+                pKFi->mnPlaceRecognitionWords=vnWords[i];
+                vpKFsSharingWords.push_back(pKFi);
             }
         }
     }
-    if(lKFsSharingWords.empty())
+    if(vpKFsSharingWords.empty())
         return;
 
     // Only compare against those keyframes that share enough words
     int maxCommonWords=0;
-    for(list<KeyFrame*>::iterator lit=lKFsSharingWords.begin(), lend= lKFsSharingWords.end(); lit!=lend; lit++)
+    for(vector<KeyFrame*>::iterator lit=vpKFsSharingWords.begin(), lend= vpKFsSharingWords.end(); lit!=lend; lit++)
     {
         if((*lit)->mnPlaceRecognitionWords>maxCommonWords)
             maxCommonWords=(*lit)->mnPlaceRecognitionWords;
@@ -647,12 +696,12 @@ void KeyFrameDatabase::DetectNBestCandidates(KeyFrame *pKF, vector<KeyFrame*> &v
 
     int minCommonWords = maxCommonWords*0.8f;
 
-    list<pair<float,KeyFrame*> > lScoreAndMatch;
+    vector<pair<float,KeyFrame*> > vScoreAndMatch;
 
     int nscores=0;
 
     // Compute similarity score.
-    for(list<KeyFrame*>::iterator lit=lKFsSharingWords.begin(), lend= lKFsSharingWords.end(); lit!=lend; lit++)
+    for(vector<KeyFrame*>::iterator lit=vpKFsSharingWords.begin(), lend= vpKFsSharingWords.end(); lit!=lend; lit++)
     {
         KeyFrame* pKFi = *lit;
 
@@ -661,28 +710,28 @@ void KeyFrameDatabase::DetectNBestCandidates(KeyFrame *pKF, vector<KeyFrame*> &v
             nscores++;
             float si = mpVoc->score(pKF->mBowVec,pKFi->mBowVec);
             pKFi->mPlaceRecognitionScore=si;
-            lScoreAndMatch.push_back(make_pair(si,pKFi));
+            vScoreAndMatch.push_back(make_pair(si,pKFi));
         }
     }
 
-    if(lScoreAndMatch.empty())
+    if(vScoreAndMatch.empty())
         return;
 
-    list<pair<float,KeyFrame*> > lAccScoreAndMatch;
+    vector<pair<float,KeyFrame*> > vAccScoreAndMatch;
     float bestAccScore = 0;
 
     // Lets now accumulate score by covisibility
-    for(list<pair<float,KeyFrame*> >::iterator it=lScoreAndMatch.begin(), itend=lScoreAndMatch.end(); it!=itend; it++)
+    for(vector<pair<float,KeyFrame*> >::iterator it=vScoreAndMatch.begin(), itend=vScoreAndMatch.end(); it!=itend; it++)
     {
         KeyFrame* pKFi = it->second;
-        vector<KeyFrame*> vpNeighs = pKFi->GetBestCovisibilityKeyFrames(10);
+        const CovisibilityEdges::Snapshot pNeighs = pKFi->GetCovisibles();
 
         float bestScore = it->first;
         float accScore = bestScore;
         KeyFrame* pBestKF = pKFi;
-        for(vector<KeyFrame*>::iterator vit=vpNeighs.begin(), vend=vpNeighs.end(); vit!=vend; vit++)
+        for(size_t iN=0, iNend=pNeighs->CountBest(10); iN<iNend; iN++)
         {
-            KeyFrame* pKF2 = *vit;
+            KeyFrame* pKF2 = pNeighs->vpKeyFrames[iN];
             if(pKF2->mnPlaceRecognitionQuery!=pKF->mnId)
                 continue;
 
@@ -694,25 +743,22 @@ void KeyFrameDatabase::DetectNBestCandidates(KeyFrame *pKF, vector<KeyFrame*> &v
             }
 
         }
-        lAccScoreAndMatch.push_back(make_pair(accScore,pBestKF));
+        vAccScoreAndMatch.push_back(make_pair(accScore,pBestKF));
         if(accScore>bestAccScore)
             bestAccScore=accScore;
     }
 
-    lAccScoreAndMatch.sort(compFirst);
+    stable_sort(vAccScoreAndMatch.begin(), vAccScoreAndMatch.end(), compFirst);
 
     vpLoopCand.reserve(nNumCandidates);
     vpMergeCand.reserve(nNumCandidates);
     set<KeyFrame*> spAlreadyAddedKF;
     int i = 0;
-    list<pair<float,KeyFrame*> >::iterator it=lAccScoreAndMatch.begin();
-    while(i < lAccScoreAndMatch.size() && (vpLoopCand.size() < nNumCandidates || vpMergeCand.size() < nNumCandidates))
+    vector<pair<float,KeyFrame*> >::iterator it=vAccScoreAndMatch.begin();
+    while(i < vAccScoreAndMatch.size() && (vpLoopCand.size() < nNumCandidates || vpMergeCand.size() < nNumCandidates))
     {
         KeyFrame* pKFi = it->second;
-        if(pKFi->isBad())
-            continue;
-
-        if(!spAlreadyAddedKF.count(pKFi))
+        if(!pKFi->isBad() && !spAlreadyAddedKF.count(pKFi))
         {
             if(pKF->GetMap() == pKFi->GetMap() && vpLoopCand.size() < nNumCandidates)
             {
@@ -732,35 +778,26 @@ void KeyFrameDatabase::DetectNBestCandidates(KeyFrame *pKF, vector<KeyFrame*> &v
 
 vector<KeyFrame*> KeyFrameDatabase::DetectRelocalizationCandidates(Frame *F, Map* pMap)
 {
-    list<KeyFrame*> lKFsSharingWords;
+    vector<KeyFrame*> vpKFsSharingWords;
 
-    // Search all keyframes that share a word with current frame
+    // Search all keyframes of the map that share a word with current frame
     {
-        unique_lock<mutex> lock(mMutex);
+        vector<int> vnWords;
+        SearchSharedWords(F->mBowVec, pMap, vpKFsSharingWords, vnWords);
 
-        for(DBoW2::BowVector::const_iterator vit=F->mBowVec.begin(), vend=F->mBowVec.end(); vit != vend; vit++)
+        for(size_t i=0; i<vpKFsSharingWords.size(); i++)
         {
-            list<KeyFrame*> &lKFs =   mvInvertedFile[vit->first];
-
-            for(list<KeyFrame*>::iterator lit=lKFs.begin(), lend= lKFs.end(); lit!=lend; lit++)
-            {
-                KeyFrame* pKFi=*lit;
-                if(pKFi->mnRelocQuery!=F->mnId)
-                {
-                    pKFi->mnRelocWords=0;
-                    pKFi->mnRelocQuery=F->mnId;
-                    lKFsSharingWords.push_back(pKFi);
-                }
-                pKFi->mnRelocWords++;
-            }
+            KeyFrame* pKFi = vpKFsSharingWords[i];
+            pKFi->mnRelocQuery=F->mnId;
+            pKFi->mnRelocWords=vnWords[i];
         }
     }
-    if(lKFsSharingWords.empty())
+    if(vpKFsSharingWords.empty())
         return vector<KeyFrame*>();
 
     // Only compare against those keyframes that share enough words
     int maxCommonWords=0;
-    for(list<KeyFrame*>::iterator lit=lKFsSharingWords.begin(), lend= lKFsSharingWords.end(); lit!=lend; lit++)
+    for(vector<KeyFrame*>::iterator lit=vpKFsSharingWords.begin(), lend= vpKFsSharingWords.end(); lit!=lend; lit++)
     {
         if((*lit)->mnRelocWords>maxCommonWords)
             maxCommonWords=(*lit)->mnRelocWords;
@@ -768,12 +805,12 @@ vector<KeyFrame*> KeyFrameDatabase::DetectRelocalizationCandidates(Frame *F, Map
 
     int minCommonWords = maxCommonWords*0.8f;
 
-    list<pair<float,KeyFrame*> > lScoreAndMatch;
+    vector<pair<float,KeyFrame*> > vScoreAndMatch;
 
     int nscores=0;
 
     // Compute similarity score.
-    for(list<KeyFrame*>::iterator lit=lKFsSharingWords.begin(), lend= lKFsSharingWords.end(); lit!=lend; lit++)
+    for(vector<KeyFrame*>::iterator lit=vpKFsSharingWords.begin(), lend= vpKFsSharingWords.end(); lit!=lend; lit++)
     {
         KeyFrame* pKFi = *lit;
 
@@ -782,28 +819,28 @@ vector<KeyFrame*> KeyFrameDatabase::DetectRelocalizationCandidates(Frame *F, Map
             nscores++;
             float si = mpVoc->score(F->mBowVec,pKFi->mBowVec);
             pKFi->mRelocScore=si;
-            lScoreAndMatch.push_back(make_pair(si,pKFi));
+            vScoreAndMatch.push_back(make_pair(si,pKFi));
         }
     }
 
-    if(lScoreAndMatch.empty())
+    if(vScoreAndMatch.empty())
         return vector<KeyFrame*>();
 
-    list<pair<float,KeyFrame*> > lAccScoreAndMatch;
+    vector<pair<float,KeyFrame*> > vAccScoreAndMatch;
     float bestAccScore = 0;
 
     // Lets now accumulate score by covisibility
-    for(list<pair<float,KeyFrame*> >::iterator it=lScoreAndMatch.begin(), itend=lScoreAndMatch.end(); it!=itend; it++)
+    for(vector<pair<float,KeyFrame*> >::iterator it=vScoreAndMatch.begin(), itend=vScoreAndMatch.end(); it!=itend; it++)
     {
         KeyFrame* pKFi = it->second;
-        vector<KeyFrame*> vpNeighs = pKFi->GetBestCovisibilityKeyFrames(10);
+        const CovisibilityEdges::Snapshot pNeighs = pKFi->GetCovisibles();
 
         float bestScore = it->first;
         float accScore = bestScore;
         KeyFrame* pBestKF = pKFi;
-        for(vector<KeyFrame*>::iterator vit=vpNeighs.begin(), vend=vpNeighs.end(); vit!=vend; vit++)
+        for(size_t iN=0, iNend=pNeighs->CountBest(10); iN<iNend; iN++)
         {
-            KeyFrame* pKF2 = *vit;
+            KeyFrame* pKF2 = pNeighs->vpKeyFrames[iN];
             if(pKF2->mnRelocQuery!=F->mnId)
                 continue;
 
@@ -815,7 +852,7 @@ vector<KeyFrame*> KeyFrameDatabase::DetectRelocalizationCandidates(Frame *F, Map
             }
 
         }
-        lAccScoreAndMatch.push_back(make_pair(accScore,pBestKF));
+        vAccScoreAndMatch.push_back(make_pair(accScore,pBestKF));
         if(accScore>bestAccScore)
             bestAccScore=accScore;
     }
@@ -824,8 +861,8 @@ vector<KeyFrame*> KeyFrameDatabase::DetectRelocalizationCandidates(Frame *F, Map
     float minScoreToRetain = 0.75f*bestAccScore;
     set<KeyFrame*> spAlreadyAddedKF;
     vector<KeyFrame*> vpRelocCandidates;
-    vpRelocCandidates.reserve(lAccScoreAndMatch.size());
-    for(list<pair<float,KeyFrame*> >::iterator it=lAccScoreAndMatch.begin(), itend=lAccScoreAndMatch.end(); it!=itend; it++)
+    vpRelocCandidates.reserve(vAccScoreAndMatch.size());
+    for(vector<pair<float,KeyFrame*> >::iterator it=vAccScoreAndMatch.begin(), itend=vAccScoreAndMatch.end(); it!=itend; it++)
     {
         const float &si = it->first;
         if(si>minScoreToRetain)
@@ -850,8 +887,7 @@ void KeyFrameDatabase::SetORBVocabulary(ORBVocabulary* pORBVoc)
     ptr = (ORBVocabulary**)( &mpVoc );
     *ptr = pORBVoc;
 
-    mvInvertedFile.clear();
-    mvInvertedFile.resize(mpVoc->size());
+    clear();
 }
 
 } //namespace ORB_SLAM
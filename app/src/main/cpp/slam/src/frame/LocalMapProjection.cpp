@@ -0,0 +1,275 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "frame/LocalMapProjection.h"
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "frame/Frame.h"
+#include "map/MapPoint.h"
+#include "camera_models/GeometricCamera.h"
+
+namespace ORB_SLAM3
+{
+
+void LocalMapProjection::Reset(const std::vector<MapPoint*>& vpMapPoints)
+{
+    const std::size_t N = vpMapPoints.size();
+    mvpPoints.assign(vpMapPoints.begin(), vpMapPoints.end());
+    mvX.resize(N); mvY.resize(N); mvZ.resize(N);
+    mvNx.resize(N); mvNy.resize(N); mvNz.resize(N);
+    mvMinDistance.resize(N); mvMaxDistance.resize(N);
+    mvScaleDistance.resize(N);
+
+    for(std::size_t i=0; i<N; i++)
+    {
+        Eigen::Vector3f P, Pn;
+        float fMinDistance, fMaxDistance;
+        mvpPoints[i]->GetProjectionData(P, Pn, fMinDistance, fMaxDistance);
+
+        mvX[i] = P(0); mvY[i] = P(1); mvZ[i] = P(2);
+        mvNx[i] = Pn(0); mvNy[i] = Pn(1); mvNz[i] = Pn(2);
+        mvMinDistance[i] = 0.8f * fMinDistance;
+        mvMaxDistance[i] = 1.2f * fMaxDistance;
+        mvScaleDistance[i] = fMaxDistance;
+    }
+
+    mvpVisible.clear();
+}
+
+int LocalMapProjection::Project(const Frame& F, float viewingCosLimit)
+{
+    mvpVisible.clear();
+    mvProjX.clear(); mvProjY.clear(); mvProjXR.clear();
+    mvDepth.clear();
+    mvViewCos.clear();
+    mvLevel.clear();
+
+    const Sophus::SE3f Tcw = F.GetPose();
+    const Eigen::Matrix3f R = Tcw.rotationMatrix();
+    const Eigen::Vector3f t = Tcw.translation();
+    const Eigen::Vector3f O = F.GetOw();
+
+    GeometricCamera* pCamera = F.mpCamera;
+    const bool bPinhole = pCamera->GetType() == GeometricCamera::CAM_PINHOLE;
+    const float fx = pCamera->getParameter(0);
+    const float fy = pCamera->getParameter(1);
+    const float cx = pCamera->getParameter(2);
+    const float cy = pCamera->getParameter(3);
+
+    const std::size_t N = mvpPoints.size();
+    std::size_t i = 0;
+
+    // Four points at a time with the operations of Frame::isInFrustum() and Pinhole::project() in the same
+    // order. Every test is done on every lane, a lane is kept if none of them rejects it.
+#if defined(__SSE2__)
+    if(bPinhole)
+    {
+        const __m128 r00 = _mm_set1_ps(R(0,0)), r01 = _mm_set1_ps(R(0,1)), r02 = _mm_set1_ps(R(0,2));
+        const __m128 r10 = _mm_set1_ps(R(1,0)), r11 = _mm_set1_ps(R(1,1)), r12 = _mm_set1_ps(R(1,2));
+        const __m128 r20 = _mm_set1_ps(R(2,0)), r21 = _mm_set1_ps(R(2,1)), r22 = _mm_set1_ps(R(2,2));
+        const __m128 t0 = _mm_set1_ps(t(0)), t1 = _mm_set1_ps(t(1)), t2 = _mm_set1_ps(t(2));
+        const __m128 o0 = _mm_set1_ps(O(0)), o1 = _mm_set1_ps(O(1)), o2 = _mm_set1_ps(O(2));
+        const __m128 vfx = _mm_set1_ps(fx), vfy = _mm_set1_ps(fy), vcx = _mm_set1_ps(cx), vcy = _mm_set1_ps(cy);
+        const __m128 minX = _mm_set1_ps(Frame::mnMinX), maxX = _mm_set1_ps(Frame::mnMaxX);
+        const __m128 minY = _mm_set1_ps(Frame::mnMinY), maxY = _mm_set1_ps(Frame::mnMaxY);
+        const __m128 bf = _mm_set1_ps(F.mbf);
+        const __m128 cosLimit = _mm_set1_ps(viewingCosLimit);
+        const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+
+        for(; i+4<=N; i+=4)
+        {
+            const __m128 x = _mm_loadu_ps(&mvX[i]), y = _mm_loadu_ps(&mvY[i]), z = _mm_loadu_ps(&mvZ[i]);
+
+            const __m128 PcX = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(r00,x), _mm_mul_ps(r01,y)), _mm_mul_ps(r02,z)), t0);
+            const __m128 PcY = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(r10,x), _mm_mul_ps(r11,y)), _mm_mul_ps(r12,z)), t1);
+            const __m128 PcZ = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(r20,x), _mm_mul_ps(r21,y)), _mm_mul_ps(r22,z)), t2);
+            __m128 reject = _mm_cmplt_ps(PcZ, zero);
+
+            const __m128 u = _mm_add_ps(_mm_div_ps(_mm_mul_ps(vfx,PcX), PcZ), vcx);
+            const __m128 v = _mm_add_ps(_mm_div_ps(_mm_mul_ps(vfy,PcY), PcZ), vcy);
+            reject = _mm_or_ps(reject, _mm_or_ps(_mm_cmplt_ps(u,minX), _mm_cmpgt_ps(u,maxX)));
+            reject = _mm_or_ps(reject, _mm_or_ps(_mm_cmplt_ps(v,minY), _mm_cmpgt_ps(v,maxY)));
+
+            const __m128 POx = _mm_sub_ps(x,o0), POy = _mm_sub_ps(y,o1), POz = _mm_sub_ps(z,o2);
+            const __m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(POx,POx), _mm_mul_ps(POy,POy)), _mm_mul_ps(POz,POz)));
+            reject = _mm_or_ps(reject, _mm_cmplt_ps(dist, _mm_loadu_ps(&mvMinDistance[i])));
+            reject = _mm_or_ps(reject, _mm_cmpgt_ps(dist, _mm_loadu_ps(&mvMaxDistance[i])));
+
+            const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(POx, _mm_loadu_ps(&mvNx[i])), _mm_mul_ps(POy, _mm_loadu_ps(&mvNy[i]))),
+                                          _mm_mul_ps(POz, _mm_loadu_ps(&mvNz[i])));
+            const __m128 viewCos = _mm_div_ps(dot, dist);
+            reject = _mm_or_ps(reject, _mm_cmplt_ps(viewCos, cosLimit));
+
+            const int keep = ~_mm_movemask_ps(reject) & 0xF;
+            if(!keep)
+                continue;
+
+            const __m128 depth = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(PcX,PcX), _mm_mul_ps(PcY,PcY)), _mm_mul_ps(PcZ,PcZ)));
+            const __m128 uR = _mm_sub_ps(u, _mm_mul_ps(bf, _mm_div_ps(one, PcZ)));
+
+            alignas(16) float au[4], av[4], auR[4], adepth[4], adist[4], aviewCos[4];
+            _mm_store_ps(au, u); _mm_store_ps(av, v); _mm_store_ps(auR, uR);
+            _mm_store_ps(adepth, depth); _mm_store_ps(adist, dist); _mm_store_ps(aviewCos, viewCos);
+            for(int k=0; k<4; k++)
+                if(keep & (1<<k))
+                    Keep(F, i+k, au[k], av[k], auR[k], adepth[k], adist[k], aviewCos[k]);
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    if(bPinhole)
+    {
+        const float32x4_t r00 = vdupq_n_f32(R(0,0)), r01 = vdupq_n_f32(R(0,1)), r02 = vdupq_n_f32(R(0,2));
+        const float32x4_t r10 = vdupq_n_f32(R(1,0)), r11 = vdupq_n_f32(R(1,1)), r12 = vdupq_n_f32(R(1,2));
+        const float32x4_t r20 = vdupq_n_f32(R(2,0)), r21 = vdupq_n_f32(R(2,1)), r22 = vdupq_n_f32(R(2,2));
+        const float32x4_t t0 = vdupq_n_f32(t(0)), t1 = vdupq_n_f32(t(1)), t2 = vdupq_n_f32(t(2));
+        const float32x4_t o0 = vdupq_n_f32(O(0)), o1 = vdupq_n_f32(O(1)), o2 = vdupq_n_f32(O(2));
+        const float32x4_t vfx = vdupq_n_f32(fx), vfy = vdupq_n_f32(fy), vcx = vdupq_n_f32(cx), vcy = vdupq_n_f32(cy);
+        const float32x4_t minX = vdupq_n_f32(Frame::mnMinX), maxX = vdupq_n_f32(Frame::mnMaxX);
+        const float32x4_t minY = vdupq_n_f32(Frame::mnMinY), maxY = vdupq_n_f32(Frame::mnMaxY);
+        const float32x4_t bf = vdupq_n_f32(F.mbf);
+        const float32x4_t cosLimit = vdupq_n_f32(viewingCosLimit);
+        const float32x4_t zero = vdupq_n_f32(0.0f), one = vdupq_n_f32(1.0f);
+
+        for(; i+4<=N; i+=4)
+        {
+            const float32x4_t x = vld1q_f32(&mvX[i]), y = vld1q_f32(&mvY[i]), z = vld1q_f32(&mvZ[i]);
+
+            const float32x4_t PcX = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(r00,x), vmulq_f32(r01,y)), vmulq_f32(r02,z)), t0);
+            const float32x4_t PcY = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(r10,x), vmulq_f32(r11,y)), vmulq_f32(r12,z)), t1);
+            const float32x4_t PcZ = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(r20,x), vmulq_f32(r21,y)), vmulq_f32(r22,z)), t2);
+            uint32x4_t reject = vcltq_f32(PcZ, zero);
+
+            const float32x4_t u = vaddq_f32(vdivq_f32(vmulq_f32(vfx,PcX), PcZ), vcx);
+            const float32x4_t v = vaddq_f32(vdivq_f32(vmulq_f32(vfy,PcY), PcZ), vcy);
+            reject = vorrq_u32(reject, vorrq_u32(vcltq_f32(u,minX), vcgtq_f32(u,maxX)));
+            reject = vorrq_u32(reject, vorrq_u32(vcltq_f32(v,minY), vcgtq_f32(v,maxY)));
+
+            const float32x4_t POx = vsubq_f32(x,o0), POy = vsubq_f32(y,o1), POz = vsubq_f32(z,o2);
+            const float32x4_t dist = vsqrtq_f32(vaddq_f32(vaddq_f32(vmulq_f32(POx,POx), vmulq_f32(POy,POy)), vmulq_f32(POz,POz)));
+            reject = vorrq_u32(reject, vcltq_f32(dist, vld1q_f32(&mvMinDistance[i])));
+            reject = vorrq_u32(reject, vcgtq_f32(dist, vld1q_f32(&mvMaxDistance[i])));
+
+            const float32x4_t dot = vaddq_f32(vaddq_f32(vmulq_f32(POx, vld1q_f32(&mvNx[i])), vmulq_f32(POy, vld1q_f32(&mvNy[i]))),
+                                              vmulq_f32(POz, vld1q_f32(&mvNz[i])));
+            const float32x4_t viewCos = vdivq_f32(dot, dist);
+            reject = vorrq_u32(reject, vcltq_f32(viewCos, cosLimit));
+
+            if(vminvq_u32(reject) != 0)
+                continue;
+
+            const float32x4_t depth = vsqrtq_f32(vaddq_f32(vaddq_f32(vmulq_f32(PcX,PcX), vmulq_f32(PcY,PcY)), vmulq_f32(PcZ,PcZ)));
+            const float32x4_t uR = vsubq_f32(u, vmulq_f32(bf, vdivq_f32(one, PcZ)));
+
+            uint32_t areject[4];
+            float au[4], av[4], auR[4], adepth[4], adist[4], aviewCos[4];
+            vst1q_u32(areject, reject);
+            vst1q_f32(au, u); vst1q_f32(av, v); vst1q_f32(auR, uR);
+            vst1q_f32(adepth, depth); vst1q_f32(adist, dist); vst1q_f32(aviewCos, viewCos);
+            for(int k=0; k<4; k++)
+                if(!areject[k])
+                    Keep(F, i+k, au[k], av[k], auR[k], adepth[k], adist[k], aviewCos[k]);
+        }
+    }
+#endif
+
+    for(; i<N; i++)
+    {
+        const float x = mvX[i], y = mvY[i], z = mvZ[i];
+
+        // 3D in camera coordinates
+        const float PcX = R(0,0)*x + R(0,1)*y + R(0,2)*z + t(0);
+        const float PcY = R(1,0)*x + R(1,1)*y + R(1,2)*z + t(1);
+        const float PcZ = R(2,0)*x + R(2,1)*y + R(2,2)*z + t(2);
+
+        // Check positive depth
+        if(PcZ<0.0f)
+            continue;
+
+        float u, v;
+        if(bPinhole)
+        {
+            u = fx*PcX/PcZ + cx;
+            v = fy*PcY/PcZ + cy;
+        }
+        else
+        {
+            const Eigen::Vector2f uv = pCamera->project(Eigen::Vector3f(PcX,PcY,PcZ));
+            u = uv(0);
+            v = uv(1);
+        }
+
+        if(u<Frame::mnMinX || u>Frame::mnMaxX)
+            continue;
+        if(v<Frame::mnMinY || v>Frame::mnMaxY)
+            continue;
+
+        // Check distance is in the scale invariance region of the MapPoint
+        const float POx = x - O(0), POy = y - O(1), POz = z - O(2);
+        const float dist = sqrt(POx*POx + POy*POy + POz*POz);
+        if(dist<mvMinDistance[i] || dist>mvMaxDistance[i])
+            continue;
+
+        // Check viewing angle
+        const float viewCos = (POx*mvNx[i] + POy*mvNy[i] + POz*mvNz[i])/dist;
+        if(viewCos<viewingCosLimit)
+            continue;
+
+        const float depth = sqrt(PcX*PcX + PcY*PcY + PcZ*PcZ);
+        Keep(F, i, u, v, u - F.mbf*(1.0f/PcZ), depth, dist, viewCos);
+    }
+
+    return static_cast<int>(mvpVisible.size());
+}
+
+void LocalMapProjection::Keep(const Frame& F, std::size_t i, float u, float v, float uR, float depth, float dist, float viewCos)
+{
+    MapPoint* pMP = mvpPoints[i];
+    if(pMP->mnLastFrameSeen == F.mnId)
+        return;
+    if(pMP->isBad())
+        return;
+
+    // Predict scale in the image, as MapPoint::PredictScale()
+    const float ratio = mvScaleDistance[i]/dist;
+    int nScale = ceil(log(ratio)/F.mfLogScaleFactor);
+    if(nScale<0)
+        nScale = 0;
+    else if(nScale>=F.mnScaleLevels)
+        nScale = F.mnScaleLevels-1;
+
+    mvpVisible.push_back(pMP);
+    mvProjX.push_back(u);
+    mvProjY.push_back(v);
+    mvProjXR.push_back(uR);
+    mvDepth.push_back(depth);
+    mvViewCos.push_back(viewCos);
+    mvLevel.push_back(nScale);
+}
+
+} //namespace ORB_SLAM3
@@ -308,7 +308,7 @@ void Atlas::PreSave()
         if(!pMi || pMi->IsBad())
             continue;
 
-        if(pMi->GetAllKeyFrames().size() == 0) {
+        if(pMi->KeyFramesInMap() == 0) {
             // Empty map, erase before of save it.
             SetMapBad(pMi);
             continue;
@@ -332,8 +332,8 @@ void Atlas::PostLoad()
     {
         mspMaps.insert(pMi);
         pMi->PostLoad(mpKeyFrameDB, mpORBVocabulary, mpCams);
-        numKF += pMi->GetAllKeyFrames().size();
-        numMP += pMi->GetAllMapPoints().size();
+        numKF += pMi->KeyFramesInMap();
+        numMP += pMi->MapPointsInMap();
     }
     mvpBackupMaps.clear();
 }
@@ -364,7 +364,7 @@ long unsigned int Atlas::GetNumLivedKF()
     long unsigned int num = 0;
     for(Map* pMap_i : mspMaps)
     {
-        num += pMap_i->GetAllKeyFrames().size();
+        num += pMap_i->KeyFramesInMap();
     }
 
     return num;
@@ -374,7 +374,7 @@ long unsigned int Atlas::GetNumLivedMP() {
     unique_lock<mutex> lock(mMutexAtlas);
     long unsigned int num = 0;
     for (Map* pMap_i : mspMaps) {
-        num += pMap_i->GetAllMapPoints().size();
+        num += pMap_i->MapPointsInMap();
     }
 
     return num;
@@ -44,10 +44,10 @@ Map::Map(int initKFid):mnInitKFid(initKFid), mnMaxKFid(initKFid),/*mnLastLoopKFi
 Map::~Map()
 {
     //TODO: erase all points from memory
-    mspMapPoints.clear();
+    mMapPoints.Clear();
 
     //TODO: erase all keyframes from memory
-    mspKeyFrames.clear();
+    mKeyFrames.Clear();
 
     if(mThumbnail)
         delete mThumbnail;
@@ -60,13 +60,13 @@ Map::~Map()
 void Map::AddKeyFrame(KeyFrame *pKF)
 {
     unique_lock<mutex> lock(mMutexMap);
-    if(mspKeyFrames.empty()){
+    if(mKeyFrames.Empty()){
         cout << "First KF:" << pKF->mnId << "; Map init KF:" << mnInitKFid << endl;
         mnInitKFid = pKF->mnId;
         mpKFinitial = pKF;
         mpKFlowerID = pKF;
     }
-    mspKeyFrames.insert(pKF);
+    mKeyFrames.Insert(pKF);
     if(pKF->mnId>mnMaxKFid)
     {
         mnMaxKFid=pKF->mnId;
@@ -80,7 +80,7 @@ void Map::AddKeyFrame(KeyFrame *pKF)
 void Map::AddMapPoint(MapPoint *pMP)
 {
     unique_lock<mutex> lock(mMutexMap);
-    mspMapPoints.insert(pMP);
+    mMapPoints.Insert(pMP);
 }
 
 void Map::SetImuInitialized()
@@ -98,7 +98,7 @@ bool Map::isImuInitialized()
 void Map::EraseMapPoint(MapPoint *pMP)
 {
     unique_lock<mutex> lock(mMutexMap);
-    mspMapPoints.erase(pMP);
+    mMapPoints.Erase(pMP);
 
     // TODO: This only erase the pointer.
     // Delete the MapPoint
@@ -107,14 +107,13 @@ void Map::EraseMapPoint(MapPoint *pMP)
 void Map::EraseKeyFrame(KeyFrame *pKF)
 {
     unique_lock<mutex> lock(mMutexMap);
-    mspKeyFrames.erase(pKF);
-    if(mspKeyFrames.size()>0)
+    mKeyFrames.Erase(pKF);
+    if(!mKeyFrames.Empty())
     {
         if(pKF->mnId == mpKFlowerID->mnId)
         {
-            vector<KeyFrame*> vpKFs = vector<KeyFrame*>(mspKeyFrames.begin(),mspKeyFrames.end());
-            sort(vpKFs.begin(),vpKFs.end(),KeyFrame::lId);
-            mpKFlowerID = vpKFs[0];
+            const vector<KeyFrame*>& vpKFs = mKeyFrames.Elements();
+            mpKFlowerID = *min_element(vpKFs.begin(),vpKFs.end(),KeyFrame::lId);
         }
     }
     else
@@ -147,25 +146,37 @@ int Map::GetLastBigChangeIdx()
 vector<KeyFrame*> Map::GetAllKeyFrames()
 {
     unique_lock<mutex> lock(mMutexMap);
-    return vector<KeyFrame*>(mspKeyFrames.begin(),mspKeyFrames.end());
+    return mKeyFrames.Elements();
 }
 
 vector<MapPoint*> Map::GetAllMapPoints()
 {
     unique_lock<mutex> lock(mMutexMap);
-    return vector<MapPoint*>(mspMapPoints.begin(),mspMapPoints.end());
+    return mMapPoints.Elements();
+}
+
+SlotMap<KeyFrame>::Snapshot Map::GetKeyFrameSnapshot()
+{
+    unique_lock<mutex> lock(mMutexMap);
+    return mKeyFrames.GetSnapshot();
+}
+
+SlotMap<MapPoint>::Snapshot Map::GetMapPointSnapshot()
+{
+    unique_lock<mutex> lock(mMutexMap);
+    return mMapPoints.GetSnapshot();
 }
 
 long unsigned int Map::MapPointsInMap()
 {
     unique_lock<mutex> lock(mMutexMap);
-    return mspMapPoints.size();
+    return mMapPoints.Size();
 }
 
 long unsigned int Map::KeyFramesInMap()
 {
     unique_lock<mutex> lock(mMutexMap);
-    return mspKeyFrames.size();
+    return mKeyFrames.Size();
 }
 
 vector<MapPoint*> Map::GetReferenceMapPoints()
@@ -213,18 +224,17 @@ void Map::SetStoredMap()
 
 void Map::clear()
 {
-//    for(set<MapPoint*>::iterator sit=mspMapPoints.begin(), send=mspMapPoints.end(); sit!=send; sit++)
-//        delete *sit;
+//    for(MapPoint* pMP : mMapPoints.Elements())
+//        delete pMP;
 
-    for(set<KeyFrame*>::iterator sit=mspKeyFrames.begin(), send=mspKeyFrames.end(); sit!=send; sit++)
+    for(KeyFrame* pKF : mKeyFrames.Elements())
     {
-        KeyFrame* pKF = *sit;
         pKF->UpdateMap(static_cast<Map*>(NULL));
-//        delete *sit;
+//        delete pKF;
     }
 
-    mspMapPoints.clear();
-    mspKeyFrames.clear();
+    mMapPoints.Clear();
+    mKeyFrames.Clear();
     mnMaxKFid = mnInitKFid;
     mbImuInitialized = false;
     mvpReferenceMapPoints.clear();
@@ -258,9 +268,8 @@ void Map::ApplyScaledRotation(const Sophus::SE3f &T, const float s, const bool b
     Eigen::Matrix3f Ryw = Tyw.rotationMatrix();
     Eigen::Vector3f tyw = Tyw.translation();
 
-    for(set<KeyFrame*>::iterator sit=mspKeyFrames.begin(); sit!=mspKeyFrames.end(); sit++)
+    for(KeyFrame* pKF : mKeyFrames.Elements())
     {
-        KeyFrame* pKF = *sit;
         Sophus::SE3f Twc = pKF->GetPoseInverse();
         Twc.translation() *= s;
         Sophus::SE3f Tyc = Tyw*Twc;
@@ -273,9 +282,8 @@ void Map::ApplyScaledRotation(const Sophus::SE3f &T, const float s, const bool b
             pKF->SetVelocity(Ryw*Vw*s);
 
     }
-    for(set<MapPoint*>::iterator sit=mspMapPoints.begin(); sit!=mspMapPoints.end(); sit++)
+    for(MapPoint* pMP : mMapPoints.Elements())
     {
-        MapPoint* pMP = *sit;
         pMP->SetWorldPos(s * Ryw * pMP->GetWorldPos() + tyw);
         pMP->UpdateNormalAndDepth();
     }
@@ -358,8 +366,10 @@ void Map::SetLastMapChange(int currentChangeId)
 
 void Map::PreSave(std::set<GeometricCamera*> &spCams)
 {
+    // Erasing observations can set points bad and erase them from the map, iterate copies
+    vector<MapPoint*> vpMapPoints = GetAllMapPoints();
     int nMPWithoutObs = 0;
-    for(MapPoint* pMPi : mspMapPoints)
+    for(MapPoint* pMPi : vpMapPoints)
     {
         if(!pMPi || pMPi->isBad())
             continue;
@@ -368,12 +378,12 @@ void Map::PreSave(std::set<GeometricCamera*> &spCams)
         {
             nMPWithoutObs++;
         }
-        map<KeyFrame*, std::tuple<int,int>> mpObs = pMPi->GetObservations();
-        for(map<KeyFrame*, std::tuple<int,int>>::iterator it= mpObs.begin(), end=mpObs.end(); it!=end; ++it)
+        ObservationList mpObs = pMPi->GetObservations();
+        for(ObservationList::iterator it= mpObs.begin(), end=mpObs.end(); it!=end; ++it)
         {
-            if(it->first->GetMap() != this || it->first->isBad())
+            if(it->pKF->GetMap() != this || it->pKF->isBad())
             {
-                pMPi->EraseObservation(it->first);
+                pMPi->EraseObservation(it->pKF);
             }
 
         }
@@ -388,26 +398,31 @@ void Map::PreSave(std::set<GeometricCamera*> &spCams)
     }
 
 
+    vpMapPoints = GetAllMapPoints();
+    const vector<KeyFrame*> vpKeyFrames = GetAllKeyFrames();
+    set<MapPoint*> spMapPoints(vpMapPoints.begin(), vpMapPoints.end());
+    set<KeyFrame*> spKeyFrames(vpKeyFrames.begin(), vpKeyFrames.end());
+
     // Backup of MapPoints
     mvpBackupMapPoints.clear();
-    for(MapPoint* pMPi : mspMapPoints)
+    for(MapPoint* pMPi : vpMapPoints)
     {
         if(!pMPi || pMPi->isBad())
             continue;
 
         mvpBackupMapPoints.push_back(pMPi);
-        pMPi->PreSave(mspKeyFrames,mspMapPoints);
+        pMPi->PreSave(spKeyFrames,spMapPoints);
     }
 
     // Backup of KeyFrames
     mvpBackupKeyFrames.clear();
-    for(KeyFrame* pKFi : mspKeyFrames)
+    for(KeyFrame* pKFi : vpKeyFrames)
     {
         if(!pKFi || pKFi->isBad())
             continue;
 
         mvpBackupKeyFrames.push_back(pKFi);
-        pKFi->PreSave(mspKeyFrames,mspMapPoints, spCams);
+        pKFi->PreSave(spKeyFrames,spMapPoints, spCams);
     }
 
     mnBackupKFinitialID = -1;
@@ -426,11 +441,13 @@ void Map::PreSave(std::set<GeometricCamera*> &spCams)
 
 void Map::PostLoad(KeyFrameDatabase* pKFDB, ORBVocabulary* pORBVoc/*, map<long unsigned int, KeyFrame*>& mpKeyFrameId*/, map<unsigned int, GeometricCamera*> &mpCams)
 {
-    std::copy(mvpBackupMapPoints.begin(), mvpBackupMapPoints.end(), std::inserter(mspMapPoints, mspMapPoints.begin()));
-    std::copy(mvpBackupKeyFrames.begin(), mvpBackupKeyFrames.end(), std::inserter(mspKeyFrames, mspKeyFrames.begin()));
+    for(MapPoint* pMPi : mvpBackupMapPoints)
+        mMapPoints.Insert(pMPi);
+    for(KeyFrame* pKFi : mvpBackupKeyFrames)
+        mKeyFrames.Insert(pKFi);
 
     map<long unsigned int,MapPoint*> mpMapPointId;
-    for(MapPoint* pMPi : mspMapPoints)
+    for(MapPoint* pMPi : mMapPoints.Elements())
     {
         if(!pMPi || pMPi->isBad())
             continue;
@@ -440,7 +457,7 @@ void Map::PostLoad(KeyFrameDatabase* pKFDB, ORBVocabulary* pORBVoc/*, map<long u
     }
 
     map<long unsigned int, KeyFrame*> mpKeyFrameId;
-    for(KeyFrame* pKFi : mspKeyFrames)
+    for(KeyFrame* pKFi : mKeyFrames.Elements())
     {
         if(!pKFi || pKFi->isBad())
             continue;
@@ -452,7 +469,7 @@ void Map::PostLoad(KeyFrameDatabase* pKFDB, ORBVocabulary* pORBVoc/*, map<long u
     }
 
     // References reconstruction between different instances
-    for(MapPoint* pMPi : mspMapPoints)
+    for(MapPoint* pMPi : mMapPoints.Elements())
     {
         if(!pMPi || pMPi->isBad())
             continue;
@@ -460,7 +477,7 @@ void Map::PostLoad(KeyFrameDatabase* pKFDB, ORBVocabulary* pORBVoc/*, map<long u
         pMPi->PostLoad(mpKeyFrameId, mpMapPointId);
     }
 
-    for(KeyFrame* pKFi : mspKeyFrames)
+    for(KeyFrame* pKFi : mKeyFrames.Elements())
     {
         if(!pKFi || pKFi->isBad())
             continue;
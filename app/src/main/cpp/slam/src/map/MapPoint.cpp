@@ -18,14 +18,47 @@
 
 #include "map/MapPoint.h"
 
+#include <cstring>
+
 #include "map/Map.h"
+#include "map/Reclaimer.h"
 #include "feature/ORBmatcher.h"
 
 namespace ORB_SLAM3
 {
 
+namespace
+{
+
+// Key frames sharing the point with one that gains or loses it, gathered under the feature lock and counted
+// once it is released
+thread_local vector<KeyFrame*> tvpShared;
+
+void AddShared(KeyFrame* pKF, const vector<KeyFrame*>& vpKFs, int n)
+{
+    for(KeyFrame* pKFi : vpKFs)
+    {
+        pKF->AddSharedMapPoints(pKFi,n);
+        pKFi->AddSharedMapPoints(pKF,n);
+    }
+}
+
+// Counts the point n times between every two key frames observing it
+void AddSharedAll(const ObservationList& obs, int n)
+{
+    for(const Observation& a : obs)
+    {
+        for(const Observation& b : obs)
+        {
+            if(a.pKF!=b.pKF)
+                a.pKF->AddSharedMapPoints(b.pKF,n);
+        }
+    }
+}
+
+} // namespace
+
 long unsigned int MapPoint::nNextId=0;
-mutex MapPoint::mGlobalMutex;
 
 MapPoint::MapPoint():
     mnFirstKFid(0), mnFirstFrame(0), nObs(0), mnTrackReferenceForFrame(0),
@@ -34,32 +67,34 @@ MapPoint::MapPoint():
     mpReplaced(static_cast<MapPoint*>(NULL))
 {
     mpReplaced = static_cast<MapPoint*>(NULL);
+
+    Reclaimer::AddMapPoint();
 }
 
 MapPoint::MapPoint(const Eigen::Vector3f &Pos, KeyFrame *pRefKF, Map* pMap):
     mnFirstKFid(pRefKF->mnId), mnFirstFrame(pRefKF->mnFrameId), nObs(0), mnTrackReferenceForFrame(0),
     mnLastFrameSeen(0), mnBALocalForKF(0), mnFuseCandidateForKF(0), mnLoopPointForKF(0), mnCorrectedByKF(0),
     mnCorrectedReference(0), mnBAGlobalForKF(0), mpRefKF(pRefKF), mnVisible(1), mnFound(1), mbBad(false),
-    mpReplaced(static_cast<MapPoint*>(NULL)), mfMinDistance(0), mfMaxDistance(0), mpMap(pMap),
+    mpReplaced(static_cast<MapPoint*>(NULL)), mpMap(pMap),
     mnOriginMapId(pMap->GetId())
 {
     SetWorldPos(Pos);
 
-    mNormalVector.setZero();
-
     mbTrackInViewR = false;
     mbTrackInView = false;
 
     // MapPoints can be created from Tracking and Local Mapping. This mutex avoid conflicts with id.
     unique_lock<mutex> lock(mpMap->mMutexPointCreation);
     mnId=nNextId++;
+
+    Reclaimer::AddMapPoint();
 }
 
 MapPoint::MapPoint(const double invDepth, cv::Point2f uv_init, KeyFrame* pRefKF, KeyFrame* pHostKF, Map* pMap):
     mnFirstKFid(pRefKF->mnId), mnFirstFrame(pRefKF->mnFrameId), nObs(0), mnTrackReferenceForFrame(0),
     mnLastFrameSeen(0), mnBALocalForKF(0), mnFuseCandidateForKF(0), mnLoopPointForKF(0), mnCorrectedByKF(0),
     mnCorrectedReference(0), mnBAGlobalForKF(0), mpRefKF(pRefKF), mnVisible(1), mnFound(1), mbBad(false),
-    mpReplaced(static_cast<MapPoint*>(NULL)), mfMinDistance(0), mfMaxDistance(0), mpMap(pMap),
+    mpReplaced(static_cast<MapPoint*>(NULL)), mpMap(pMap),
     mnOriginMapId(pMap->GetId())
 {
     mInvDepth=invDepth;
@@ -67,12 +102,12 @@ MapPoint::MapPoint(const double invDepth, cv::Point2f uv_init, KeyFrame* pRefKF,
     mInitV=(double)uv_init.y;
     mpHostKF = pHostKF;
 
-    mNormalVector.setZero();
-
     // Worldpos is not set
     // MapPoints can be created from Tracking and Local Mapping. This mutex avoid conflicts with id.
     unique_lock<mutex> lock(mpMap->mMutexPointCreation);
     mnId=nNextId++;
+
+    Reclaimer::AddMapPoint();
 }
 
 MapPoint::MapPoint(const Eigen::Vector3f &Pos, Map* pMap, Frame* pFrame, const int &idxF):
@@ -81,8 +116,6 @@ MapPoint::MapPoint(const Eigen::Vector3f &Pos, Map* pMap, Frame* pFrame, const i
     mnCorrectedReference(0), mnBAGlobalForKF(0), mpRefKF(static_cast<KeyFrame*>(NULL)), mnVisible(1),
     mnFound(1), mbBad(false), mpReplaced(NULL), mpMap(pMap), mnOriginMapId(pMap->GetId())
 {
-    SetWorldPos(Pos);
-
     Eigen::Vector3f Ow;
     if(pFrame -> Nleft == -1 || idxF < pFrame -> Nleft){
         Ow = pFrame->GetCameraCenter();
@@ -94,10 +127,10 @@ MapPoint::MapPoint(const Eigen::Vector3f &Pos, Map* pMap, Frame* pFrame, const i
 
         Ow = Rwl * tlr + twl;
     }
-    mNormalVector = mWorldPos - Ow;
-    mNormalVector = mNormalVector / mNormalVector.norm();
+    Eigen::Vector3f normal = Pos - Ow;
+    normal = normal / normal.norm();
 
-    Eigen::Vector3f PC = mWorldPos - Ow;
+    Eigen::Vector3f PC = Pos - Ow;
     const float dist = PC.norm();
     const int level = (pFrame -> Nleft == -1) ? pFrame->mvKeysUn[idxF].octave
                                               : (idxF < pFrame -> Nleft) ? pFrame->mvKeys[idxF].octave
@@ -105,30 +138,51 @@ MapPoint::MapPoint(const Eigen::Vector3f &Pos, Map* pMap, Frame* pFrame, const i
     const float levelScaleFactor =  pFrame->mvScaleFactors[level];
     const int nLevels = pFrame->mnScaleLevels;
 
-    mfMaxDistance = dist*levelScaleFactor;
-    mfMinDistance = mfMaxDistance/pFrame->mvScaleFactors[nLevels-1];
+    Geometry geometry;
+    Eigen::Vector3f::Map(geometry.Pos) = Pos;
+    Eigen::Vector3f::Map(geometry.Normal) = normal;
+    geometry.fMaxDistance = dist*levelScaleFactor;
+    geometry.fMinDistance = geometry.fMaxDistance/pFrame->mvScaleFactors[nLevels-1];
+    mGeometry.Store(geometry);
 
-    pFrame->mDescriptors.row(idxF).copyTo(mDescriptor);
+    mDescriptor = pFrame->mDescriptors[idxF];
 
     // MapPoints can be created from Tracking and Local Mapping. This mutex avoid conflicts with id.
     unique_lock<mutex> lock(mpMap->mMutexPointCreation);
     mnId=nNextId++;
+
+    Reclaimer::AddMapPoint();
+}
+
+MapPoint::~MapPoint()
+{
+    Reclaimer::RemoveMapPoint(mbBad);
 }
 
 void MapPoint::SetWorldPos(const Eigen::Vector3f &Pos) {
-    unique_lock<mutex> lock2(mGlobalMutex);
     unique_lock<mutex> lock(mMutexPos);
-    mWorldPos = Pos;
+    Geometry geometry = mGeometry.Load();
+    Eigen::Vector3f::Map(geometry.Pos) = Pos;
+    mGeometry.Store(geometry);
 }
 
 Eigen::Vector3f MapPoint::GetWorldPos() {
-    unique_lock<mutex> lock(mMutexPos);
-    return mWorldPos;
+    const Geometry geometry = mGeometry.Load();
+    return Eigen::Vector3f::Map(geometry.Pos);
 }
 
 Eigen::Vector3f MapPoint::GetNormal() {
-    unique_lock<mutex> lock(mMutexPos);
-    return mNormalVector;
+    const Geometry geometry = mGeometry.Load();
+    return Eigen::Vector3f::Map(geometry.Normal);
+}
+
+void MapPoint::GetProjectionData(Eigen::Vector3f &Pos, Eigen::Vector3f &Normal, float &fMinDistance, float &fMaxDistance)
+{
+    const Geometry geometry = mGeometry.Load();
+    Pos = Eigen::Vector3f::Map(geometry.Pos);
+    Normal = Eigen::Vector3f::Map(geometry.Normal);
+    fMinDistance = geometry.fMinDistance;
+    fMaxDistance = geometry.fMaxDistance;
 }
 
 
@@ -140,29 +194,36 @@ KeyFrame* MapPoint::GetReferenceKeyFrame()
 
 void MapPoint::AddObservation(KeyFrame* pKF, int idx)
 {
-    unique_lock<mutex> lock(mMutexFeatures);
-    tuple<int,int> indexes;
+    tvpShared.clear();
+    {
+        unique_lock<mutex> lock(mMutexFeatures);
+        const size_t nKFs = mObservations.size();
+        Observation& obs = mObservations.Get(pKF);
 
-    if(mObservations.count(pKF)){
-        indexes = mObservations[pKF];
-    }
-    else{
-        indexes = tuple<int,int>(-1,-1);
-    }
+        if(pKF -> NLeft != -1 && idx >= pKF -> NLeft){
+            obs.nRight = idx;
+        }
+        else{
+            obs.nLeft = idx;
+        }
 
-    if(pKF -> NLeft != -1 && idx >= pKF -> NLeft){
-        get<1>(indexes) = idx;
-    }
-    else{
-        get<0>(indexes) = idx;
-    }
+        if(!pKF->mpCamera2 && pKF->mvuRight[idx]>=0)
+            nObs+=2;
+        else
+            nObs++;
 
-    mObservations[pKF]=indexes;
+        // A new key frame of a good point shares it with the others, a bad one is shared by none
+        if(!mbBad && mObservations.size()>nKFs)
+        {
+            for(const Observation& obsi : mObservations)
+            {
+                if(obsi.pKF!=pKF)
+                    tvpShared.push_back(obsi.pKF);
+            }
+        }
+    }
 
-    if(!pKF->mpCamera2 && pKF->mvuRight[idx]>=0)
-        nObs+=2;
-    else
-        nObs++;
+    AddShared(pKF,tvpShared,1);
 }
 
 void MapPoint::EraseObservation(KeyFrame* pKF)
@@ -170,10 +231,9 @@ void MapPoint::EraseObservation(KeyFrame* pKF)
     bool bBad=false;
     {
         unique_lock<mutex> lock(mMutexFeatures);
-        if(mObservations.count(pKF))
+        if(const Observation* pObs = mObservations.Find(pKF))
         {
-            tuple<int,int> indexes = mObservations[pKF];
-            int leftIndex = get<0>(indexes), rightIndex = get<1>(indexes);
+            int leftIndex = pObs->nLeft, rightIndex = pObs->nRight;
 
             if(leftIndex != -1){
                 if(!pKF->mpCamera2 && pKF->mvuRight[leftIndex]>=0)
@@ -185,23 +245,34 @@ void MapPoint::EraseObservation(KeyFrame* pKF)
                 nObs--;
             }
 
-            mObservations.erase(pKF);
+            mObservations.Erase(pKF);
+
+            tvpShared.clear();
+            if(!mbBad)
+            {
+                for(const Observation& obs : mObservations)
+                    tvpShared.push_back(obs.pKF);
+            }
 
-            if(mpRefKF==pKF)
-                mpRefKF=mObservations.begin()->first;
+            if(mpRefKF==pKF && !mObservations.empty())
+                mpRefKF=mObservations.front().pKF;
 
             // If only 2 observations or less, discard point
             if(nObs<=2)
                 bBad=true;
         }
+        else
+            return;
     }
 
+    AddShared(pKF,tvpShared,-1);
+
     if(bBad)
         SetBadFlag();
 }
 
 
-std::map<KeyFrame*, std::tuple<int,int>>  MapPoint::GetObservations()
+ObservationList MapPoint::GetObservations()
 {
     unique_lock<mutex> lock(mMutexFeatures);
     return mObservations;
@@ -215,18 +286,24 @@ int MapPoint::Observations()
 
 void MapPoint::SetBadFlag()
 {
-    map<KeyFrame*, tuple<int,int>> obs;
+    ObservationList obs;
+    bool bWasBad;
     {
         unique_lock<mutex> lock1(mMutexFeatures);
         unique_lock<mutex> lock2(mMutexPos);
+        bWasBad = mbBad;
+        if(!mbBad)
+            Reclaimer::SetMapPointBad();
         mbBad=true;
-        obs = mObservations;
+        obs = std::move(mObservations);
         mObservations.clear();
     }
-    for(map<KeyFrame*, tuple<int,int>>::iterator mit=obs.begin(), mend=obs.end(); mit!=mend; mit++)
+    if(!bWasBad)
+        AddSharedAll(obs,-1);
+    for(const Observation& ob : obs)
     {
-        KeyFrame* pKF = mit->first;
-        int leftIndex = get<0>(mit -> second), rightIndex = get<1>(mit -> second);
+        KeyFrame* pKF = ob.pKF;
+        int leftIndex = ob.nLeft, rightIndex = ob.nRight;
         if(leftIndex != -1){
             pKF->EraseMapPointMatch(leftIndex);
         }
@@ -251,25 +328,31 @@ void MapPoint::Replace(MapPoint* pMP)
         return;
 
     int nvisible, nfound;
-    map<KeyFrame*,tuple<int,int>> obs;
+    ObservationList obs;
+    bool bWasBad;
     {
         unique_lock<mutex> lock1(mMutexFeatures);
         unique_lock<mutex> lock2(mMutexPos);
-        obs=mObservations;
+        obs=std::move(mObservations);
         mObservations.clear();
+        bWasBad = mbBad;
+        if(!mbBad)
+            Reclaimer::SetMapPointBad();
         mbBad=true;
         nvisible = mnVisible;
         nfound = mnFound;
         mpReplaced = pMP;
     }
+    // The observations moved to pMP are counted again as it gains them
+    if(!bWasBad)
+        AddSharedAll(obs,-1);
 
-    for(map<KeyFrame*,tuple<int,int>>::iterator mit=obs.begin(), mend=obs.end(); mit!=mend; mit++)
+    for(const Observation& ob : obs)
     {
         // Replace measurement in keyframe
-        KeyFrame* pKF = mit->first;
+        KeyFrame* pKF = ob.pKF;
 
-        tuple<int,int> indexes = mit -> second;
-        int leftIndex = get<0>(indexes), rightIndex = get<1>(indexes);
+        int leftIndex = ob.nLeft, rightIndex = ob.nRight;
 
         if(!pMP->IsInKeyFrame(pKF))
         {
@@ -329,9 +412,9 @@ float MapPoint::GetFoundRatio()
 void MapPoint::ComputeDistinctiveDescriptors()
 {
     // Retrieve all observed descriptors
-    vector<cv::Mat> vDescriptors;
+    vector<const unsigned char*> vDescriptors;
 
-    map<KeyFrame*,tuple<int,int>> observations;
+    ObservationList observations;
 
     {
         unique_lock<mutex> lock1(mMutexFeatures);
@@ -345,19 +428,18 @@ void MapPoint::ComputeDistinctiveDescriptors()
 
     vDescriptors.reserve(observations.size());
 
-    for(map<KeyFrame*,tuple<int,int>>::iterator mit=observations.begin(), mend=observations.end(); mit!=mend; mit++)
+    for(const Observation& obs : observations)
     {
-        KeyFrame* pKF = mit->first;
+        KeyFrame* pKF = obs.pKF;
 
         if(!pKF->isBad()){
-            tuple<int,int> indexes = mit -> second;
-            int leftIndex = get<0>(indexes), rightIndex = get<1>(indexes);
+            int leftIndex = obs.nLeft, rightIndex = obs.nRight;
 
             if(leftIndex != -1){
-                vDescriptors.push_back(pKF->mDescriptors.row(leftIndex));
+                vDescriptors.push_back(pKF->mDescriptors.Row(leftIndex));
             }
             if(rightIndex != -1){
-                vDescriptors.push_back(pKF->mDescriptors.row(rightIndex));
+                vDescriptors.push_back(pKF->mDescriptors.Row(rightIndex));
             }
         }
     }
@@ -398,21 +480,21 @@ void MapPoint::ComputeDistinctiveDescriptors()
 
     {
         unique_lock<mutex> lock(mMutexFeatures);
-        mDescriptor = vDescriptors[BestIdx].clone();
+        memcpy(mDescriptor.data, vDescriptors[BestIdx], PackedDescriptor::L);
     }
 }
 
-cv::Mat MapPoint::GetDescriptor()
+PackedDescriptor MapPoint::GetDescriptor()
 {
     unique_lock<mutex> lock(mMutexFeatures);
-    return mDescriptor.clone();
+    return mDescriptor;
 }
 
 tuple<int,int> MapPoint::GetIndexInKeyFrame(KeyFrame *pKF)
 {
     unique_lock<mutex> lock(mMutexFeatures);
-    if(mObservations.count(pKF))
-        return mObservations[pKF];
+    if(const Observation* pObs = mObservations.Find(pKF))
+        return tuple<int,int>(pObs->nLeft,pObs->nRight);
     else
         return tuple<int,int>(-1,-1);
 }
@@ -420,12 +502,12 @@ tuple<int,int> MapPoint::GetIndexInKeyFrame(KeyFrame *pKF)
 bool MapPoint::IsInKeyFrame(KeyFrame *pKF)
 {
     unique_lock<mutex> lock(mMutexFeatures);
-    return (mObservations.count(pKF));
+    return mObservations.Find(pKF)!=NULL;
 }
 
 void MapPoint::UpdateNormalAndDepth()
 {
-    map<KeyFrame*,tuple<int,int>> observations;
+    ObservationList observations;
     KeyFrame* pRefKF;
     Eigen::Vector3f Pos;
     {
@@ -435,7 +517,7 @@ void MapPoint::UpdateNormalAndDepth()
             return;
         observations = mObservations;
         pRefKF = mpRefKF;
-        Pos = mWorldPos;
+        Pos = Eigen::Vector3f::Map(mGeometry.Load().Pos);
     }
 
     if(observations.empty())
@@ -444,12 +526,11 @@ void MapPoint::UpdateNormalAndDepth()
     Eigen::Vector3f normal;
     normal.setZero();
     int n=0;
-    for(map<KeyFrame*,tuple<int,int>>::iterator mit=observations.begin(), mend=observations.end(); mit!=mend; mit++)
+    for(const Observation& obs : observations)
     {
-        KeyFrame* pKF = mit->first;
+        KeyFrame* pKF = obs.pKF;
 
-        tuple<int,int> indexes = mit -> second;
-        int leftIndex = get<0>(indexes), rightIndex = get<1>(indexes);
+        int leftIndex = obs.nLeft, rightIndex = obs.nRight;
 
         if(leftIndex != -1){
             Eigen::Vector3f Owi = pKF->GetCameraCenter();
@@ -468,8 +549,9 @@ void MapPoint::UpdateNormalAndDepth()
     Eigen::Vector3f PC = Pos - pRefKF->GetCameraCenter();
     const float dist = PC.norm();
 
-    tuple<int ,int> indexes = observations[pRefKF];
-    int leftIndex = get<0>(indexes), rightIndex = get<1>(indexes);
+    // As the std::map lookup did, an observation missing from the copy reads as index 0
+    const Observation* pRefObs = observations.Find(pRefKF);
+    int leftIndex = pRefObs ? pRefObs->nLeft : 0, rightIndex = pRefObs ? pRefObs->nRight : 0;
     int level;
     if(pRefKF -> NLeft == -1){
         level = pRefKF->mvKeysUn[leftIndex].octave;
@@ -487,37 +569,35 @@ void MapPoint::UpdateNormalAndDepth()
 
     {
         unique_lock<mutex> lock3(mMutexPos);
-        mfMaxDistance = dist*levelScaleFactor;
-        mfMinDistance = mfMaxDistance/pRefKF->mvScaleFactors[nLevels-1];
-        mNormalVector = normal/n;
+        Geometry geometry = mGeometry.Load();
+        geometry.fMaxDistance = dist*levelScaleFactor;
+        geometry.fMinDistance = geometry.fMaxDistance/pRefKF->mvScaleFactors[nLevels-1];
+        Eigen::Vector3f::Map(geometry.Normal) = normal/n;
+        mGeometry.Store(geometry);
     }
 }
 
 void MapPoint::SetNormalVector(const Eigen::Vector3f& normal)
 {
     unique_lock<mutex> lock3(mMutexPos);
-    mNormalVector = normal;
+    Geometry geometry = mGeometry.Load();
+    Eigen::Vector3f::Map(geometry.Normal) = normal;
+    mGeometry.Store(geometry);
 }
 
 float MapPoint::GetMinDistanceInvariance()
 {
-    unique_lock<mutex> lock(mMutexPos);
-    return 0.8f * mfMinDistance;
+    return 0.8f * mGeometry.Load().fMinDistance;
 }
 
 float MapPoint::GetMaxDistanceInvariance()
 {
-    unique_lock<mutex> lock(mMutexPos);
-    return 1.2f * mfMaxDistance;
+    return 1.2f * mGeometry.Load().fMaxDistance;
 }
 
 int MapPoint::PredictScale(const float &currentDist, KeyFrame* pKF)
 {
-    float ratio;
-    {
-        unique_lock<mutex> lock(mMutexPos);
-        ratio = mfMaxDistance/currentDist;
-    }
+    const float ratio = mGeometry.Load().fMaxDistance/currentDist;
 
     int nScale = ceil(log(ratio)/pKF->mfLogScaleFactor);
     if(nScale<0)
@@ -530,11 +610,7 @@ int MapPoint::PredictScale(const float &currentDist, KeyFrame* pKF)
 
 int MapPoint::PredictScale(const float &currentDist, Frame* pF)
 {
-    float ratio;
-    {
-        unique_lock<mutex> lock(mMutexPos);
-        ratio = mfMaxDistance/currentDist;
-    }
+    const float ratio = mGeometry.Load().fMaxDistance/currentDist;
 
     int nScale = ceil(log(ratio)/pF->mfLogScaleFactor);
     if(nScale<0)
@@ -548,11 +624,9 @@ int MapPoint::PredictScale(const float &currentDist, Frame* pF)
 void MapPoint::PrintObservations()
 {
     cout << "MP_OBS: MP " << mnId << endl;
-    for(map<KeyFrame*,tuple<int,int>>::iterator mit=mObservations.begin(), mend=mObservations.end(); mit!=mend; mit++)
+    for(const Observation& obs : mObservations)
     {
-        KeyFrame* pKFi = mit->first;
-        tuple<int,int> indexes = mit->second;
-        int leftIndex = get<0>(indexes), rightIndex = get<1>(indexes);
+        KeyFrame* pKFi = obs.pKF;
         cout << "--OBS in KF " << pKFi->mnId << " in map " << pKFi->GetMap()->GetId() << endl;
     }
 }
@@ -577,14 +651,15 @@ void MapPoint::PreSave(set<KeyFrame*>& spKF,set<MapPoint*>& spMP)
 
     mBackupObservationsId1.clear();
     mBackupObservationsId2.clear();
-    // Save the id and position in each KF who view it
-    for(std::map<KeyFrame*,std::tuple<int,int> >::const_iterator it = mObservations.begin(), end = mObservations.end(); it != end; ++it)
+    // Save the id and position in each KF who view it. Iterates a copy, EraseObservation changes the list.
+    const ObservationList observations = GetObservations();
+    for(const Observation& obs : observations)
     {
-        KeyFrame* pKFi = it->first;
+        KeyFrame* pKFi = obs.pKF;
         if(spKF.find(pKFi) != spKF.end())
         {
-            mBackupObservationsId1[it->first->mnId] = get<0>(it->second);
-            mBackupObservationsId2[it->first->mnId] = get<1>(it->second);
+            mBackupObservationsId1[pKFi->mnId] = obs.nLeft;
+            mBackupObservationsId2[pKFi->mnId] = obs.nRight;
         }
         else
         {
@@ -620,13 +695,18 @@ void MapPoint::PostLoad(map<long unsigned int, KeyFrame*>& mpKFid, map<long unsi
     {
         KeyFrame* pKFi = mpKFid[it->first];
         map<long unsigned int, int>::const_iterator it2 = mBackupObservationsId2.find(it->first);
-        std::tuple<int, int> indexes = tuple<int,int>(it->second,it2->second);
         if(pKFi)
         {
-           mObservations[pKFi] = indexes;
+           Observation& obs = mObservations.Get(pKFi);
+           obs.nLeft = it->second;
+           obs.nRight = it2->second;
         }
     }
 
+    // The shared map point counts of the key frames are not saved
+    if(!mbBad)
+        AddSharedAll(mObservations,1);
+
     mBackupObservationsId1.clear();
     mBackupObservationsId2.clear();
 }
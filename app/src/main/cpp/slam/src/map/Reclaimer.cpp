@@ -0,0 +1,185 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "map/Reclaimer.h"
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include "frame/KeyFrame.h"
+#include "map/MapPoint.h"
+
+namespace ORB_SLAM3
+{
+
+namespace
+{
+
+struct RetiredKeyFrame
+{
+    uint64_t nEpoch;
+    KeyFrame* pKF;
+    bool bDelete;
+    int64_t nBytes;
+};
+
+std::mutex gMutexReclaimer;
+std::vector<Reclaimer::Participant*> gvpParticipants;
+// In retirement order, so in increasing epochs
+std::deque<RetiredKeyFrame> gdRetired;
+std::atomic<uint64_t> gnEpoch(0);
+
+std::atomic<int64_t> gnKeyFrames(0);
+std::atomic<int64_t> gnKeyFrameBytes(0);
+std::atomic<int64_t> gnRetiredKeyFrames(0);
+std::atomic<int64_t> gnRetiredKeyFrameBytes(0);
+std::atomic<int64_t> gnReclaimedKeyFrames(0);
+std::atomic<int64_t> gnReclaimedBytes(0);
+std::atomic<int64_t> gnMapPoints(0);
+std::atomic<int64_t> gnBadMapPoints(0);
+
+uint64_t ToCount(int64_t n)
+{
+    return n > 0 ? static_cast<uint64_t>(n) : 0;
+}
+
+} // namespace
+
+Reclaimer::Participant::Participant()
+{
+    std::unique_lock<std::mutex> lock(gMutexReclaimer);
+    mnEpoch = gnEpoch.load();
+    gvpParticipants.push_back(this);
+}
+
+Reclaimer::Participant::~Participant()
+{
+    std::unique_lock<std::mutex> lock(gMutexReclaimer);
+    gvpParticipants.erase(std::find(gvpParticipants.begin(), gvpParticipants.end(), this));
+}
+
+void Reclaimer::Participant::Quiescent()
+{
+    mnEpoch = gnEpoch.load();
+}
+
+void Reclaimer::Retire(KeyFrame* pKF)
+{
+    const int64_t nBytes = pKF->FeatureBytes();
+
+    std::unique_lock<std::mutex> lock(gMutexReclaimer);
+    gdRetired.push_back({++gnEpoch, pKF, false, nBytes});
+    gnRetiredKeyFrames++;
+    gnRetiredKeyFrameBytes += nBytes;
+}
+
+void Reclaimer::Delete(KeyFrame* pKF)
+{
+    std::unique_lock<std::mutex> lock(gMutexReclaimer);
+    gdRetired.push_back({++gnEpoch, pKF, true, 0});
+}
+
+void Reclaimer::Collect()
+{
+    std::vector<RetiredKeyFrame> vReady;
+    {
+        std::unique_lock<std::mutex> lock(gMutexReclaimer);
+        uint64_t nOldest = std::numeric_limits<uint64_t>::max();
+        for(Participant* pParticipant : gvpParticipants)
+            nOldest = std::min(nOldest, pParticipant->mnEpoch.load());
+
+        while(!gdRetired.empty() && gdRetired.front().nEpoch <= nOldest)
+        {
+            vReady.push_back(gdRetired.front());
+            gdRetired.pop_front();
+        }
+    }
+
+    // Released outside the lock, in retirement order so that the features of a key frame go before it
+    for(const RetiredKeyFrame& retired : vReady)
+    {
+        if(retired.bDelete)
+        {
+            delete retired.pKF;
+            continue;
+        }
+
+        const int64_t nReleased = retired.pKF->ReleaseFeatures();
+        gnRetiredKeyFrames--;
+        gnRetiredKeyFrameBytes -= retired.nBytes;
+        gnReclaimedKeyFrames++;
+        gnReclaimedBytes += nReleased;
+        gnKeyFrameBytes -= nReleased;
+    }
+}
+
+void Reclaimer::AddKeyFrame(int64_t nBytes)
+{
+    gnKeyFrames++;
+    gnKeyFrameBytes += nBytes;
+}
+
+void Reclaimer::RemoveKeyFrame(int64_t nBytes)
+{
+    gnKeyFrames--;
+    gnKeyFrameBytes -= nBytes;
+}
+
+void Reclaimer::ResizeKeyFrame(int64_t nBytes)
+{
+    gnKeyFrameBytes += nBytes;
+}
+
+void Reclaimer::AddMapPoint()
+{
+    gnMapPoints++;
+}
+
+void Reclaimer::RemoveMapPoint(bool bBad)
+{
+    gnMapPoints--;
+    if(bBad)
+        gnBadMapPoints--;
+}
+
+void Reclaimer::SetMapPointBad()
+{
+    gnBadMapPoints++;
+}
+
+Reclaimer::Summary Reclaimer::GetSummary()
+{
+    Summary summary;
+    summary.nKeyFrames = ToCount(gnKeyFrames.load());
+    summary.nKeyFrameBytes = ToCount(gnKeyFrameBytes.load());
+    summary.nRetiredKeyFrames = ToCount(gnRetiredKeyFrames.load());
+    summary.nRetiredKeyFrameBytes = ToCount(gnRetiredKeyFrameBytes.load());
+    summary.nReclaimedKeyFrames = ToCount(gnReclaimedKeyFrames.load());
+    summary.nReclaimedBytes = ToCount(gnReclaimedBytes.load());
+    summary.nMapPoints = ToCount(gnMapPoints.load());
+    summary.nMapPointBytes = summary.nMapPoints * sizeof(MapPoint);
+    summary.nBadMapPoints = ToCount(gnBadMapPoints.load());
+    summary.nBadMapPointBytes = summary.nBadMapPoints * sizeof(MapPoint);
+    return summary;
+}
+
+} //namespace ORB_SLAM3
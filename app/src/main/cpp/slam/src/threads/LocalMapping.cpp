@@ -32,6 +32,8 @@
 
 #include "utils/Converter.h"
 #include "utils/GeometricTools.h"
+#include "utils/Stats.h"
+#include "utils/Trace.h"
 
 namespace ORB_SLAM3
 {
@@ -68,11 +70,6 @@ LocalMapping::LocalMapping(System* pSys, Atlas *pAtlas, const float bMonocular,
     mNumLM = 0;
     mNumKFCulling=0;
 
-#ifdef REGISTER_TIMES
-    nLBA_exec = 0;
-    nLBA_abort = 0;
-#endif
-
 }
 
 void LocalMapping::SetLoopCloser(LoopClosing* pLoopCloser)
@@ -88,38 +85,33 @@ void LocalMapping::SetTracker(Tracking *pTracker)
 void LocalMapping::Run()
 {
     mbFinished = false;
+    Trace::SetThreadName("LocalMapping");
 
     while(1)
     {
+        // No key frame of the previous iteration is held anymore
+        mReclaimerParticipant.Quiescent();
+        Reclaimer::Collect();
+
         // Tracking will see that Local Mapping is busy
         SetAcceptKeyFrames(false);
 
         // Check if there are keyframes in the queue
         if(CheckNewKeyFrames() && !mbBadImu)
         {
-#ifdef REGISTER_TIMES
-            double timeLBA_ms = 0;
-            double timeKFCulling_ms = 0;
-
             std::chrono::steady_clock::time_point time_StartProcessKF = std::chrono::steady_clock::now();
-#endif
+
             // BoW conversion and insertion in Map
             ProcessNewKeyFrame();
-#ifdef REGISTER_TIMES
-            std::chrono::steady_clock::time_point time_EndProcessKF = std::chrono::steady_clock::now();
 
-            double timeProcessKF = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndProcessKF - time_StartProcessKF).count();
-            vdKFInsert_ms.push_back(timeProcessKF);
-#endif
+            std::chrono::steady_clock::time_point time_EndProcessKF = std::chrono::steady_clock::now();
+            Stats::Record(SLAM_STAT_ID("LocalMapping::ProcessNewKeyFrame"), time_StartProcessKF, time_EndProcessKF);
 
             // Check recent MapPoints
             MapPointCulling();
-#ifdef REGISTER_TIMES
-            std::chrono::steady_clock::time_point time_EndMPCulling = std::chrono::steady_clock::now();
 
-            double timeMPCulling = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndMPCulling - time_EndProcessKF).count();
-            vdMPCulling_ms.push_back(timeMPCulling);
-#endif
+            std::chrono::steady_clock::time_point time_EndMPCulling = std::chrono::steady_clock::now();
+            Stats::Record(SLAM_STAT_ID("LocalMapping::MapPointCulling"), time_EndProcessKF, time_EndMPCulling);
 
             // Triangulate new MapPoints
             CreateNewMapPoints();
@@ -132,12 +124,8 @@ void LocalMapping::Run()
                 SearchInNeighbors();
             }
 
-#ifdef REGISTER_TIMES
             std::chrono::steady_clock::time_point time_EndMPCreation = std::chrono::steady_clock::now();
-
-            double timeMPCreation = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndMPCreation - time_EndMPCulling).count();
-            vdMPCreation_ms.push_back(timeMPCreation);
-#endif
+            Stats::Record(SLAM_STAT_ID("LocalMapping::CreateNewMapPoints"), time_EndMPCulling, time_EndMPCreation);
 
             bool b_doneLBA = false;
             int num_FixedKF_BA = 0;
@@ -180,27 +168,15 @@ void LocalMapping::Run()
                     }
 
                 }
-#ifdef REGISTER_TIMES
                 std::chrono::steady_clock::time_point time_EndLBA = std::chrono::steady_clock::now();
-
                 if(b_doneLBA)
                 {
-                    timeLBA_ms = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndLBA - time_EndMPCreation).count();
-                    vdLBA_ms.push_back(timeLBA_ms);
-
-                    nLBA_exec += 1;
                     if(mbAbortBA)
-                    {
-                        nLBA_abort += 1;
-                    }
-                    vnLBA_edges.push_back(num_edges_BA);
-                    vnLBA_KFopt.push_back(num_OptKF_BA);
-                    vnLBA_KFfixed.push_back(num_FixedKF_BA);
-                    vnLBA_MPs.push_back(num_MPs_BA);
+                        Stats::Record(SLAM_STAT_ID("LocalMapping::LocalBA(aborted)"), time_EndMPCreation, time_EndLBA);
+                    else
+                        Stats::Record(SLAM_STAT_ID("LocalMapping::LocalBA"), time_EndMPCreation, time_EndLBA);
                 }
 
-#endif
-
                 // Initialize IMU here
                 if(!mpCurrentKeyFrame->GetMap()->isImuInitialized() && mbInertial)
                 {
@@ -214,12 +190,8 @@ void LocalMapping::Run()
                 // Check redundant local Keyframes
                 KeyFrameCulling();
 
-#ifdef REGISTER_TIMES
                 std::chrono::steady_clock::time_point time_EndKFCulling = std::chrono::steady_clock::now();
-
-                timeKFCulling_ms = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndKFCulling - time_EndLBA).count();
-                vdKFCulling_ms.push_back(timeKFCulling_ms);
-#endif
+                Stats::Record(SLAM_STAT_ID("LocalMapping::KeyFrameCulling"), time_EndLBA, time_EndKFCulling);
 
                 if ((mTinit<50.0f) && mbInertial)
                 {
@@ -266,25 +238,17 @@ void LocalMapping::Run()
                 }
             }
 
-#ifdef REGISTER_TIMES
-            vdLBASync_ms.push_back(timeKFCulling_ms);
-            vdKFCullingSync_ms.push_back(timeKFCulling_ms);
-#endif
-
             mpLoopCloser->InsertKeyFrame(mpCurrentKeyFrame);
 
-#ifdef REGISTER_TIMES
             std::chrono::steady_clock::time_point time_EndLocalMap = std::chrono::steady_clock::now();
-
-            double timeLocalMap = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndLocalMap - time_StartProcessKF).count();
-            vdLMTotal_ms.push_back(timeLocalMap);
-#endif
+            Stats::Record(SLAM_STAT_ID("LocalMapping::Total"), time_StartProcessKF, time_EndLocalMap);
         }
         else if(Stop() && !mbBadImu)
         {
             // Safe area to stop
             while(isStopped() && !CheckFinish())
             {
+                mReclaimerParticipant.Quiescent();
                 usleep(3000);
             }
             if(CheckFinish())
@@ -741,11 +705,11 @@ void LocalMapping::SearchInNeighbors()
     int nn = 10;
     if(mbMonocular)
         nn=30;
-    const vector<KeyFrame*> vpNeighKFs = mpCurrentKeyFrame->GetBestCovisibilityKeyFrames(nn);
+    const CovisibilityEdges::Snapshot pNeighKFs = mpCurrentKeyFrame->GetCovisibles();
     vector<KeyFrame*> vpTargetKFs;
-    for(vector<KeyFrame*>::const_iterator vit=vpNeighKFs.begin(), vend=vpNeighKFs.end(); vit!=vend; vit++)
+    for(size_t iN=0, iNend=pNeighKFs->CountBest(nn); iN<iNend; iN++)
     {
-        KeyFrame* pKFi = *vit;
+        KeyFrame* pKFi = pNeighKFs->vpKeyFrames[iN];
         if(pKFi->isBad() || pKFi->mnFuseTargetForKF == mpCurrentKeyFrame->mnId)
             continue;
         vpTargetKFs.push_back(pKFi);
@@ -756,10 +720,10 @@ void LocalMapping::SearchInNeighbors()
     // Extend to some second neighbors if abort is not requested
     for(int i=0, imax=vpTargetKFs.size(); i<imax; i++)
     {
-        const vector<KeyFrame*> vpSecondNeighKFs = vpTargetKFs[i]->GetBestCovisibilityKeyFrames(20);
-        for(vector<KeyFrame*>::const_iterator vit2=vpSecondNeighKFs.begin(), vend2=vpSecondNeighKFs.end(); vit2!=vend2; vit2++)
+        const CovisibilityEdges::Snapshot pSecondNeighKFs = vpTargetKFs[i]->GetCovisibles();
+        for(size_t iN2=0, iN2end=pSecondNeighKFs->CountBest(20); iN2<iN2end; iN2++)
         {
-            KeyFrame* pKFi2 = *vit2;
+            KeyFrame* pKFi2 = pSecondNeighKFs->vpKeyFrames[iN2];
             if(pKFi2->isBad() || pKFi2->mnFuseTargetForKF==mpCurrentKeyFrame->mnId || pKFi2->mnId==mpCurrentKeyFrame->mnId)
                 continue;
             vpTargetKFs.push_back(pKFi2);
@@ -992,15 +956,14 @@ void LocalMapping::KeyFrameCulling()
                         const int &scaleLevel = (pKF -> NLeft == -1) ? pKF->mvKeysUn[i].octave
                                                                      : (i < pKF -> NLeft) ? pKF -> mvKeys[i].octave
                                                                                           : pKF -> mvKeysRight[i].octave;
-                        const map<KeyFrame*, tuple<int,int>> observations = pMP->GetObservations();
+                        const ObservationList observations = pMP->GetObservations();
                         int nObs=0;
-                        for(map<KeyFrame*, tuple<int,int>>::const_iterator mit=observations.begin(), mend=observations.end(); mit!=mend; mit++)
+                        for(ObservationList::const_iterator mit=observations.begin(), mend=observations.end(); mit!=mend; mit++)
                         {
-                            KeyFrame* pKFi = mit->first;
+                            KeyFrame* pKFi = mit->pKF;
                             if(pKFi==pKF)
                                 continue;
-                            tuple<int,int> indexes = mit->second;
-                            int leftIndex = get<0>(indexes), rightIndex = get<1>(indexes);
+                            int leftIndex = mit->nLeft, rightIndex = mit->nRight;
                             int scaleLeveli = -1;
                             if(pKFi -> NLeft == -1)
                                 scaleLeveli = pKFi->mvKeysUn[leftIndex].octave;
@@ -1303,7 +1266,7 @@ void LocalMapping::InitializeIMU(float priorG, float priorA, bool bFIBA)
 
     // Before this line we are not changing the map
     {
-        unique_lock<mutex> lock(mpAtlas->GetCurrentMap()->mMutexMapUpdate);
+        unique_lock<mutex> lock = TracedLock(mpAtlas->GetCurrentMap()->mMutexMapUpdate, "Wait mMutexMapUpdate");
         if ((fabs(mScale - 1.f) > 0.00001) || !mbMonocular)
         {
             Sophus::SE3f Twg(mRwg.cast<float>().transpose(), Eigen::Vector3f::Zero());
@@ -1342,7 +1305,7 @@ void LocalMapping::InitializeIMU(float priorG, float priorA, bool bFIBA)
     Verbose::PrintMess("Global Bundle Adjustment finished\nUpdating map ...", Verbose::VERBOSITY_NORMAL);
 
     // Get Map Mutex
-    unique_lock<mutex> lock(mpAtlas->GetCurrentMap()->mMutexMapUpdate);
+    unique_lock<mutex> lock = TracedLock(mpAtlas->GetCurrentMap()->mMutexMapUpdate, "Wait mMutexMapUpdate");
 
     unsigned long GBAid = mpCurrentKeyFrame->mnId;
 
@@ -1407,7 +1370,8 @@ void LocalMapping::InitializeIMU(float priorG, float priorA, bool bFIBA)
     }
 
     // Correct MapPoints
-    const vector<MapPoint*> vpMPs = mpAtlas->GetCurrentMap()->GetAllMapPoints();
+    const SlotMap<MapPoint>::Snapshot pMPs = mpAtlas->GetCurrentMap()->GetMapPointSnapshot();
+    const vector<MapPoint*>& vpMPs = *pMPs;
 
     for (auto pMP: vpMPs)
     {
@@ -1443,7 +1407,7 @@ void LocalMapping::InitializeIMU(float priorG, float priorA, bool bFIBA)
     for (auto& mlNewKeyFrame: mlNewKeyFrames)
     {
         mlNewKeyFrame->SetBadFlag();
-        delete mlNewKeyFrame;
+        Reclaimer::Delete(mlNewKeyFrame);
     }
     mlNewKeyFrames.clear();
 
@@ -1497,7 +1461,7 @@ void LocalMapping::ScaleRefinement()
     
     Sophus::SO3d so3wg(mRwg);
     // Before this line we are not changing the map
-    unique_lock<mutex> lock(mpAtlas->GetCurrentMap()->mMutexMapUpdate);
+    unique_lock<mutex> lock = TracedLock(mpAtlas->GetCurrentMap()->mMutexMapUpdate, "Wait mMutexMapUpdate");
     std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
     if ((fabs(mScale-1.f)>0.002)||!mbMonocular)
     {
@@ -1510,7 +1474,7 @@ void LocalMapping::ScaleRefinement()
     for(auto & mlNewKeyFrame : mlNewKeyFrames)
     {
         mlNewKeyFrame->SetBadFlag();
-        delete mlNewKeyFrame;
+        Reclaimer::Delete(mlNewKeyFrame);
     }
     mlNewKeyFrames.clear();
 
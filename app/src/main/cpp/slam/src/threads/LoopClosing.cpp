@@ -31,6 +31,8 @@
 #include "solver/G2oTypes.h"
 
 #include "utils/Converter.h"
+#include "utils/Stats.h"
+#include "utils/Trace.h"
 
 #include "feature/ORBmatcher.h"
 
@@ -39,6 +41,7 @@ namespace ORB_SLAM3
 
 LoopClosing::LoopClosing(Atlas *pAtlas, KeyFrameDatabase *pDB, ORBVocabulary *pVoc, const bool bFixScale, const bool bActiveLC):
     mbResetRequested(false), mbResetActiveMapRequested(false), mbFinishRequested(false), mbFinished(true), mpAtlas(pAtlas),
+    mbProcessingKF(false),
     mpKeyFrameDB(pDB), mpORBVocabulary(pVoc), mpMatchedKF(NULL), mLastLoopKFid(0), mbRunningGBA(false), mbFinishedGBA(true),
     mbStopGBA(false), mpThreadGBA(NULL), mbFixScale(bFixScale), mnFullBAIdx(0), mnLoopNumCoincidences(0), mnMergeNumCoincidences(0),
     mbLoopDetected(false), mbMergeDetected(false), mnLoopNumNotFound(0), mnMergeNumNotFound(0), mbActiveLC(bActiveLC)
@@ -46,36 +49,6 @@ LoopClosing::LoopClosing(Atlas *pAtlas, KeyFrameDatabase *pDB, ORBVocabulary *pV
     mnCovisibilityConsistencyTh = 3;
     mpLastCurrentKF = static_cast<KeyFrame*>(NULL);
 
-#ifdef REGISTER_TIMES
-
-    vdDataQuery_ms.clear();
-    vdEstSim3_ms.clear();
-    vdPRTotal_ms.clear();
-
-    vdMergeMaps_ms.clear();
-    vdWeldingBA_ms.clear();
-    vdMergeOptEss_ms.clear();
-    vdMergeTotal_ms.clear();
-    vnMergeKFs.clear();
-    vnMergeMPs.clear();
-    nMerges = 0;
-
-    vdLoopFusion_ms.clear();
-    vdLoopOptEss_ms.clear();
-    vdLoopTotal_ms.clear();
-    vnLoopKFs.clear();
-    nLoop = 0;
-
-    vdGBA_ms.clear();
-    vdUpdateMap_ms.clear();
-    vdFGBATotal_ms.clear();
-    vnGBAKFs.clear();
-    vnGBAMPs.clear();
-    nFGBA_exec = 0;
-    nFGBA_abort = 0;
-
-#endif
-
     mstrFolderSubTraj = "SubTrajectories/";
     mnNumCorrection = 0;
     mnCorrectionGBA = 0;
@@ -95,9 +68,12 @@ void LoopClosing::SetLocalMapper(LocalMapping *pLocalMapper)
 void LoopClosing::Run()
 {
     mbFinished =false;
+    Trace::SetThreadName("LoopClosing");
 
     while(1)
     {
+        // The key frames matched over several key frames are kept from being erased until the match ends
+        mReclaimerParticipant.Quiescent();
 
         //NEW LOOP AND MERGE DETECTION ALGORITHM
         //----------------------------
@@ -110,18 +86,13 @@ void LoopClosing::Run()
                 mpLastCurrentKF->mvpLoopCandKFs.clear();
                 mpLastCurrentKF->mvpMergeCandKFs.clear();
             }
-#ifdef REGISTER_TIMES
             std::chrono::steady_clock::time_point time_StartPR = std::chrono::steady_clock::now();
-#endif
 
             bool bFindedRegion = NewDetectCommonRegions();
 
-#ifdef REGISTER_TIMES
             std::chrono::steady_clock::time_point time_EndPR = std::chrono::steady_clock::now();
 
-            double timePRTotal = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndPR - time_StartPR).count();
-            vdPRTotal_ms.push_back(timePRTotal);
-#endif
+            Stats::Record(SLAM_STAT_ID("LoopClosing::DetectCommonRegions"), time_StartPR, time_EndPR);
             if(bFindedRegion)
             {
                 if(mbMergeDetected)
@@ -176,23 +147,16 @@ void LoopClosing::Run()
 
                         Verbose::PrintMess("*Merge detected", Verbose::VERBOSITY_QUIET);
 
-#ifdef REGISTER_TIMES
                         std::chrono::steady_clock::time_point time_StartMerge = std::chrono::steady_clock::now();
-
-                        nMerges += 1;
-#endif
                         // TODO UNCOMMENT
                         if (mpTracker->mSensor==System::IMU_MONOCULAR ||mpTracker->mSensor==System::IMU_STEREO || mpTracker->mSensor==System::IMU_RGBD)
                             MergeLocal2();
                         else
                             MergeLocal();
 
-#ifdef REGISTER_TIMES
                         std::chrono::steady_clock::time_point time_EndMerge = std::chrono::steady_clock::now();
 
-                        double timeMergeTotal = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndMerge - time_StartMerge).count();
-                        vdMergeTotal_ms.push_back(timeMergeTotal);
-#endif
+                        Stats::Record(SLAM_STAT_ID("LoopClosing::Merge"), time_StartMerge, time_EndMerge);
 
                         Verbose::PrintMess("Merge finished!", Verbose::VERBOSITY_QUIET);
                     }
@@ -270,19 +234,11 @@ void LoopClosing::Run()
 
                         mvpLoopMapPoints = mvpLoopMPs;
 
-#ifdef REGISTER_TIMES
                         std::chrono::steady_clock::time_point time_StartLoop = std::chrono::steady_clock::now();
-
-                        nLoop += 1;
-
-#endif
                         CorrectLoop();
-#ifdef REGISTER_TIMES
                         std::chrono::steady_clock::time_point time_EndLoop = std::chrono::steady_clock::now();
 
-                        double timeLoopTotal = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndLoop - time_StartLoop).count();
-                        vdLoopTotal_ms.push_back(timeLoopTotal);
-#endif
+                        Stats::Record(SLAM_STAT_ID("LoopClosing::CorrectLoop"), time_StartLoop, time_EndLoop);
 
                         mnNumCorrection += 1;
                     }
@@ -299,6 +255,9 @@ void LoopClosing::Run()
 
             }
             mpLastCurrentKF = mpCurrentKF;
+
+            unique_lock<mutex> lock(mMutexLoopQueue);
+            mbProcessingKF = false;
         }
 
         ResetIfRequested();
@@ -317,7 +276,14 @@ void LoopClosing::InsertKeyFrame(KeyFrame *pKF)
 {
     unique_lock<mutex> lock(mMutexLoopQueue);
     if(pKF->mnId!=0)
+    {
+        // Kept from being erased until it is popped: the features of a key frame culled meanwhile would be
+        // released while this thread reads them, since its quiescent points do not cover the queue.
+        // Without place recognition the queue is never consumed nor read.
+        if(mbActiveLC)
+            pKF->SetNotErase();
         mlpLoopKeyFrameQueue.push_back(pKF);
+    }
 }
 
 bool LoopClosing::CheckNewKeyFrames()
@@ -326,6 +292,17 @@ bool LoopClosing::CheckNewKeyFrames()
     return(!mlpLoopKeyFrameQueue.empty());
 }
 
+bool LoopClosing::isIdle()
+{
+    {
+        unique_lock<mutex> lock(mMutexLoopQueue);
+        // Without place recognition the queue is never consumed
+        if(mbProcessingKF || (mbActiveLC && !mlpLoopKeyFrameQueue.empty()))
+            return false;
+    }
+    return !isRunningGBA();
+}
+
 bool LoopClosing::NewDetectCommonRegions()
 {
     // To deactivate placerecognition. No loopclosing nor merging will be performed
@@ -336,13 +313,20 @@ bool LoopClosing::NewDetectCommonRegions()
         unique_lock<mutex> lock(mMutexLoopQueue);
         mpCurrentKF = mlpLoopKeyFrameQueue.front();
         mlpLoopKeyFrameQueue.pop_front();
-        // Avoid that a keyframe can be erased while it is being process by this thread
-        mpCurrentKF->SetNotErase();
+        mbProcessingKF = true;
+        // InsertKeyFrame() keeps the keyframe from being erased until it is processed by this thread
         mpCurrentKF->mbCurrentPlaceRecognition = true;
 
         mpLastMap = mpCurrentKF->GetMap();
     }
 
+    // Culled by the local mapping while it was queued: erased now, neither matched nor added to the database
+    if(mpCurrentKF->isToBeErased() || mpCurrentKF->isBad())
+    {
+        mpCurrentKF->SetErase();
+        return false;
+    }
+
     if(mpLastMap->IsInertial() && !mpLastMap->GetIniertialBA2())
     {
         mpKeyFrameDB->add(mpCurrentKF);
@@ -350,7 +334,7 @@ bool LoopClosing::NewDetectCommonRegions()
         return false;
     }
 
-    if(mpTracker->mSensor == System::STEREO && mpLastMap->GetAllKeyFrames().size() < 5) //12
+    if(mpTracker->mSensor == System::STEREO && mpLastMap->KeyFramesInMap() < 5) //12
     {
         // cout << "LoopClousure: Stereo KF inserted without check: " << mpCurrentKF->mnId << endl;
         mpKeyFrameDB->add(mpCurrentKF);
@@ -358,7 +342,7 @@ bool LoopClosing::NewDetectCommonRegions()
         return false;
     }
 
-    if(mpLastMap->GetAllKeyFrames().size() < 12)
+    if(mpLastMap->KeyFramesInMap() < 12)
     {
         // cout << "LoopClousure: Stereo KF inserted without check, map is small: " << mpCurrentKF->mnId << endl;
         mpKeyFrameDB->add(mpCurrentKF);
@@ -373,9 +357,7 @@ bool LoopClosing::NewDetectCommonRegions()
     bool bLoopDetectedInKF = false;
     bool bCheckSpatial = false;
 
-#ifdef REGISTER_TIMES
     std::chrono::steady_clock::time_point time_StartEstSim3_1 = std::chrono::steady_clock::now();
-#endif
     if(mnLoopNumCoincidences > 0)
     {
         bCheckSpatial = true;
@@ -467,17 +449,13 @@ bool LoopClosing::NewDetectCommonRegions()
 
         }
     }  
-#ifdef REGISTER_TIMES
         std::chrono::steady_clock::time_point time_EndEstSim3_1 = std::chrono::steady_clock::now();
 
         double timeEstSim3 = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndEstSim3_1 - time_StartEstSim3_1).count();
-#endif
 
     if(mbMergeDetected || mbLoopDetected)
     {
-#ifdef REGISTER_TIMES
-        vdEstSim3_ms.push_back(timeEstSim3);
-#endif
+        Stats::Record(SLAM_STAT_ID("LoopClosing::EstimateSim3"), timeEstSim3);
         mpKeyFrameDB->add(mpCurrentKF);
         return true;
     }
@@ -490,21 +468,14 @@ bool LoopClosing::NewDetectCommonRegions()
     if(!bMergeDetectedInKF || !bLoopDetectedInKF)
     {
         // Search in BoW
-#ifdef REGISTER_TIMES
         std::chrono::steady_clock::time_point time_StartQuery = std::chrono::steady_clock::now();
-#endif
         mpKeyFrameDB->DetectNBestCandidates(mpCurrentKF, vpLoopBowCand, vpMergeBowCand,3);
-#ifdef REGISTER_TIMES
         std::chrono::steady_clock::time_point time_EndQuery = std::chrono::steady_clock::now();
 
-        double timeDataQuery = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndQuery - time_StartQuery).count();
-        vdDataQuery_ms.push_back(timeDataQuery);
-#endif
+        Stats::Record(SLAM_STAT_ID("LoopClosing::DetectNBestCandidates"), time_StartQuery, time_EndQuery);
     }
 
-#ifdef REGISTER_TIMES
         std::chrono::steady_clock::time_point time_StartEstSim3_2 = std::chrono::steady_clock::now();
-#endif
     // Check the BoW candidates if the geometric candidate list is empty
     //Loop candidates
     if(!bLoopDetectedInKF && !vpLoopBowCand.empty())
@@ -517,12 +488,10 @@ bool LoopClosing::NewDetectCommonRegions()
         mbMergeDetected = DetectCommonRegionsFromBoW(vpMergeBowCand, mpMergeMatchedKF, mpMergeLastCurrentKF, mg2oMergeSlw, mnMergeNumCoincidences, mvpMergeMPs, mvpMergeMatchedMPs);
     }
 
-#ifdef REGISTER_TIMES
         std::chrono::steady_clock::time_point time_EndEstSim3_2 = std::chrono::steady_clock::now();
 
         timeEstSim3 += std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndEstSim3_2 - time_StartEstSim3_2).count();
-        vdEstSim3_ms.push_back(timeEstSim3);
-#endif
+        Stats::Record(SLAM_STAT_ID("LoopClosing::EstimateSim3"), timeEstSim3);
 
     mpKeyFrameDB->add(mpCurrentKF);
 
@@ -1028,22 +997,11 @@ void LoopClosing::CorrectLoop()
 
     Map* pLoopMap = mpCurrentKF->GetMap();
 
-#ifdef REGISTER_TIMES
-    /*KeyFrame* pKF = mpCurrentKF;
-    int numKFinLoop = 0;
-    while(pKF && pKF->mnId > mpLoopMatchedKF->mnId)
-    {
-        pKF = pKF->GetParent();
-        numKFinLoop += 1;
-    }
-    vnLoopKFs.push_back(numKFinLoop);*/
-
     std::chrono::steady_clock::time_point time_StartFusion = std::chrono::steady_clock::now();
-#endif
 
     {
         // Get Map Mutex
-        unique_lock<mutex> lock(pLoopMap->mMutexMapUpdate);
+        unique_lock<mutex> lock = TracedLock(pLoopMap->mMutexMapUpdate, "Wait mMutexMapUpdate");
 
         const bool bImuInit = pLoopMap->isImuInitialized();
 
@@ -1171,12 +1129,9 @@ void LoopClosing::CorrectLoop()
     if(mpTracker->mSensor==System::IMU_MONOCULAR && !mpCurrentKF->GetMap()->GetIniertialBA2())
         bFixedScale=false;
 
-#ifdef REGISTER_TIMES
         std::chrono::steady_clock::time_point time_EndFusion = std::chrono::steady_clock::now();
 
-        double timeFusion = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndFusion - time_StartFusion).count();
-        vdLoopFusion_ms.push_back(timeFusion);
-#endif
+        Stats::Record(SLAM_STAT_ID("LoopClosing::LoopFusion"), time_StartFusion, time_EndFusion);
     //cout << "Optimize essential graph" << endl;
     if(pLoopMap->IsInertial() && pLoopMap->isImuInitialized())
     {
@@ -1187,12 +1142,9 @@ void LoopClosing::CorrectLoop()
         //cout << "Loop -> Scale correction: " << mg2oLoopScw.scale() << endl;
         Optimizer::OptimizeEssentialGraph(pLoopMap, mpLoopMatchedKF, mpCurrentKF, NonCorrectedSim3, CorrectedSim3, LoopConnections, bFixedScale);
     }
-#ifdef REGISTER_TIMES
     std::chrono::steady_clock::time_point time_EndOpt = std::chrono::steady_clock::now();
 
-    double timeOptEss = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndOpt - time_EndFusion).count();
-    vdLoopOptEss_ms.push_back(timeOptEss);
-#endif
+    Stats::Record(SLAM_STAT_ID("LoopClosing::LoopEssentialGraph"), time_EndFusion, time_EndOpt);
 
     mpAtlas->InformNewBigChange();
 
@@ -1268,9 +1220,7 @@ void LoopClosing::MergeLocal()
     //std::cout << "Merge local, Active map: " << pCurrentMap->GetId() << std::endl;
     //std::cout << "Merge local, Non-Active map: " << pMergeMap->GetId() << std::endl;
 
-#ifdef REGISTER_TIMES
     std::chrono::steady_clock::time_point time_StartMerge = std::chrono::steady_clock::now();
-#endif
 
     // Ensure current keyframe is updated
     mpCurrentKF->UpdateConnections();
@@ -1418,10 +1368,6 @@ void LoopClosing::MergeLocal()
     vNonCorrectedSim3[mpCurrentKF]=g2oNonCorrectedScw;
 
 
-#ifdef REGISTER_TIMES
-    vnMergeKFs.push_back(spLocalWindowKFs.size() + spMergeConnectedKFs.size());
-    vnMergeMPs.push_back(spLocalWindowMPs.size() + spMapPointMerge.size());
-#endif
     for(KeyFrame* pKFi : spLocalWindowKFs)
     {
         if(!pKFi || pKFi->isBad())
@@ -1531,8 +1477,8 @@ void LoopClosing::MergeLocal()
             // Make sure connections are updated
             pKFi->UpdateMap(pMergeMap);
             pKFi->mnMergeCorrectedForKF = mpCurrentKF->mnId;
-            pMergeMap->AddKeyFrame(pKFi);
             pCurrentMap->EraseKeyFrame(pKFi);
+            pMergeMap->AddKeyFrame(pKFi);
 
             if(pCurrentMap->isImuInitialized())
             {
@@ -1548,8 +1494,8 @@ void LoopClosing::MergeLocal()
             pMPi->SetWorldPos(pMPi->mPosMerge);
             pMPi->SetNormalVector(pMPi->mNormalVectorMerge);
             pMPi->UpdateMap(pMergeMap);
-            pMergeMap->AddMapPoint(pMPi);
             pCurrentMap->EraseMapPoint(pMPi);
+            pMergeMap->AddMapPoint(pMPi);
         }
 
         mpAtlas->ChangeMap(pMergeMap);
@@ -1611,12 +1557,9 @@ void LoopClosing::MergeLocal()
 
     //std::cout << "[Merge]: Start welding bundle adjustment" << std::endl;
 
-#ifdef REGISTER_TIMES
     std::chrono::steady_clock::time_point time_StartWeldingBA = std::chrono::steady_clock::now();
 
-    double timeMergeMaps = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_StartWeldingBA - time_StartMerge).count();
-    vdMergeMaps_ms.push_back(timeMergeMaps);
-#endif
+    Stats::Record(SLAM_STAT_ID("LoopClosing::MergeMaps"), time_StartMerge, time_StartWeldingBA);
 
     bool bStop = false;
     vpLocalCurrentWindowKFs.clear();
@@ -1632,12 +1575,9 @@ void LoopClosing::MergeLocal()
         Optimizer::LocalBundleAdjustment(mpCurrentKF, vpLocalCurrentWindowKFs, vpMergeConnectedKFs,&bStop);
     }
 
-#ifdef REGISTER_TIMES
     std::chrono::steady_clock::time_point time_EndWeldingBA = std::chrono::steady_clock::now();
 
-    double timeWeldingBA = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndWeldingBA - time_StartWeldingBA).count();
-    vdWeldingBA_ms.push_back(timeWeldingBA);
-#endif
+    Stats::Record(SLAM_STAT_ID("LoopClosing::WeldingBA"), time_StartWeldingBA, time_EndWeldingBA);
     //std::cout << "[Merge]: Welding bundle adjustment finished" << std::endl;
 
     // Loop closed. Release Local Mapping.
@@ -1739,8 +1679,8 @@ void LoopClosing::MergeLocal()
 
                 // Make sure connections are updated
                 pKFi->UpdateMap(pMergeMap);
-                pMergeMap->AddKeyFrame(pKFi);
                 pCurrentMap->EraseKeyFrame(pKFi);
+                pMergeMap->AddKeyFrame(pKFi);
             }
 
             for(MapPoint* pMPi : vpCurrentMapMPs)
@@ -1749,18 +1689,15 @@ void LoopClosing::MergeLocal()
                     continue;
 
                 pMPi->UpdateMap(pMergeMap);
-                pMergeMap->AddMapPoint(pMPi);
                 pCurrentMap->EraseMapPoint(pMPi);
+                pMergeMap->AddMapPoint(pMPi);
             }
         }
     }
 
-#ifdef REGISTER_TIMES
     std::chrono::steady_clock::time_point time_EndOptEss = std::chrono::steady_clock::now();
 
-    double timeOptEss = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndOptEss - time_EndWeldingBA).count();
-    vdMergeOptEss_ms.push_back(timeOptEss);
-#endif
+    Stats::Record(SLAM_STAT_ID("LoopClosing::MergeEssentialGraph"), time_EndWeldingBA, time_EndOptEss);
 
 
     mpLocalMapper->Release();
@@ -1838,7 +1775,7 @@ void LoopClosing::MergeLocal2()
         float s_on = mSold_new.scale();
         Sophus::SE3f T_on(mSold_new.rotation().cast<float>(), mSold_new.translation().cast<float>());
 
-        unique_lock<mutex> lock(mpAtlas->GetCurrentMap()->mMutexMapUpdate);
+        unique_lock<mutex> lock = TracedLock(mpAtlas->GetCurrentMap()->mMutexMapUpdate, "Wait mMutexMapUpdate");
 
         //cout << "KFs before empty: " << mpAtlas->GetCurrentMap()->KeyFramesInMap() << endl;
         mpLocalMapper->EmptyQueue();
@@ -1867,7 +1804,7 @@ void LoopClosing::MergeLocal2()
         ba << 0., 0., 0.;
         Optimizer::InertialOptimization(pCurrentMap,bg,ba);
         IMU::Bias b (ba[0],ba[1],ba[2],bg[0],bg[1],bg[2]);
-        unique_lock<mutex> lock(mpAtlas->GetCurrentMap()->mMutexMapUpdate);
+        unique_lock<mutex> lock = TracedLock(mpAtlas->GetCurrentMap()->mMutexMapUpdate, "Wait mMutexMapUpdate");
         mpTracker->UpdateFrameIMU(1.0f,b,mpTracker->GetLastKeyFrame());
 
         // Set map initialized
@@ -1901,8 +1838,8 @@ void LoopClosing::MergeLocal2()
 
             // Make sure connections are updated
             pKFi->UpdateMap(pCurrentMap);
-            pCurrentMap->AddKeyFrame(pKFi);
             pMergeMap->EraseKeyFrame(pKFi);
+            pCurrentMap->AddKeyFrame(pKFi);
         }
 
         for(MapPoint* pMPi : vpMergeMapMPs)
@@ -1911,8 +1848,8 @@ void LoopClosing::MergeLocal2()
                 continue;
 
             pMPi->UpdateMap(pCurrentMap);
-            pCurrentMap->AddMapPoint(pMPi);
             pMergeMap->EraseMapPoint(pMPi);
+            pCurrentMap->AddMapPoint(pMPi);
         }
 
         // Save non corrected poses (already merged maps)
@@ -2082,10 +2019,10 @@ void LoopClosing::CheckObservations(set<KeyFrame*> &spKFsMap1, set<KeyFrame*> &s
                 continue;
             }
 
-            map<KeyFrame*, tuple<int,int>> mMPijObs = pMPij->GetObservations();
+            const ObservationList mMPijObs = pMPij->GetObservations();
             for(KeyFrame* pKFi2 : spKFsMap2)
             {
-                if(mMPijObs.find(pKFi2) != mMPijObs.end())
+                if(mMPijObs.Find(pKFi2))
                 {
                     if(mMatchedMP.find(pKFi2) != mMatchedMP.end())
                     {
@@ -2138,7 +2075,7 @@ void LoopClosing::SearchAndFuse(const KeyFrameAndPose &CorrectedPosesMap, vector
         int numFused = matcher.Fuse(pKFi,Scw,vpMapPoints,4,vpReplacePoints);
 
         // Get Map Mutex
-        unique_lock<mutex> lock(pMap->mMutexMapUpdate);
+        unique_lock<mutex> lock = TracedLock(pMap->mMutexMapUpdate, "Wait mMutexMapUpdate");
         const int nLP = vpMapPoints.size();
         for(int i=0; i<nLP;i++)
         {
@@ -2183,7 +2120,7 @@ void LoopClosing::SearchAndFuse(const vector<KeyFrame*> &vConectedKFs, vector<Ma
         matcher.Fuse(pKF,Scw,vpMapPoints,4,vpReplacePoints);
 
         // Get Map Mutex
-        unique_lock<mutex> lock(pMap->mMutexMapUpdate);
+        unique_lock<mutex> lock = TracedLock(pMap->mMutexMapUpdate, "Wait mMutexMapUpdate");
         const int nLP = vpMapPoints.size();
         for(int i=0; i<nLP;i++)
         {
@@ -2273,15 +2210,12 @@ void LoopClosing::ResetIfRequested()
 void LoopClosing::RunGlobalBundleAdjustment(Map* pActiveMap, unsigned long nLoopKF)
 {  
     Verbose::PrintMess("Starting Global Bundle Adjustment", Verbose::VERBOSITY_NORMAL);
+    Trace::SetThreadName("GlobalBA");
 
-#ifdef REGISTER_TIMES
-    std::chrono::steady_clock::time_point time_StartFGBA = std::chrono::steady_clock::now();
+    // The key frames of the map stay readable until the end of the global BA
+    Reclaimer::Participant reclaimerParticipant;
 
-    nFGBA_exec += 1;
-
-    vnGBAKFs.push_back(pActiveMap->GetAllKeyFrames().size());
-    vnGBAMPs.push_back(pActiveMap->GetAllMapPoints().size());
-#endif
+    std::chrono::steady_clock::time_point time_StartFGBA = std::chrono::steady_clock::now();
 
     const bool bImuInit = pActiveMap->isImuInitialized();
 
@@ -2290,17 +2224,9 @@ void LoopClosing::RunGlobalBundleAdjustment(Map* pActiveMap, unsigned long nLoop
     else
         Optimizer::FullInertialBA(pActiveMap,7,false,nLoopKF,&mbStopGBA);
 
-#ifdef REGISTER_TIMES
     std::chrono::steady_clock::time_point time_EndGBA = std::chrono::steady_clock::now();
 
-    double timeGBA = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndGBA - time_StartFGBA).count();
-    vdGBA_ms.push_back(timeGBA);
-
-    if(mbStopGBA)
-    {
-        nFGBA_abort += 1;
-    }
-#endif
+    Stats::Record(SLAM_STAT_ID("LoopClosing::GlobalBA"), time_StartFGBA, time_EndGBA);
 
     int idx =  mnFullBAIdx;
     // Optimizer::GlobalBundleAdjustemnt(mpMap,10,&mbStopGBA,nLoopKF,false);
@@ -2331,7 +2257,7 @@ void LoopClosing::RunGlobalBundleAdjustment(Map* pActiveMap, unsigned long nLoop
             }
 
             // Get Map Mutex
-            unique_lock<mutex> lock(pActiveMap->mMutexMapUpdate);
+            unique_lock<mutex> lock = TracedLock(pActiveMap->mMutexMapUpdate, "Wait mMutexMapUpdate");
             // cout << "LC: Update Map Mutex adquired" << endl;
 
             //pActiveMap->PrintEssentialGraph();
@@ -2455,7 +2381,8 @@ void LoopClosing::RunGlobalBundleAdjustment(Map* pActiveMap, unsigned long nLoop
 
             //cout << "GBA: Correct MapPoints" << endl;
             // Correct MapPoints
-            const vector<MapPoint*> vpMPs = pActiveMap->GetAllMapPoints();
+            const SlotMap<MapPoint>::Snapshot pMPs = pActiveMap->GetMapPointSnapshot();
+            const vector<MapPoint*>& vpMPs = *pMPs;
 
             for(size_t i=0; i<vpMPs.size(); i++)
             {
@@ -2498,15 +2425,11 @@ void LoopClosing::RunGlobalBundleAdjustment(Map* pActiveMap, unsigned long nLoop
 
             mpLocalMapper->Release();
 
-#ifdef REGISTER_TIMES
             std::chrono::steady_clock::time_point time_EndUpdateMap = std::chrono::steady_clock::now();
 
-            double timeUpdateMap = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndUpdateMap - time_EndGBA).count();
-            vdUpdateMap_ms.push_back(timeUpdateMap);
+            Stats::Record(SLAM_STAT_ID("LoopClosing::GlobalBAUpdateMap"), time_EndGBA, time_EndUpdateMap);
 
-            double timeFGBA = std::chrono::duration_cast<std::chrono::duration<double,std::milli> >(time_EndUpdateMap - time_StartFGBA).count();
-            vdFGBATotal_ms.push_back(timeFGBA);
-#endif
+            Stats::Record(SLAM_STAT_ID("LoopClosing::GlobalBATotal"), time_StartFGBA, time_EndUpdateMap);
             Verbose::PrintMess("Map updated!", Verbose::VERBOSITY_NORMAL);
         }
 
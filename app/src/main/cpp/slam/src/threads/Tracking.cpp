@@ -31,6 +31,8 @@
 
 #include "utils/Converter.h"
 #include "utils/GeometricTools.h"
+#include "utils/Stats.h"
+#include "utils/Trace.h"
 
 #include "solver/G2oTypes.h"
 #include "solver/Optimizer.h"
@@ -60,6 +62,11 @@ namespace ORB_SLAM3
         , mbOnlyTracking(false)
         , mbMapUpdated(false)
         , mbVO(false)
+        , mpORBextractorLeft(nullptr)
+        , mpORBextractorRight(nullptr)
+        , mpIniORBextractor(nullptr)
+        , mpExtractorPool(nullptr)
+        , mpBowThread(new TaskThread("TrackingBoW"))
         , mpORBVocabulary(pVoc)
         , mpKeyFrameDB(pKFDB)
         , mbReadyToInitializate(false)
@@ -72,6 +79,11 @@ namespace ORB_SLAM3
         , mnFirstFrameId(0)
         , mpCamera2(nullptr)
         , mpLastKeyFrame(static_cast<KeyFrame*>(NULL))
+        , mTime_ORBExtract(0.0)
+        , mTime_PreIntIMU(0.0)
+        , mTime_PosePred(0.0)
+        , mTime_LocalMapTrack(0.0)
+        , mTime_NewKF_Dec(0.0)
     {
         // Load camera parameters from settings file
         if (settings) {
@@ -147,6 +159,9 @@ namespace ORB_SLAM3
     {
         //f_track_stats.close();
 
+        // The Bag of Words task runs on the extractor pool
+        delete mpBowThread;
+        delete mpExtractorPool;
     }
 
     void Tracking::newParameterLoader(Settings* settings)
@@ -216,6 +231,11 @@ namespace ORB_SLAM3
         if (mSensor == System::MONOCULAR || mSensor == System::IMU_MONOCULAR)
             mpIniORBextractor = new ORBextractor(5 * nFeatures, fScaleFactor, nLevels, fIniThFAST, fMinThFAST);
 
+        SetExtractorThreads(settings->extractorThreads());
+        SetDescriptorAngleMode(settings->continuousAngle() ? OrbDescriptor::ANGLE_CONTINUOUS : OrbDescriptor::ANGLE_BINS);
+        SetKeyPointDistribution(settings->keyPointDistribution() == 0 ? ORBextractor::DISTRIBUTION_LIST
+                                                                       : ORBextractor::DISTRIBUTION_ARENA);
+
         //IMU parameters
         Sophus::SE3f Tbc = settings->Tbc();
         mInsertKFsLost = settings->insertKFsWhenLost();
@@ -902,16 +922,73 @@ namespace ORB_SLAM3
         if (mSensor == System::MONOCULAR || mSensor == System::IMU_MONOCULAR)
             mpIniORBextractor = new ORBextractor(5 * nFeatures, fScaleFactor, nLevels, fIniThFAST, fMinThFAST);
 
+        int nExtractorThreads = 1;
+        node = fSettings["ORBextractor.nThreads"];
+        if (!node.empty() && node.isInt())
+        {
+            nExtractorThreads = node.operator int();
+        }
+        SetExtractorThreads(nExtractorThreads);
+
+        bool bContinuousAngle = false;
+        node = fSettings["ORBextractor.continuousAngle"];
+        if (!node.empty() && node.isInt())
+        {
+            bContinuousAngle = node.operator int() != 0;
+        }
+        SetDescriptorAngleMode(bContinuousAngle ? OrbDescriptor::ANGLE_CONTINUOUS : OrbDescriptor::ANGLE_BINS);
+
+        int nDistribution = 1;
+        node = fSettings["ORBextractor.distribution"];
+        if (!node.empty() && node.isInt())
+        {
+            nDistribution = node.operator int();
+        }
+        SetKeyPointDistribution(nDistribution == 0 ? ORBextractor::DISTRIBUTION_LIST : ORBextractor::DISTRIBUTION_ARENA);
+
         cout << endl << "ORB Extractor Parameters: " << endl;
         cout << "- Number of Features: " << nFeatures << endl;
         cout << "- Scale Levels: " << nLevels << endl;
         cout << "- Scale Factor: " << fScaleFactor << endl;
         cout << "- Initial Fast Threshold: " << fIniThFAST << endl;
         cout << "- Minimum Fast Threshold: " << fMinThFAST << endl;
+        cout << "- Extractor Threads: " << nExtractorThreads << endl;
+        cout << "- Descriptor Angle: " << (bContinuousAngle ? "continuous" : "30 bins") << endl;
+        cout << "- Key Point Distribution: " << (nDistribution == 0 ? "list" : "arena") << endl;
 
         return true;
     }
 
+    void Tracking::SetExtractorThreads(int nThreads)
+    {
+        delete mpExtractorPool;
+        mpExtractorPool = nThreads > 1 ? new WorkerPool(nThreads) : nullptr;
+
+        for (ORBextractor* pExtractor : {mpORBextractorLeft, mpORBextractorRight, mpIniORBextractor})
+        {
+            if (pExtractor)
+                pExtractor->SetWorkerPool(mpExtractorPool);
+        }
+    }
+
+    void Tracking::SetDescriptorAngleMode(OrbDescriptor::AngleMode mode)
+    {
+        for (ORBextractor* pExtractor : {mpORBextractorLeft, mpORBextractorRight, mpIniORBextractor})
+        {
+            if (pExtractor)
+                pExtractor->SetDescriptorAngleMode(mode);
+        }
+    }
+
+    void Tracking::SetKeyPointDistribution(ORBextractor::Distribution distribution)
+    {
+        for (ORBextractor* pExtractor : {mpORBextractorLeft, mpORBextractorRight, mpIniORBextractor})
+        {
+            if (pExtractor)
+                pExtractor->SetDistribution(distribution);
+        }
+    }
+
     bool Tracking::ParseIMUParamFile(cv::FileStorage& fSettings)
     {
         bool b_miss_params = false;
@@ -1088,6 +1165,8 @@ namespace ORB_SLAM3
 
         //cout << "Incoming frame creation" << endl;
 
+        std::chrono::steady_clock::time_point time_StartExtORB = std::chrono::steady_clock::now();
+
         if (mSensor == System::STEREO && !mpCamera2)
         {
             //mCurrentFrame = Frame(mImGray, imGrayRight, timestamp, mpORBextractorLeft, mpORBextractorRight, mpORBVocabulary, mK, mDistCoef, mbf, mThDepth, mpCamera);
@@ -1111,6 +1190,9 @@ namespace ORB_SLAM3
 
         //cout << "Incoming frame ended" << endl;
 
+        std::chrono::steady_clock::time_point time_EndExtORB = std::chrono::steady_clock::now();
+        mTime_ORBExtract = Stats::Record(SLAM_STAT_ID("Tracking::ORBExtract"), time_StartExtORB, time_EndExtORB);
+
         mCurrentFrame.mNameFile = filename;
         mCurrentFrame.mnDataset = mnNumDataset;
 
@@ -1145,6 +1227,8 @@ namespace ORB_SLAM3
         if ((fabs(mDepthMapFactor - 1.0f) > 1e-5) || imDepth.type() != CV_32F)
             imDepth.convertTo(imDepth, CV_32F, mDepthMapFactor);
 
+        std::chrono::steady_clock::time_point time_StartExtORB = std::chrono::steady_clock::now();
+
         if (mSensor == System::RGBD)
         {
             //mCurrentFrame = Frame(mImGray, imDepth, timestamp, mpORBextractorLeft, mpORBVocabulary, mK, mDistCoef, mbf, mThDepth, mpCamera);
@@ -1156,6 +1240,8 @@ namespace ORB_SLAM3
             mCurrentFrame.reset(mImGray, imDepth, timestamp, mpORBextractorLeft, mpORBVocabulary, mK, mDistCoef, mbf, mThDepth, mpCamera, &mLastFrame, *mpImuCalib);
         }
 
+        std::chrono::steady_clock::time_point time_EndExtORB = std::chrono::steady_clock::now();
+        mTime_ORBExtract = Stats::Record(SLAM_STAT_ID("Tracking::ORBExtract"), time_StartExtORB, time_EndExtORB);
 
         mCurrentFrame.mNameFile = filename;
         mCurrentFrame.mnDataset = mnNumDataset;
@@ -1178,6 +1264,8 @@ namespace ORB_SLAM3
             cvtColor(mImGray, mImGray, (mbRGB ? cv::COLOR_RGBA2GRAY : cv::COLOR_BGRA2GRAY));
         }
 
+        std::chrono::steady_clock::time_point time_StartExtORB = std::chrono::steady_clock::now();
+
         if (mSensor == System::MONOCULAR)
         {
             if (mState == NOT_INITIALIZED || mState == NO_IMAGES_YET || (lastID - initID) < mMaxFrames)
@@ -1205,6 +1293,9 @@ namespace ORB_SLAM3
             }
         }
 
+        std::chrono::steady_clock::time_point time_EndExtORB = std::chrono::steady_clock::now();
+        mTime_ORBExtract = Stats::Record(SLAM_STAT_ID("Tracking::ORBExtract"), time_StartExtORB, time_EndExtORB);
+
         if (mState == NO_IMAGES_YET)
         {
             t0 = timestamp;
@@ -1393,6 +1484,12 @@ namespace ORB_SLAM3
 
     void Tracking::Track()
     {
+        Trace::SetThreadName("Tracking");
+        SLAM_SCOPED_TIMER("Tracking::Track");
+
+        // Key frames kept from the previous frame are checked for isBad() before their features are read
+        mReclaimerParticipant.Quiescent();
+
         if (mpLocalMapper->mbBadImu)
         {
             cout << "TRACK: Reset map because local mapper set the bad imu flag " << endl;
@@ -1454,16 +1551,30 @@ namespace ORB_SLAM3
         }
         mLastProcessedState = mState;
 
+        // When the pose prediction is sure to go through the reference keyframe or relocalization, the Bag of
+        // Words is computed while the IMU is preintegrated, the map is locked and the motion model is tried
+        if (PredictionNeedsBoW(ChoosePosePrediction(pCurrentMap)))
+            StartComputeBoW();
+
+        mTime_PreIntIMU = 0.0;
+        mTime_PosePred = 0.0;
+        mTime_LocalMapTrack = 0.0;
+        mTime_NewKF_Dec = 0.0;
+
         if ((mSensor == System::IMU_MONOCULAR || mSensor == System::IMU_STEREO || mSensor == System::IMU_RGBD) &&
             !mbCreatedMap)
         {
+            std::chrono::steady_clock::time_point time_StartPreIMU = std::chrono::steady_clock::now();
             PreintegrateIMU();
+            std::chrono::steady_clock::time_point time_EndPreIMU = std::chrono::steady_clock::now();
+
+            mTime_PreIntIMU = Stats::Record(SLAM_STAT_ID("Tracking::PreintegrateIMU"), time_StartPreIMU, time_EndPreIMU);
         }
         mbCreatedMap = false;
 
 
         // Get Map Mutex -> Map cannot be changed
-        unique_lock<mutex> lock(pCurrentMap->mMutexMapUpdate);
+        unique_lock<mutex> lock = TracedLock(pCurrentMap->mMutexMapUpdate, "Wait mMutexMapUpdate");
 
         mbMapUpdated = false;
 
@@ -1506,6 +1617,11 @@ namespace ORB_SLAM3
             // System is initialized. Track Frame.
             bool bOK;
 
+            // Chosen again now that the map is locked, the IMU initialization may have finished meanwhile
+            const ePosePrediction prediction = ChoosePosePrediction(pCurrentMap);
+
+            std::chrono::steady_clock::time_point time_StartPosePred = std::chrono::steady_clock::now();
+
             // Initial camera pose estimation using motion model or relocalization (if tracking is lost)
             if (!mbOnlyTracking)
             {
@@ -1517,7 +1633,7 @@ namespace ORB_SLAM3
                     // Local Mapping might have changed some MapPoints tracked in last frame
                     CheckReplacedInLastFrame();
 
-                    if ((!mbVelocity && !pCurrentMap->isImuInitialized()) || mCurrentFrame.mnId < mnLastRelocFrameId + 2)
+                    if (prediction == PREDICTION_REFERENCE_KF)
                     {
                         Verbose::PrintMess("TRACK: Track with respect to the reference KF ", Verbose::VERBOSITY_DEBUG);
                         bOK = TrackReferenceKeyFrame();
@@ -1558,7 +1674,7 @@ namespace ORB_SLAM3
                         Verbose::PrintMess("Lost for a short time", Verbose::VERBOSITY_NORMAL);
 
                         bOK = true;
-                        if ((mSensor == System::IMU_MONOCULAR || mSensor == System::IMU_STEREO || mSensor == System::IMU_RGBD))
+                        if (prediction == PREDICTION_IMU)
                         {
                             if (pCurrentMap->isImuInitialized())
                             {
@@ -1616,7 +1732,7 @@ namespace ORB_SLAM3
             else
             {
                 // Localization Mode: Local Mapping is deactivated (TODO Not available in inertial mode)
-                if (mState == LOST)
+                if (prediction == PREDICTION_RELOCALIZATION)
                 {
                     if (mSensor == System::IMU_MONOCULAR || mSensor == System::IMU_STEREO || mSensor == System::IMU_RGBD)
                         Verbose::PrintMess("IMU. State LOST", Verbose::VERBOSITY_NORMAL);
@@ -1624,10 +1740,10 @@ namespace ORB_SLAM3
                 }
                 else
                 {
-                    if (!mbVO)
+                    if (prediction != PREDICTION_VO)
                     {
                         // In last frame we tracked enough MapPoints in the map
-                        if (mbVelocity)
+                        if (prediction == PREDICTION_MOTION_MODEL)
                         {
                             bOK = TrackWithMotionModel();
                         }
@@ -1685,9 +1801,16 @@ namespace ORB_SLAM3
                 }
             }
 
+            mpBowThread->Wait();
+
             if (!mCurrentFrame.mpReferenceKF)
                 mCurrentFrame.mpReferenceKF = mpReferenceKF;
 
+            std::chrono::steady_clock::time_point time_EndPosePred = std::chrono::steady_clock::now();
+            mTime_PosePred = Stats::Record(SLAM_STAT_ID("Tracking::PosePrediction"), time_StartPosePred, time_EndPosePred);
+
+            std::chrono::steady_clock::time_point time_StartLMTrack = std::chrono::steady_clock::now();
+
             // If we have an initial estimation of the camera pose and matching. Track the local map.
             if (!mbOnlyTracking)
             {
@@ -1708,6 +1831,9 @@ namespace ORB_SLAM3
                     bOK = TrackLocalMap();
             }
 
+            std::chrono::steady_clock::time_point time_EndLMTrack = std::chrono::steady_clock::now();
+            mTime_LocalMapTrack = Stats::Record(SLAM_STAT_ID("Tracking::TrackLocalMap"), time_StartLMTrack, time_EndLMTrack);
+
             if (bOK)
                 mState = OK;
             else if (mState == OK)
@@ -1796,9 +1922,7 @@ namespace ORB_SLAM3
                 }
                 mlpTemporalPoints.clear();
 
-#ifdef REGISTER_TIMES
                 std::chrono::steady_clock::time_point time_StartNewKF = std::chrono::steady_clock::now();
-#endif
                 bool bNeedKF = NeedNewKeyFrame();
 
                 // Check if we need to insert a new keyframe
@@ -1807,12 +1931,8 @@ namespace ORB_SLAM3
                     (mSensor == System::IMU_MONOCULAR || mSensor == System::IMU_STEREO || mSensor == System::IMU_RGBD))))
                     CreateNewKeyFrame();
 
-#ifdef REGISTER_TIMES
                 std::chrono::steady_clock::time_point time_EndNewKF = std::chrono::steady_clock::now();
-
-                double timeNewKF = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(time_EndNewKF - time_StartNewKF).count();
-                vdNewKF_ms.push_back(timeNewKF);
-#endif
+                mTime_NewKF_Dec = Stats::Record(SLAM_STAT_ID("Tracking::NewKeyFrameDecision"), time_StartNewKF, time_EndNewKF);
 
                 // We allow points with high innovation (considererd outliers by the Huber Function)
                 // pass to the new keyframe, so that bundle adjustment will finally decide
@@ -2090,8 +2210,8 @@ namespace ORB_SLAM3
             pKFini->mpImuPreintegrated = nullptr;
 
 
-        pKFini->ComputeBoW();
-        pKFcur->ComputeBoW();
+        pKFini->ComputeBoW(mpExtractorPool);
+        pKFcur->ComputeBoW(mpExtractorPool);
 
         // Insert KFs in the map
         mpAtlas->AddKeyFrame(pKFini);
@@ -2280,17 +2400,75 @@ namespace ORB_SLAM3
     }
 
 
+    Tracking::ePosePrediction Tracking::ChoosePosePrediction(Map* pCurrentMap) const
+    {
+        if (mState == NO_IMAGES_YET || mState == NOT_INITIALIZED)
+            return PREDICTION_NONE;
+
+        if (!mbOnlyTracking)
+        {
+            if (mState == OK)
+            {
+                if ((!mbVelocity && !pCurrentMap->isImuInitialized()) || mCurrentFrame.mnId < mnLastRelocFrameId + 2)
+                    return PREDICTION_REFERENCE_KF;
+                return PREDICTION_MOTION_MODEL;
+            }
+            if (mState == RECENTLY_LOST)
+            {
+                if (mSensor == System::IMU_MONOCULAR || mSensor == System::IMU_STEREO || mSensor == System::IMU_RGBD)
+                    return PREDICTION_IMU;
+                return PREDICTION_RELOCALIZATION;
+            }
+            // Lost, a new map is started
+            return PREDICTION_NONE;
+        }
+
+        if (mState == LOST)
+            return PREDICTION_RELOCALIZATION;
+        if (mbVO)
+            return PREDICTION_VO;
+        return mbVelocity ? PREDICTION_MOTION_MODEL : PREDICTION_REFERENCE_KF;
+    }
+
+    bool Tracking::PredictionNeedsBoW(ePosePrediction prediction)
+    {
+        // The motion model computes it only when it falls back to the reference keyframe
+        return prediction == PREDICTION_REFERENCE_KF || prediction == PREDICTION_RELOCALIZATION ||
+               prediction == PREDICTION_VO;
+    }
+
+    void Tracking::StartComputeBoW()
+    {
+        if (mpBowThread->Pending() || !mCurrentFrame.mBowVec.empty())
+            return;
+
+        // Only the vectors of the frame are written, which the pose prediction does not read until
+        // ComputeBoW()
+        mpBowThread->Submit([this] { mCurrentFrame.ComputeBoW(mpExtractorPool); });
+    }
+
+    void Tracking::ComputeBoW()
+    {
+        if (!mpBowThread->Wait())
+            mCurrentFrame.ComputeBoW(mpExtractorPool);
+    }
+
     bool Tracking::TrackReferenceKeyFrame()
     {
         // Compute Bag of Words vector
-        mCurrentFrame.ComputeBoW();
+        ComputeBoW();
 
         // We perform first an ORB matching with the reference keyframe
         // If enough matches are found we setup a PnP solver
         ORBmatcher matcher(0.7, true);
         vector<MapPoint*> vpMapPointMatches;
 
-        int nmatches = matcher.SearchByBoW(mpReferenceKF, mCurrentFrame, vpMapPointMatches);
+        // The features of a culled reference keyframe may be released, match its parent instead
+        KeyFrame* pRefKF = mpReferenceKF;
+        while (pRefKF->isBad() && pRefKF->GetParent())
+            pRefKF = pRefKF->GetParent();
+
+        int nmatches = pRefKF->isBad() ? 0 : matcher.SearchByBoW(pRefKF, mCurrentFrame, vpMapPointMatches);
 
         if (nmatches < 15)
         {
@@ -2928,23 +3106,38 @@ namespace ORB_SLAM3
         int nToMatch = 0;
 
         // Project points in frame and check its visibility
-        for (vector<MapPoint*>::iterator vit = mvpLocalMapPoints.begin(), vend = mvpLocalMapPoints.end(); vit != vend; vit++)
+        const bool bProjection = mCurrentFrame.Nleft == -1;
+        if (bProjection)
         {
-            MapPoint* pMP = *vit;
-
-            if (pMP->mnLastFrameSeen == mCurrentFrame.mnId)
-                continue;
-            if (pMP->isBad())
-                continue;
-            // Project (this fills MapPoint variables for matching)
-            if (mCurrentFrame.isInFrustum(pMP, 0.5))
+            // All the points at once, from the snapshot taken by UpdateLocalMap()
+            nToMatch = mLocalMapProjection.Project(mCurrentFrame, 0.5f);
+            for (int k = 0; k < nToMatch; k++)
             {
+                MapPoint* pMP = mLocalMapProjection.Point(k);
                 pMP->IncreaseVisible();
-                nToMatch++;
+                mCurrentFrame.mmProjectPoints[pMP->mnId] = cv::Point2f(mLocalMapProjection.ProjX(k), mLocalMapProjection.ProjY(k));
             }
-            if (pMP->mbTrackInView)
+        }
+        else
+        {
+            for (vector<MapPoint*>::iterator vit = mvpLocalMapPoints.begin(), vend = mvpLocalMapPoints.end(); vit != vend; vit++)
             {
-                mCurrentFrame.mmProjectPoints[pMP->mnId] = cv::Point2f(pMP->mTrackProjX, pMP->mTrackProjY);
+                MapPoint* pMP = *vit;
+
+                if (pMP->mnLastFrameSeen == mCurrentFrame.mnId)
+                    continue;
+                if (pMP->isBad())
+                    continue;
+                // Project (this fills MapPoint variables for matching)
+                if (mCurrentFrame.isInFrustum(pMP, 0.5))
+                {
+                    pMP->IncreaseVisible();
+                    nToMatch++;
+                }
+                if (pMP->mbTrackInView)
+                {
+                    mCurrentFrame.mmProjectPoints[pMP->mnId] = cv::Point2f(pMP->mTrackProjX, pMP->mTrackProjY);
+                }
             }
         }
 
@@ -2973,7 +3166,11 @@ namespace ORB_SLAM3
             if (mState == LOST || mState == RECENTLY_LOST) // Lost for less than 1 second
                 th = 15; // 15
 
-            int matches = matcher.SearchByProjection(mCurrentFrame, mvpLocalMapPoints, th, mpLocalMapper->mbFarPoints, mpLocalMapper->mThFarPoints);
+            int matches;
+            if (bProjection)
+                matches = matcher.SearchByProjection(mCurrentFrame, mLocalMapProjection, th, mpLocalMapper->mbFarPoints, mpLocalMapper->mThFarPoints);
+            else
+                matches = matcher.SearchByProjection(mCurrentFrame, mvpLocalMapPoints, th, mpLocalMapper->mbFarPoints, mpLocalMapper->mThFarPoints);
         }
     }
 
@@ -2985,6 +3182,9 @@ namespace ORB_SLAM3
         // Update
         UpdateLocalKeyFrames();
         UpdateLocalPoints();
+
+        if (mCurrentFrame.Nleft == -1)
+            mLocalMapProjection.Reset(mvpLocalMapPoints);
     }
 
     void Tracking::UpdateLocalPoints()
@@ -3030,9 +3230,7 @@ namespace ORB_SLAM3
                 {
                     if (!pMP->isBad())
                     {
-                        const map<KeyFrame*, tuple<int, int>> observations = pMP->GetObservations();
-                        for (map<KeyFrame*, tuple<int, int>>::const_iterator it = observations.begin(), itend = observations.end(); it != itend; it++)
-                            keyframeCounter[it->first]++;
+                        pMP->ForEachObservation([&keyframeCounter](const Observation& obs) { keyframeCounter[obs.pKF]++; });
                     }
                     else
                     {
@@ -3053,9 +3251,7 @@ namespace ORB_SLAM3
                         continue;
                     if (!pMP->isBad())
                     {
-                        const map<KeyFrame*, tuple<int, int>> observations = pMP->GetObservations();
-                        for (map<KeyFrame*, tuple<int, int>>::const_iterator it = observations.begin(), itend = observations.end(); it != itend; it++)
-                            keyframeCounter[it->first]++;
+                        pMP->ForEachObservation([&keyframeCounter](const Observation& obs) { keyframeCounter[obs.pKF]++; });
                     }
                     else
                     {
@@ -3100,12 +3296,12 @@ namespace ORB_SLAM3
 
             KeyFrame* pKF = *itKF;
 
-            const vector<KeyFrame*> vNeighs = pKF->GetBestCovisibilityKeyFrames(10);
+            const CovisibilityEdges::Snapshot pNeighs = pKF->GetCovisibles();
 
 
-            for (vector<KeyFrame*>::const_iterator itNeighKF = vNeighs.begin(), itEndNeighKF = vNeighs.end(); itNeighKF != itEndNeighKF; itNeighKF++)
+            for (size_t iN = 0, iNend = pNeighs->CountBest(10); iN < iNend; iN++)
             {
-                KeyFrame* pNeighKF = *itNeighKF;
+                KeyFrame* pNeighKF = pNeighs->vpKeyFrames[iN];
                 if (!pNeighKF->isBad())
                 {
                     if (pNeighKF->mnTrackReferenceForFrame != mCurrentFrame.mnId)
@@ -3173,7 +3369,7 @@ namespace ORB_SLAM3
     {
         Verbose::PrintMess("Starting relocalization", Verbose::VERBOSITY_NORMAL);
         // Compute Bag of Words Vector
-        mCurrentFrame.ComputeBoW();
+        ComputeBoW();
 
         // Relocalization is performed when tracking is lost
         // Track Lost: Query KeyFrame Database for keyframe candidates for relocalisation
@@ -3433,7 +3629,7 @@ namespace ORB_SLAM3
         cout << "mnFirstFrameId = " << mnFirstFrameId << endl;
         for (Map* pMap : mpAtlas->GetAllMaps())
         {
-            if (pMap->GetAllKeyFrames().size() > 0)
+            if (pMap->KeyFramesInMap() > 0)
             {
                 if (index > pMap->GetLowerKFID())
                     index = pMap->GetLowerKFID();
@@ -0,0 +1,229 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "utils/ObjectPool.h"
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+namespace ORB_SLAM3
+{
+
+namespace
+{
+
+const size_t SLAB_BYTES = 64 * 1024;
+const size_t MIN_CHUNKS_PER_SLAB = 16;
+
+std::mutex gMutexPools;
+FixedPool* gvpPools[FixedPool::MAX_POOLS];
+int gnPools = 0;
+
+size_t AlignUp(size_t n, size_t nAlign)
+{
+    return (n + nAlign - 1) / nAlign * nAlign;
+}
+
+} // namespace
+
+namespace
+{
+
+// Set when the cache of the thread is destroyed. Objects freed later in the thread or static teardown, and
+// allocated then, go straight to the shared free lists. Trivially destructible so it outlives the cache.
+thread_local bool gbThreadCacheGone = false;
+
+} // namespace
+
+// Free chunks of every pool kept by one thread, given back when the thread ends.
+struct PoolThreadCache
+{
+    FixedPool::Node* mpFree[FixedPool::MAX_POOLS] = {};
+    int mnFree[FixedPool::MAX_POOLS] = {};
+
+    ~PoolThreadCache()
+    {
+        gbThreadCacheGone = true;
+        for(int i=0; i<FixedPool::MAX_POOLS; i++)
+        {
+            if(!mpFree[i])
+                continue;
+
+            FixedPool::Node* pLast = mpFree[i];
+            while(pLast->pNext)
+                pLast = pLast->pNext;
+            gvpPools[i]->Release(mpFree[i], pLast);
+        }
+    }
+};
+
+namespace
+{
+
+thread_local PoolThreadCache gThreadCache;
+
+} // namespace
+
+FixedPool::FixedPool(const char* name, size_t nSize, size_t nAlign)
+    : mName(name)
+    , mnChunkSize(AlignUp(std::max(nSize, sizeof(Node)), std::max(nAlign, alignof(std::max_align_t))))
+    , mnAlign(std::max(nAlign, alignof(std::max_align_t)))
+    , mnChunksPerSlab(std::max(MIN_CHUNKS_PER_SLAB, SLAB_BYTES / mnChunkSize))
+    , mpFree(nullptr)
+    , mnLive(0)
+{
+    std::unique_lock<std::mutex> lock(gMutexPools);
+    if(gnPools >= MAX_POOLS)
+        throw std::length_error("Too many object pools, raise FixedPool::MAX_POOLS.");
+    mnId = gnPools++;
+    gvpPools[mnId] = this;
+}
+
+void* FixedPool::Allocate()
+{
+    if(gbThreadCacheGone)
+    {
+        int nCount;
+        Node* pNode = Refill(nCount);
+        if(!pNode)
+            throw std::bad_alloc();
+        if(pNode->pNext)
+        {
+            Node* pLast = pNode->pNext;
+            while(pLast->pNext)
+                pLast = pLast->pNext;
+            Release(pNode->pNext, pLast);
+        }
+        mnLive.fetch_add(1, std::memory_order_relaxed);
+        return pNode;
+    }
+
+    PoolThreadCache& cache = gThreadCache;
+    Node* pNode = cache.mpFree[mnId];
+    if(!pNode)
+    {
+        pNode = Refill(cache.mnFree[mnId]);
+        if(!pNode)
+            throw std::bad_alloc();
+    }
+
+    cache.mpFree[mnId] = pNode->pNext;
+    cache.mnFree[mnId]--;
+    mnLive.fetch_add(1, std::memory_order_relaxed);
+    return pNode;
+}
+
+void FixedPool::Free(void* p)
+{
+    Node* pNode = static_cast<Node*>(p);
+    if(gbThreadCacheGone)
+    {
+        Release(pNode, pNode);
+        mnLive.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
+
+    PoolThreadCache& cache = gThreadCache;
+    pNode->pNext = cache.mpFree[mnId];
+    cache.mpFree[mnId] = pNode;
+    cache.mnFree[mnId]++;
+    mnLive.fetch_sub(1, std::memory_order_relaxed);
+
+    // A thread freeing what others allocate (deferred deletions) hands its excess back in batches
+    if(cache.mnFree[mnId] >= 2*BATCH)
+    {
+        Node* pFirst = cache.mpFree[mnId];
+        Node* pLast = pFirst;
+        for(int i=1; i<BATCH; i++)
+            pLast = pLast->pNext;
+        cache.mpFree[mnId] = pLast->pNext;
+        cache.mnFree[mnId] -= BATCH;
+        Release(pFirst, pLast);
+    }
+}
+
+FixedPool::Node* FixedPool::Refill(int &nCount)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    if(!mpFree)
+    {
+        char* pSlab = static_cast<char*>(::operator new(mnChunkSize * mnChunksPerSlab, std::align_val_t(mnAlign),
+                                                        std::nothrow));
+        if(!pSlab)
+            return nullptr;
+        mvpSlabs.push_back(pSlab);
+
+        // Chunks are handed out in address order
+        for(size_t i=mnChunksPerSlab; i>0; i--)
+        {
+            Node* pNode = reinterpret_cast<Node*>(pSlab + (i-1) * mnChunkSize);
+            pNode->pNext = mpFree;
+            mpFree = pNode;
+        }
+    }
+
+    Node* pFirst = mpFree;
+    Node* pLast = pFirst;
+    nCount = 1;
+    while(nCount < BATCH && pLast->pNext)
+    {
+        pLast = pLast->pNext;
+        nCount++;
+    }
+    mpFree = pLast->pNext;
+    pLast->pNext = nullptr;
+    return pFirst;
+}
+
+void FixedPool::Release(Node* pFirst, Node* pLast)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    pLast->pNext = mpFree;
+    mpFree = pFirst;
+}
+
+FixedPool::Summary FixedPool::GetSummary()
+{
+    Summary summary;
+    summary.name = mName;
+    summary.nChunkSize = mnChunkSize;
+    const int64_t nLive = mnLive.load(std::memory_order_relaxed);
+    summary.nLive = nLive > 0 ? static_cast<uint64_t>(nLive) : 0;
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    summary.nSlabBytes = mvpSlabs.size() * mnChunksPerSlab * mnChunkSize;
+    return summary;
+}
+
+std::vector<FixedPool::Summary> FixedPool::GetSummaries()
+{
+    std::vector<FixedPool*> vpPools;
+    {
+        std::unique_lock<std::mutex> lock(gMutexPools);
+        vpPools.assign(gvpPools, gvpPools + gnPools);
+    }
+
+    std::vector<Summary> vSummaries;
+    for(FixedPool* pPool : vpPools)
+        vSummaries.push_back(pPool->GetSummary());
+    return vSummaries;
+}
+
+} //namespace ORB_SLAM3
@@ -281,6 +281,9 @@ namespace ORB_SLAM3 {
             nLevels_ = desc.orbInfo.nLevels;
             initThFAST_ = desc.orbInfo.initThFAST;
             minThFAST_ = desc.orbInfo.minThFAST;
+            extractorThreads_ = std::max(1, desc.orbInfo.nThreads);
+            continuousAngle_ = desc.orbInfo.continuousAngle;
+            keyPointDistribution_ = desc.orbInfo.distribution;
         }
 
         // read viewer
@@ -640,6 +643,15 @@ namespace ORB_SLAM3 {
         nLevels_ = readParameter<int>(fSettings, "ORBextractor.nLevels", found);
         initThFAST_ = readParameter<int>(fSettings, "ORBextractor.iniThFAST", found);
         minThFAST_ = readParameter<int>(fSettings, "ORBextractor.minThFAST", found);
+        extractorThreads_ = readParameter<int>(fSettings, "ORBextractor.nThreads", found, false);
+        if (!found || extractorThreads_ < 1)
+            extractorThreads_ = 1;
+        continuousAngle_ = readParameter<int>(fSettings, "ORBextractor.continuousAngle", found, false) != 0;
+        if (!found)
+            continuousAngle_ = false;
+        keyPointDistribution_ = readParameter<int>(fSettings, "ORBextractor.distribution", found, false);
+        if (!found)
+            keyPointDistribution_ = 1;
     }
 
     void Settings::readViewer(cv::FileStorage& fSettings) {
@@ -824,6 +836,9 @@ namespace ORB_SLAM3 {
         output << "\t-ORB number of scales: " << settings.nLevels_ << endl;
         output << "\t-Initial FAST threshold: " << settings.initThFAST_ << endl;
         output << "\t-Min FAST threshold: " << settings.minThFAST_ << endl;
+        output << "\t-ORB extractor threads: " << settings.extractorThreads_ << endl;
+        output << "\t-ORB descriptor angle: " << (settings.continuousAngle_ ? "continuous" : "30 bins") << endl;
+        output << "\t-ORB key point distribution: " << (settings.keyPointDistribution_ == 0 ? "list" : "arena") << endl;
 
         return output;
     }
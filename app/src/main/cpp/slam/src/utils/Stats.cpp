@@ -0,0 +1,268 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "utils/Stats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#include "utils/Trace.h"
+
+namespace ORB_SLAM3
+{
+
+namespace
+{
+
+struct TimerHistogram
+{
+    std::atomic<uint64_t> buckets[Stats::NUM_BUCKETS];
+    std::atomic<uint64_t> sumNs;
+    std::atomic<uint64_t> maxNs;
+};
+
+// Histograms written by one thread. Slots of finished threads are handed to the next new thread, so
+// short lived threads (global BA) do not grow the registry and their samples are kept.
+struct ThreadStats
+{
+    std::atomic<TimerHistogram*> timers[Stats::MAX_TIMERS];
+
+    ~ThreadStats()
+    {
+        for(int i=0; i<Stats::MAX_TIMERS; i++)
+            delete timers[i].load();
+    }
+};
+
+std::mutex gMutexRegistry;
+std::vector<std::string> gvTimerNames;
+std::atomic<const char*> gvpTimerNames[Stats::MAX_TIMERS];
+std::vector<std::unique_ptr<ThreadStats>> gvThreadStats;
+std::vector<ThreadStats*> gvFreeThreadStats;
+
+// Only the owner thread writes, a plain load + store is enough and avoids locked instructions.
+inline void Bump(std::atomic<uint64_t>& counter, uint64_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+struct ThreadSlot
+{
+    ThreadStats* pStats = nullptr;
+
+    ~ThreadSlot()
+    {
+        if(pStats)
+        {
+            std::unique_lock<std::mutex> lock(gMutexRegistry);
+            gvFreeThreadStats.push_back(pStats);
+        }
+    }
+};
+
+ThreadStats* GetThreadStats()
+{
+    thread_local ThreadSlot slot;
+    if(!slot.pStats)
+    {
+        std::unique_lock<std::mutex> lock(gMutexRegistry);
+        if(!gvFreeThreadStats.empty())
+        {
+            slot.pStats = gvFreeThreadStats.back();
+            gvFreeThreadStats.pop_back();
+        }
+        else
+        {
+            gvThreadStats.push_back(std::unique_ptr<ThreadStats>(new ThreadStats()));
+            slot.pStats = gvThreadStats.back().get();
+        }
+    }
+    return slot.pStats;
+}
+
+} // namespace
+
+int Stats::Register(const std::string& name)
+{
+    std::unique_lock<std::mutex> lock(gMutexRegistry);
+
+    auto it = std::find(gvTimerNames.begin(), gvTimerNames.end(), name);
+    if(it != gvTimerNames.end())
+        return static_cast<int>(it - gvTimerNames.begin());
+
+    if(gvTimerNames.size() >= MAX_TIMERS)
+        return -1;
+
+    gvTimerNames.push_back(name);
+    gvpTimerNames[gvTimerNames.size() - 1].store(strdup(name.c_str()), std::memory_order_release);
+    return static_cast<int>(gvTimerNames.size()) - 1;
+}
+
+void Stats::Record(int id, double ms)
+{
+    if(id < 0 || id >= MAX_TIMERS)
+        return;
+
+    ThreadStats* pStats = GetThreadStats();
+    TimerHistogram* pHist = pStats->timers[id].load(std::memory_order_relaxed);
+    if(!pHist)
+    {
+        pHist = new TimerHistogram();
+        pStats->timers[id].store(pHist, std::memory_order_release);
+    }
+
+    const uint64_t ns = ms > 0.0 ? static_cast<uint64_t>(ms * 1e6) : 0;
+    Bump(pHist->buckets[BucketOf(ns / 1000)], 1);
+    Bump(pHist->sumNs, ns);
+    if(ns > pHist->maxNs.load(std::memory_order_relaxed))
+        pHist->maxNs.store(ns, std::memory_order_relaxed);
+}
+
+double Stats::Record(int id, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    Record(id, ms);
+
+    if(Trace::IsEnabled())
+    {
+        const char* name = GetName(id);
+        if(name)
+            Trace::Complete(name, start, end);
+    }
+    return ms;
+}
+
+const char* Stats::GetName(int id)
+{
+    if(id < 0 || id >= MAX_TIMERS)
+        return nullptr;
+    return gvpTimerNames[id].load(std::memory_order_acquire);
+}
+
+std::vector<Stats::Summary> Stats::GetSummaries()
+{
+    std::vector<std::string> vNames;
+    std::vector<ThreadStats*> vpThreads;
+    {
+        std::unique_lock<std::mutex> lock(gMutexRegistry);
+        vNames = gvTimerNames;
+        for(const auto& pStats : gvThreadStats)
+            vpThreads.push_back(pStats.get());
+    }
+
+    std::vector<Summary> vSummaries;
+    std::vector<uint64_t> vBuckets(NUM_BUCKETS);
+    for(size_t id=0; id<vNames.size(); id++)
+    {
+        std::fill(vBuckets.begin(), vBuckets.end(), 0);
+        uint64_t count = 0;
+        uint64_t sumNs = 0;
+        uint64_t maxNs = 0;
+        for(ThreadStats* pStats : vpThreads)
+        {
+            TimerHistogram* pHist = pStats->timers[id].load(std::memory_order_acquire);
+            if(!pHist)
+                continue;
+
+            for(int b=0; b<NUM_BUCKETS; b++)
+                vBuckets[b] += pHist->buckets[b].load(std::memory_order_relaxed);
+            sumNs += pHist->sumNs.load(std::memory_order_relaxed);
+            maxNs = std::max(maxNs, pHist->maxNs.load(std::memory_order_relaxed));
+        }
+
+        for(int b=0; b<NUM_BUCKETS; b++)
+            count += vBuckets[b];
+        if(count == 0)
+            continue;
+
+        Summary summary;
+        summary.name = vNames[id];
+        summary.count = count;
+        summary.mean_ms = static_cast<double>(sumNs) / static_cast<double>(count) * 1e-6;
+        summary.max_ms = static_cast<double>(maxNs) * 1e-6;
+
+        const double vPercentiles[3] = {0.50, 0.95, 0.99};
+        double* vpOut[3] = {&summary.p50_ms, &summary.p95_ms, &summary.p99_ms};
+        for(int p=0; p<3; p++)
+        {
+            const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(vPercentiles[p] * count)));
+            uint64_t seen = 0;
+            int b = 0;
+            for(; b<NUM_BUCKETS-1; b++)
+            {
+                seen += vBuckets[b];
+                if(seen >= rank)
+                    break;
+            }
+            *vpOut[p] = std::min(BucketValueMs(b), summary.max_ms);
+        }
+
+        vSummaries.push_back(summary);
+    }
+
+    return vSummaries;
+}
+
+void Stats::Reset()
+{
+    std::unique_lock<std::mutex> lock(gMutexRegistry);
+    for(const auto& pStats : gvThreadStats)
+    {
+        for(int id=0; id<MAX_TIMERS; id++)
+        {
+            TimerHistogram* pHist = pStats->timers[id].load(std::memory_order_acquire);
+            if(!pHist)
+                continue;
+
+            // Samples recorded concurrently with the reset may survive it.
+            for(int b=0; b<NUM_BUCKETS; b++)
+                pHist->buckets[b].store(0, std::memory_order_relaxed);
+            pHist->sumNs.store(0, std::memory_order_relaxed);
+            pHist->maxNs.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+int Stats::BucketOf(uint64_t us)
+{
+    const uint64_t nSub = 1ull << SUB_BUCKET_BITS;
+    if(us < nSub)
+        return static_cast<int>(us);
+
+    const int msb = 63 - __builtin_clzll(us);
+    const int shift = msb - SUB_BUCKET_BITS;
+    const int bucket = ((shift + 1) << SUB_BUCKET_BITS) + static_cast<int>((us >> shift) & (nSub - 1));
+    return std::min(bucket, NUM_BUCKETS - 1);
+}
+
+double Stats::BucketValueMs(int bucket)
+{
+    const int nSub = 1 << SUB_BUCKET_BITS;
+    if(bucket < nSub)
+        return (bucket + 0.5) * 1e-3;
+
+    const int shift = (bucket >> SUB_BUCKET_BITS) - 1;
+    const double lower = static_cast<double>(static_cast<uint64_t>(nSub + (bucket & (nSub - 1))) << shift);
+    const double width = static_cast<double>(1ull << shift);
+    return (lower + 0.5 * width) * 1e-3;
+}
+
+} //namespace ORB_SLAM3
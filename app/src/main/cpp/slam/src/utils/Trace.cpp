@@ -0,0 +1,230 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "utils/Trace.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace ORB_SLAM3
+{
+
+std::atomic<bool> Trace::mbEnabled(false);
+
+namespace
+{
+
+struct TraceEvent
+{
+    const char* name;
+    int64_t startNs;
+    int64_t durationNs;
+    uint32_t tid;
+};
+
+// Ring of one thread. Only the owner writes the events, head is published after each write so a
+// reader can tell which slots may have been overwritten while it was copying them.
+struct ThreadBuffer
+{
+    TraceEvent events[Trace::EVENTS_PER_THREAD];
+    std::atomic<uint64_t> head;
+};
+
+const std::chrono::steady_clock::time_point gEpoch = std::chrono::steady_clock::now();
+
+std::mutex gMutexRegistry;
+std::vector<std::unique_ptr<ThreadBuffer>> gvBuffers;
+std::vector<ThreadBuffer*> gvFreeBuffers;
+std::map<uint32_t, const char*> gmThreadNames;
+uint32_t gnNextTid = 1;
+std::atomic<int64_t> gnClearedNs(0);
+
+inline int64_t ToNs(std::chrono::steady_clock::time_point t)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t - gEpoch).count();
+}
+
+// Buffers of finished threads are reused, every thread still gets its own tid in the events.
+// The buffer is only taken at the first event, so threads never traced cost nothing.
+struct ThreadSlot
+{
+    ThreadBuffer* pBuffer = nullptr;
+    uint32_t tid = 0;
+    const char* name = nullptr;
+
+    ~ThreadSlot()
+    {
+        if(pBuffer)
+        {
+            std::unique_lock<std::mutex> lock(gMutexRegistry);
+            gvFreeBuffers.push_back(pBuffer);
+        }
+    }
+};
+
+thread_local ThreadSlot tSlot;
+
+ThreadSlot& GetThreadSlot()
+{
+    ThreadSlot& slot = tSlot;
+    if(!slot.pBuffer)
+    {
+        std::unique_lock<std::mutex> lock(gMutexRegistry);
+        if(!gvFreeBuffers.empty())
+        {
+            slot.pBuffer = gvFreeBuffers.back();
+            gvFreeBuffers.pop_back();
+        }
+        else
+        {
+            gvBuffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+            slot.pBuffer = gvBuffers.back().get();
+        }
+        slot.tid = gnNextTid++;
+        if(slot.name)
+            gmThreadNames[slot.tid] = slot.name;
+    }
+    return slot;
+}
+
+void WriteJsonString(std::ofstream& f, const char* str)
+{
+    f << '"';
+    for(const char* c = str; *c; c++)
+    {
+        if(*c == '"' || *c == '\\')
+            f << '\\';
+        f << *c;
+    }
+    f << '"';
+}
+
+} // namespace
+
+void Trace::SetEnabled(bool bEnabled)
+{
+    mbEnabled.store(bEnabled, std::memory_order_relaxed);
+}
+
+void Trace::SetThreadName(const char* name)
+{
+    if(tSlot.name == name)
+        return;
+
+    tSlot.name = name;
+    if(tSlot.pBuffer)
+    {
+        std::unique_lock<std::mutex> lock(gMutexRegistry);
+        gmThreadNames[tSlot.tid] = name;
+    }
+}
+
+void Trace::Complete(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    ThreadSlot& slot = GetThreadSlot();
+    ThreadBuffer* pBuffer = slot.pBuffer;
+
+    const uint64_t idx = pBuffer->head.load(std::memory_order_relaxed);
+    TraceEvent& event = pBuffer->events[idx % EVENTS_PER_THREAD];
+    event.name = name;
+    event.startNs = ToNs(start);
+    event.durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    event.tid = slot.tid;
+    pBuffer->head.store(idx + 1, std::memory_order_release);
+}
+
+bool Trace::DumpChromeJson(const std::string& filename, double windowSeconds)
+{
+    std::vector<ThreadBuffer*> vpBuffers;
+    std::map<uint32_t, const char*> mThreadNames;
+    {
+        std::unique_lock<std::mutex> lock(gMutexRegistry);
+        for(const auto& pBuffer : gvBuffers)
+            vpBuffers.push_back(pBuffer.get());
+        mThreadNames = gmThreadNames;
+    }
+
+    const int64_t nowNs = ToNs(std::chrono::steady_clock::now());
+    const int64_t minEndNs = windowSeconds > 0.0 ? nowNs - static_cast<int64_t>(windowSeconds * 1e9) : 0;
+    const int64_t clearedNs = gnClearedNs.load(std::memory_order_relaxed);
+
+    std::vector<TraceEvent> vEvents;
+    for(ThreadBuffer* pBuffer : vpBuffers)
+    {
+        const uint64_t head = pBuffer->head.load(std::memory_order_acquire);
+        const uint64_t count = std::min<uint64_t>(head, EVENTS_PER_THREAD);
+
+        std::vector<TraceEvent> vCopy(count);
+        for(uint64_t i=0; i<count; i++)
+            vCopy[i] = pBuffer->events[(head - count + i) % EVENTS_PER_THREAD];
+
+        // The owner may have overwritten the oldest slots meanwhile, the slot of newHead is being written.
+        const uint64_t newHead = pBuffer->head.load(std::memory_order_acquire);
+        const uint64_t firstValid = newHead >= EVENTS_PER_THREAD ? newHead - EVENTS_PER_THREAD + 1 : 0;
+        for(uint64_t i=0; i<count; i++)
+        {
+            const TraceEvent& event = vCopy[i];
+            if(head - count + i < firstValid)
+                continue;
+            if(event.startNs < clearedNs || event.startNs + event.durationNs < minEndNs)
+                continue;
+            vEvents.push_back(event);
+        }
+    }
+
+    std::sort(vEvents.begin(), vEvents.end(), [](const TraceEvent& a, const TraceEvent& b) { return a.startNs < b.startNs; });
+
+    std::ofstream f(filename);
+    if(!f.is_open())
+        return false;
+
+    f << std::fixed << std::setprecision(3);
+    f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool bFirst = true;
+    for(const auto& thread : mThreadNames)
+    {
+        f << (bFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.first
+          << ",\"args\":{\"name\":";
+        WriteJsonString(f, thread.second);
+        f << "}}";
+        bFirst = false;
+    }
+    for(const TraceEvent& event : vEvents)
+    {
+        f << (bFirst ? "" : ",\n") << "{\"name\":";
+        WriteJsonString(f, event.name);
+        f << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.tid << ",\"ts\":" << event.startNs * 1e-3
+          << ",\"dur\":" << event.durationNs * 1e-3 << "}";
+        bFirst = false;
+    }
+    f << "\n]}\n";
+
+    return f.good();
+}
+
+void Trace::Clear()
+{
+    gnClearedNs.store(ToNs(std::chrono::steady_clock::now()), std::memory_order_relaxed);
+}
+
+} //namespace ORB_SLAM3
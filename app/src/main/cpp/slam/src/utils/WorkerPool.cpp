@@ -0,0 +1,170 @@
+/**
+* This file is part of ORB-SLAM3
+*
+* Copyright (C) 2017-2021 Carlos Campos, Richard Elvira, Juan J. Gómez Rodríguez, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+* Copyright (C) 2014-2016 Raúl Mur-Artal, José M.M. Montiel and Juan D. Tardós, University of Zaragoza.
+*
+* ORB-SLAM3 is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* ORB-SLAM3 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with ORB-SLAM3.
+* If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "utils/WorkerPool.h"
+
+#include "utils/Trace.h"
+
+namespace ORB_SLAM3
+{
+
+WorkerPool::WorkerPool(int nThreads)
+    : mpTask(nullptr), mnTasks(0), mnNextTask(0), mnActive(0), mnGeneration(0), mbStop(false)
+{
+    for(int i=1; i<nThreads; i++)
+        mvThreads.emplace_back(&WorkerPool::Run, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mbStop = true;
+    }
+    mCondWork.notify_all();
+
+    for(std::thread& thread : mvThreads)
+        thread.join();
+}
+
+void WorkerPool::ParallelFor(int nTasks, const std::function<void(int)>& f)
+{
+    std::unique_lock<std::mutex> lockLoop(mMutexLoop, std::defer_lock);
+    if(mvThreads.empty() || nTasks <= 1 || !lockLoop.try_lock())
+    {
+        for(int i=0; i<nTasks; i++)
+            f(i);
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mpTask = &f;
+        mnTasks = nTasks;
+        mnNextTask.store(0, std::memory_order_relaxed);
+        mnGeneration++;
+    }
+    mCondWork.notify_all();
+
+    RunTasks(f);
+
+    // Workers which did not pick the loop up by now will skip it
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondDone.wait(lock, [this] { return mnActive == 0; });
+    mpTask = nullptr;
+}
+
+void WorkerPool::Run()
+{
+    Trace::SetThreadName("WorkerPool");
+
+    uint64_t nSeenGeneration = 0;
+    while(true)
+    {
+        const std::function<void(int)>* pTask;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondWork.wait(lock, [&] { return mbStop || mnGeneration != nSeenGeneration; });
+            if(mbStop)
+                return;
+
+            nSeenGeneration = mnGeneration;
+            pTask = mpTask;
+            if(!pTask)
+                continue;
+            mnActive++;
+        }
+
+        RunTasks(*pTask);
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        if(--mnActive == 0)
+            mCondDone.notify_all();
+    }
+}
+
+void WorkerPool::RunTasks(const std::function<void(int)>& f)
+{
+    for(int i = mnNextTask.fetch_add(1); i < mnTasks; i = mnNextTask.fetch_add(1))
+        f(i);
+}
+
+TaskThread::TaskThread(const char* name)
+    : mpName(name), mbBusy(false), mbStop(false), mbPending(false), mThread(&TaskThread::Run, this)
+{
+}
+
+TaskThread::~TaskThread()
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mbStop = true;
+    }
+    mCondWork.notify_all();
+
+    // A task still running is finished first
+    mThread.join();
+}
+
+void TaskThread::Submit(std::function<void()> f)
+{
+    Wait();
+
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mTask = std::move(f);
+        mbBusy = true;
+    }
+    mCondWork.notify_one();
+    mbPending = true;
+}
+
+bool TaskThread::Wait()
+{
+    if(!mbPending)
+        return false;
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondDone.wait(lock, [this] { return !mbBusy; });
+    mbPending = false;
+    return true;
+}
+
+void TaskThread::Run()
+{
+    Trace::SetThreadName(mpName);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while(true)
+    {
+        mCondWork.wait(lock, [this] { return mbStop || mbBusy; });
+        if(!mbBusy)
+            return;
+
+        std::function<void()> task = std::move(mTask);
+        lock.unlock();
+        task();
+        lock.lock();
+
+        mbBusy = false;
+        mCondDone.notify_all();
+    }
+}
+
+} //namespace ORB_SLAM3
@@ -0,0 +1,195 @@
+#include "KernelBench.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#include <opencv2/core/core.hpp>
+
+// Every allocation of the process goes through these. The counters of the benchmark threads are per
+// thread so each one only sees its own allocations, the other threads (worker pools, helper threads)
+// share one counter.
+//
+// With glibc malloc itself is replaced and forwards to the glibc allocator, so operator new in all its
+// forms (std::align_val_t included), the Eigen aligned allocations of the map objects and g2o, and the
+// cv::Mat buffers are all counted. Elsewhere only operator new and the cv::Mat buffers are.
+namespace
+{
+
+thread_local bool   t_bench_thread = false;
+thread_local size_t t_alloc_count  = 0;
+thread_local size_t t_alloc_bytes  = 0;
+
+std::atomic<size_t> g_background_count{ 0 };
+std::atomic<size_t> g_background_bytes{ 0 };
+
+void countAlloc(size_t size)
+{
+    if (t_bench_thread)
+    {
+        ++t_alloc_count;
+        t_alloc_bytes += size;
+    }
+    else
+    {
+        g_background_count.fetch_add(1, std::memory_order_relaxed);
+        g_background_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace
+
+#if defined(__GLIBC__)
+
+extern "C"
+{
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+// free() and the other entry points are left to glibc, the memory comes from its heap.
+void* malloc(size_t size) noexcept
+{
+    countAlloc(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept
+{
+    countAlloc(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) noexcept
+{
+    if (size != 0) countAlloc(size);
+    return __libc_realloc(p, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept
+{
+    countAlloc(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept
+{
+    countAlloc(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** p, size_t alignment, size_t size) noexcept
+{
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) return EINVAL;
+
+    countAlloc(size);
+    void* q = __libc_memalign(alignment, size);
+    if (!q) return ENOMEM;
+    *p = q;
+    return 0;
+}
+
+}  // extern "C"
+
+#else
+
+namespace
+{
+
+void* countedAlloc(size_t size)
+{
+    countAlloc(size);
+
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* countedAlignedAlloc(size_t size, std::align_val_t alignment)
+{
+    countAlloc(size);
+
+    const size_t a = static_cast<size_t>(alignment);
+    void*        p = std::aligned_alloc(a, (size + a - 1) / a * a);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+// cv::Mat buffers come from cv::fastMalloc, count them through the default Mat allocator.
+class CountingMatAllocator : public cv::MatAllocator
+{
+public:
+    cv::UMatData* allocate(int                dims,
+                           const int*         sizes,
+                           int                type,
+                           void*              data,
+                           size_t*            step,
+                           cv::AccessFlag     flags,
+                           cv::UMatUsageFlags usage_flags) const override
+    {
+        cv::UMatData* u = cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage_flags);
+        if (u && !data) countAlloc(u->size);
+        return u;
+    }
+
+    bool allocate(cv::UMatData* u, cv::AccessFlag flags, cv::UMatUsageFlags usage_flags) const override
+    {
+        return cv::Mat::getStdAllocator()->allocate(u, flags, usage_flags);
+    }
+
+    void deallocate(cv::UMatData* u) const override { cv::Mat::getStdAllocator()->deallocate(u); }
+};
+
+CountingMatAllocator g_mat_allocator;
+
+}  // namespace
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void  operator delete(void* p) noexcept { std::free(p); }
+void  operator delete[](void* p) noexcept { std::free(p); }
+void  operator delete(void* p, size_t) noexcept { std::free(p); }
+void  operator delete[](void* p, size_t) noexcept { std::free(p); }
+void  operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void  operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void  operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void  operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+#endif
+
+namespace android_slam
+{
+namespace kernel_bench_utils
+{
+
+AllocCount threadAllocs() { return { t_alloc_count, t_alloc_bytes }; }
+
+AllocCount backgroundAllocs()
+{
+    return { g_background_count.load(std::memory_order_relaxed), g_background_bytes.load(std::memory_order_relaxed) };
+}
+
+void markBenchThread() { t_bench_thread = true; }
+
+bool countsAllAllocations()
+{
+#if defined(__GLIBC__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void installAllocCounters()
+{
+#if !defined(__GLIBC__)
+    cv::Mat::setDefaultAllocator(&g_mat_allocator);
+#endif
+}
+
+}  // namespace kernel_bench_utils
+}  // namespace android_slam
@@ -0,0 +1,759 @@
+// Kernels of the feature extraction: ORB extraction, image pyramid, FAST, descriptors, key point
+// distribution, and the Hamming distances shared by the matcher and the vocabulary.
+#include "KernelBench.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <DBoW2/HammingDistance.h>
+
+#include <feature/FastDetector.h>
+#include <feature/ImagePyramid.h>
+#include <feature/ORBextractor.h>
+#include <feature/OrbDescriptor.h>
+#include <utils/WorkerPool.h>
+
+namespace android_slam
+{
+namespace kernel_bench_utils
+{
+
+bool sameKeyPoints(const std::vector<cv::KeyPoint>& a, const std::vector<cv::KeyPoint>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (a[i].pt != b[i].pt || a[i].size != b[i].size || a[i].angle != b[i].angle ||
+            a[i].response != b[i].response || a[i].octave != b[i].octave || a[i].class_id != b[i].class_id)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Cells of ORBextractor::ComputeKeyPointsOctTree() on one pyramid level (EDGE_THRESHOLD 19, cell size
+// 35), area is the bounding box of the cells.
+std::vector<cv::Rect> fastCells(const cv::Mat& level, cv::Rect& area)
+{
+    const int   min_border   = 19 - 3;
+    const int   max_border_x = level.cols - 19 + 3;
+    const int   max_border_y = level.rows - 19 + 3;
+    const float width        = (float)(max_border_x - min_border);
+    const float height       = (float)(max_border_y - min_border);
+    const int   n_cols       = (int)(width / 35.0f);
+    const int   n_rows       = (int)(height / 35.0f);
+    const int   w_cell       = (int)std::ceil(width / (float)n_cols);
+    const int   h_cell       = (int)std::ceil(height / (float)n_rows);
+
+    area = cv::Rect(min_border, min_border, (int)width, (int)height);
+
+    std::vector<cv::Rect> cells;
+    for (int i = 0; i < n_rows; ++i)
+    {
+        const int ini_y = min_border + i * h_cell;
+        if (ini_y >= max_border_y - 3) continue;
+        const int max_y = std::min(ini_y + h_cell + 6, max_border_y);
+
+        for (int j = 0; j < n_cols; ++j)
+        {
+            const int ini_x = min_border + j * w_cell;
+            if (ini_x >= max_border_x - 6) continue;
+            const int max_x = std::min(ini_x + w_cell + 6, max_border_x);
+
+            cells.emplace_back(ini_x, ini_y, max_x - ini_x, max_y - ini_y);
+        }
+    }
+    return cells;
+}
+
+// Pyramid of ORBextractor before ImagePyramid: freshly allocated bordered levels every frame, then a
+// blurred copy of every level for the descriptors.
+void buildPyramidPerFrame(const cv::Mat&            image,
+                          const std::vector<float>& inv_scale_factors,
+                          std::vector<cv::Mat>&     levels,
+                          std::vector<cv::Mat>&     blurred)
+{
+    constexpr int border = 19;
+
+    levels.resize(inv_scale_factors.size());
+    blurred.resize(inv_scale_factors.size());
+    for (size_t level = 0; level < levels.size(); ++level)
+    {
+        const float    scale = inv_scale_factors[level];
+        const cv::Size size(cvRound((float)image.cols * scale), cvRound((float)image.rows * scale));
+        cv::Mat        temp(size.height + border * 2, size.width + border * 2, image.type());
+        levels[level] = temp(cv::Rect(border, border, size.width, size.height));
+
+        if (level != 0)
+        {
+            cv::resize(levels[level - 1], levels[level], size, 0, 0, cv::INTER_LINEAR);
+            cv::copyMakeBorder(
+                levels[level], temp, border, border, border, border, cv::BORDER_REFLECT_101 + cv::BORDER_ISOLATED);
+        }
+        else
+        {
+            cv::copyMakeBorder(image, temp, border, border, border, border, cv::BORDER_REFLECT_101);
+        }
+    }
+
+    for (size_t level = 0; level < levels.size(); ++level)
+    {
+        blurred[level] = levels[level].clone();
+        cv::GaussianBlur(blurred[level], blurred[level], cv::Size(7, 7), 2, 2, cv::BORDER_REFLECT_101);
+    }
+}
+
+// Descriptors as ORBextractor computed them before OrbDescriptor: one key point at a time, pattern rotated
+// to its exact angle, scalar gathers and comparisons.
+void computeDescriptorsLegacy(const cv::Mat&                   image,
+                              const std::vector<cv::KeyPoint>& key_points,
+                              const std::vector<cv::Point>&    pattern,
+                              cv::Mat&                         descriptors)
+{
+    descriptors = cv::Mat::zeros((int)key_points.size(), 32, CV_8UC1);
+
+    const float factor_pi = (float)(CV_PI / 180.f);
+    const int   step      = (int)image.step;
+    for (size_t i = 0; i < key_points.size(); ++i)
+    {
+        const cv::KeyPoint& kpt    = key_points[i];
+        const float         angle  = (float)kpt.angle * factor_pi;
+        const float         a      = (float)std::cos(angle);
+        const float         b      = (float)std::sin(angle);
+        const uchar*        center = &image.at<uchar>(cvRound(kpt.pt.y), cvRound(kpt.pt.x));
+        auto value = [&](const cv::Point& p) {
+            return center[cvRound(p.x * b + p.y * a) * step + cvRound(p.x * a - p.y * b)];
+        };
+
+        const cv::Point* p    = pattern.data();
+        uchar*           desc = descriptors.ptr((int)i);
+        for (int j = 0; j < 32; ++j, p += 16)
+        {
+            int val = 0;
+            for (int k = 0; k < 8; ++k) val |= (value(p[2 * k]) < value(p[2 * k + 1])) << k;
+            desc[j] = (uchar)val;
+        }
+    }
+}
+
+// Blurred pyramid levels of an image with the key points the extractor found on them, in level
+// coordinates.
+struct DescriptorLevel
+{
+    cv::Mat                   blurred;
+    std::vector<cv::KeyPoint> key_points;
+};
+
+std::vector<DescriptorLevel> descriptorLevels(ORB_SLAM3::ORBextractor& extractor, const cv::Mat& image)
+{
+    std::vector<cv::KeyPoint> key_points;
+    cv::Mat                   descriptors;
+    std::vector<int>          lapping_area = { 0, 0 };
+    extractor(image, cv::Mat(), key_points, descriptors, lapping_area);
+
+    const std::vector<float> inv_scale_factors = extractor.GetInverseScaleFactors();
+    ORB_SLAM3::ImagePyramid  pyramid(19);
+    pyramid.Build(image, inv_scale_factors);
+
+    std::vector<DescriptorLevel> levels(inv_scale_factors.size());
+    for (size_t level = 0; level < levels.size(); ++level) levels[level].blurred = pyramid.mvBlurred[level].clone();
+    for (cv::KeyPoint key_point : key_points)
+    {
+        key_point.pt *= inv_scale_factors[key_point.octave];
+        levels[key_point.octave].key_points.push_back(key_point);
+    }
+    return levels;
+}
+
+// Bytes read and written by the pyramid of one frame, counting every pass over a level.
+size_t pyramidTraffic(const cv::Size& image_size, const std::vector<float>& inv_scale_factors, bool per_frame)
+{
+    constexpr size_t border = 19;
+
+    size_t traffic       = 0;
+    size_t previous_area = 0;
+    for (size_t level = 0; level < inv_scale_factors.size(); ++level)
+    {
+        const float  scale    = inv_scale_factors[level];
+        const size_t width    = cvRound((float)image_size.width * scale);
+        const size_t height   = cvRound((float)image_size.height * scale);
+        const size_t area     = width * height;
+        const size_t bordered = (width + border * 2) * (height + border * 2);
+
+        // Resize (or copy of the image) and border
+        traffic += (level == 0 ? area : previous_area) + area;
+        traffic += per_frame && level != 0 ? area + bordered : 2 * (bordered - area);
+        // Copy for the blur, blur
+        traffic += per_frame ? 2 * area : 0;
+        traffic += 2 * area;
+
+        previous_area = area;
+    }
+    return traffic;
+}
+
+bool runFeatureKernels(const BenchContext& ctx, std::vector<KernelResult>& results)
+{
+    const BenchFixture& fixture    = ctx.fixture;
+    Scene&              scene      = ctx.scene;
+    const size_t        iterations = ctx.iterations;
+    const int           threads    = ctx.threads;
+
+    const BenchFixture::OrbParams& orb = fixture.orb;
+
+    // ORB extraction of the current frame image.
+    struct ExtractState
+    {
+        std::unique_ptr<ORB_SLAM3::ORBextractor> extractor;
+        std::vector<cv::KeyPoint>                key_points;
+        cv::Mat                                  descriptors;
+        std::vector<int>                         lapping_area = { 0, 0 };
+    };
+    runKernel(
+        "orb_extract",
+        threads,
+        iterations,
+        [&](int) {
+            ExtractState s;
+            s.extractor = std::make_unique<ORB_SLAM3::ORBextractor>(
+                orb.n_features, orb.scale_factor, orb.n_levels, orb.ini_th_fast, orb.min_th_fast);
+            return s;
+        },
+        [](ExtractState&) {},
+        [&](ExtractState& s) {
+            (*s.extractor)(fixture.frame.image, cv::Mat(), s.key_points, s.descriptors, s.lapping_area);
+        },
+        results);
+
+    // Same extraction with the key points distributed on the std::list quadtree.
+    runKernel(
+        "orb_extract_list",
+        threads,
+        iterations,
+        [&](int) {
+            ExtractState s;
+            s.extractor = std::make_unique<ORB_SLAM3::ORBextractor>(
+                orb.n_features, orb.scale_factor, orb.n_levels, orb.ini_th_fast, orb.min_th_fast);
+            s.extractor->SetDistribution(ORB_SLAM3::ORBextractor::DISTRIBUTION_LIST);
+            return s;
+        },
+        [](ExtractState&) {},
+        [&](ExtractState& s) {
+            (*s.extractor)(fixture.frame.image, cv::Mat(), s.key_points, s.descriptors, s.lapping_area);
+        },
+        results);
+
+    // Same extraction split over the levels and cell rows by a pool of 4 threads.
+    struct PooledExtractState : ExtractState
+    {
+        std::unique_ptr<ORB_SLAM3::WorkerPool> pool;
+    };
+    runKernel(
+        "orb_extract_pool4",
+        threads,
+        iterations,
+        [&](int) {
+            PooledExtractState s;
+            s.extractor = std::make_unique<ORB_SLAM3::ORBextractor>(
+                orb.n_features, orb.scale_factor, orb.n_levels, orb.ini_th_fast, orb.min_th_fast);
+            s.pool = std::make_unique<ORB_SLAM3::WorkerPool>(4);
+            s.extractor->SetWorkerPool(s.pool.get());
+            return s;
+        },
+        [](PooledExtractState&) {},
+        [&](PooledExtractState& s) {
+            (*s.extractor)(fixture.frame.image, cv::Mat(), s.key_points, s.descriptors, s.lapping_area);
+        },
+        results);
+
+    // Pyramid and blurred levels of the frame, allocated every frame as ORBextractor used to do, against
+    // the buffers of ImagePyramid reused between frames.
+    const std::vector<float> inv_scale_factors = scene.extractor->GetInverseScaleFactors();
+    struct PyramidState
+    {
+        std::vector<cv::Mat> levels;
+        std::vector<cv::Mat> blurred;
+    };
+    runKernel(
+        "pyramid_per_frame",
+        threads,
+        iterations,
+        [](int) { return PyramidState{}; },
+        [](PyramidState& s) {
+            s.levels.clear();
+            s.blurred.clear();
+        },
+        [&](PyramidState& s) { buildPyramidPerFrame(fixture.frame.image, inv_scale_factors, s.levels, s.blurred); },
+        results);
+    runKernel(
+        "pyramid",
+        threads,
+        iterations,
+        [](int) { return std::make_unique<ORB_SLAM3::ImagePyramid>(19); },
+        [](std::unique_ptr<ORB_SLAM3::ImagePyramid>&) {},
+        [&](std::unique_ptr<ORB_SLAM3::ImagePyramid>& pyramid) { pyramid->Build(fixture.frame.image, inv_scale_factors); },
+        results);
+
+    // Descriptors of the frame key points: the former per key point code, the SIMD kernel at the exact
+    // angles and with the 30 bins table.
+    const std::vector<DescriptorLevel> descriptor_levels = descriptorLevels(*scene.extractor, fixture.frame.image);
+    const ORB_SLAM3::OrbDescriptor&    orb_descriptor    = scene.extractor->GetDescriptor();
+    runKernel(
+        "orb_descriptors_legacy",
+        threads,
+        iterations,
+        [](int) { return cv::Mat(); },
+        [](cv::Mat&) {},
+        [&](cv::Mat& descriptors) {
+            for (const DescriptorLevel& level : descriptor_levels)
+            {
+                computeDescriptorsLegacy(level.blurred, level.key_points, orb_descriptor.GetPattern(), descriptors);
+            }
+        },
+        results);
+    for (const auto mode : { ORB_SLAM3::OrbDescriptor::ANGLE_CONTINUOUS, ORB_SLAM3::OrbDescriptor::ANGLE_BINS })
+    {
+        runKernel(
+            mode == ORB_SLAM3::OrbDescriptor::ANGLE_BINS ? "orb_descriptors" : "orb_descriptors_continuous",
+            threads,
+            iterations,
+            [](int) { return cv::Mat(); },
+            [](cv::Mat&) {},
+            [&](cv::Mat& descriptors) {
+                for (const DescriptorLevel& level : descriptor_levels)
+                {
+                    orb_descriptor.Compute(level.blurred, level.key_points, descriptors, mode);
+                }
+            },
+            results);
+    }
+
+    // FAST of the extractor cells over the whole pyramid of the frame: cv::FAST on every cell, as
+    // ORBextractor used to do, against one FastDetector pass per level served to the cells.
+    struct FastLevel
+    {
+        cv::Mat               image;
+        cv::Rect              area;
+        std::vector<cv::Rect> cells;
+    };
+    std::vector<FastLevel> fast_levels;
+    {
+        ORB_SLAM3::ORBextractor   extractor(orb.n_features, orb.scale_factor, orb.n_levels, orb.ini_th_fast, orb.min_th_fast);
+        std::vector<cv::KeyPoint> key_points;
+        cv::Mat                   descriptors;
+        std::vector<int>          lapping_area = { 0, 0 };
+        extractor(fixture.frame.image, cv::Mat(), key_points, descriptors, lapping_area);
+        for (const cv::Mat& image : extractor.mvImagePyramid)
+        {
+            FastLevel level{ image.clone(), {}, {} };
+            level.cells = fastCells(level.image, level.area);
+            fast_levels.push_back(std::move(level));
+        }
+    }
+    struct FastState
+    {
+        cv::Mat                   contrast;
+        std::vector<cv::KeyPoint> key_points;
+    };
+    runKernel(
+        "fast_cells_opencv",
+        threads,
+        iterations,
+        [](int) { return FastState{}; },
+        [](FastState&) {},
+        [&](FastState& s) {
+            for (const FastLevel& level : fast_levels)
+            {
+                for (const cv::Rect& cell : level.cells)
+                {
+                    s.key_points.clear();
+                    cv::FAST(level.image(cell), s.key_points, orb.ini_th_fast, true);
+                    if (s.key_points.empty()) cv::FAST(level.image(cell), s.key_points, orb.min_th_fast, true);
+                }
+            }
+        },
+        results);
+    runKernel(
+        "fast_cells",
+        threads,
+        iterations,
+        [](int) { return FastState{}; },
+        [](FastState&) {},
+        [&](FastState& s) {
+            for (const FastLevel& level : fast_levels)
+            {
+                ORB_SLAM3::FastDetector::ComputeContrast(
+                    level.image, level.area, std::min(orb.ini_th_fast, orb.min_th_fast), s.contrast);
+                for (const cv::Rect& cell : level.cells)
+                {
+                    s.key_points.clear();
+                    ORB_SLAM3::FastDetector::Detect(s.contrast, cell, orb.ini_th_fast, s.key_points);
+                    if (s.key_points.empty())
+                    {
+                        ORB_SLAM3::FastDetector::Detect(s.contrast, cell, orb.min_th_fast, s.key_points);
+                    }
+                }
+            }
+        },
+        results);
+
+    // Brute force Hamming distances of the current frame descriptors to the reference key frame ones, with
+    // every implementation of the batched kernel the cpu supports.
+    {
+        using DBoW2::HammingDistance;
+
+        const ORB_SLAM3::DescriptorArray& queries = scene.frame.mDescriptors;
+        std::vector<const unsigned char*> rows;
+        for (int i = 0; i < scene.reference->mDescriptors.Size(); ++i)
+        {
+            rows.push_back(scene.reference->mDescriptors.Row(i));
+        }
+
+        const HammingDistance::Impl impls[] = { HammingDistance::IMPL_SCALAR,
+                                                HammingDistance::IMPL_POPCNT,
+                                                HammingDistance::IMPL_AVX2,
+                                                HammingDistance::IMPL_NEON };
+        for (HammingDistance::Impl impl : impls)
+        {
+            if (!HammingDistance::supported(impl)) continue;
+
+            const std::string name = std::string("hamming_") + HammingDistance::implName(impl);
+            runKernel(
+                name.c_str(),
+                threads,
+                iterations,
+                [&](int) { return std::vector<int>(rows.size()); },
+                [](std::vector<int>&) {},
+                [&](std::vector<int>& dist) {
+                    for (int i = 0; i < queries.Size(); ++i)
+                    {
+                        HammingDistance::distances(queries.Row(i), rows.data(), (int)rows.size(), dist.data(), impl);
+                    }
+                },
+                results);
+        }
+    }
+
+    std::cout << "[Android Slam Tools Info] Pyramid memory traffic per frame: "
+              << pyramidTraffic(fixture.frame.image.size(), inv_scale_factors, true) / 1024 << " KiB allocated per frame, "
+              << pyramidTraffic(fixture.frame.image.size(), inv_scale_factors, false) / 1024 << " KiB with ImagePyramid."
+              << std::endl;
+
+    return true;
+}
+
+// FastDetector on every cell of every pyramid level of the fixture images, with every implementation
+// the cpu runs, against cv::FAST on the cell at both extractor thresholds.
+bool checkFast(const BenchFixture& fixture)
+{
+    using ORB_SLAM3::FastDetector;
+
+    const BenchFixture::OrbParams& orb = fixture.orb;
+    ORB_SLAM3::ORBextractor extractor(orb.n_features, orb.scale_factor, orb.n_levels, orb.ini_th_fast, orb.min_th_fast);
+
+    std::vector<FastDetector::Impl> impls = { FastDetector::IMPL_SCALAR };
+    if (FastDetector::BestImpl() != FastDetector::IMPL_SCALAR) impls.push_back(FastDetector::BestImpl());
+    if (FastDetector::BestImpl() == FastDetector::IMPL_AVX2) impls.push_back(FastDetector::IMPL_SSE2);
+
+    const std::vector<const BenchFixture::View*> views = fixtureViews(fixture);
+
+    size_t                    cell_count = 0;
+    size_t                    key_points = 0;
+    std::vector<cv::KeyPoint> expected;
+    std::vector<cv::KeyPoint> actual;
+    cv::Mat                   contrast;
+    for (const BenchFixture::View* view : views)
+    {
+        // Only the pyramid is used.
+        std::vector<cv::KeyPoint> view_key_points;
+        cv::Mat                   descriptors;
+        std::vector<int>          lapping_area = { 0, 0 };
+        extractor(view->image, cv::Mat(), view_key_points, descriptors, lapping_area);
+
+        for (int level = 0; level < orb.n_levels; ++level)
+        {
+            const cv::Mat&              image = extractor.mvImagePyramid[level];
+            cv::Rect                    area;
+            const std::vector<cv::Rect> cells = fastCells(image, area);
+
+            for (FastDetector::Impl impl : impls)
+            {
+                FastDetector::ComputeContrast(image, area, std::min(orb.ini_th_fast, orb.min_th_fast), contrast, impl);
+                for (const cv::Rect& cell : cells)
+                {
+                    for (int threshold : { orb.ini_th_fast, orb.min_th_fast })
+                    {
+                        expected.clear();
+                        actual.clear();
+                        cv::FAST(image(cell), expected, threshold, true);
+                        FastDetector::Detect(contrast, cell, threshold, actual);
+                        if (!sameKeyPoints(expected, actual))
+                        {
+                            std::cerr << "[Android Slam Tools Info] fast_cells (" << FastDetector::ImplName(impl)
+                                      << ") differs from cv::FAST at level " << level << ", cell " << cell
+                                      << ", threshold " << threshold << ": " << actual.size() << " key points instead of "
+                                      << expected.size() << "." << std::endl;
+                            return false;
+                        }
+                        key_points += expected.size();
+                    }
+                    ++cell_count;
+                }
+            }
+        }
+    }
+
+    std::cout << "[Android Slam Tools Info] fast_cells: " << cell_count << " cells, " << key_points
+              << " key points identical to cv::FAST (";
+    for (size_t i = 0; i < impls.size(); ++i) std::cout << (i ? ", " : "") << FastDetector::ImplName(impls[i]);
+    std::cout << ")." << std::endl;
+    return true;
+}
+
+// ORBextractor split over a worker pool against the serial extractor on the fixture images: key points,
+// descriptors and lapping counts must not depend on the thread count.
+bool checkExtractorPool(const BenchFixture& fixture)
+{
+    const BenchFixture::OrbParams& orb = fixture.orb;
+    ORB_SLAM3::ORBextractor serial(orb.n_features, orb.scale_factor, orb.n_levels, orb.ini_th_fast, orb.min_th_fast);
+    ORB_SLAM3::ORBextractor pooled(orb.n_features, orb.scale_factor, orb.n_levels, orb.ini_th_fast, orb.min_th_fast);
+
+    const std::vector<const BenchFixture::View*> views = fixtureViews(fixture);
+
+    size_t key_points = 0;
+    for (int thread_count : { 2, 4, 8 })
+    {
+        ORB_SLAM3::WorkerPool pool(thread_count);
+        pooled.SetWorkerPool(&pool);
+
+        for (const BenchFixture::View* view : views)
+        {
+            std::vector<cv::KeyPoint> expected_key_points, actual_key_points;
+            cv::Mat                   expected_descriptors, actual_descriptors;
+            std::vector<int>          lapping_area = { 0, 0 };
+            const int expected_mono = serial(view->image, cv::Mat(), expected_key_points, expected_descriptors, lapping_area);
+            const int actual_mono   = pooled(view->image, cv::Mat(), actual_key_points, actual_descriptors, lapping_area);
+
+            if (expected_mono != actual_mono || !sameKeyPoints(expected_key_points, actual_key_points) ||
+                expected_descriptors.size() != actual_descriptors.size() ||
+                (!expected_descriptors.empty() && cv::norm(expected_descriptors, actual_descriptors, cv::NORM_L1) != 0.0))
+            {
+                std::cerr << "[Android Slam Tools Info] orb_extract with " << thread_count
+                          << " threads differs from the serial extractor on frame " << view->time_stamp << "." << std::endl;
+                pooled.SetWorkerPool(nullptr);
+                return false;
+            }
+            key_points += expected_key_points.size();
+        }
+
+        pooled.SetWorkerPool(nullptr);
+    }
+
+    std::cout << "[Android Slam Tools Info] orb_extract: " << key_points
+              << " key points and descriptors identical with 2, 4 and 8 threads." << std::endl;
+    return true;
+}
+
+// ImagePyramid reused over the fixture images against the pyramid allocated every frame: levels with
+// their borders and blurred levels must be identical.
+bool checkPyramid(const BenchFixture& fixture)
+{
+    const BenchFixture::OrbParams& orb = fixture.orb;
+    ORB_SLAM3::ORBextractor  extractor(orb.n_features, orb.scale_factor, orb.n_levels, orb.ini_th_fast, orb.min_th_fast);
+    const std::vector<float> inv_scale_factors = extractor.GetInverseScaleFactors();
+
+    const std::vector<const BenchFixture::View*> views = fixtureViews(fixture);
+
+    ORB_SLAM3::ImagePyramid pyramid(19);
+    std::vector<cv::Mat>    levels;
+    std::vector<cv::Mat>    blurred;
+    for (const BenchFixture::View* view : views)
+    {
+        buildPyramidPerFrame(view->image, inv_scale_factors, levels, blurred);
+        pyramid.Build(view->image, inv_scale_factors);
+
+        for (int level = 0; level < orb.n_levels; ++level)
+        {
+            cv::Mat expected = levels[level];
+            cv::Mat actual   = pyramid.mvLevels[level];
+            expected.adjustROI(19, 19, 19, 19);
+            actual.adjustROI(19, 19, 19, 19);
+            if (expected.size() != actual.size() || cv::norm(expected, actual, cv::NORM_INF) != 0.0 ||
+                cv::norm(blurred[level], pyramid.mvBlurred[level], cv::NORM_INF) != 0.0)
+            {
+                std::cerr << "[Android Slam Tools Info] pyramid differs from the per frame pyramid at level " << level
+                          << " of frame " << view->time_stamp << "." << std::endl;
+                return false;
+            }
+        }
+    }
+
+    std::cout << "[Android Slam Tools Info] pyramid: " << views.size()
+              << " frames identical to the per frame pyramid, borders and blurred levels included." << std::endl;
+    return true;
+}
+
+// OrbDescriptor at the exact angles against the former per key point code on the fixture images, then
+// the distance of the 30 bins descriptors to the exact ones.
+bool checkDescriptors(const BenchFixture& fixture)
+{
+    using ORB_SLAM3::OrbDescriptor;
+
+    const BenchFixture::OrbParams& orb = fixture.orb;
+    ORB_SLAM3::ORBextractor extractor(orb.n_features, orb.scale_factor, orb.n_levels, orb.ini_th_fast, orb.min_th_fast);
+    const OrbDescriptor&    orb_descriptor = extractor.GetDescriptor();
+
+    const std::vector<const BenchFixture::View*> views = fixtureViews(fixture);
+
+    size_t  key_points   = 0;
+    size_t  distance     = 0;
+    size_t  max_distance = 0;
+    cv::Mat expected, continuous, bins;
+    for (const BenchFixture::View* view : views)
+    {
+        for (const DescriptorLevel& level : descriptorLevels(extractor, view->image))
+        {
+            computeDescriptorsLegacy(level.blurred, level.key_points, orb_descriptor.GetPattern(), expected);
+            orb_descriptor.Compute(level.blurred, level.key_points, continuous, OrbDescriptor::ANGLE_CONTINUOUS);
+            orb_descriptor.Compute(level.blurred, level.key_points, bins, OrbDescriptor::ANGLE_BINS);
+
+            if (!level.key_points.empty() && cv::norm(expected, continuous, cv::NORM_HAMMING) != 0.0)
+            {
+                std::cerr << "[Android Slam Tools Info] orb_descriptors_continuous differs from the former descriptors "
+                          << "on frame " << view->time_stamp << "." << std::endl;
+                return false;
+            }
+
+            for (int i = 0; i < bins.rows; ++i)
+            {
+                const size_t d = (size_t)cv::norm(bins.row(i), continuous.row(i), cv::NORM_HAMMING);
+                distance += d;
+                max_distance = std::max(max_distance, d);
+            }
+            key_points += level.key_points.size();
+        }
+    }
+
+    std::cout << "[Android Slam Tools Info] orb_descriptors: " << key_points
+              << " continuous angle descriptors identical to the former ones, 30 bins descriptors "
+              << (key_points ? (double)distance / (double)key_points : 0.0) << " bits away on average ("
+              << max_distance << " at most)." << std::endl;
+    return true;
+}
+
+// Every implementation of the batched Hamming kernel against cv::norm on all the pairs of descriptors of
+// the fixture frame and its first key frame.
+bool checkHamming(const BenchFixture& fixture)
+{
+    using DBoW2::HammingDistance;
+
+    const BenchFixture::OrbParams& orb = fixture.orb;
+    ORB_SLAM3::ORBextractor extractor(orb.n_features, orb.scale_factor, orb.n_levels, orb.ini_th_fast, orb.min_th_fast);
+
+    const BenchFixture::View& other = fixture.key_frames.empty() ? fixture.frame : fixture.key_frames.front();
+    std::vector<cv::KeyPoint> key_points;
+    std::vector<int>          lapping_area = { 0, 0 };
+    cv::Mat                   queries, candidates;
+    extractor(fixture.frame.image, cv::Mat(), key_points, queries, lapping_area);
+    extractor(other.image, cv::Mat(), key_points, candidates, lapping_area);
+
+    std::vector<const unsigned char*> rows;
+    for (int i = 0; i < candidates.rows; ++i) rows.push_back(candidates.ptr<unsigned char>(i));
+
+    const HammingDistance::Impl impls[] = { HammingDistance::IMPL_SCALAR,
+                                            HammingDistance::IMPL_POPCNT,
+                                            HammingDistance::IMPL_AVX2,
+                                            HammingDistance::IMPL_NEON };
+    std::vector<int> dist(rows.size());
+    for (int i = 0; i < queries.rows; ++i)
+    {
+        for (HammingDistance::Impl impl : impls)
+        {
+            if (!HammingDistance::supported(impl)) continue;
+
+            HammingDistance::distances(queries.ptr<unsigned char>(i), rows.data(), (int)rows.size(), dist.data(), impl);
+            for (int j = 0; j < candidates.rows; ++j)
+            {
+                if (dist[j] != (int)cv::norm(queries.row(i), candidates.row(j), cv::NORM_HAMMING))
+                {
+                    std::cerr << "[Android Slam Tools Info] hamming_" << HammingDistance::implName(impl)
+                              << " differs from cv::norm on descriptors " << i << " and " << j << "." << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    std::cout << "[Android Slam Tools Info] hamming: " << (size_t)queries.rows * rows.size()
+              << " distances identical to cv::norm, " << HammingDistance::implName(HammingDistance::bestImpl())
+              << " in use." << std::endl;
+    return true;
+}
+
+// Share of the 16x16 pixel cells of the image holding at least one key point.
+double keyPointSpread(const std::vector<cv::KeyPoint>& key_points, const cv::Size& image_size)
+{
+    const int         cols = (image_size.width + 15) / 16;
+    const int         rows = (image_size.height + 15) / 16;
+    std::vector<char> occupied(cols * rows, 0);
+    for (const cv::KeyPoint& key_point : key_points)
+    {
+        const int x = std::min(std::max((int)key_point.pt.x / 16, 0), cols - 1);
+        const int y = std::min(std::max((int)key_point.pt.y / 16, 0), rows - 1);
+        occupied[y * cols + x] = 1;
+    }
+    return (double)std::count(occupied.begin(), occupied.end(), 1) / (double)occupied.size();
+}
+
+// Extraction with the arena distribution against the std::list one on the fixture images.
+bool checkDistribution(const BenchFixture& fixture)
+{
+    const BenchFixture::OrbParams& orb = fixture.orb;
+    ORB_SLAM3::ORBextractor list(orb.n_features, orb.scale_factor, orb.n_levels, orb.ini_th_fast, orb.min_th_fast);
+    ORB_SLAM3::ORBextractor arena(orb.n_features, orb.scale_factor, orb.n_levels, orb.ini_th_fast, orb.min_th_fast);
+    list.SetDistribution(ORB_SLAM3::ORBextractor::DISTRIBUTION_LIST);
+    arena.SetDistribution(ORB_SLAM3::ORBextractor::DISTRIBUTION_ARENA);
+
+    const std::vector<const BenchFixture::View*> views = fixtureViews(fixture);
+
+    size_t key_points = 0;
+    double spread     = 0.0;
+    for (const BenchFixture::View* view : views)
+    {
+        std::vector<cv::KeyPoint> expected_key_points, actual_key_points;
+        cv::Mat                   expected_descriptors, actual_descriptors;
+        std::vector<int>          lapping_area = { 0, 0 };
+        list(view->image, cv::Mat(), expected_key_points, expected_descriptors, lapping_area);
+        arena(view->image, cv::Mat(), actual_key_points, actual_descriptors, lapping_area);
+
+        if (!sameKeyPoints(expected_key_points, actual_key_points) ||
+            (!expected_descriptors.empty() && cv::norm(expected_descriptors, actual_descriptors, cv::NORM_HAMMING) != 0.0))
+        {
+            std::cerr << "[Android Slam Tools Info] arena distribution differs from the list one on frame "
+                      << view->time_stamp << ": " << actual_key_points.size() << " key points instead of "
+                      << expected_key_points.size() << "." << std::endl;
+            return false;
+        }
+        key_points += expected_key_points.size();
+        spread += keyPointSpread(expected_key_points, view->image.size());
+    }
+
+    std::cout << "[Android Slam Tools Info] distribution: " << key_points
+              << " key points identical with the list and the arena, " << std::setprecision(3)
+              << 100.0 * spread / (double)views.size() << "% of the 16x16 cells covered." << std::endl;
+    return true;
+}
+
+bool checkFeatureKernels(const BenchFixture& fixture)
+{
+    return checkPyramid(fixture) && checkFast(fixture) && checkDescriptors(fixture) && checkHamming(fixture) &&
+           checkDistribution(fixture) && checkExtractorPool(fixture);
+}
+
+}  // namespace kernel_bench_utils
+}  // namespace android_slam
@@ -0,0 +1,161 @@
+#include "BenchFixture.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace android_slam
+{
+namespace bench_fixture_utils
+{
+
+constexpr char k_magic[4] = { 'A', 'S', 'F', 'X' };
+
+template <typename T>
+void write(std::ofstream& fout, const T& value)
+{
+    fout.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read(std::ifstream& fin, T& value)
+{
+    fin.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return fin.good();
+}
+
+void writeView(std::ofstream& fout, const BenchFixture::View& view)
+{
+    write(fout, view.time_stamp);
+    write(fout, view.pose);
+    write(fout, view.key_point_count);
+
+    cv::Mat image = view.image.isContinuous() ? view.image : view.image.clone();
+    write(fout, static_cast<int32_t>(image.rows));
+    write(fout, static_cast<int32_t>(image.cols));
+    fout.write(reinterpret_cast<const char*>(image.data), image.total());
+}
+
+bool readView(std::ifstream& fin, BenchFixture::View& view)
+{
+    int32_t rows = 0;
+    int32_t cols = 0;
+    if (!read(fin, view.time_stamp) || !read(fin, view.pose) || !read(fin, view.key_point_count) ||
+        !read(fin, rows) || !read(fin, cols))
+    {
+        return false;
+    }
+
+    view.image.create(rows, cols, CV_8UC1);
+    fin.read(reinterpret_cast<char*>(view.image.data), view.image.total());
+    return fin.good();
+}
+
+}  // namespace bench_fixture_utils
+
+bool BenchFixture::save(const std::string& file) const
+{
+    using namespace bench_fixture_utils;
+
+    std::ofstream fout(file, std::ios::binary);
+    if (!fout.good())
+    {
+        std::cerr << "[Android Slam Tools Info] Failed to create fixture " << file << "." << std::endl;
+        return false;
+    }
+
+    fout.write(k_magic, sizeof(k_magic));
+    write(fout, k_version);
+
+    write(fout, camera.fx);
+    write(fout, camera.fy);
+    write(fout, camera.cx);
+    write(fout, camera.cy);
+    write(fout, static_cast<int32_t>(camera.dist_coef.size()));
+    for (float d : camera.dist_coef) write(fout, d);
+    write(fout, camera.width);
+    write(fout, camera.height);
+
+    write(fout, orb);
+
+    write(fout, static_cast<int32_t>(key_frames.size()));
+    for (const View& view : key_frames) writeView(fout, view);
+    write(fout, reference_key_frame);
+    writeView(fout, frame);
+
+    write(fout, static_cast<int32_t>(points.size()));
+    for (const Point& point : points)
+    {
+        write(fout, point.pos);
+        write(fout, point.reference_view);
+        write(fout, static_cast<int32_t>(point.observations.size()));
+        for (const Observation& obs : point.observations) write(fout, obs);
+    }
+
+    write(fout, static_cast<int32_t>(frame_matches.size()));
+    for (int32_t match : frame_matches) write(fout, match);
+
+    return fout.good();
+}
+
+bool BenchFixture::load(const std::string& file)
+{
+    using namespace bench_fixture_utils;
+
+    std::ifstream fin(file, std::ios::binary);
+
+    char     magic[4] = {};
+    uint32_t version  = 0;
+    fin.read(magic, sizeof(magic));
+    if (!fin.good() || memcmp(magic, k_magic, sizeof(magic)) != 0 || !read(fin, version) || version != k_version)
+    {
+        std::cerr << "[Android Slam Tools Info] " << file << " is not a version " << k_version << " fixture." << std::endl;
+        return false;
+    }
+
+    int32_t count = 0;
+
+    read(fin, camera.fx);
+    read(fin, camera.fy);
+    read(fin, camera.cx);
+    read(fin, camera.cy);
+    read(fin, count);
+    camera.dist_coef.resize(count);
+    for (float& d : camera.dist_coef) read(fin, d);
+    read(fin, camera.width);
+    read(fin, camera.height);
+
+    read(fin, orb);
+
+    read(fin, count);
+    key_frames.resize(count);
+    for (View& view : key_frames)
+    {
+        if (!readView(fin, view)) return false;
+    }
+    read(fin, reference_key_frame);
+    if (!readView(fin, frame)) return false;
+
+    read(fin, count);
+    points.resize(count);
+    for (Point& point : points)
+    {
+        read(fin, point.pos);
+        read(fin, point.reference_view);
+        read(fin, count);
+        point.observations.resize(count);
+        for (Observation& obs : point.observations) read(fin, obs);
+    }
+
+    read(fin, count);
+    frame_matches.resize(count);
+    for (int32_t& match : frame_matches) read(fin, match);
+
+    if (!fin.good())
+    {
+        std::cerr << "[Android Slam Tools Info] Fixture " << file << " is truncated." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace android_slam
@@ -0,0 +1,85 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+namespace android_slam
+{
+
+// Snapshot of the tracking state around one frame of a real run, used to time the slam kernels in
+// isolation. Features are not stored: every view keeps its gray image and is re-extracted on load
+// (ORB extraction is deterministic), key point indices of the observations refer to that output.
+//
+// Binary layout (little endian), version 1:
+//   header      char[4] "ASFX", uint32 version
+//   camera      float fx, fy, cx, cy, int32 dist_count, float dist[dist_count], int32 width, height
+//   orb         int32 n_features, float scale_factor, int32 n_levels, ini_th_fast, min_th_fast
+//   key frames  int32 count, View[count]
+//   reference   int32 index of the reference key frame of the frame
+//   frame       View
+//   points      int32 count, Point[count]
+//   matches     int32 count, int32 point index (-1 if none) for every key point of the frame
+// View:  double time_stamp, float pose[7] (Tcw as qx qy qz qw tx ty tz), int32 key_point_count,
+//        int32 rows, cols, uint8 gray[rows * cols]
+// Point: float pos[3], int32 reference view, int32 count, (int32 view, int32 key point)[count]
+struct BenchFixture
+{
+    static constexpr uint32_t k_version = 1;
+
+    struct Camera
+    {
+        float              fx;
+        float              fy;
+        float              cx;
+        float              cy;
+        std::vector<float> dist_coef;
+        int32_t            width;
+        int32_t            height;
+    };
+
+    struct OrbParams
+    {
+        int32_t n_features;
+        float   scale_factor;
+        int32_t n_levels;
+        int32_t ini_th_fast;
+        int32_t min_th_fast;
+    };
+
+    struct View
+    {
+        double               time_stamp;
+        std::array<float, 7> pose;
+        int32_t              key_point_count;
+        cv::Mat              image;
+    };
+
+    struct Observation
+    {
+        int32_t view;
+        int32_t key_point;
+    };
+
+    struct Point
+    {
+        std::array<float, 3>     pos;
+        int32_t                  reference_view;
+        std::vector<Observation> observations;
+    };
+
+    Camera               camera;
+    OrbParams            orb;
+    std::vector<View>    key_frames;
+    int32_t              reference_key_frame;
+    View                 frame;
+    std::vector<Point>   points;
+    std::vector<int32_t> frame_matches;
+
+    bool save(const std::string& file) const;
+    bool load(const std::string& file);
+};
+
+}  // namespace android_slam
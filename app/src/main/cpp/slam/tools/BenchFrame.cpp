@@ -0,0 +1,366 @@
+// Kernels of the frames and the key frame database: feature grid searches, local map projection,
+// matching, BoW transform and inverted index searches.
+#include "KernelBench.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <feature/ORBextractor.h>
+#include <feature/ORBmatcher.h>
+#include <frame/BowInvertedIndex.h>
+#include <frame/FeatureGrid.h>
+#include <frame/LocalMapProjection.h>
+#include <utils/Converter.h>
+#include <utils/WorkerPool.h>
+
+namespace android_slam
+{
+namespace kernel_bench_utils
+{
+
+bool runFrameKernels(const BenchContext& ctx, std::vector<KernelResult>& results)
+{
+    Scene&                    scene      = ctx.scene;
+    ORB_SLAM3::ORBVocabulary* vocabulary = ctx.vocabulary;
+    const size_t              iterations = ctx.iterations;
+    const int                 threads    = ctx.threads;
+
+    // Grid searches around every key point of the current frame, with the radius and levels of
+    // ORBmatcher::SearchByProjection().
+    runKernel(
+        "features_in_area_vector",
+        threads,
+        iterations,
+        [](int) { return size_t(0); },
+        [](size_t&) {},
+        [&](size_t& found) {
+            const ORB_SLAM3::Frame& f = scene.frame;
+            for (const cv::KeyPoint& kp : f.mvKeysUn)
+            {
+                const float r = 4.0f * f.mvScaleFactors[kp.octave];
+                found += f.GetFeaturesInArea(kp.pt.x, kp.pt.y, r, kp.octave - 1, kp.octave).size();
+            }
+        },
+        results);
+    runKernel(
+        "features_in_area",
+        threads,
+        iterations,
+        [](int) { return std::vector<size_t>(); },
+        [](std::vector<size_t>&) {},
+        [&](std::vector<size_t>& indices) {
+            const ORB_SLAM3::Frame& f = scene.frame;
+            for (const cv::KeyPoint& kp : f.mvKeysUn)
+            {
+                const float r = 4.0f * f.mvScaleFactors[kp.octave];
+                f.GetFeaturesInArea(kp.pt.x, kp.pt.y, r, kp.octave - 1, kp.octave, false, indices);
+            }
+        },
+        results);
+
+    // Projection of the local map points, the frustum culling of Tracking::SearchLocalPoints() is done
+    // once up front since it writes into the shared map points.
+    std::vector<ORB_SLAM3::MapPoint*> visible_points;
+    {
+        ORB_SLAM3::Frame probe;
+        probe.copyFrom(scene.frame_unmatched);
+        for (ORB_SLAM3::MapPoint* mp : scene.points)
+        {
+            mp->mbTrackInView  = false;
+            mp->mbTrackInViewR = false;
+            if (probe.isInFrustum(mp, 0.5f)) visible_points.push_back(mp);
+        }
+    }
+    runKernel(
+        "search_by_projection",
+        threads,
+        iterations,
+        [&](int) { return std::make_unique<ORB_SLAM3::Frame>(); },
+        [&](std::unique_ptr<ORB_SLAM3::Frame>& f) { f->copyFrom(scene.frame_unmatched); },
+        [&](std::unique_ptr<ORB_SLAM3::Frame>& f) {
+            ORB_SLAM3::ORBmatcher matcher(0.8f);
+            matcher.SearchByProjection(*f, visible_points, 3.0f);
+        },
+        results);
+
+    // The same frustum culling per map point (on one thread since it writes into the map points), then from
+    // the local map snapshot of Tracking.
+    ORB_SLAM3::LocalMapProjection projection;
+    projection.Reset(scene.points);
+    if (projection.Project(scene.frame_unmatched, 0.5f) != static_cast<int>(visible_points.size()))
+    {
+        std::cerr << "[Android Slam Tools Info] local map projection keeps " << projection.Visible()
+                  << " points, Frame::isInFrustum() " << visible_points.size() << "." << std::endl;
+        return false;
+    }
+    runKernel(
+        "frustum_per_point",
+        1,
+        iterations,
+        [&](int) { return std::make_unique<ORB_SLAM3::Frame>(); },
+        [&](std::unique_ptr<ORB_SLAM3::Frame>& f) { f->copyFrom(scene.frame_unmatched); },
+        [&](std::unique_ptr<ORB_SLAM3::Frame>& f) {
+            for (ORB_SLAM3::MapPoint* mp : scene.points) f->isInFrustum(mp, 0.5f);
+        },
+        results);
+    runKernel(
+        "local_map_snapshot",
+        threads,
+        iterations,
+        [](int) { return std::make_unique<ORB_SLAM3::LocalMapProjection>(); },
+        [](std::unique_ptr<ORB_SLAM3::LocalMapProjection>&) {},
+        [&](std::unique_ptr<ORB_SLAM3::LocalMapProjection>& p) { p->Reset(scene.points); },
+        results);
+    runKernel(
+        "local_map_projection",
+        threads,
+        iterations,
+        [&](int) {
+            auto p = std::make_unique<ORB_SLAM3::LocalMapProjection>();
+            p->Reset(scene.points);
+            return p;
+        },
+        [](std::unique_ptr<ORB_SLAM3::LocalMapProjection>&) {},
+        [&](std::unique_ptr<ORB_SLAM3::LocalMapProjection>& p) { p->Project(scene.frame_unmatched, 0.5f); },
+        results);
+    // On one thread as well, the matches of the projection are written into the shared map points.
+    runKernel(
+        "search_by_projection_arrays",
+        1,
+        iterations,
+        [&](int) { return std::make_unique<ORB_SLAM3::Frame>(); },
+        [&](std::unique_ptr<ORB_SLAM3::Frame>& f) { f->copyFrom(scene.frame_unmatched); },
+        [&](std::unique_ptr<ORB_SLAM3::Frame>& f) {
+            ORB_SLAM3::ORBmatcher matcher(0.8f);
+            matcher.SearchByProjection(*f, projection, 3.0f);
+        },
+        results);
+
+    // Matching against the reference key frame, as in Tracking::TrackReferenceKeyFrame().
+    struct BowState
+    {
+        std::unique_ptr<ORB_SLAM3::Frame> frame = std::make_unique<ORB_SLAM3::Frame>();
+        std::vector<ORB_SLAM3::MapPoint*> matches;
+    };
+    runKernel(
+        "search_by_bow",
+        threads,
+        iterations,
+        [](int) { return BowState{}; },
+        [&](BowState& s) { s.frame->copyFrom(scene.frame_unmatched); },
+        [&](BowState& s) {
+            ORB_SLAM3::ORBmatcher matcher(0.7f, true);
+            matcher.SearchByBoW(scene.reference, *s.frame, s.matches);
+        },
+        results);
+
+    // Vocabulary transform of the current frame descriptors, from a cv::Mat header per row as
+    // Frame::ComputeBoW() used to do, then straight from the packed descriptors.
+    struct TransformState
+    {
+        std::vector<cv::Mat> descriptors;
+        DBoW2::BowVector     bow;
+        DBoW2::FeatureVector feat;
+    };
+    runKernel(
+        "bow_transform_mat_rows",
+        threads,
+        iterations,
+        [&](int) { return TransformState{}; },
+        [](TransformState&) {},
+        [&](TransformState& s) {
+            s.descriptors = ORB_SLAM3::Converter::toDescriptorVector(scene.frame.mDescriptors.Mat());
+            vocabulary->transform(s.descriptors, s.bow, s.feat, 4);
+        },
+        results);
+    runKernel(
+        "bow_transform",
+        threads,
+        iterations,
+        [&](int) { return TransformState{}; },
+        [](TransformState&) {},
+        [&](TransformState& s) {
+            const ORB_SLAM3::DescriptorArray& descriptors = scene.frame.mDescriptors;
+            vocabulary->transform(descriptors.Data(), descriptors.Size(), s.bow, s.feat, 4);
+        },
+        results);
+
+    // Same transform with the blocks of descriptors sent down the tree by a pool of 4 threads, as
+    // Frame::ComputeBoW() does with the extractor pool. The vectors must be the serial ones.
+    struct PooledTransformState : TransformState
+    {
+        std::unique_ptr<ORB_SLAM3::WorkerPool> pool;
+    };
+    {
+        const ORB_SLAM3::DescriptorArray& descriptors = scene.frame.mDescriptors;
+        ORB_SLAM3::WorkerPool             pool(4);
+        DBoW2::BowVector                  serial_bow, pooled_bow;
+        DBoW2::FeatureVector              serial_feat, pooled_feat;
+        vocabulary->transform(descriptors.Data(), descriptors.Size(), serial_bow, serial_feat, 4);
+        vocabulary->transform(descriptors.Data(), descriptors.Size(), pooled_bow, pooled_feat, 4,
+                              [&pool](int n, const std::function<void(int)>& f) { pool.ParallelFor(n, f); });
+        if (serial_bow != pooled_bow || serial_feat != pooled_feat)
+        {
+            std::cerr << "[Android Slam Tools Info] bow_transform_pool4 differs from the serial transform." << std::endl;
+        }
+    }
+    runKernel(
+        "bow_transform_pool4",
+        threads,
+        iterations,
+        [&](int) {
+            PooledTransformState s;
+            s.pool = std::make_unique<ORB_SLAM3::WorkerPool>(4);
+            return s;
+        },
+        [](PooledTransformState&) {},
+        [&](PooledTransformState& s) {
+            const ORB_SLAM3::DescriptorArray& descriptors = scene.frame.mDescriptors;
+            ORB_SLAM3::WorkerPool*            pool        = s.pool.get();
+            vocabulary->transform(descriptors.Data(), descriptors.Size(), s.bow, s.feat, 4,
+                                  [pool](int n, const std::function<void(int)>& f) { pool->ParallelFor(n, f); });
+        },
+        results);
+
+    // Key frame database searches with the current frame words, over 1k, 10k and 50k key frames spread
+    // over 4 maps: in every map as the loop and merge detection, then in one map as the relocalization.
+    // The key frames have the words of the fixture key frames with 90% of them replaced at random.
+    // Then the insertion and removal of a key frame while another thread searches every map, as the
+    // local mapping does during a loop detection.
+    std::vector<const DBoW2::BowVector*> key_frame_words;
+    for (ORB_SLAM3::KeyFrame* kf : scene.key_frames)
+    {
+        if (kf) key_frame_words.push_back(&kf->mBowVec);
+    }
+    for (int key_frame_count : { 1000, 10000, 50000 })
+    {
+        ORB_SLAM3::BowInvertedIndex              index;
+        std::mt19937                             rng(key_frame_count);
+        std::uniform_int_distribution<unsigned> random_word(0, vocabulary->size() - 1);
+        std::uniform_real_distribution<float>   keep(0.0f, 1.0f);
+        for (int i = 0; i < key_frame_count; ++i)
+        {
+            DBoW2::BowVector bow;
+            for (const auto& word : *key_frame_words[i % key_frame_words.size()])
+            {
+                bow.addWeight(keep(rng) < 0.1f ? word.first : random_word(rng), word.second);
+            }
+            index.Add(i % 4, bow);
+        }
+
+        struct SearchState
+        {
+            std::vector<unsigned int> ids;
+            std::vector<int>          words;
+        };
+        for (int partition : { -1, 0 })
+        {
+            const std::string name = std::string(partition < 0 ? "kfdb_search_all_" : "kfdb_search_map_") +
+                                     std::to_string(key_frame_count / 1000) + "k";
+            runKernel(
+                name.c_str(),
+                threads,
+                iterations,
+                [](int) { return SearchState{}; },
+                [](SearchState&) {},
+                [&](SearchState& s) {
+                    ORB_SLAM3::BowInvertedIndex::ReadSection read(index);
+                    index.Search(scene.frame.mBowVec, partition, s.ids, s.words);
+                },
+                results);
+        }
+
+        std::atomic<bool> searching(true);
+        std::thread       searcher([&]() {
+            SearchState s;
+            while (searching.load())
+            {
+                ORB_SLAM3::BowInvertedIndex::ReadSection read(index);
+                index.Search(scene.frame.mBowVec, -1, s.ids, s.words);
+            }
+        });
+        const std::string name = "kfdb_add_erase_" + std::to_string(key_frame_count / 1000) + "k";
+        runKernel(
+            name.c_str(),
+            1,
+            iterations,
+            [](int) { return 0; },
+            [](int&) {},
+            [&](int&) { index.Erase(index.Add(0, scene.frame.mBowVec)); },
+            results);
+        searching = false;
+        searcher.join();
+    }
+
+    return true;
+}
+
+// FeatureGrid cells against per cell vectors filled one key point after the other, as the frame grid used to
+// be, on the key points of the fixture images.
+bool checkFeatureGrid(const BenchFixture& fixture)
+{
+    const BenchFixture::OrbParams& orb = fixture.orb;
+    ORB_SLAM3::ORBextractor extractor(orb.n_features, orb.scale_factor, orb.n_levels, orb.ini_th_fast, orb.min_th_fast);
+
+    const std::vector<const BenchFixture::View*> views = fixtureViews(fixture);
+
+    constexpr int cols = ORB_SLAM3::FRAME_GRID_COLS;
+    constexpr int rows = ORB_SLAM3::FRAME_GRID_ROWS;
+
+    size_t key_points = 0;
+    for (const BenchFixture::View* view : views)
+    {
+        std::vector<cv::KeyPoint> keys;
+        cv::Mat                   descriptors;
+        std::vector<int>          lapping_area = { 0, 0 };
+        extractor(view->image, cv::Mat(), keys, descriptors, lapping_area);
+
+        const float width_inv  = (float)cols / (float)view->image.cols;
+        const float height_inv = (float)rows / (float)view->image.rows;
+
+        std::vector<std::vector<size_t>> expected(cols * rows);
+        std::vector<int>                 cells(keys.size(), -1);
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            const int x = (int)std::round(keys[i].pt.x * width_inv);
+            const int y = (int)std::round(keys[i].pt.y * height_inv);
+            if (x < 0 || x >= cols || y < 0 || y >= rows) continue;
+            cells[i] = x * rows + y;
+            expected[cells[i]].push_back(i);
+        }
+
+        ORB_SLAM3::FeatureGrid grid;
+        grid.Build(cols, rows, cells);
+        for (int x = 0; x < cols; ++x)
+        {
+            for (int y = 0; y < rows; ++y)
+            {
+                const std::vector<size_t>& cell = expected[x * rows + y];
+                if (!std::equal(cell.begin(), cell.end(), grid.CellBegin(x, y), grid.CellEnd(x, y)))
+                {
+                    std::cerr << "[Android Slam Tools Info] feature grid cell " << x << "," << y
+                              << " differs from the per cell vectors on frame " << view->time_stamp << "."
+                              << std::endl;
+                    return false;
+                }
+            }
+        }
+        key_points += keys.size();
+    }
+
+    std::cout << "[Android Slam Tools Info] feature_grid: " << key_points
+              << " key points in the same cells and order as the per cell vectors." << std::endl;
+    return true;
+}
+
+bool checkFrameKernels(const BenchFixture& fixture) { return checkFeatureGrid(fixture); }
+
+}  // namespace kernel_bench_utils
+}  // namespace android_slam
@@ -0,0 +1,259 @@
+// Kernels of the map: object pools, map point observations, map enumeration, covisibility graph and map
+// point geometry.
+#include "KernelBench.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <utils/ImuTypes.h>
+#include <utils/ObjectPool.h>
+
+namespace android_slam
+{
+namespace kernel_bench_utils
+{
+
+bool runMapKernels(const BenchContext& ctx, std::vector<KernelResult>& results)
+{
+    Scene&       scene      = ctx.scene;
+    const size_t iterations = ctx.iterations;
+    const int    threads    = ctx.threads;
+
+    // Creation and deletion of the map objects, 256 at a time, from their slab pools then from the Eigen
+    // aligned heap allocation of the EIGEN_MAKE_ALIGNED_OPERATOR_NEW they replace.
+    struct AllocState
+    {
+        std::vector<void*> chunks = std::vector<void*>(256);
+    };
+    auto runAllocKernels = [&](const std::string& type, ORB_SLAM3::FixedPool& pool, size_t size) {
+        runKernel(
+            ("alloc_" + type + "_pool").c_str(),
+            threads,
+            iterations,
+            [](int) { return AllocState{}; },
+            [](AllocState&) {},
+            [&](AllocState& s) {
+                for (void*& p : s.chunks) p = pool.Allocate();
+                for (void* p : s.chunks) pool.Free(p);
+            },
+            results);
+        runKernel(
+            ("alloc_" + type + "_heap").c_str(),
+            threads,
+            iterations,
+            [](int) { return AllocState{}; },
+            [](AllocState&) {},
+            [&](AllocState& s) {
+                for (void*& p : s.chunks) p = Eigen::internal::aligned_malloc(size);
+                for (void* p : s.chunks) Eigen::internal::aligned_free(p);
+            },
+            results);
+    };
+    runAllocKernels("map_point",
+                    ORB_SLAM3::ObjectPool<ORB_SLAM3::MapPoint>::Get("MapPoint"),
+                    sizeof(ORB_SLAM3::MapPoint));
+    runAllocKernels("key_frame",
+                    ORB_SLAM3::ObjectPool<ORB_SLAM3::KeyFrame>::Get("KeyFrame"),
+                    sizeof(ORB_SLAM3::KeyFrame));
+    runAllocKernels("preintegrated",
+                    ORB_SLAM3::ObjectPool<ORB_SLAM3::IMU::Preintegrated>::Get("Preintegrated"),
+                    sizeof(ORB_SLAM3::IMU::Preintegrated));
+
+    // Key frame votes of the frame map points, as Tracking::UpdateLocalKeyFrames gathers them, reading the
+    // observations through a copy then through the locked visitor.
+    runKernel(
+        "observation_votes_copy",
+        threads,
+        iterations,
+        [](int) { return 0; },
+        [](int& votes) { votes = 0; },
+        [&](int& votes) {
+            for (ORB_SLAM3::MapPoint* mp : scene.frame.mvpMapPoints)
+            {
+                if (!mp) continue;
+                const ORB_SLAM3::ObservationList observations = mp->GetObservations();
+                for (const ORB_SLAM3::Observation& obs : observations) votes += obs.pKF != nullptr;
+            }
+        },
+        results);
+    runKernel(
+        "observation_votes_visit",
+        threads,
+        iterations,
+        [](int) { return 0; },
+        [](int& votes) { votes = 0; },
+        [&](int& votes) {
+            for (ORB_SLAM3::MapPoint* mp : scene.frame.mvpMapPoints)
+            {
+                if (!mp) continue;
+                mp->ForEachObservation([&votes](const ORB_SLAM3::Observation& obs) { votes += obs.pKF != nullptr; });
+            }
+        },
+        results);
+
+    // Enumeration of the map points, as SlamKernel::handleData does every frame, through a copy of the
+    // whole map then through the shared snapshot of an unchanged map.
+    runKernel(
+        "map_points_copy",
+        threads,
+        iterations,
+        [](int) { return 0; },
+        [](int& count) { count = 0; },
+        [&](int& count) {
+            const std::vector<ORB_SLAM3::MapPoint*> points = scene.map->GetAllMapPoints();
+            for (ORB_SLAM3::MapPoint* mp : points) count += mp != nullptr;
+        },
+        results);
+    runKernel(
+        "map_points_snapshot",
+        threads,
+        iterations,
+        [](int) { return 0; },
+        [](int& count) { count = 0; },
+        [&](int& count) {
+            const auto points = scene.map->GetMapPointSnapshot();
+            for (ORB_SLAM3::MapPoint* mp : *points) count += mp != nullptr;
+        },
+        results);
+
+    // Best 10 covisibles of every key frame, as the local map and the key frame database read them, through
+    // a copy then through the shared ordered list.
+    runKernel(
+        "covisibles_best_copy",
+        threads,
+        iterations,
+        [](int) { return 0; },
+        [](int& count) { count = 0; },
+        [&](int& count) {
+            for (ORB_SLAM3::KeyFrame* kf : scene.key_frames)
+            {
+                if (!kf) continue;
+                const std::vector<ORB_SLAM3::KeyFrame*> neighbors = kf->GetBestCovisibilityKeyFrames(10);
+                count += static_cast<int>(neighbors.size());
+            }
+        },
+        results);
+    runKernel(
+        "covisibles_best_shared",
+        threads,
+        iterations,
+        [](int) { return 0; },
+        [](int& count) { count = 0; },
+        [&](int& count) {
+            for (ORB_SLAM3::KeyFrame* kf : scene.key_frames)
+            {
+                if (!kf) continue;
+                const auto neighbors = kf->GetCovisibles();
+                count += static_cast<int>(neighbors->CountBest(10));
+            }
+        },
+        results);
+
+    // Covisibility edges of the reference key frame rebuilt from its shared map point counts. Its neighbors
+    // are written, so it is kept single threaded.
+    runKernel(
+        "update_connections",
+        1,
+        iterations,
+        [](int) { return 0; },
+        [](int&) {},
+        [&](int&) { scene.reference->UpdateConnections(); },
+        results);
+
+    // Projection data of every map point, as the local map search reads it in tracking: alone, then while
+    // another thread rewrites the positions as the BA recovery does, then the same through a mutex per point
+    // as the geometry was read before.
+    const auto geometry_points = scene.map->GetMapPointSnapshot();
+    struct GeometryState
+    {
+        Eigen::Vector3f pos, normal;
+        float           min_distance = 0.0f, max_distance = 0.0f;
+        float           sum          = 0.0f;
+    };
+    auto read_geometry = [&](GeometryState& s) {
+        for (ORB_SLAM3::MapPoint* mp : *geometry_points)
+        {
+            mp->GetProjectionData(s.pos, s.normal, s.min_distance, s.max_distance);
+            s.sum += s.pos.z() + s.max_distance;
+        }
+    };
+    runKernel(
+        "map_point_geometry",
+        threads,
+        iterations,
+        [](int) { return GeometryState{}; },
+        [](GeometryState&) {},
+        read_geometry,
+        results);
+
+    std::atomic<bool> writing(true);
+    std::thread       writer([&]() {
+        while (writing.load())
+        {
+            for (ORB_SLAM3::MapPoint* mp : *geometry_points) mp->SetWorldPos(mp->GetWorldPos());
+        }
+    });
+    runKernel(
+        "map_point_geometry_writer",
+        threads,
+        iterations,
+        [](int) { return GeometryState{}; },
+        [](GeometryState&) {},
+        read_geometry,
+        results);
+    writing = false;
+    writer.join();
+
+    struct LockedGeometry
+    {
+        std::mutex      mutex;
+        Eigen::Vector3f pos, normal;
+        float           min_distance = 0.0f, max_distance = 0.0f;
+    };
+    std::vector<LockedGeometry> locked_geometry(geometry_points->size());
+    for (size_t i = 0; i < locked_geometry.size(); ++i)
+    {
+        LockedGeometry& g = locked_geometry[i];
+        (*geometry_points)[i]->GetProjectionData(g.pos, g.normal, g.min_distance, g.max_distance);
+    }
+    writing = true;
+    writer  = std::thread([&]() {
+        while (writing.load())
+        {
+            for (LockedGeometry& g : locked_geometry)
+            {
+                std::unique_lock<std::mutex> lock(g.mutex);
+                g.pos = Eigen::Vector3f(g.pos);
+            }
+        }
+    });
+    runKernel(
+        "map_point_geometry_mutex",
+        threads,
+        iterations,
+        [](int) { return GeometryState{}; },
+        [](GeometryState&) {},
+        [&](GeometryState& s) {
+            for (LockedGeometry& g : locked_geometry)
+            {
+                std::unique_lock<std::mutex> lock(g.mutex);
+                s.pos          = g.pos;
+                s.normal       = g.normal;
+                s.min_distance = g.min_distance;
+                s.max_distance = g.max_distance;
+                s.sum += s.pos.z() + s.max_distance;
+            }
+        },
+        results);
+    writing = false;
+    writer.join();
+
+    return true;
+}
+
+}  // namespace kernel_bench_utils
+}  // namespace android_slam
@@ -0,0 +1,52 @@
+// Kernels of the solver: motion only BA of the frame and local BA around the reference key frame.
+#include "KernelBench.h"
+#include <memory>
+#include <vector>
+
+#include <solver/Optimizer.h>
+
+namespace android_slam
+{
+namespace kernel_bench_utils
+{
+
+bool runSolverKernels(const BenchContext& ctx, std::vector<KernelResult>& results)
+{
+    Scene&       scene      = ctx.scene;
+    const size_t iterations = ctx.iterations;
+    const int    threads    = ctx.threads;
+
+    // Motion only BA of the current frame matches.
+    runKernel(
+        "pose_optimization",
+        threads,
+        iterations,
+        [&](int) { return std::make_unique<ORB_SLAM3::Frame>(); },
+        [&](std::unique_ptr<ORB_SLAM3::Frame>& f) { f->copyFrom(scene.frame); },
+        [](std::unique_ptr<ORB_SLAM3::Frame>& f) { ORB_SLAM3::Optimizer::PoseOptimization(f.get()); },
+        results);
+
+    // Local BA around the reference key frame, it writes the shared map so it is kept single threaded.
+    runKernel(
+        "local_bundle_adjustment",
+        1,
+        iterations,
+        [](int) { return 0; },
+        [&](int&) { restoreScene(scene); },
+        [&](int&) {
+            bool stop       = false;
+            int  num_fixed  = 0;
+            int  num_opt    = 0;
+            int  num_points = 0;
+            int  num_edges  = 0;
+            ORB_SLAM3::Optimizer::LocalBundleAdjustment(
+                scene.reference, &stop, scene.map, num_fixed, num_opt, num_points, num_edges);
+        },
+        results);
+    restoreScene(scene);
+
+    return true;
+}
+
+}  // namespace kernel_bench_utils
+}  // namespace android_slam
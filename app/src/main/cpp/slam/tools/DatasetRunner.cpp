@@ -0,0 +1,255 @@
+// Host side harness: feeds an EuRoC / TUM-VI style dataset, or a sensor log recorded by the app, to
+// SlamKernel and writes the per-frame stage latency and the final trajectories.
+//
+// Usage: dataset_runner <vocabulary ORBVoc.txt | ORBVoc.bin> <dataset folder | sensor log> <output folder>
+//                       [max frames] [--wall-clock] [--deterministic]
+//
+//   --wall-clock      Sensor logs only: feed the records at the pace they were recorded at instead of
+//                     as fast as possible.
+//   --deterministic   Wait for local mapping and loop closing to go idle after every frame, so that
+//                     repeated runs of the same input give the same trajectory.
+//
+// Outputs in <output folder>:
+//   frame_times.csv            frame,time_stamp,extract_ms,track_ms,local_map_ms,total_ms
+//   frame_trajectory.txt       EuRoC format, time stamps relative to the first image.
+//   key_frame_trajectory.txt   EuRoC format, time stamps relative to the first image.
+//   trace.json                 Chrome trace of the slam threads, newest spans of each thread.
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SensorLog.h>
+#include <SlamKernel.h>
+
+#include "EurocReader.h"
+
+namespace android_slam
+{
+namespace dataset_runner_utils
+{
+
+struct StageSamples
+{
+    const char*         name;
+    std::vector<double> samples;
+};
+
+double percentile(std::vector<double> samples, double p)
+{
+    if (samples.empty()) return 0.0;
+
+    std::sort(samples.begin(), samples.end());
+    size_t idx = static_cast<size_t>(p * (double)(samples.size() - 1) + 0.5);
+    return samples[std::min(idx, samples.size() - 1)];
+}
+
+double mean(const std::vector<double>& samples)
+{
+    if (samples.empty()) return 0.0;
+
+    double sum = 0.0;
+    for (double s : samples) sum += s;
+    return sum / (double)samples.size();
+}
+
+}  // namespace dataset_runner_utils
+}  // namespace android_slam
+
+int main(int argc, char** argv)
+{
+    using namespace android_slam;
+
+    if (argc < 4)
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " <vocabulary> <dataset folder | sensor log> <output folder> [max frames] [--wall-clock]"
+                     " [--deterministic]"
+                  << std::endl;
+        return 1;
+    }
+
+    const std::string voc_file    = argv[1];
+    const std::string dataset_dir = argv[2];
+    const std::string output_dir  = argv[3];
+
+    size_t                     max_frames = std::numeric_limits<size_t>::max();
+    SensorLogReplayer::Options replay_options{};
+    for (int i = 4; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--wall-clock")
+        {
+            replay_options.pace = SensorLogReplayer::Pace::WallClock;
+        }
+        else if (arg == "--deterministic")
+        {
+            replay_options.deterministic = true;
+        }
+        else
+        {
+            max_frames = static_cast<size_t>(std::stoull(arg));
+        }
+    }
+
+    // A regular file is a sensor log, a folder an EuRoC dataset.
+    std::unique_ptr<SensorLogReader> log_reader;
+    std::unique_ptr<EurocReader>     euroc_reader;
+
+    // The kernel is created with the size of the first image.
+    int32_t width           = 0;
+    int32_t height          = 0;
+    int64_t begin_timestamp = 0;
+    Image   first;
+    if (std::filesystem::is_regular_file(dataset_dir))
+    {
+        log_reader = std::make_unique<SensorLogReader>(dataset_dir);
+        if (!log_reader->isValid()) return 1;
+
+        width           = log_reader->width();
+        height          = log_reader->height();
+        begin_timestamp = log_reader->beginTimeStamp();
+    }
+    else
+    {
+        euroc_reader = std::make_unique<EurocReader>(dataset_dir);
+        if (!euroc_reader->isValid()) return 1;
+
+        max_frames = std::min(max_frames, euroc_reader->imageCount());
+        first      = euroc_reader->loadImage(0, width, height);
+        if (first.data.empty()) return 1;
+        begin_timestamp = first.time_stamp;
+    }
+
+    std::filesystem::create_directories(output_dir);
+
+    std::cout << "[Android Slam Tools Info] Loading vocabulary " << voc_file << "." << std::endl;
+    std::string voc_data = readTextFile(voc_file);
+    if (voc_data.empty()) return 1;
+
+    SlamKernel kernel(width, height, std::move(voc_data), begin_timestamp);
+    kernel.setTracing(true);
+
+    std::ofstream frame_times(output_dir + "/frame_times.csv");
+    frame_times << "frame,time_stamp,extract_ms,track_ms,local_map_ms,total_ms" << std::endl;
+    frame_times << std::fixed << std::setprecision(3);
+
+    dataset_runner_utils::StageSamples stages[] = {
+        { "extract", {} },
+        { "track", {} },
+        { "local_map", {} },
+        { "total", {} },
+    };
+
+    auto record_frame = [&](size_t i, int64_t time_stamp, const TrackingResult& res) {
+        const TrackingResult::StageTime& t = res.stage_time;
+        frame_times << i << ',' << time_stamp << ',' << t.extract << ',' << t.track << ',' << t.local_map << ','
+                    << t.total << '\n';
+
+        stages[0].samples.push_back(t.extract);
+        stages[1].samples.push_back(t.track);
+        stages[2].samples.push_back(t.local_map);
+        stages[3].samples.push_back(t.total);
+
+        if ((i + 1) % 100 == 0)
+        {
+            std::cout << "[Android Slam Tools Info] " << (i + 1) << " frames." << std::endl;
+        }
+    };
+
+    const std::chrono::steady_clock::time_point run_begin = std::chrono::steady_clock::now();
+
+    if (log_reader)
+    {
+        SensorLogReplayer replayer(*log_reader, replay_options);
+        TrackingResult    res;
+        while (replayer.recordIndex() < max_frames && replayer.step(kernel, res))
+        {
+            record_frame(replayer.recordIndex() - 1, replayer.lastTimeStamp(), res);
+        }
+    }
+    else
+    {
+        std::vector<Image> images(1);
+        for (size_t i = 0; i < max_frames; ++i)
+        {
+            int32_t w = 0;
+            int32_t h = 0;
+            images[0] = (i == 0) ? std::move(first) : euroc_reader->loadImage(i, w, h);
+            if (images[0].data.empty()) break;
+            if (i != 0 && (w != width || h != height))
+            {
+                std::cerr << "[Android Slam Tools Info] Image " << i << " has a different size, stop." << std::endl;
+                break;
+            }
+
+            TrackingResult res = kernel.handleData(images, euroc_reader->imuBetween(i));
+            if (replay_options.deterministic) kernel.waitUntilIdle();
+
+            record_frame(i, images[0].time_stamp, res);
+        }
+    }
+
+    const double run_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - run_begin).count();
+
+    kernel.dumpTrace(output_dir + "/trace.json");
+    kernel.saveTrajectory(output_dir + "/frame_trajectory.txt", output_dir + "/key_frame_trajectory.txt");
+
+    const size_t processed = stages[3].samples.size();
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "[Android Slam Tools Info] " << processed << " frames in " << run_seconds << " s ("
+              << (run_seconds > 0.0 ? (double)processed / run_seconds : 0.0) << " fps)." << std::endl;
+    std::cout << std::left << std::setw(12) << "stage" << std::right << std::setw(12) << "mean ms"
+              << std::setw(12) << "p50 ms" << std::setw(12) << "p95 ms" << std::setw(12) << "p99 ms"
+              << std::setw(12) << "max ms" << std::endl;
+    for (const auto& stage : stages)
+    {
+        std::cout << std::left << std::setw(12) << stage.name << std::right << std::setw(12)
+                  << dataset_runner_utils::mean(stage.samples) << std::setw(12)
+                  << dataset_runner_utils::percentile(stage.samples, 0.50) << std::setw(12)
+                  << dataset_runner_utils::percentile(stage.samples, 0.95) << std::setw(12)
+                  << dataset_runner_utils::percentile(stage.samples, 0.99) << std::setw(12)
+                  << dataset_runner_utils::percentile(stage.samples, 1.00) << std::endl;
+    }
+
+    // Internal timers of the slam threads, over the whole run.
+    std::cout << std::left << std::setw(44) << "timer" << std::right << std::setw(10) << "count" << std::setw(12)
+              << "mean ms" << std::setw(12) << "p50 ms" << std::setw(12) << "p95 ms" << std::setw(12) << "p99 ms"
+              << std::setw(12) << "max ms" << std::endl;
+    for (const TimerStats& timer : kernel.getStats())
+    {
+        std::cout << std::left << std::setw(44) << timer.name << std::right << std::setw(10) << timer.count
+                  << std::setw(12) << timer.mean << std::setw(12) << timer.p50 << std::setw(12) << timer.p95
+                  << std::setw(12) << timer.p99 << std::setw(12) << timer.max << std::endl;
+    }
+
+    // Key frames and map points left in memory at the end of the run.
+    const MemoryStats memory = kernel.getMemoryStats();
+    std::cout << "[Android Slam Tools Info] key frames: " << memory.key_frames << " (" << memory.key_frame_bytes
+              << " bytes), retired " << memory.retired_key_frames << " (" << memory.retired_key_frame_bytes
+              << " bytes), reclaimed " << memory.reclaimed_key_frames << " (" << memory.reclaimed_bytes
+              << " bytes)." << std::endl;
+    std::cout << "[Android Slam Tools Info] map points: " << memory.map_points << " (" << memory.map_point_bytes
+              << " bytes), bad " << memory.bad_map_points << " (" << memory.bad_map_point_bytes << " bytes)."
+              << std::endl;
+
+    // Slab pools of the map objects: the unused share of the slabs is their fragmentation.
+    std::cout << std::left << std::setw(16) << "pool" << std::right << std::setw(12) << "chunk" << std::setw(12)
+              << "live" << std::setw(16) << "slab bytes" << std::setw(12) << "unused %" << std::endl;
+    for (const PoolStats& pool : kernel.getPoolStats())
+    {
+        const double used = (double)(pool.live * pool.chunk_size);
+        std::cout << std::left << std::setw(16) << pool.name << std::right << std::setw(12) << pool.chunk_size
+                  << std::setw(12) << pool.live << std::setw(16) << pool.slab_bytes << std::setw(12)
+                  << (pool.slab_bytes > 0 ? 100.0 * (1.0 - used / (double)pool.slab_bytes) : 0.0) << std::endl;
+    }
+
+    return 0;
+}
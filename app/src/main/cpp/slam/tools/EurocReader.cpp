@@ -0,0 +1,153 @@
+#include "EurocReader.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+namespace android_slam
+{
+namespace euroc_reader_utils
+{
+
+bool isFile(const std::string& file)
+{
+    std::ifstream fin(file);
+    return fin.good();
+}
+
+// Splits a csv line, skipping comment lines beginning with '#'.
+bool splitCsvLine(const std::string& line, std::vector<std::string>& fields)
+{
+    fields.clear();
+    if (line.empty() || line[0] == '#') return false;
+
+    std::stringstream ss(line);
+    std::string       field;
+    while (std::getline(ss, field, ','))
+    {
+        field.erase(std::remove_if(field.begin(), field.end(), [](char c) { return c == '\r' || c == ' '; }),
+                    field.end());
+        fields.push_back(field);
+    }
+    return !fields.empty();
+}
+
+}  // namespace euroc_reader_utils
+
+EurocReader::EurocReader(const std::string& root)
+{
+    std::string mav0 = root + "/mav0";
+    if (!euroc_reader_utils::isFile(mav0 + "/cam0/data.csv"))
+    {
+        mav0 = root;
+    }
+
+    std::vector<std::string> fields;
+    std::string              line;
+
+    std::ifstream cam_csv(mav0 + "/cam0/data.csv");
+    while (std::getline(cam_csv, line))
+    {
+        if (!euroc_reader_utils::splitCsvLine(line, fields) || fields.size() < 2) continue;
+
+        m_images.push_back({ std::stoll(fields[0]), mav0 + "/cam0/data/" + fields[1] });
+    }
+
+    std::ifstream imu_csv(mav0 + "/imu0/data.csv");
+    while (std::getline(imu_csv, line))
+    {
+        if (!euroc_reader_utils::splitCsvLine(line, fields) || fields.size() < 7) continue;
+
+        m_imus.emplace_back(std::stof(fields[4]),
+                            std::stof(fields[5]),
+                            std::stof(fields[6]),
+                            std::stof(fields[1]),
+                            std::stof(fields[2]),
+                            std::stof(fields[3]),
+                            std::stoll(fields[0]));
+    }
+
+    if (m_images.empty())
+    {
+        std::cerr << "[Android Slam Tools Info] No image found in " << mav0 << "/cam0/data.csv." << std::endl;
+    }
+    if (m_imus.empty())
+    {
+        std::cerr << "[Android Slam Tools Info] No imu data found in " << mav0 << "/imu0/data.csv." << std::endl;
+    }
+}
+
+Image EurocReader::loadImage(size_t idx, int32_t& width, int32_t& height) const
+{
+    const ImageEntry& entry = m_images[idx];
+
+    cv::Mat bgr = cv::imread(entry.file, cv::IMREAD_COLOR);
+    if (bgr.empty())
+    {
+        std::cerr << "[Android Slam Tools Info] Failed to load image " << entry.file << "." << std::endl;
+        width  = 0;
+        height = 0;
+        return {};
+    }
+
+    cv::Mat rgb;
+    cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+
+    width  = rgb.cols;
+    height = rgb.rows;
+
+    std::vector<uint8_t> data(rgb.total() * rgb.elemSize());
+    if (rgb.isContinuous())
+    {
+        memcpy(data.data(), rgb.data, data.size());
+    }
+    else
+    {
+        const size_t row_size = rgb.cols * rgb.elemSize();
+        for (int r = 0; r < rgb.rows; ++r)
+        {
+            memcpy(data.data() + r * row_size, rgb.ptr(r), row_size);
+        }
+    }
+
+    return { std::move(data), entry.time_stamp };
+}
+
+std::vector<ImuPoint> EurocReader::imuBetween(size_t idx) const
+{
+    std::vector<ImuPoint> res;
+    if (idx == 0) return res;
+
+    const int64_t begin = m_images[idx - 1].time_stamp;
+    const int64_t end   = m_images[idx].time_stamp;
+
+    auto it = std::upper_bound(m_imus.begin(),
+                               m_imus.end(),
+                               begin,
+                               [](int64_t ts, const ImuPoint& imu) { return ts < imu.time_stamp; });
+    for (; it != m_imus.end() && it->time_stamp <= end; ++it)
+    {
+        res.push_back(*it);
+    }
+    return res;
+}
+
+std::string readTextFile(const std::string& file)
+{
+    std::ifstream fin(file, std::ios::binary);
+    if (!fin.good())
+    {
+        std::cerr << "[Android Slam Tools Info] Failed to open " << file << "." << std::endl;
+        return {};
+    }
+
+    std::stringstream ss;
+    ss << fin.rdbuf();
+    return ss.str();
+}
+
+}  // namespace android_slam
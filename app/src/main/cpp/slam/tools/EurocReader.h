@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <SlamKernel.h>
+
+namespace android_slam
+{
+
+// Reader of EuRoC / TUM-VI style dataset folders:
+//   <root>/mav0/cam0/data.csv   "timestamp [ns],filename"
+//   <root>/mav0/cam0/data/*.png
+//   <root>/mav0/imu0/data.csv   "timestamp [ns],wx,wy,wz,ax,ay,az"
+// Passing the mav0 folder itself as root is accepted as well.
+class EurocReader
+{
+public:
+    struct ImageEntry
+    {
+        int64_t     time_stamp;
+        std::string file;
+    };
+
+public:
+    explicit EurocReader(const std::string& root);
+
+    bool isValid() const { return !m_images.empty(); }
+
+    size_t imageCount() const { return m_images.size(); }
+    const ImageEntry& imageEntry(size_t idx) const { return m_images[idx]; }
+
+    // Loads the image as tightly packed RGB, the layout SlamKernel::handleData() expects.
+    Image loadImage(size_t idx, int32_t& width, int32_t& height) const;
+
+    // Imu samples in (time_stamp(idx - 1), time_stamp(idx)], empty for the first image.
+    std::vector<ImuPoint> imuBetween(size_t idx) const;
+
+private:
+    std::vector<ImageEntry> m_images;
+    std::vector<ImuPoint>   m_imus;
+};
+
+// Reads the whole file into a string, used for the ORB vocabulary.
+std::string readTextFile(const std::string& file);
+
+}  // namespace android_slam
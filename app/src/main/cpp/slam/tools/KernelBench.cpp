@@ -0,0 +1,488 @@
+// Host side micro benchmarks of the slam hot kernels, driven by fixtures captured from a real run.
+//
+// Usage:
+//   kernel_bench capture <vocabulary ORBVoc.txt | ORBVoc.bin> <dataset folder> <frame index> <fixture file>
+//       Runs SlamKernel on the dataset up to <frame index>, freezes local mapping and stores the
+//       local window of the tracker (reference key frame, its covisible key frames, the local map
+//       points with all their observers and the matches of the current frame).
+//   kernel_bench run <vocabulary ORBVoc.txt | ORBVoc.bin> <fixture file> [iterations] [threads]
+//       Rebuilds the window from the fixture and times every kernel, reporting ns/op, allocations/op
+//       and allocated bytes/op per thread. The allocations of the other threads during the run (worker
+//       pools, helper threads of a kernel) are reported apart as pool allocations/op, split evenly over
+//       the ops of all the threads. LocalBundleAdjustment always runs on a single thread.
+//       The kernels of each subsystem live in BenchFeature.cpp, BenchFrame.cpp, BenchMap.cpp and
+//       BenchSolver.cpp.
+//   kernel_bench check <fixture file>
+//       Checks that the optimized kernels give bit exact results against the code they replace, on
+//       the fixture images. Exits with 1 on the first failing kernel.
+#include "KernelBench.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <SlamKernel.h>
+
+#include <camera_models/Pinhole.h>
+#include <core/System.h>
+#include <threads/LocalMapping.h>
+#include <threads/Tracking.h>
+
+#include "EurocReader.h"
+
+namespace android_slam
+{
+namespace kernel_bench_utils
+{
+
+constexpr size_t k_kept_frames = 64;
+
+std::array<float, 7> toPose(const Sophus::SE3f& Tcw)
+{
+    const Eigen::Quaternionf q = Tcw.unit_quaternion();
+    const Eigen::Vector3f    t = Tcw.translation();
+    return { q.x(), q.y(), q.z(), q.w(), t.x(), t.y(), t.z() };
+}
+
+Sophus::SE3f fromPose(const std::array<float, 7>& pose)
+{
+    return Sophus::SE3f(Eigen::Quaternionf(pose[3], pose[0], pose[1], pose[2]),
+                        Eigen::Vector3f(pose[4], pose[5], pose[6]));
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Capture.
+// ---------------------------------------------------------------------------------------------------
+
+int capture(const std::string& voc_file, const std::string& dataset_dir, size_t frame_index, const std::string& fixture_file)
+{
+    EurocReader reader(dataset_dir);
+    if (!reader.isValid()) return 1;
+    if (frame_index >= reader.imageCount())
+    {
+        std::cerr << "[Android Slam Tools Info] The dataset only has " << reader.imageCount() << " images." << std::endl;
+        return 1;
+    }
+
+    int32_t width  = 0;
+    int32_t height = 0;
+    Image   first  = reader.loadImage(0, width, height);
+    if (first.data.empty()) return 1;
+
+    std::string voc_data = readTextFile(voc_file);
+    if (voc_data.empty()) return 1;
+
+    SlamKernel kernel(width, height, std::move(voc_data), first.time_stamp);
+
+    ORB_SLAM3::System&   system  = kernel.getSystem();
+    ORB_SLAM3::Tracking* tracker = &system.getTracker();
+
+    // Gray images of the recent frames and of every key frame, indexed by frame id.
+    std::map<unsigned long, cv::Mat> gray_images;
+
+    std::vector<Image> images(1);
+    for (size_t i = 0; i <= frame_index; ++i)
+    {
+        int32_t w = 0;
+        int32_t h = 0;
+        images[0] = (i == 0) ? std::move(first) : reader.loadImage(i, w, h);
+        if (images[0].data.empty()) return 1;
+
+        kernel.handleData(images, reader.imuBetween(i));
+
+        const unsigned long frame_id = tracker->mCurrentFrame.mnId;
+        gray_images[frame_id]        = tracker->mImGray.clone();
+
+        std::set<unsigned long> key_frame_ids;
+        if (ORB_SLAM3::KeyFrame* ref = tracker->mCurrentFrame.mpReferenceKF)
+        {
+            for (ORB_SLAM3::KeyFrame* kf : ref->GetMap()->GetAllKeyFrames()) key_frame_ids.insert(kf->mnFrameId);
+        }
+        for (auto it = gray_images.begin(); it != gray_images.end();)
+        {
+            if (it->first + k_kept_frames < frame_id && !key_frame_ids.count(it->first))
+                it = gray_images.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    // Freeze the map while it is read.
+    ORB_SLAM3::LocalMapping* local_mapper = &system.getLocalMapper();
+    local_mapper->RequestStop();
+    while (!local_mapper->isStopped())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const ORB_SLAM3::Frame& frame = tracker->mCurrentFrame;
+    ORB_SLAM3::KeyFrame*    ref   = frame.mpReferenceKF;
+    if (!ref || tracker->mState != ORB_SLAM3::Tracking::OK)
+    {
+        std::cerr << "[Android Slam Tools Info] Frame " << frame_index << " is not tracked, pick another one." << std::endl;
+        local_mapper->Release();
+        return 1;
+    }
+
+    BenchFixture fixture{};
+
+    fixture.camera.fx = frame.mpCamera->getParameter(0);
+    fixture.camera.fy = frame.mpCamera->getParameter(1);
+    fixture.camera.cx = frame.mpCamera->getParameter(2);
+    fixture.camera.cy = frame.mpCamera->getParameter(3);
+    for (int i = 0; i < frame.mDistCoef.rows * frame.mDistCoef.cols; ++i)
+    {
+        fixture.camera.dist_coef.push_back(frame.mDistCoef.at<float>(i));
+    }
+    fixture.camera.width  = tracker->mImGray.cols;
+    fixture.camera.height = tracker->mImGray.rows;
+
+    fixture.orb.n_features   = frame.mpORBextractorLeft->GetNumFeatures();
+    fixture.orb.scale_factor = frame.mpORBextractorLeft->GetScaleFactor();
+    fixture.orb.n_levels     = frame.mpORBextractorLeft->GetLevels();
+    fixture.orb.ini_th_fast  = frame.mpORBextractorLeft->GetIniThFAST();
+    fixture.orb.min_th_fast  = frame.mpORBextractorLeft->GetMinThFAST();
+
+    std::unordered_map<ORB_SLAM3::KeyFrame*, int32_t> view_idx;
+    auto addView = [&](ORB_SLAM3::KeyFrame* kf) -> int32_t {
+        auto it = view_idx.find(kf);
+        if (it != view_idx.end()) return it->second;
+
+        auto img = gray_images.find(kf->mnFrameId);
+        if (kf->isBad() || img == gray_images.end())
+        {
+            view_idx[kf] = -1;
+            return -1;
+        }
+
+        const int32_t idx = static_cast<int32_t>(fixture.key_frames.size());
+        fixture.key_frames.push_back({ kf->mTimeStamp, toPose(kf->GetPose()), kf->N, img->second });
+        view_idx[kf] = idx;
+        return idx;
+    };
+
+    // Local key frames first, the observers of the local points become the fixed key frames.
+    fixture.reference_key_frame = addView(ref);
+    if (fixture.reference_key_frame < 0)
+    {
+        std::cerr << "[Android Slam Tools Info] The image of the reference key frame is lost." << std::endl;
+        local_mapper->Release();
+        return 1;
+    }
+    std::vector<ORB_SLAM3::KeyFrame*> local_key_frames = ref->GetVectorCovisibleKeyFrames();
+    for (ORB_SLAM3::KeyFrame* kf : local_key_frames) addView(kf);
+    local_key_frames.push_back(ref);
+
+    std::vector<ORB_SLAM3::MapPoint*>                  points;
+    std::unordered_map<ORB_SLAM3::MapPoint*, int32_t> point_idx;
+    auto addPoint = [&](ORB_SLAM3::MapPoint* mp) {
+        if (!mp || mp->isBad() || point_idx.count(mp)) return;
+        point_idx[mp] = static_cast<int32_t>(points.size());
+        points.push_back(mp);
+    };
+    for (ORB_SLAM3::KeyFrame* kf : local_key_frames)
+    {
+        for (ORB_SLAM3::MapPoint* mp : kf->GetMapPointMatches()) addPoint(mp);
+    }
+    for (ORB_SLAM3::MapPoint* mp : tracker->GetLocalMapMPS()) addPoint(mp);
+    for (ORB_SLAM3::MapPoint* mp : frame.mvpMapPoints) addPoint(mp);
+
+    size_t dropped = 0;
+    for (ORB_SLAM3::MapPoint* mp : points)
+    {
+        BenchFixture::Point point{};
+        const Eigen::Vector3f pos = mp->GetWorldPos();
+        point.pos                 = { pos.x(), pos.y(), pos.z() };
+        point.reference_view      = mp->GetReferenceKeyFrame() ? addView(mp->GetReferenceKeyFrame()) : -1;
+
+        for (const auto& obs : mp->GetObservations())
+        {
+            const int32_t view = addView(obs.pKF);
+            const int32_t kp   = obs.nLeft;
+            if (view < 0 || kp < 0)
+            {
+                ++dropped;
+                continue;
+            }
+            point.observations.push_back({ view, kp });
+        }
+        fixture.points.push_back(std::move(point));
+    }
+
+    fixture.frame = { frame.mTimeStamp, toPose(frame.GetPose()), frame.N, tracker->mImGray.clone() };
+    fixture.frame_matches.assign(frame.N, -1);
+    for (int i = 0; i < frame.N; ++i)
+    {
+        ORB_SLAM3::MapPoint* mp = frame.mvpMapPoints[i];
+        if (mp && !frame.mvbOutlier[i] && point_idx.count(mp)) fixture.frame_matches[i] = point_idx[mp];
+    }
+
+    local_mapper->Release();
+
+    std::cout << "[Android Slam Tools Info] Captured " << fixture.key_frames.size() << " key frames, "
+              << fixture.points.size() << " points (" << dropped << " observations without image dropped)."
+              << std::endl;
+
+    return fixture.save(fixture_file) ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Rebuilt scene.
+// ---------------------------------------------------------------------------------------------------
+
+// Extracts the view with the extractor that reproduces the captured key point count, the frames of
+// the map initialization are extracted with 5 times the features.
+bool buildFrame(Scene& scene, const BenchFixture::View& view, ORB_SLAM3::Frame& frame)
+{
+    for (ORB_SLAM3::ORBextractor* extractor : { scene.extractor.get(), scene.ini_extractor.get() })
+    {
+        frame.copyFrom(ORB_SLAM3::Frame(
+            view.image, view.time_stamp, extractor, scene.vocabulary, scene.camera.get(), scene.dist_coef, 0.0f, 0.0f));
+        if (frame.N == view.key_point_count) break;
+    }
+    if (frame.N != view.key_point_count) return false;
+
+    frame.SetPose(fromPose(view.pose));
+    frame.ComputeBoW();
+    return true;
+}
+
+bool buildScene(const BenchFixture& fixture, ORB_SLAM3::ORBVocabulary* vocabulary, Scene& scene)
+{
+    scene.vocabulary = vocabulary;
+    scene.camera     = std::make_unique<ORB_SLAM3::Pinhole>(
+        std::vector<float>{ fixture.camera.fx, fixture.camera.fy, fixture.camera.cx, fixture.camera.cy });
+    scene.dist_coef = cv::Mat(fixture.camera.dist_coef, true);
+    if (scene.dist_coef.empty()) scene.dist_coef = cv::Mat::zeros(4, 1, CV_32F);
+
+    const BenchFixture::OrbParams& orb = fixture.orb;
+    scene.extractor     = std::make_unique<ORB_SLAM3::ORBextractor>(
+        orb.n_features, orb.scale_factor, orb.n_levels, orb.ini_th_fast, orb.min_th_fast);
+    scene.ini_extractor = std::make_unique<ORB_SLAM3::ORBextractor>(
+        5 * orb.n_features, orb.scale_factor, orb.n_levels, orb.ini_th_fast, orb.min_th_fast);
+    scene.key_frame_db = std::make_unique<ORB_SLAM3::KeyFrameDatabase>(*vocabulary);
+    scene.map          = new ORB_SLAM3::Map(0);
+
+    for (const BenchFixture::View& view : fixture.key_frames)
+    {
+        ORB_SLAM3::Frame frame;
+        if (!buildFrame(scene, view, frame))
+        {
+            std::cerr << "[Android Slam Tools Info] Key frame " << scene.key_frames.size()
+                      << " does not re-extract to the captured features, skipped." << std::endl;
+            scene.key_frames.push_back(nullptr);
+            continue;
+        }
+
+        ORB_SLAM3::KeyFrame* kf = new ORB_SLAM3::KeyFrame(frame, scene.map, scene.key_frame_db.get());
+        scene.map->AddKeyFrame(kf);
+        scene.key_frames.push_back(kf);
+    }
+
+    scene.reference = scene.key_frames[fixture.reference_key_frame];
+    if (!scene.reference)
+    {
+        std::cerr << "[Android Slam Tools Info] The reference key frame could not be rebuilt." << std::endl;
+        return false;
+    }
+
+    std::vector<ORB_SLAM3::MapPoint*> point_of(fixture.points.size(), nullptr);
+    for (size_t i = 0; i < fixture.points.size(); ++i)
+    {
+        const BenchFixture::Point& src = fixture.points[i];
+
+        ORB_SLAM3::KeyFrame* ref = src.reference_view >= 0 ? scene.key_frames[src.reference_view] : nullptr;
+        for (const BenchFixture::Observation& obs : src.observations)
+        {
+            if (!ref) ref = scene.key_frames[obs.view];
+        }
+        if (!ref) continue;
+
+        auto* mp = new ORB_SLAM3::MapPoint(Eigen::Vector3f(src.pos[0], src.pos[1], src.pos[2]), ref, scene.map);
+        for (const BenchFixture::Observation& obs : src.observations)
+        {
+            ORB_SLAM3::KeyFrame* kf = scene.key_frames[obs.view];
+            if (!kf || obs.key_point >= kf->N) continue;
+
+            mp->AddObservation(kf, obs.key_point);
+            kf->AddMapPoint(mp, obs.key_point);
+        }
+        if (mp->Observations() == 0)
+        {
+            delete mp;
+            continue;
+        }
+
+        mp->ComputeDistinctiveDescriptors();
+        mp->UpdateNormalAndDepth();
+        scene.map->AddMapPoint(mp);
+        scene.points.push_back(mp);
+        point_of[i] = mp;
+    }
+
+    for (ORB_SLAM3::KeyFrame* kf : scene.key_frames)
+    {
+        if (kf) kf->UpdateConnections();
+    }
+
+    if (!buildFrame(scene, fixture.frame, scene.frame_unmatched))
+    {
+        std::cerr << "[Android Slam Tools Info] The current frame does not re-extract to the captured features." << std::endl;
+        return false;
+    }
+    scene.frame_unmatched.mpReferenceKF = scene.reference;
+
+    scene.frame.copyFrom(scene.frame_unmatched);
+    for (int i = 0; i < scene.frame.N && i < static_cast<int>(fixture.frame_matches.size()); ++i)
+    {
+        const int32_t match = fixture.frame_matches[i];
+        if (match >= 0) scene.frame.mvpMapPoints[i] = point_of[match];
+    }
+
+    for (ORB_SLAM3::KeyFrame* kf : scene.key_frames)
+    {
+        if (kf) scene.key_frame_poses.push_back(kf->GetPose());
+    }
+    for (ORB_SLAM3::MapPoint* mp : scene.points) scene.point_positions.push_back(mp->GetWorldPos());
+
+    std::cout << "[Android Slam Tools Info] Rebuilt " << scene.map->KeyFramesInMap() << " key frames, "
+              << scene.points.size() << " points." << std::endl;
+    return true;
+}
+
+void restoreScene(Scene& scene)
+{
+    size_t idx = 0;
+    for (ORB_SLAM3::KeyFrame* kf : scene.key_frames)
+    {
+        if (!kf) continue;
+        kf->SetPose(scene.key_frame_poses[idx++]);
+        kf->mnBALocalForKF = 0;
+        kf->mnBAFixedForKF = 0;
+    }
+    for (size_t i = 0; i < scene.points.size(); ++i)
+    {
+        scene.points[i]->SetWorldPos(scene.point_positions[i]);
+        scene.points[i]->mnBALocalForKF = 0;
+    }
+}
+
+std::vector<const BenchFixture::View*> fixtureViews(const BenchFixture& fixture)
+{
+    std::vector<const BenchFixture::View*> views = { &fixture.frame };
+    for (const BenchFixture::View& view : fixture.key_frames) views.push_back(&view);
+    return views;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Run.
+// ---------------------------------------------------------------------------------------------------
+
+int run(const std::string& voc_file, const std::string& fixture_file, size_t iterations, int threads)
+{
+    BenchFixture fixture{};
+    if (!fixture.load(fixture_file)) return 1;
+
+    std::cout << "[Android Slam Tools Info] Loading vocabulary " << voc_file << "." << std::endl;
+    auto*       vocabulary = new ORB_SLAM3::ORBVocabulary();
+    std::string voc_data   = readTextFile(voc_file);
+    bool        loaded     = false;
+    if (ORB_SLAM3::ORBVocabulary::isBinary(voc_data.data(), voc_data.size()))
+    {
+        auto storage = std::make_shared<const std::string>(std::move(voc_data));
+        loaded       = vocabulary->loadFromBinaryBuffer(storage->data(), storage->size(), storage);
+    }
+    else
+    {
+        loaded = vocabulary->loadFromAndroidTextFile(std::move(voc_data));
+    }
+    if (!loaded)
+    {
+        std::cerr << "[Android Slam Tools Info] Failed to load vocabulary " << voc_file << "." << std::endl;
+        return 1;
+    }
+
+    Scene scene;
+    if (!buildScene(fixture, vocabulary, scene)) return 1;
+
+    std::vector<KernelResult> results;
+    const BenchContext ctx{ fixture, vocabulary, scene, iterations, threads };
+    if (!runFeatureKernels(ctx, results)) return 1;
+    if (!runFrameKernels(ctx, results)) return 1;
+    if (!runMapKernels(ctx, results)) return 1;
+    if (!runSolverKernels(ctx, results)) return 1;
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::left << std::setw(26) << "kernel" << std::right << std::setw(8) << "thread" << std::setw(10)
+              << "ops" << std::setw(16) << "ns/op" << std::setw(14) << "allocs/op" << std::setw(14) << "bytes/op"
+              << std::setw(16) << "pool allocs/op" << std::setw(16) << "pool bytes/op" << std::endl;
+    for (const KernelResult& r : results)
+    {
+        std::cout << std::left << std::setw(26) << r.name << std::right << std::setw(8) << r.thread << std::setw(10)
+                  << r.ops << std::setw(16) << r.ns_per_op << std::setw(14) << r.allocs_per_op << std::setw(14)
+                  << r.bytes_per_op << std::setw(16) << r.pool_allocs_per_op << std::setw(16) << r.pool_bytes_per_op
+                  << std::endl;
+    }
+
+    if (!countsAllAllocations())
+    {
+        std::cout << "[Android Slam Tools Info] Only operator new and cv::Mat allocations are counted on this "
+                  << "platform, the Eigen aligned allocations are not." << std::endl;
+    }
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Parity checks.
+// ---------------------------------------------------------------------------------------------------
+
+int check(const std::string& fixture_file)
+{
+    BenchFixture fixture{};
+    if (!fixture.load(fixture_file)) return 1;
+
+    if (!checkFeatureKernels(fixture)) return 1;
+    if (!checkFrameKernels(fixture)) return 1;
+
+    return 0;
+}
+
+}  // namespace kernel_bench_utils
+}  // namespace android_slam
+
+int main(int argc, char** argv)
+{
+    using namespace android_slam;
+
+    kernel_bench_utils::installAllocCounters();
+
+    const std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "capture" && argc == 6)
+    {
+        return kernel_bench_utils::capture(argv[2], argv[3], std::stoull(argv[4]), argv[5]);
+    }
+    if (mode == "run" && argc >= 4)
+    {
+        const size_t iterations = argc > 4 ? std::stoull(argv[4]) : 100;
+        const int    threads    = argc > 5 ? std::max(1, std::stoi(argv[5])) : 1;
+        return kernel_bench_utils::run(argv[2], argv[3], iterations, threads);
+    }
+    if (mode == "check" && argc == 3)
+    {
+        return kernel_bench_utils::check(argv[2]);
+    }
+
+    std::cerr << "Usage: " << argv[0] << " capture <vocabulary> <dataset folder> <frame index> <fixture file>" << std::endl;
+    std::cerr << "       " << argv[0] << " run <vocabulary> <fixture file> [iterations] [threads]" << std::endl;
+    std::cerr << "       " << argv[0] << " check <fixture file>" << std::endl;
+    return 1;
+}
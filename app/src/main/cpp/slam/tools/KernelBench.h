@@ -0,0 +1,210 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <camera_models/GeometricCamera.h>
+#include <feature/ORBextractor.h>
+#include <feature/ORBVocabulary.h>
+#include <frame/Frame.h>
+#include <frame/KeyFrame.h>
+#include <frame/KeyFrameDatabase.h>
+#include <map/Map.h>
+#include <map/MapPoint.h>
+
+#include "BenchFixture.h"
+
+namespace android_slam
+{
+namespace kernel_bench_utils
+{
+
+// ---------------------------------------------------------------------------------------------------
+// Allocation counting (BenchAlloc.cpp).
+// ---------------------------------------------------------------------------------------------------
+
+struct AllocCount
+{
+    size_t count;
+    size_t bytes;
+};
+
+// Heap allocations made by the calling thread since it was marked as a benchmark thread.
+AllocCount threadAllocs();
+
+// Heap allocations of all the threads that are not benchmark threads (worker pools, helper threads of
+// the kernels, the main thread), summed.
+AllocCount backgroundAllocs();
+
+// Counts the allocations of the calling thread in threadAllocs() instead of backgroundAllocs().
+void markBenchThread();
+
+// True when every heap allocation is counted (malloc is replaced, glibc only). Otherwise only the
+// operator new overloads and the cv::Mat buffers are, the Eigen aligned allocations are missed.
+bool countsAllAllocations();
+
+// Installs the counting cv::Mat allocator where malloc is not replaced.
+void installAllocCounters();
+
+// ---------------------------------------------------------------------------------------------------
+// Timing.
+// ---------------------------------------------------------------------------------------------------
+
+struct KernelResult
+{
+    std::string name;
+    int         thread;
+    size_t      ops;
+    double      ns_per_op;
+    double      allocs_per_op;
+    double      bytes_per_op;
+    double      pool_allocs_per_op;  // Made by the other threads during the run, split evenly over the ops.
+    double      pool_bytes_per_op;
+};
+
+// Runs op() iterations times on every thread after an untimed prepare(), both take the per thread
+// state made by make_state(thread). prepare() runs before every op and is excluded from the timing.
+template <typename MakeState, typename Prepare, typename Op>
+void runKernel(const char*                name,
+               int                        threads,
+               size_t                     iterations,
+               MakeState                  make_state,
+               Prepare                    prepare,
+               Op                         op,
+               std::vector<KernelResult>& results)
+{
+    std::vector<KernelResult> thread_results(threads);
+    std::atomic<int>          ready{ 0 };
+    std::atomic<bool>         start{ false };
+    std::atomic<int>          done{ 0 };
+
+    auto worker = [&](int t) {
+        markBenchThread();
+        auto state = make_state(t);
+
+        // Warm up, then wait for the other threads so they contend for the whole run.
+        prepare(state);
+        op(state);
+        ready.fetch_add(1);
+        while (!start.load()) std::this_thread::yield();
+
+        std::chrono::steady_clock::duration elapsed{};
+        const AllocCount                    before     = threadAllocs();
+        size_t                              prep_count = 0;
+        size_t                              prep_bytes = 0;
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            const AllocCount c = threadAllocs();
+            prepare(state);
+            const AllocCount p = threadAllocs();
+            prep_count += p.count - c.count;
+            prep_bytes += p.bytes - c.bytes;
+
+            const auto begin = std::chrono::steady_clock::now();
+            op(state);
+            elapsed += std::chrono::steady_clock::now() - begin;
+        }
+        const AllocCount after = threadAllocs();
+        done.fetch_add(1);
+
+        const double n    = (double)iterations;
+        thread_results[t] = { name,
+                              t,
+                              iterations,
+                              std::chrono::duration<double, std::nano>(elapsed).count() / n,
+                              (double)(after.count - before.count - prep_count) / n,
+                              (double)(after.bytes - before.bytes - prep_bytes) / n,
+                              0.0,
+                              0.0 };
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) workers.emplace_back(worker, t);
+
+    // The other threads are counted from the moment every benchmark thread is warmed up until the last
+    // one is done, the pools being created and torn down are left out.
+    while (ready.load() < threads) std::this_thread::yield();
+    const AllocCount pool_before = backgroundAllocs();
+    start                        = true;
+    while (done.load() < threads) std::this_thread::yield();
+    const AllocCount pool_after = backgroundAllocs();
+
+    for (std::thread& w : workers) w.join();
+
+    const double ops = (double)iterations * (double)threads;
+    for (KernelResult& r : thread_results)
+    {
+        r.pool_allocs_per_op = (double)(pool_after.count - pool_before.count) / ops;
+        r.pool_bytes_per_op  = (double)(pool_after.bytes - pool_before.bytes) / ops;
+    }
+    results.insert(results.end(), thread_results.begin(), thread_results.end());
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Rebuilt scene (KernelBench.cpp).
+// ---------------------------------------------------------------------------------------------------
+
+struct Scene
+{
+    ORB_SLAM3::ORBVocabulary*                  vocabulary = nullptr;
+    std::unique_ptr<ORB_SLAM3::GeometricCamera> camera;
+    cv::Mat                                    dist_coef;
+    std::unique_ptr<ORB_SLAM3::ORBextractor>   extractor;
+    std::unique_ptr<ORB_SLAM3::ORBextractor>   ini_extractor;
+    std::unique_ptr<ORB_SLAM3::KeyFrameDatabase> key_frame_db;
+    ORB_SLAM3::Map*                            map = nullptr;
+
+    std::vector<ORB_SLAM3::KeyFrame*> key_frames;  // nullptr for the views that could not be rebuilt.
+    std::vector<ORB_SLAM3::MapPoint*> points;
+    ORB_SLAM3::KeyFrame*              reference = nullptr;
+
+    ORB_SLAM3::Frame frame;            // Current frame with its matches and BoW.
+    ORB_SLAM3::Frame frame_unmatched;  // Current frame with BoW but no match.
+
+    std::vector<Sophus::SE3f>    key_frame_poses;
+    std::vector<Eigen::Vector3f> point_positions;
+};
+
+// Puts the poses and positions the local BA writes back to the rebuilt ones.
+void restoreScene(Scene& scene);
+
+// What the kernels of every subsystem run on.
+struct BenchContext
+{
+    const BenchFixture&       fixture;
+    ORB_SLAM3::ORBVocabulary* vocabulary;
+    Scene&                    scene;
+    size_t                    iterations;
+    int                       threads;
+};
+
+// The frame then the key frames of the fixture.
+std::vector<const BenchFixture::View*> fixtureViews(const BenchFixture& fixture);
+
+// ---------------------------------------------------------------------------------------------------
+// Kernels and parity checks of each subsystem. The run functions return false when the rebuilt scene
+// does not behave as captured, the check functions on the first kernel differing from the code it
+// replaces.
+// ---------------------------------------------------------------------------------------------------
+
+// ORB extraction, pyramid, FAST, descriptors, key point distribution and Hamming distances
+// (BenchFeature.cpp).
+bool runFeatureKernels(const BenchContext& ctx, std::vector<KernelResult>& results);
+bool checkFeatureKernels(const BenchFixture& fixture);
+
+// Feature grid, local map projection, matching and BoW of the frames, key frame database (BenchFrame.cpp).
+bool runFrameKernels(const BenchContext& ctx, std::vector<KernelResult>& results);
+bool checkFrameKernels(const BenchFixture& fixture);
+
+// Map object pools, observations, map enumeration, covisibility and map point geometry (BenchMap.cpp).
+bool runMapKernels(const BenchContext& ctx, std::vector<KernelResult>& results);
+
+// Pose optimization and local bundle adjustment (BenchSolver.cpp).
+bool runSolverKernels(const BenchContext& ctx, std::vector<KernelResult>& results);
+
+}  // namespace kernel_bench_utils
+}  // namespace android_slam
@@ -0,0 +1,116 @@
+// Host side converter of the ORB vocabulary from the text format (ORBVoc.txt) to the binary one, which the
+// app maps from its assets and uses in place instead of parsing about a million nodes at start up.
+//
+// Usage: vocabulary_converter <ORBVoc.txt> <ORBVoc.bin>
+//
+// The binary file is loaded back and checked against the text one: every word (descriptor, weight and
+// ancestors) and the words and nodes given by transform() to random descriptors must be identical.
+// Put the result in app/src/main/assets/vocabulary/, it is picked over ORBVoc.txt when present.
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include <feature/ORBVocabulary.h>
+
+namespace android_slam
+{
+namespace vocabulary_converter_utils
+{
+
+double elapsedMs(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+bool sameVocabulary(const ORB_SLAM3::ORBVocabulary& text, const ORB_SLAM3::ORBVocabulary& binary)
+{
+    if (text.size() != binary.size() || text.getBranchingFactor() != binary.getBranchingFactor() ||
+        text.getDepthLevels() != binary.getDepthLevels() || text.getScoringType() != binary.getScoringType() ||
+        text.getWeightingType() != binary.getWeightingType())
+    {
+        std::cerr << "[Android Slam Tools Info] The vocabulary parameters differ." << std::endl;
+        return false;
+    }
+
+    for (DBoW2::WordId wid = 0; wid < text.size(); ++wid)
+    {
+        bool same = text.getWordWeight(wid) == binary.getWordWeight(wid) &&
+                    cv::norm(text.getWord(wid), binary.getWord(wid), cv::NORM_HAMMING) == 0.0;
+        for (int levels_up = 1; same && levels_up <= text.getDepthLevels(); ++levels_up)
+        {
+            same = text.getParentNode(wid, levels_up) == binary.getParentNode(wid, levels_up);
+        }
+        if (!same)
+        {
+            std::cerr << "[Android Slam Tools Info] Word " << wid << " differs." << std::endl;
+            return false;
+        }
+    }
+
+    cv::RNG rng(0x5eed);
+    cv::Mat descriptors(1000, DBoW2::FORB::L, CV_8U);
+    rng.fill(descriptors, cv::RNG::UNIFORM, 0, 256);
+
+    DBoW2::BowVector     text_bow, binary_bow;
+    DBoW2::FeatureVector text_feat, binary_feat;
+    text.transform(descriptors.ptr<unsigned char>(), descriptors.rows, text_bow, text_feat, 4);
+    binary.transform(descriptors.ptr<unsigned char>(), descriptors.rows, binary_bow, binary_feat, 4);
+    if (text_bow != binary_bow || text_feat != binary_feat)
+    {
+        std::cerr << "[Android Slam Tools Info] transform() differs on random descriptors." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+}  // namespace vocabulary_converter_utils
+}  // namespace android_slam
+
+int main(int argc, char** argv)
+{
+    using namespace android_slam::vocabulary_converter_utils;
+
+    if (argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <ORBVoc.txt> <ORBVoc.bin>" << std::endl;
+        return 1;
+    }
+
+    const std::string text_file   = argv[1];
+    const std::string binary_file = argv[2];
+
+    ORB_SLAM3::ORBVocabulary text;
+    auto                     begin = std::chrono::steady_clock::now();
+    if (!text.loadFromTextFile(text_file))
+    {
+        std::cerr << "[Android Slam Tools Info] Failed to load vocabulary " << text_file << "." << std::endl;
+        return 1;
+    }
+    std::cout << "[Android Slam Tools Info] Loaded " << text.size() << " words from " << text_file << " in "
+              << elapsedMs(begin) << " ms." << std::endl;
+
+    if (!text.saveToBinaryFile(binary_file))
+    {
+        std::cerr << "[Android Slam Tools Info] Failed to write " << binary_file << "." << std::endl;
+        return 1;
+    }
+
+    ORB_SLAM3::ORBVocabulary binary;
+    begin = std::chrono::steady_clock::now();
+    if (!binary.loadFromBinaryFile(binary_file))
+    {
+        std::cerr << "[Android Slam Tools Info] Failed to load vocabulary " << binary_file << "." << std::endl;
+        return 1;
+    }
+    std::cout << "[Android Slam Tools Info] Loaded " << binary.size() << " words from " << binary_file << " in "
+              << elapsedMs(begin) << " ms." << std::endl;
+
+    if (!sameVocabulary(text, binary)) return 1;
+
+    std::cout << "[Android Slam Tools Info] " << binary_file << " matches " << text_file << "." << std::endl;
+    return 0;
+}